@@ -24,9 +24,13 @@
 
 #define GLM_FORCE_RADIANS
 
+#include <algorithm>
+#include <atomic>
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <thread>
 #include <utility>
 #include <iterator>
 
@@ -57,8 +61,14 @@
 
 #define MASK_3D_CACHE "3D_CACHE"
 
+// guards the cache map and list; the entries themselves are loaded under their own lock
 static wxCriticalSection lock3D_cache;
 
+// the plugins and the scene graph writer rely on process wide state (the numeric
+// locale, the node name counters), so models are parsed and cache files written
+// one at a time; hashing, cache file reading and render data creation run concurrently
+static wxCriticalSection lock3D_plugins;
+
 
 static bool isSHA1Same( const unsigned char* shaA, const unsigned char* shaB )
 {
@@ -76,6 +86,7 @@ static bool checkTag( const char* aTag, void* aPluginMgrPtr )
         return false;
 
     S3D_PLUGIN_MANAGER *pp = (S3D_PLUGIN_MANAGER*) aPluginMgrPtr;
+    wxCriticalSectionLocker lock( lock3D_plugins );
 
     return pp->CheckTag( aTag );
 }
@@ -136,6 +147,11 @@ public:
     std::string   pluginInfo;   // PluginName:Version string
     SCENEGRAPH*   sceneData;
     S3DMODEL*     renderData;
+
+    // held while the entry is loaded, checked or converted to render data; concurrent
+    // requests for the same file wait here for the first one instead of loading it again
+    wxCriticalSection lock;
+    bool              loaded;   // set once the file was loaded (or failed to load)
 };
 
 
@@ -143,6 +159,7 @@ S3D_CACHE_ENTRY::S3D_CACHE_ENTRY()
 {
     sceneData = NULL;
     renderData = NULL;
+    loaded = false;
     memset( sha1sum, 0, 20 );
 }
 
@@ -168,6 +185,7 @@ void S3D_CACHE_ENTRY::SetSHA1( const unsigned char* aSHA1Sum )
     }
 
     memcpy( sha1sum, aSHA1Sum, 20 );
+    m_CacheBaseName.clear();
     return;
 }
 
@@ -205,7 +223,8 @@ S3D_CACHE::~S3D_CACHE()
 }
 
 
-SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr )
+SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr,
+                              bool aSceneData )
 {
     if( aCachePtr )
         *aCachePtr = NULL;
@@ -220,56 +239,58 @@ SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCach
         return NULL;
     }
 
-    // check cache if file is already loaded
-    wxCriticalSectionLocker lock( lock3D_cache );
-    std::map< wxString, S3D_CACHE_ENTRY*, rsort_wxString >::iterator mi;
-    mi = m_CacheMap.find( full3Dpath );
+    S3D_CACHE_ENTRY* ep = getEntry( full3Dpath );
+    wxCriticalSectionLocker lock( ep->lock );
 
-    if( mi != m_CacheMap.end() )
-    {
-        wxFileName fname( full3Dpath );
+    if( aCachePtr )
+        *aCachePtr = ep;
 
-        if( fname.FileExists() )    // Only check if file exists. If not, it will
-        {                           // use the same model in cache.
-            bool reload = false;
-            wxDateTime fmdate = fname.GetModificationTime();
+    // a new entry: search the Filename->Cachename map
+    if( !ep->loaded )
+        return checkCache( full3Dpath, ep, aSceneData );
 
-            if( fmdate != mi->second->modTime )
-            {
-                unsigned char hashSum[20];
-                getSHA1( full3Dpath, hashSum );
-                mi->second->modTime = fmdate;
-
-                if( !isSHA1Same( hashSum, mi->second->sha1sum ) )
-                {
-                    mi->second->SetSHA1( hashSum );
-                    reload = true;
-                }
-            }
+    // check if the file already loaded was modified
+    wxFileName fname( full3Dpath );
 
-            if( reload )
-            {
-                if( NULL != mi->second->sceneData )
-                {
-                    S3D::DestroyNode( mi->second->sceneData );
-                    mi->second->sceneData = NULL;
-                }
+    if( fname.FileExists() )    // Only check if file exists. If not, it will
+    {                           // use the same model in cache.
+        bool reload = false;
+        wxDateTime fmdate = fname.GetModificationTime();
 
-                if( NULL != mi->second->renderData )
-                    S3D::Destroy3DModel( &mi->second->renderData );
+        if( fmdate != ep->modTime )
+        {
+            unsigned char hashSum[20];
+            getSHA1( full3Dpath, hashSum );
+            ep->modTime = fmdate;
 
-                mi->second->sceneData = m_Plugins->Load3DModel( full3Dpath, mi->second->pluginInfo );
+            if( !isSHA1Same( hashSum, ep->sha1sum ) )
+            {
+                ep->SetSHA1( hashSum );
+                reload = true;
             }
         }
 
-        if( NULL != aCachePtr )
-            *aCachePtr = mi->second;
+        if( reload )
+        {
+            if( NULL != ep->sceneData )
+            {
+                S3D::DestroyNode( ep->sceneData );
+                ep->sceneData = NULL;
+            }
 
-        return mi->second->sceneData;
+            if( NULL != ep->renderData )
+                S3D::Destroy3DModel( &ep->renderData );
+
+            wxCriticalSectionLocker pluginLock( lock3D_plugins );
+            ep->sceneData = m_Plugins->Load3DModel( full3Dpath, ep->pluginInfo );
+        }
     }
 
-    // a cache item does not exist; search the Filename->Cachename map
-    return checkCache( full3Dpath, aCachePtr );
+    // the render data was read from the model cache file, without the scene data
+    if( aSceneData && !ep->sceneData && ep->renderData )
+        return loadSceneData( full3Dpath, ep );
+
+    return ep->sceneData;
 }
 
 
@@ -279,75 +300,65 @@ SCENEGRAPH* S3D_CACHE::Load( const wxString& aModelFile )
 }
 
 
-SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr )
+S3D_CACHE_ENTRY* S3D_CACHE::getEntry( const wxString& aFileName )
 {
-    if( aCachePtr )
-        *aCachePtr = NULL;
+    wxCriticalSectionLocker lock( lock3D_cache );
+    std::map< wxString, S3D_CACHE_ENTRY*, rsort_wxString >::iterator mi;
+    mi = m_CacheMap.find( aFileName );
+
+    if( mi != m_CacheMap.end() )
+        return mi->second;
+
+    S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
+    m_CacheList.push_back( ep );
+    m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >( aFileName, ep ) );
+
+    return ep;
+}
 
+
+SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem,
+                                    bool aSceneData )
+{
     unsigned char sha1sum[20];
+    wxFileName fname( aFileName );
+
+    aCacheItem->modTime = fname.GetModificationTime();
+    aCacheItem->loaded = true;
 
     if( !getSHA1( aFileName, sha1sum ) || m_CacheDir.empty() )
     {
         // just in case we can't get a hash digest (for example, on access issues)
-        // or we do not have a configured cache file directory, we create an
-        // entry to prevent further attempts at loading the file
-        S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
-        m_CacheList.push_back( ep );
-        wxFileName fname( aFileName );
-        ep->modTime = fname.GetModificationTime();
-
-        if( m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >
-            ( aFileName, ep ) ).second == false )
-        {
-            wxLogTrace( MASK_3D_CACHE, "%s:%s:%d\n * [BUG] duplicate entry in map file; key = '%s'",
-                        __FILE__, __FUNCTION__, __LINE__, aFileName );
-
-            m_CacheList.pop_back();
-            delete ep;
-        }
-        else
-        {
-            if( aCachePtr )
-                *aCachePtr = ep;
-
-        }
-
+        // or we do not have a configured cache file directory, we keep the
+        // entry empty to prevent further attempts at loading the file
         return NULL;
     }
 
-    S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
-    m_CacheList.push_back( ep );
-    wxFileName fname( aFileName );
-    ep->modTime = fname.GetModificationTime();
-
-    if( m_CacheMap.insert( std::pair< wxString, S3D_CACHE_ENTRY* >
-                               ( aFileName, ep ) ).second == false )
-    {
-        wxLogTrace( MASK_3D_CACHE, "%s:%s:%d\n * [BUG] duplicate entry in map file; key = '%s'",
-                    __FILE__, __FUNCTION__, __LINE__, aFileName );
+    aCacheItem->SetSHA1( sha1sum );
 
-        m_CacheList.pop_back();
-        delete ep;
+    // the render data is all a renderer needs: read it ready to use if possible
+    if( !aSceneData && loadModelCacheData( aCacheItem ) )
         return NULL;
-    }
 
-    if( aCachePtr )
-        *aCachePtr = ep;
+    return loadSceneData( aFileName, aCacheItem );
+}
 
-    ep->SetSHA1( sha1sum );
 
-    wxString bname = ep->GetCacheBaseName();
+SCENEGRAPH* S3D_CACHE::loadSceneData( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem )
+{
+    wxString bname = aCacheItem->GetCacheBaseName();
     wxString cachename = m_CacheDir + bname + wxT( ".3dc" );
 
-    if( wxFileName::FileExists( cachename ) && loadCacheData( ep ) )
-        return ep->sceneData;
+    if( wxFileName::FileExists( cachename ) && loadCacheData( aCacheItem ) )
+        return aCacheItem->sceneData;
 
-    ep->sceneData = m_Plugins->Load3DModel( aFileName, ep->pluginInfo );
+    wxCriticalSectionLocker pluginLock( lock3D_plugins );
+    aCacheItem->sceneData = m_Plugins->Load3DModel( aFileName, aCacheItem->pluginInfo );
 
-    if( NULL != ep->sceneData )
-        saveCacheData( ep );
+    if( NULL != aCacheItem->sceneData )
+        saveCacheData( aCacheItem );
 
-    return ep->sceneData;
+    return aCacheItem->sceneData;
 }
 
 
@@ -502,6 +513,39 @@ bool S3D_CACHE::saveCacheData( S3D_CACHE_ENTRY* aCacheItem )
 }
 
 
+bool S3D_CACHE::loadModelCacheData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    if( m_CacheDir.empty() )
+        return false;
+
+    wxString fname = m_CacheDir + aCacheItem->GetCacheBaseName() + wxT( ".3dm" );
+
+    if( !wxFileName::FileExists( fname ) )
+        return false;
+
+    if( NULL != aCacheItem->renderData )
+        S3D::Destroy3DModel( &aCacheItem->renderData );
+
+    aCacheItem->renderData = S3D::ReadModelCache( fname.ToUTF8(), m_Plugins, checkTag,
+                                                  aCacheItem->pluginInfo );
+
+    return NULL != aCacheItem->renderData;
+}
+
+
+bool S3D_CACHE::saveModelCacheData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    if( m_CacheDir.empty() || NULL == aCacheItem->renderData )
+        return false;
+
+    wxString fname = m_CacheDir + aCacheItem->GetCacheBaseName() + wxT( ".3dm" );
+
+    wxCriticalSectionLocker pluginLock( lock3D_plugins );
+    return S3D::WriteModelCache( fname.ToUTF8(), aCacheItem->renderData,
+                                 aCacheItem->pluginInfo.c_str() );
+}
+
+
 bool S3D_CACHE::Set3DConfigDir( const wxString& aConfigDir )
 {
     if( !m_ConfigDir.empty() )
@@ -694,6 +738,7 @@ std::list< wxString > const* S3D_CACHE::GetFileFilters( void ) const
 
 void S3D_CACHE::FlushCache( bool closePlugins )
 {
+    wxCriticalSectionLocker lock( lock3D_cache );
     std::list< S3D_CACHE_ENTRY* >::iterator sCL = m_CacheList.begin();
     std::list< S3D_CACHE_ENTRY* >::iterator eCL = m_CacheList.end();
 
@@ -725,30 +770,64 @@ void S3D_CACHE::ClosePlugins( void )
 S3DMODEL* S3D_CACHE::GetModel( const wxString& aModelFileName )
 {
     S3D_CACHE_ENTRY* cp = NULL;
-    SCENEGRAPH* sp = load( aModelFileName, &cp );
-
-    if( !sp )
-        return NULL;
+    load( aModelFileName, &cp, false );
 
+    // the model cannot be found
     if( !cp )
-    {
-        wxLogTrace( MASK_3D_CACHE,
-                    "%s:%s:%d\n  * [BUG] model loaded with no associated S3D_CACHE_ENTRY",
-                    __FILE__, __FUNCTION__, __LINE__ );
-
         return NULL;
-    }
 
-    if( cp->renderData )
+    wxCriticalSectionLocker lock( cp->lock );
+
+    if( cp->renderData || !cp->sceneData )
         return cp->renderData;
 
-    S3DMODEL* mp = S3D::GetModel( sp );
+    S3DMODEL* mp = S3D::GetModel( cp->sceneData );
     cp->renderData = mp;
 
+    if( NULL != mp )
+        saveModelCacheData( cp );
+
     return mp;
 }
 
 
+void S3D_CACHE::LoadModels( const std::vector<wxString>& aModelFileNames )
+{
+    std::vector<wxString> files( aModelFileNames );
+    std::sort( files.begin(), files.end() );
+    files.erase( std::unique( files.begin(), files.end() ), files.end() );
+
+    std::atomic<size_t> nextItem( 0 );
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+                                                   files.size() );
+    std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+    auto load_lambda = [&]() -> size_t
+    {
+        size_t num = 0;
+
+        for( size_t i = nextItem++; i < files.size(); i = nextItem++ )
+        {
+            if( GetModel( files[i] ) )
+                num++;
+        }
+
+        return num;
+    };
+
+    if( parallelThreadCount <= 1 )
+        load_lambda();
+    else
+    {
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, load_lambda );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii].wait();
+    }
+}
+
+
 wxString S3D_CACHE::GetModelHash( const wxString& aModelFileName )
 {
     wxString full3Dpath = m_FNResolver->ResolvePath( aModelFileName );
@@ -756,19 +835,12 @@ wxString S3D_CACHE::GetModelHash( const wxString& aModelFileName )
     if( full3Dpath.empty() || !wxFileName::FileExists( full3Dpath ) )
         return wxEmptyString;
 
-    // check cache if file is already loaded
-    std::map< wxString, S3D_CACHE_ENTRY*, rsort_wxString >::iterator mi;
-    mi = m_CacheMap.find( full3Dpath );
-
-    if( mi != m_CacheMap.end() )
-        return mi->second->GetCacheBaseName();
+    S3D_CACHE_ENTRY* cp = getEntry( full3Dpath );
+    wxCriticalSectionLocker lock( cp->lock );
 
-    // a cache item does not exist; search the Filename->Cachename map
-    S3D_CACHE_ENTRY* cp = NULL;
-    checkCache( full3Dpath, &cp );
-
-    if( NULL != cp )
-        return cp->GetCacheBaseName();
+    // a new entry: search the Filename->Cachename map
+    if( !cp->loaded )
+        checkCache( full3Dpath, cp, true );
 
-    return wxEmptyString;
+    return cp->GetCacheBaseName();
 }
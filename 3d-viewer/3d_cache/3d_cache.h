@@ -31,6 +31,7 @@
 
 #include <list>
 #include <map>
+#include <vector>
 #include <wx/string.h>
 #include "kicad_string.h"
 #include "filename_resolver.h"
@@ -75,16 +76,43 @@ private:
 
     /** Find or create cache entry for file name
      *
-     * Searches the cache list for the given filename and retrieves
-     * the cache data; a cache entry is created if one does not
-     * already exist.
+     * Searches the cache list for the given filename; an empty
+     * cache entry is created if one does not already exist. The
+     * entry is loaded by checkCache() under its own lock.
      *
-     * @param[in]   aFileName   file name (full or partial path)
-     * @param[out]  aCachePtr   optional return address for cache entry pointer
+     * @param[in]   aFileName   file name (full path)
+     * @return      cache entry associated with file name
+     */
+    S3D_CACHE_ENTRY* getEntry( const wxString& aFileName );
+
+    /** Load the data of a new cache entry
+     *
+     * Hashes the file, then retrieves the render data from the model
+     * cache file if only that is needed and there is one for the hash,
+     * otherwise loads the scene data (see loadSceneData()). The caller
+     * holds the entry's lock.
+     *
+     * @param[in]   aFileName   file name (full path)
+     * @param[in]   aCacheItem  cache entry of the file
+     * @param[in]   aSceneData  false if the render data is enough
+     * @return      SCENEGRAPH object associated with file name
+     * @retval      NULL    on error, or if only the render data was loaded
+     */
+    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem,
+                            bool aSceneData );
+
+    /** Load the scene data of a hashed cache entry
+     *
+     * Retrieves the scene data from the cache file if there is
+     * one for the file's hash, otherwise loads the file with the
+     * plugins and saves the cache file.
+     *
+     * @param[in]   aFileName   file name (full path)
+     * @param[in]   aCacheItem  cache entry of the file
      * @return      SCENEGRAPH object associated with file name
      * @retval      NULL    on error
      */
-    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr = NULL );
+    SCENEGRAPH* loadSceneData( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem );
 
     /**
      * Function getSHA1
@@ -103,8 +131,17 @@ private:
     // save scene data to a cache file
     bool saveCacheData( S3D_CACHE_ENTRY* aCacheItem );
 
-    // the real load function (can supply a cache entry pointer to member functions)
-    SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = NULL );
+    // load render data from a model cache file
+    bool loadModelCacheData( S3D_CACHE_ENTRY* aCacheItem );
+
+    // save render data to a model cache file
+    bool saveModelCacheData( S3D_CACHE_ENTRY* aCacheItem );
+
+    // the real load function (can supply a cache entry pointer to member functions);
+    // if aSceneData is false and the render data is in the model cache, the scene
+    // data is not loaded and NULL is returned
+    SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = NULL,
+                      bool aSceneData = true );
 
 public:
     S3D_CACHE();
@@ -200,6 +237,16 @@ public:
      */
     S3DMODEL* GetModel( const wxString& aModelFileName );
 
+    /**
+     * Function LoadModels
+     * loads the render data of several models on parallel threads, so that
+     * the following GetModel() calls for them return at once. Each file is
+     * loaded once even if it is listed several times.
+     *
+     * @param aModelFileNames is the list of the models to be loaded
+     */
+    void LoadModels( const std::vector<wxString>& aModelFileNames );
+
     wxString GetModelHash( const wxString& aModelFileName );
 };
 
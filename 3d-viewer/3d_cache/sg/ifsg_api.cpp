@@ -21,6 +21,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -468,6 +470,247 @@ SGNODE* S3D::ReadCache( const char* aFileName, void* aPluginMgr,
 }
 
 
+// Flat model cache file layout; all values are in the byte order of the machine and
+// every array starts on a 32 bit boundary, so the file may be read or mapped in place:
+//
+//   "KICAD3DM"                                  magic
+//   uint32 format version, uint32 0x01020304    (byte order check)
+//   uint32 sizeof( SMATERIAL ), uint32 sizeof( SFVEC3F ) << 16 | sizeof( SFVEC2F )
+//                                               (data layout check)
+//   uint32 plugin info length, plugin info characters padded to 32 bits
+//   uint32 material count, SMATERIAL[material count]
+//   uint32 mesh count, and for each mesh:
+//      uint32 vertex count, face index count, material index, flags (MODEL_CACHE_*)
+//      SFVEC3F positions[vertex count]
+//      SFVEC3F normals[vertex count]           if MODEL_CACHE_NORMALS
+//      SFVEC2F texture coords[vertex count]    if MODEL_CACHE_TEXCOORDS
+//      SFVEC3F colors[vertex count]            if MODEL_CACHE_COLORS
+//      uint32 face indices[face index count]
+
+static const char     MODEL_CACHE_MAGIC[8]   = { 'K', 'I', 'C', 'A', 'D', '3', 'D', 'M' };
+static const uint32_t MODEL_CACHE_VERSION    = 1;
+static const uint32_t MODEL_CACHE_BYTE_ORDER = 0x01020304;
+static const uint32_t MODEL_CACHE_LAYOUT     = sizeof( SFVEC3F ) << 16 | sizeof( SFVEC2F );
+
+enum MODEL_CACHE_FLAGS
+{
+    MODEL_CACHE_NORMALS   = 1,
+    MODEL_CACHE_TEXCOORDS = 2,
+    MODEL_CACHE_COLORS    = 4
+};
+
+
+static void writeU32( std::ostream& aFile, uint32_t aValue )
+{
+    aFile.write( (const char*) &aValue, sizeof( aValue ) );
+}
+
+
+template <class T>
+static void writeArray( std::ostream& aFile, const T* aArray, size_t aCount )
+{
+    aFile.write( (const char*) aArray, aCount * sizeof( T ) );
+}
+
+
+static bool readU32( std::istream& aFile, uint32_t& aValue )
+{
+    aFile.read( (char*) &aValue, sizeof( aValue ) );
+    return aFile.good();
+}
+
+
+// allocates aArray with new[], as FREE_SMESH() expects, and reads it; aFileSize
+// guards against allocating the counts of a corrupt file
+template <class T>
+static bool readArray( std::istream& aFile, std::streamoff aFileSize, T*& aArray,
+                       size_t aCount )
+{
+    if( (double) aCount * sizeof( T ) > (double) ( aFileSize - aFile.tellg() ) )
+        return false;
+
+    aArray = new T[aCount];
+    aFile.read( (char*) aArray, aCount * sizeof( T ) );
+    return aFile.good();
+}
+
+
+bool S3D::WriteModelCache( const char* aFileName, const S3DMODEL* aModel,
+    const char* aPluginInfo )
+{
+    if( NULL == aFileName || aFileName[0] == 0 || NULL == aModel )
+        return false;
+
+    OPEN_OSTREAM( output, aFileName );
+
+    if( output.fail() )
+    {
+        wxString errmsg;
+        errmsg << __FILE__ << ": " << __FUNCTION__ << ": " << __LINE__ << "\n";
+        errmsg << " * [INFO] " << "failed to open file" << " '" << aFileName << "'";
+        wxLogTrace( MASK_3D_SG, errmsg );
+        return false;
+    }
+
+    std::string pluginInfo = ( NULL != aPluginInfo && aPluginInfo[0] != 0 ) ?
+                             aPluginInfo : "INTERNAL:0.0.0.0";
+
+    output.write( MODEL_CACHE_MAGIC, sizeof( MODEL_CACHE_MAGIC ) );
+    writeU32( output, MODEL_CACHE_VERSION );
+    writeU32( output, MODEL_CACHE_BYTE_ORDER );
+    writeU32( output, sizeof( SMATERIAL ) );
+    writeU32( output, MODEL_CACHE_LAYOUT );
+
+    writeU32( output, pluginInfo.size() );
+    pluginInfo.resize( ( pluginInfo.size() + 3 ) & ~3, 0 );
+    output.write( pluginInfo.data(), pluginInfo.size() );
+
+    writeU32( output, aModel->m_MaterialsSize );
+    writeArray( output, aModel->m_Materials, aModel->m_MaterialsSize );
+
+    writeU32( output, aModel->m_MeshesSize );
+
+    for( unsigned int i = 0; i < aModel->m_MeshesSize; ++i )
+    {
+        const SMESH& mesh = aModel->m_Meshes[i];
+        uint32_t flags = ( mesh.m_Normals ? MODEL_CACHE_NORMALS : 0 )
+                         | ( mesh.m_Texcoords ? MODEL_CACHE_TEXCOORDS : 0 )
+                         | ( mesh.m_Color ? MODEL_CACHE_COLORS : 0 );
+
+        writeU32( output, mesh.m_VertexSize );
+        writeU32( output, mesh.m_FaceIdxSize );
+        writeU32( output, mesh.m_MaterialIdx );
+        writeU32( output, flags );
+
+        writeArray( output, mesh.m_Positions, mesh.m_VertexSize );
+
+        if( flags & MODEL_CACHE_NORMALS )
+            writeArray( output, mesh.m_Normals, mesh.m_VertexSize );
+
+        if( flags & MODEL_CACHE_TEXCOORDS )
+            writeArray( output, mesh.m_Texcoords, mesh.m_VertexSize );
+
+        if( flags & MODEL_CACHE_COLORS )
+            writeArray( output, mesh.m_Color, mesh.m_VertexSize );
+
+        writeArray( output, mesh.m_FaceIdx, mesh.m_FaceIdxSize );
+    }
+
+    bool rval = output.good();
+    CLOSE_STREAM( output );
+
+    if( !rval )
+    {
+        wxLogTrace( MASK_3D_SG, " * [INFO] problems encountered writing cache file '%s'",
+                    aFileName );
+
+        // delete the defective file
+        wxRemoveFile( wxString::FromUTF8Unchecked( aFileName ) );
+    }
+
+    return rval;
+}
+
+
+S3DMODEL* S3D::ReadModelCache( const char* aFileName, void* aPluginMgr,
+    bool (*aTagCheck)( const char*, void* ), std::string& aPluginInfo )
+{
+    if( NULL == aFileName || aFileName[0] == 0 )
+        return NULL;
+
+    OPEN_ISTREAM( file, aFileName );
+
+    if( file.fail() )
+        return NULL;
+
+    file.seekg( 0, std::ios_base::end );
+    std::streamoff fileSize = file.tellg();
+    file.seekg( 0, std::ios_base::beg );
+
+    char     magic[sizeof( MODEL_CACHE_MAGIC )];
+    uint32_t version, byteOrder, materialSize, layout, infoSize;
+
+    file.read( magic, sizeof( magic ) );
+
+    if( !file.good() || memcmp( magic, MODEL_CACHE_MAGIC, sizeof( magic ) )
+        || !readU32( file, version ) || version != MODEL_CACHE_VERSION
+        || !readU32( file, byteOrder ) || byteOrder != MODEL_CACHE_BYTE_ORDER
+        || !readU32( file, materialSize ) || materialSize != sizeof( SMATERIAL )
+        || !readU32( file, layout ) || layout != MODEL_CACHE_LAYOUT
+        || !readU32( file, infoSize ) || infoSize > 1024 )
+    {
+        CLOSE_STREAM( file );
+        return NULL;
+    }
+
+    std::string pluginInfo( ( infoSize + 3 ) & ~3, 0 );
+    file.read( &pluginInfo[0], pluginInfo.size() );
+    pluginInfo.resize( infoSize );
+
+    // check the plugin tag
+    if( !file.good()
+        || ( NULL != aTagCheck && NULL != aPluginMgr
+             && !aTagCheck( pluginInfo.c_str(), aPluginMgr ) ) )
+    {
+        CLOSE_STREAM( file );
+        return NULL;
+    }
+
+    S3DMODEL* model = S3D::New3DModel();
+    bool      rval = readU32( file, model->m_MaterialsSize )
+                     && readArray( file, fileSize, model->m_Materials, model->m_MaterialsSize )
+                     && readU32( file, model->m_MeshesSize )
+                     && model->m_MeshesSize <= ( fileSize - file.tellg() ) / 16;
+
+    if( rval )
+    {
+        model->m_Meshes = new SMESH[model->m_MeshesSize];
+
+        for( unsigned int i = 0; i < model->m_MeshesSize; ++i )
+            S3D::Init3DMesh( model->m_Meshes[i] );
+    }
+
+    for( unsigned int i = 0; rval && i < model->m_MeshesSize; ++i )
+    {
+        SMESH&   mesh = model->m_Meshes[i];
+        uint32_t flags;
+
+        rval = readU32( file, mesh.m_VertexSize ) && readU32( file, mesh.m_FaceIdxSize )
+               && readU32( file, mesh.m_MaterialIdx ) && readU32( file, flags )
+               && mesh.m_MaterialIdx < model->m_MaterialsSize
+               && readArray( file, fileSize, mesh.m_Positions, mesh.m_VertexSize );
+
+        if( rval && ( flags & MODEL_CACHE_NORMALS ) )
+            rval = readArray( file, fileSize, mesh.m_Normals, mesh.m_VertexSize );
+
+        if( rval && ( flags & MODEL_CACHE_TEXCOORDS ) )
+            rval = readArray( file, fileSize, mesh.m_Texcoords, mesh.m_VertexSize );
+
+        if( rval && ( flags & MODEL_CACHE_COLORS ) )
+            rval = readArray( file, fileSize, mesh.m_Color, mesh.m_VertexSize );
+
+        rval = rval && readArray( file, fileSize, mesh.m_FaceIdx, mesh.m_FaceIdxSize );
+
+        for( unsigned int j = 0; rval && j < mesh.m_FaceIdxSize; ++j )
+            rval = mesh.m_FaceIdx[j] < mesh.m_VertexSize;
+    }
+
+    CLOSE_STREAM( file );
+
+    if( !rval )
+    {
+        wxLogTrace( MASK_3D_SG, " * [INFO] problems encountered reading cache file '%s'",
+                    aFileName );
+
+        S3D::Destroy3DModel( &model );
+        return NULL;
+    }
+
+    aPluginInfo = pluginInfo;
+    return model;
+}
+
+
 S3DMODEL* S3D::GetModel( SCENEGRAPH* aNode )
 {
     if( NULL == aNode )
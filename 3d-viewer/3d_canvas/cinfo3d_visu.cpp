@@ -65,6 +65,10 @@ CINFO3D_VISU::CINFO3D_VISU() :
     m_boardSize = wxSize();
     m_boardCenter = SFVEC3F( 0.0f );
 
+    m_dirtyAll = true;
+    m_layers_render_engine = m_render_engine;
+    m_buildCount = 0;
+
     m_boardBoudingBox.Reset();
     m_board2dBBox3DU.Reset();
 
@@ -92,6 +96,7 @@ CINFO3D_VISU::CINFO3D_VISU() :
 
     memset( m_layerZcoordTop, 0, sizeof( m_layerZcoordTop ) );
     memset( m_layerZcoordBottom, 0, sizeof( m_layerZcoordBottom ) );
+    memset( m_layerBuildId, 0, sizeof( m_layerBuildId ) );
 
     SetFlag( FL_USE_REALISTIC_MODE, true );
     SetFlag( FL_MODULE_ATTRIBUTES_NORMAL, true );
@@ -285,6 +290,11 @@ void CINFO3D_VISU::InitSettings( REPORTER *aStatusTextReporter )
     if( ( bbbox.GetWidth() == 0 ) && ( bbbox.GetHeight() == 0 ) )
         bbbox.Inflate( Millimeter2iu( 10 ) );
 
+    const wxSize       prevBoardSize = m_boardSize;
+    const wxPoint      prevBoardPos = m_boardPos;
+    const unsigned int prevCopperLayersCount = m_copperLayersCount;
+    const float        prevEpoxyThickness3DU = m_epoxyThickness3DU;
+
     m_boardSize = bbbox.GetSize();
     m_boardPos  = bbbox.Centre();
 
@@ -418,14 +428,36 @@ void CINFO3D_VISU::InitSettings( REPORTER *aStatusTextReporter )
 
     m_boardBoudingBox = CBBOX( boardMin, boardMax );
 
+    // Only the dirty layers are rebuilt if the board outline, its scale and the
+    // layer stack are the same of the previous build
+    const bool rebuildAll = m_dirtyAll ||
+                            m_dirtyLayers[Edge_Cuts] ||
+                            ( m_layers_render_engine != m_render_engine ) ||
+                            ( prevBoardSize != m_boardSize ) ||
+                            ( prevBoardPos != m_boardPos ) ||
+                            ( prevCopperLayersCount != m_copperLayersCount ) ||
+                            ( prevEpoxyThickness3DU != m_epoxyThickness3DU );
+
+    m_rebuildLayers = rebuildAll ? LSET::AllLayersMask() : m_dirtyLayers;
+
+    m_dirtyLayers.reset();
+    m_dirtyAll = false;
+    m_layers_render_engine = m_render_engine;
+
+    wxLogTrace( m_logTrace, wxT( "CINFO3D_VISU::InitSettings rebuild %s" ),
+                rebuildAll ? wxT( "all" ) : wxT( "dirty layers" ) );
+
 #ifdef PRINT_STATISTICS_3D_VIEWER
     unsigned stats_startCreateBoardPolyTime = GetRunningMicroSecs();
 #endif
 
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Build board body" ) );
+    if( rebuildAll )
+    {
+        if( aStatusTextReporter )
+            aStatusTextReporter->Report( _( "Build board body" ) );
 
-    createBoardPolygon();
+        createBoardPolygon();
+    }
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
     unsigned stats_stopCreateBoardPolyTime = GetRunningMicroSecs();
@@ -119,7 +119,13 @@ class CINFO3D_VISU
      * @brief SetBoard - Set current board to be rendered
      * @param aBoard: board to process
      */
-    void SetBoard( BOARD *aBoard ) { m_board = aBoard; }
+    void SetBoard( BOARD *aBoard )
+    {
+        if( aBoard != m_board )
+            m_dirtyAll = true;
+
+        m_board = aBoard;
+    }
 
     /**
      * @brief GetBoard - Get current board to be rendered
@@ -134,6 +140,31 @@ class CINFO3D_VISU
      */
     void InitSettings( REPORTER *aStatusTextReporter );
 
+    /**
+     * @brief SetLayersDirty - Mark the layers whose board items were changed, so
+     * the next InitSettings rebuilds only these layers when the rest of the board
+     * is unchanged
+     * @param aLayers: the changed layers
+     */
+    void SetLayersDirty( const LSET &aLayers ) { m_dirtyLayers |= aLayers; }
+
+    /**
+     * @brief SetAllLayersDirty - Request the next InitSettings to rebuild all the
+     * board data
+     */
+    void SetAllLayersDirty() { m_dirtyAll = true; }
+
+    /**
+     * @brief GetLayerBuildId - Get the identifier of the current data of a layer
+     * @param aLayerId: layer id
+     * @return a number which changes each time InitSettings rebuilds the layer, so
+     * the renders can keep the objects they made from the unchanged layers
+     */
+    unsigned int GetLayerBuildId( PCB_LAYER_ID aLayerId ) const
+    {
+        return m_layerBuildId[aLayerId];
+    }
+
     /**
      * @brief BiuTo3Dunits - Board integer units To 3D units
      * @return the conversion factor to transform a position from the board to 3d units
@@ -420,7 +451,14 @@ class CINFO3D_VISU
  private:
     void createBoardPolygon();
     void createLayers( REPORTER *aStatusTextReporter );
-    void destroyLayers();
+    void destroyLayers( const LSET &aLayers = LSET::AllLayersMask() );
+
+    // The board items of a layer, gathered by createLayers() for the layer builders below
+    struct LAYER_ITEMS;
+
+    // Build the objects and polygons of one layer; the layers are built concurrently
+    void createCopperLayer( PCB_LAYER_ID aLayerId, const LAYER_ITEMS& aItems );
+    void createTechLayer( PCB_LAYER_ID aLayerId, const LAYER_ITEMS& aItems );
 
     // Helper functions to create the board
     COBJECT2D *createNewTrack( const TRACK* aTrack , int aClearanceValue ) const;
@@ -581,6 +619,27 @@ class CINFO3D_VISU
     SHAPE_POLY_SET    m_board_poly;
 
 
+    // Incremental rebuild
+
+    /// Layers changed since the last InitSettings
+    LSET              m_dirtyLayers;
+
+    /// All the board data must be rebuilt by the next InitSettings
+    bool              m_dirtyAll;
+
+    /// Render engine for which the layers were built
+    RENDER_ENGINE     m_layers_render_engine;
+
+    /// Layers which are rebuilt by the current InitSettings
+    LSET              m_rebuildLayers;
+
+    /// Number of times the layers were built, used to make the layer build ids
+    unsigned int      m_buildCount;
+
+    /// Build id of each layer, see GetLayerBuildId
+    unsigned int      m_layerBuildId[PCB_LAYER_ID_COUNT];
+
+
     // 2D element containers
 
     /// It contains the 2d elements of each layer
@@ -55,76 +55,38 @@
 #include <thread>
 #include <algorithm>
 #include <atomic>
+#include <future>
 
 #include <profile.h>
 
-void CINFO3D_VISU::destroyLayers()
+// Delete the entries of the given layers from a map of layer objects
+template<class MAP>
+static void destroyMapLayers( MAP &aMap, const LSET &aLayers )
 {
-    if( !m_layers_poly.empty() )
+    for( typename MAP::iterator ii = aMap.begin(); ii != aMap.end(); )
     {
-        for( MAP_POLY::iterator ii = m_layers_poly.begin();
-             ii != m_layers_poly.end();
-             ++ii )
-        {
-            delete ii->second;
-            ii->second = NULL;
-        }
-
-        m_layers_poly.clear();
-    }
-
-    if( !m_layers_inner_holes_poly.empty() )
-    {
-        for( MAP_POLY::iterator ii = m_layers_inner_holes_poly.begin();
-             ii != m_layers_inner_holes_poly.end();
-             ++ii )
-        {
-            delete ii->second;
-            ii->second = NULL;
-        }
-
-        m_layers_inner_holes_poly.clear();
-    }
-
-    if( !m_layers_outer_holes_poly.empty() )
-    {
-        for( MAP_POLY::iterator ii = m_layers_outer_holes_poly.begin();
-             ii != m_layers_outer_holes_poly.end();
-             ++ii )
+        if( aLayers[ii->first] )
         {
             delete ii->second;
-            ii->second = NULL;
+            ii = aMap.erase( ii );
         }
-
-        m_layers_outer_holes_poly.clear();
-    }
-
-    if( !m_layers_container2D.empty() )
-    {
-        for( MAP_CONTAINER_2D::iterator ii = m_layers_container2D.begin();
-             ii != m_layers_container2D.end();
-             ++ii )
+        else
         {
-            delete ii->second;
-            ii->second = NULL;
+            ++ii;
         }
-
-        m_layers_container2D.clear();
     }
+}
 
-    if( !m_layers_holes2D.empty() )
-    {
-        for( MAP_CONTAINER_2D::iterator ii = m_layers_holes2D.begin();
-             ii != m_layers_holes2D.end();
-             ++ii )
-        {
-            delete ii->second;
-            ii->second = NULL;
-        }
 
-        m_layers_holes2D.clear();
-    }
+void CINFO3D_VISU::destroyLayers( const LSET &aLayers )
+{
+    destroyMapLayers( m_layers_poly, aLayers );
+    destroyMapLayers( m_layers_inner_holes_poly, aLayers );
+    destroyMapLayers( m_layers_outer_holes_poly, aLayers );
+    destroyMapLayers( m_layers_container2D, aLayers );
+    destroyMapLayers( m_layers_holes2D, aLayers );
 
+    // The through holes are shared by all the layers and are always rebuilt
     m_through_holes_inner.Clear();
     m_through_holes_outer.Clear();
     m_through_holes_vias_outer.Clear();
@@ -138,29 +100,54 @@ void CINFO3D_VISU::destroyLayers()
 }
 
 
+struct CINFO3D_VISU::LAYER_ITEMS
+{
+    std::vector<const TRACK*>          m_tracks;
+    std::vector<const MODULE*>         m_modules;
+    std::vector<const BOARD_ITEM*>     m_drawings;
+    std::vector<const ZONE_CONTAINER*> m_zones;
+};
+
+
+// The layers where the pads and graphic items of a module can add objects
+static LSET moduleLayers( const MODULE* aModule )
+{
+    LSET layers;
+
+    for( const D_PAD* pad = aModule->PadsList(); pad; pad = pad->Next() )
+        layers |= pad->GetLayerSet();
+
+    for( const BOARD_ITEM* item = aModule->GraphicalItemsList(); item; item = item->Next() )
+        layers |= item->GetLayerSet();
+
+    layers.set( aModule->Reference().GetLayer() );
+    layers.set( aModule->Value().GetLayer() );
+
+    return layers;
+}
+
+
 void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
 {
-    // Number of segments to draw a circle using segments (used on countour zones
-    // and text copper elements )
-    const int    segcountforcircle = 12;
-    const double correctionFactor  = GetCircleCorrectionFactor( segcountforcircle );
+    // Keep the objects of the layers which were not changed
+    destroyLayers( m_rebuildLayers );
 
-    // segments to draw a circle to build texts. Is is used only to build
-    // the shape of each segment of the stroke font, therefore no need to have
-    // many segments per circle.
-    const int segcountInStrokeFont  = 12;
-    const double correctionFactorStroke = GetCircleCorrectionFactor( segcountInStrokeFont );
+    ++m_buildCount;
 
-    destroyLayers();
+    for( int layer = 0; layer < PCB_LAYER_ID_COUNT; ++layer )
+    {
+        if( m_rebuildLayers[layer] )
+            m_layerBuildId[layer] = m_buildCount;
+    }
 
     // Build Copper layers
     // Based on: https://github.com/KiCad/kicad-source-mirror/blob/master/3d-viewer/3d_draw.cpp#L692
     // /////////////////////////////////////////////////////////////////////////
 
-    #ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_startCopperLayersTime = GetRunningMicroSecs();
+#ifdef PRINT_STATISTICS_3D_VIEWER
+    unsigned stats_startLayersTime = GetRunningMicroSecs();
 
-    unsigned start_Time = stats_startCopperLayersTime;
+    unsigned start_Time = stats_startLayersTime;
 #endif
 
     PCB_LAYER_ID cu_seq[MAX_CU_LAYERS];
@@ -173,52 +160,13 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
     m_stats_nr_holes                = 0;
     m_stats_hole_med_diameter       = 0;
 
-    // Prepare track list, convert in a vector. Calc statistic for the holes
-    // /////////////////////////////////////////////////////////////////////////
-    std::vector< const TRACK *> trackList;
-    trackList.clear();
-    trackList.reserve( m_board->m_Track.GetCount() );
-
-    for( const TRACK* track = m_board->m_Track; track; track = track->Next() )
-    {
-        if( !Is3DLayerEnabled( track->GetLayer() ) ) // Skip non enabled layers
-            continue;
-
-        // Note: a TRACK holds normal segment tracks and
-        // also vias circles (that have also drill values)
-        trackList.push_back( track );
-
-        if( track->Type() == PCB_VIA_T )
-        {
-            const VIA *via = static_cast< const VIA*>( track );
-            m_stats_nr_vias++;
-            m_stats_via_med_hole_diameter += via->GetDrillValue() * m_biuTo3Dunits;
-        }
-        else
-        {
-            m_stats_nr_tracks++;
-        }
-
-        m_stats_track_med_width += track->GetWidth() * m_biuTo3Dunits;
-    }
-
-    if( m_stats_nr_tracks )
-        m_stats_track_med_width /= (float)m_stats_nr_tracks;
-
-    if( m_stats_nr_vias )
-        m_stats_via_med_hole_diameter /= (float)m_stats_nr_vias;
-
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T01: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
     // Prepare copper layers index and containers
     // /////////////////////////////////////////////////////////////////////////
     std::vector< PCB_LAYER_ID > layer_id;
-    layer_id.clear();
     layer_id.reserve( m_copperLayersCount );
 
+    LSET cu_layers;
+
     for( unsigned i = 0; i < arrayDim( cu_seq ); ++i )
         cu_seq[i] = ToLAYER_ID( B_Cu - i );
 
@@ -229,8 +177,16 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
         if( !Is3DLayerEnabled( curr_layer_id ) ) // Skip non enabled layers
             continue;
 
+        cu_layers.set( curr_layer_id );
+
+        if( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() )
+            continue;   // Unchanged layer
+
         layer_id.push_back( curr_layer_id );
 
+        m_rebuildLayers.set( curr_layer_id );
+        m_layerBuildId[curr_layer_id] = m_buildCount;
+
         CBVHCONTAINER2D *layerContainer = new CBVHCONTAINER2D;
         m_layers_container2D[curr_layer_id] = layerContainer;
 
@@ -242,281 +198,185 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T02: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Create tracks and vias" ) );
-
-    // Create tracks as objects and add it to container
+    // Prepare tech layers containers
+    // Based on: https://github.com/KiCad/kicad-source-mirror/blob/master/3d-viewer/3d_draw.cpp#L1059
     // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
-    {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
 
-        wxASSERT( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() );
+    // draw graphic items, on technical layers
+    static const PCB_LAYER_ID teckLayerList[] = {
+            B_Adhes,
+            F_Adhes,
+            B_Paste,
+            F_Paste,
+            B_SilkS,
+            F_SilkS,
+            B_Mask,
+            F_Mask,
 
-        CBVHCONTAINER2D *layerContainer = m_layers_container2D[curr_layer_id];
+            // Aux Layers
+            Dwgs_User,
+            Cmts_User,
+            Eco1_User,
+            Eco2_User,
+            Edge_Cuts,
+            Margin
+        };
 
-        // ADD TRACKS
-        unsigned int nTracks = trackList.size();
+    LSET all_layers = cu_layers;
 
-        for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
-        {
-            const TRACK *track = trackList[trackIdx];
+    // User layers are not drawn here, only technical layers
+    std::vector< PCB_LAYER_ID > tech_layer_id;
 
-            // NOTE: Vias can be on multiple layers
-            if( !track->IsOnLayer( curr_layer_id ) )
-                continue;
+    for( LSEQ seq = LSET::AllNonCuMask().Seq( teckLayerList, arrayDim( teckLayerList ) );
+         seq;
+         ++seq )
+    {
+        const PCB_LAYER_ID curr_layer_id = *seq;
 
-            // Add object item to layer container
-            layerContainer->Add( createNewTrack( track, 0.0f ) );
-        }
-    }
+        if( !Is3DLayerEnabled( curr_layer_id ) )
+            continue;
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T03: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+        all_layers.set( curr_layer_id );
 
-    // Create VIAS and THTs objects and add it to holes containers
-    // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
-    {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+        if( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() )
+            continue;   // Unchanged layer
 
-        // ADD TRACKS
-        unsigned int nTracks = trackList.size();
+        tech_layer_id.push_back( curr_layer_id );
 
-        for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
-        {
-            const TRACK *track = trackList[trackIdx];
+        m_rebuildLayers.set( curr_layer_id );
+        m_layerBuildId[curr_layer_id] = m_buildCount;
 
-            if( !track->IsOnLayer( curr_layer_id ) )
-                continue;
+        CBVHCONTAINER2D *layerContainer = new CBVHCONTAINER2D;
+        m_layers_container2D[curr_layer_id] = layerContainer;
 
-            // ADD VIAS and THT
-            if( track->Type() == PCB_VIA_T )
-            {
-                const VIA *via = static_cast< const VIA*>( track );
-                const VIATYPE_T viatype = via->GetViaType();
-                const float holediameter = via->GetDrillValue() * BiuTo3Dunits();
-                const float thickness = GetCopperThickness3DU();
-                const float hole_inner_radius = ( holediameter / 2.0f );
-
-                const SFVEC2F via_center(  via->GetStart().x * m_biuTo3Dunits,
-                                          -via->GetStart().y * m_biuTo3Dunits );
-
-                if( viatype != VIA_THROUGH )
-                {
-
-                    // Add hole objects
-                    // /////////////////////////////////////////////////////////
-
-                    CBVHCONTAINER2D *layerHoleContainer = NULL;
-
-                    // Check if the layer is already created
-                    if( m_layers_holes2D.find( curr_layer_id ) == m_layers_holes2D.end() )
-                    {
-                        // not found, create a new container
-                        layerHoleContainer = new CBVHCONTAINER2D;
-                        m_layers_holes2D[curr_layer_id] = layerHoleContainer;
-                    }
-                    else
-                    {
-                        // found
-                        layerHoleContainer = m_layers_holes2D[curr_layer_id];
-                    }
-
-                    // Add a hole for this layer
-                    layerHoleContainer->Add( new CFILLEDCIRCLE2D( via_center,
-                                                                  hole_inner_radius + thickness,
-                                                                  *track ) );
-                }
-                else if( lIdx == 0 ) // it only adds once the THT holes
-                {
-                    // Add through hole object
-                    // /////////////////////////////////////////////////////////
-                    m_through_holes_outer.Add( new CFILLEDCIRCLE2D( via_center,
-                                                                    hole_inner_radius + thickness,
-                                                                    *track ) );
-
-                    m_through_holes_vias_outer.Add(
-                                new CFILLEDCIRCLE2D( via_center,
-                                                     hole_inner_radius + thickness,
-                                                     *track ) );
-
-                    m_through_holes_inner.Add( new CFILLEDCIRCLE2D( via_center,
-                                                                    hole_inner_radius,
-                                                                    *track ) );
-
-                    //m_through_holes_vias_inner.Add( new CFILLEDCIRCLE2D( via_center,
-                    //                                                     hole_inner_radius,
-                    //                                                     *track ) );
-                }
-            }
-        }
+        SHAPE_POLY_SET *layerPoly = new SHAPE_POLY_SET;
+        m_layers_poly[curr_layer_id] = layerPoly;
     }
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T04: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
+    printf( "T01: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
     start_Time = GetRunningMicroSecs();
 #endif
 
-    // Create VIAS and THTs objects and add it to holes containers
+    if( aStatusTextReporter )
+        aStatusTextReporter->Report( _( "Create tracks and vias" ) );
+
+    // Sort the board items by layer, scanning each list once. The through holes are
+    // shared by all the layers and are added here
     // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+    std::vector< LAYER_ITEMS > layerItems( PCB_LAYER_ID_COUNT );
+
+    for( const TRACK* track = m_board->m_Track; track; track = track->Next() )
     {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+        if( !Is3DLayerEnabled( track->GetLayer() ) ) // Skip non enabled layers
+            continue;
 
-        // ADD TRACKS
-        const unsigned int nTracks = trackList.size();
+        // Note: a TRACK holds normal segment tracks and
+        // also vias circles (that have also drill values)
+        // NOTE: Vias can be on multiple layers
+        const LSET layers = track->GetLayerSet() & cu_layers;
 
-        for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
-        {
-            const TRACK *track = trackList[trackIdx];
+        for( LSEQ seq = layers.Seq(); seq; ++seq )
+            layerItems[*seq].m_tracks.push_back( track );
 
-            if( !track->IsOnLayer( curr_layer_id ) )
-                continue;
+        m_stats_track_med_width += track->GetWidth() * m_biuTo3Dunits;
 
-            // ADD VIAS and THT
-            if( track->Type() == PCB_VIA_T )
-            {
-                const VIA *via = static_cast< const VIA*>( track );
-                const VIATYPE_T viatype = via->GetViaType();
-
-                if( viatype != VIA_THROUGH )
-                {
-
-                    // Add VIA hole contourns
-                    // /////////////////////////////////////////////////////////
-
-                    // Add outter holes of VIAs
-                    SHAPE_POLY_SET *layerOuterHolesPoly = NULL;
-                    SHAPE_POLY_SET *layerInnerHolesPoly = NULL;
-
-                    // Check if the layer is already created
-                    if( m_layers_outer_holes_poly.find( curr_layer_id ) ==
-                        m_layers_outer_holes_poly.end() )
-                    {
-                        // not found, create a new container
-                        layerOuterHolesPoly = new SHAPE_POLY_SET;
-                        m_layers_outer_holes_poly[curr_layer_id] = layerOuterHolesPoly;
-
-                        wxASSERT( m_layers_inner_holes_poly.find( curr_layer_id ) ==
-                                  m_layers_inner_holes_poly.end() );
-
-                        layerInnerHolesPoly = new SHAPE_POLY_SET;
-                        m_layers_inner_holes_poly[curr_layer_id] = layerInnerHolesPoly;
-                    }
-                    else
-                    {
-                        // found
-                        layerOuterHolesPoly = m_layers_outer_holes_poly[curr_layer_id];
-
-                        wxASSERT( m_layers_inner_holes_poly.find( curr_layer_id ) !=
-                                  m_layers_inner_holes_poly.end() );
-
-                        layerInnerHolesPoly = m_layers_inner_holes_poly[curr_layer_id];
-                    }
-
-                    const int holediameter = via->GetDrillValue();
-                    const int hole_outer_radius = (holediameter / 2) + GetCopperThicknessBIU();
-
-                    TransformCircleToPolygon( *layerOuterHolesPoly,
-                                              via->GetStart(),
-                                              hole_outer_radius,
-                                              GetNrSegmentsCircle( hole_outer_radius * 2 ) );
-
-                    TransformCircleToPolygon( *layerInnerHolesPoly,
-                                              via->GetStart(),
-                                              holediameter / 2,
-                                              GetNrSegmentsCircle( holediameter ) );
-                }
-                else if( lIdx == 0 ) // it only adds once the THT holes
-                {
-                    const int holediameter = via->GetDrillValue();
-                    const int hole_outer_radius = (holediameter / 2)+ GetCopperThicknessBIU();
-
-                    // Add through hole contourns
-                    // /////////////////////////////////////////////////////////
-                    TransformCircleToPolygon( m_through_outer_holes_poly,
-                                              via->GetStart(),
-                                              hole_outer_radius,
-                                              GetNrSegmentsCircle( hole_outer_radius * 2 ) );
-
-                    TransformCircleToPolygon( m_through_inner_holes_poly,
-                                              via->GetStart(),
-                                              holediameter / 2,
-                                              GetNrSegmentsCircle( holediameter ) );
-
-                    // Add samething for vias only
-
-                    TransformCircleToPolygon( m_through_outer_holes_vias_poly,
-                                              via->GetStart(),
-                                              hole_outer_radius,
-                                              GetNrSegmentsCircle( hole_outer_radius * 2 ) );
-
-                    //TransformCircleToPolygon( m_through_inner_holes_vias_poly,
-                    //                          via->GetStart(),
-                    //                          holediameter / 2,
-                    //                          GetNrSegmentsCircle( holediameter ) );
-                }
-            }
+        if( track->Type() != PCB_VIA_T )
+        {
+            m_stats_nr_tracks++;
+            continue;
         }
-    }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T05: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+        const VIA *via = static_cast< const VIA*>( track );
+        m_stats_nr_vias++;
+        m_stats_via_med_hole_diameter += via->GetDrillValue() * m_biuTo3Dunits;
 
-    // Creates outline contours of the tracks and add it to the poly of the layer
-    // /////////////////////////////////////////////////////////////////////////
-    if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
-    {
-        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+        if( via->GetViaType() != VIA_THROUGH )
         {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-            wxASSERT( m_layers_poly.find( curr_layer_id ) != m_layers_poly.end() );
-
-            SHAPE_POLY_SET *layerPoly = m_layers_poly[curr_layer_id];
-
-            // ADD TRACKS
-            unsigned int nTracks = trackList.size();
-
-            for( unsigned int trackIdx = 0; trackIdx < nTracks; ++trackIdx )
+            // Create the hole containers of the layers of the blind and buried vias,
+            // which are filled by the layer builders
+            for( LSEQ seq = layers.Seq(); seq; ++seq )
             {
-                const TRACK *track = trackList[trackIdx];
+                const PCB_LAYER_ID curr_layer_id = *seq;
 
-                if( !track->IsOnLayer( curr_layer_id ) )
+                if( m_layers_holes2D.find( curr_layer_id ) != m_layers_holes2D.end() )
                     continue;
 
-                // Add the track contour
-                int nrSegments = GetNrSegmentsCircle( track->GetWidth() );
-
-                track->TransformShapeWithClearanceToPolygon(
-                            *layerPoly,
-                            0,
-                            nrSegments,
-                            GetCircleCorrectionFactor( nrSegments ) );
+                m_layers_holes2D[curr_layer_id] = new CBVHCONTAINER2D;
+                m_layers_outer_holes_poly[curr_layer_id] = new SHAPE_POLY_SET;
+                m_layers_inner_holes_poly[curr_layer_id] = new SHAPE_POLY_SET;
             }
         }
+        else if( layers.any() )
+        {
+            const float holediameter = via->GetDrillValue() * BiuTo3Dunits();
+            const float thickness = GetCopperThickness3DU();
+            const float hole_inner_radius = ( holediameter / 2.0f );
+
+            const SFVEC2F via_center(  via->GetStart().x * m_biuTo3Dunits,
+                                      -via->GetStart().y * m_biuTo3Dunits );
+
+            // Add through hole object
+            // /////////////////////////////////////////////////////////////////
+            m_through_holes_outer.Add( new CFILLEDCIRCLE2D( via_center,
+                                                            hole_inner_radius + thickness,
+                                                            *track ) );
+
+            m_through_holes_vias_outer.Add(
+                        new CFILLEDCIRCLE2D( via_center,
+                                             hole_inner_radius + thickness,
+                                             *track ) );
+
+            m_through_holes_inner.Add( new CFILLEDCIRCLE2D( via_center,
+                                                            hole_inner_radius,
+                                                            *track ) );
+
+            //m_through_holes_vias_inner.Add( new CFILLEDCIRCLE2D( via_center,
+            //                                                     hole_inner_radius,
+            //                                                     *track ) );
+
+            const int holediameterBIU = via->GetDrillValue();
+            const int hole_outer_radius = (holediameterBIU / 2) + GetCopperThicknessBIU();
+
+            // Add through hole contourns
+            // /////////////////////////////////////////////////////////////////
+            TransformCircleToPolygon( m_through_outer_holes_poly,
+                                      via->GetStart(),
+                                      hole_outer_radius,
+                                      GetNrSegmentsCircle( hole_outer_radius * 2 ) );
+
+            TransformCircleToPolygon( m_through_inner_holes_poly,
+                                      via->GetStart(),
+                                      holediameterBIU / 2,
+                                      GetNrSegmentsCircle( holediameterBIU ) );
+
+            // Add samething for vias only
+
+            TransformCircleToPolygon( m_through_outer_holes_vias_poly,
+                                      via->GetStart(),
+                                      hole_outer_radius,
+                                      GetNrSegmentsCircle( hole_outer_radius * 2 ) );
+
+            //TransformCircleToPolygon( m_through_inner_holes_vias_poly,
+            //                          via->GetStart(),
+            //                          holediameterBIU / 2,
+            //                          GetNrSegmentsCircle( holediameterBIU ) );
+        }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T06: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+    if( m_stats_nr_tracks )
+        m_stats_track_med_width /= (float)m_stats_nr_tracks;
+
+    if( m_stats_nr_vias )
+        m_stats_via_med_hole_diameter /= (float)m_stats_nr_vias;
 
-    // Add holes of modules
+    // Add holes of modules and their contours (pads can be Circle or Segment holes)
     // /////////////////////////////////////////////////////////////////////////
     for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
     {
+        for( LSEQ seq = LSET( moduleLayers( module ) & all_layers ).Seq(); seq; ++seq )
+            layerItems[*seq].m_modules.push_back( module );
+
         const D_PAD* pad = module->PadsList();
 
         for( ; pad; pad = pad->Next() )
@@ -528,48 +388,22 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
 
             // The hole in the body is inflated by copper thickness,
             // if not plated, no copper
-            const int inflate = (pad->GetAttribute () != PAD_ATTRIB_HOLE_NOT_PLATED) ?
-                                GetCopperThicknessBIU() : 0;
+            const int inflate = GetCopperThicknessBIU();
+            const bool plated = pad->GetAttribute () != PAD_ATTRIB_HOLE_NOT_PLATED;
 
             m_stats_nr_holes++;
             m_stats_hole_med_diameter += ( ( pad->GetDrillSize().x +
                                              pad->GetDrillSize().y ) / 2.0f ) * m_biuTo3Dunits;
 
-            m_through_holes_outer.Add( createNewPadDrill( pad, inflate ) );
-            m_through_holes_inner.Add( createNewPadDrill( pad,       0 ) );
-        }
-    }
-    if( m_stats_nr_holes )
-        m_stats_hole_med_diameter /= (float)m_stats_nr_holes;
-
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T07: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    // Add contours of the pad holes (pads can be Circle or Segment holes)
-    // /////////////////////////////////////////////////////////////////////////
-    for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
-    {
-        const D_PAD* pad = module->PadsList();
-
-        for( ; pad; pad = pad->Next() )
-        {
-            const wxSize padHole = pad->GetDrillSize();
-
-            if( !padHole.x ) // Not drilled pad like SMD pad
-                continue;
-
-            // The hole in the body is inflated by copper thickness.
-            const int inflate = GetCopperThicknessBIU();
+            m_through_holes_outer.Add( createNewPadDrill( pad, plated ? inflate : 0 ) );
+            m_through_holes_inner.Add( createNewPadDrill( pad, 0 ) );
 
             // we use the hole diameter to calculate the seg count.
             // for round holes, padHole.x == padHole.y
             // for oblong holes, the diameter is the smaller of (padHole.x, padHole.y)
             const int diam = std::min( padHole.x, padHole.y );
 
-
-            if( pad->GetAttribute () != PAD_ATTRIB_HOLE_NOT_PLATED )
+            if( plated )
             {
                 pad->BuildPadDrillShapePolygon( m_through_outer_holes_poly,
                                                 inflate,
@@ -589,636 +423,459 @@ void CINFO3D_VISU::createLayers( REPORTER *aStatusTextReporter )
         }
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T08: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+    if( m_stats_nr_holes )
+        m_stats_hole_med_diameter /= (float)m_stats_nr_holes;
 
-    // Add modules PADs objects to containers
-    // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+    for( auto item : m_board->Drawings() )
     {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-        wxASSERT( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() );
-
-        CBVHCONTAINER2D *layerContainer = m_layers_container2D[curr_layer_id];
+        for( LSEQ seq = LSET( item->GetLayerSet() & all_layers ).Seq(); seq; ++seq )
+            layerItems[*seq].m_drawings.push_back( item );
+    }
 
-        // ADD PADS
-        for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
+    if( GetFlag( FL_ZONE ) )
+    {
+        for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
         {
-            // Note: NPTH pads are not drawn on copper layers when the pad
-            // has same shape as its hole
-            AddPadsShapesWithClearanceToContainer( module,
-                                                   layerContainer,
-                                                   curr_layer_id,
-                                                   0,
-                                                   true );
+            const ZONE_CONTAINER* zone = m_board->GetArea( ii );
 
-            // Micro-wave modules may have items on copper layers
-            AddGraphicsShapesWithClearanceToContainer( module,
-                                                       layerContainer,
-                                                       curr_layer_id,
-                                                       0 );
+            for( LSEQ seq = LSET( zone->GetLayerSet() & all_layers ).Seq(); seq; ++seq )
+                layerItems[*seq].m_zones.push_back( zone );
         }
     }
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T09: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
+    printf( "T02: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
     start_Time = GetRunningMicroSecs();
 #endif
 
-    // Add modules PADs poly contourns
+    if( aStatusTextReporter )
+        aStatusTextReporter->Report( _( "Build copper and tech layers" ) );
+
+    // Build the layers concurrently, starting with the copper layers which hold most of
+    // the items. The containers and maps were all created above: the threads only fill
+    // the containers of their own layer
     // /////////////////////////////////////////////////////////////////////////
-    if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
+    std::vector< PCB_LAYER_ID > layersToBuild( layer_id );
+    layersToBuild.insert( layersToBuild.end(), tech_layer_id.begin(), tech_layer_id.end() );
+
+    std::atomic<size_t> nextLayer( 0 );
+    size_t parallelThreadCount = std::min<size_t>(
+            std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
+            layersToBuild.size() );
+    std::vector<std::future<void>> returns( parallelThreadCount );
+
+    auto build_lambda = [&]()
     {
-        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+        for( size_t i = nextLayer++; i < layersToBuild.size(); i = nextLayer++ )
         {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+            const PCB_LAYER_ID curr_layer_id = layersToBuild[i];
 
-            wxASSERT( m_layers_poly.find( curr_layer_id ) != m_layers_poly.end() );
+            if( IsCopperLayer( curr_layer_id ) )
+                createCopperLayer( curr_layer_id, layerItems[curr_layer_id] );
+            else
+                createTechLayer( curr_layer_id, layerItems[curr_layer_id] );
+        }
+    };
 
-            SHAPE_POLY_SET *layerPoly = m_layers_poly[curr_layer_id];
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        returns[ii] = std::async( std::launch::async, build_lambda );
 
-            // ADD PADS
-            for( const MODULE* module = m_board->m_Modules; module; module = module->Next() )
-            {
-                // Construct polys
-                // /////////////////////////////////////////////////////////////
-
-                // Note: NPTH pads are not drawn on copper layers when the pad
-                // has same shape as its hole
-                transformPadsShapesWithClearanceToPolygon( module->PadsList(),
-                                                           curr_layer_id,
-                                                           *layerPoly,
-                                                           0,
-                                                           true );
-
-                // Micro-wave modules may have items on copper layers
-                module->TransformGraphicTextWithClearanceToPolygonSet( curr_layer_id,
-                                                                        *layerPoly,
-                                                                        0,
-                                                                        segcountforcircle,
-                                                                        correctionFactor );
-
-                transformGraphicModuleEdgeToPolygonSet( module, curr_layer_id, *layerPoly );
-            }
-        }
-    }
+    // This will make a union of all added contourns; done meanwhile, as no layer
+    // uses the through holes
+    m_through_inner_holes_poly.Simplify( SHAPE_POLY_SET::PM_FAST );
+    m_through_outer_holes_poly.Simplify( SHAPE_POLY_SET::PM_FAST );
+    m_through_outer_holes_poly_NPTH.Simplify( SHAPE_POLY_SET::PM_FAST );
+    m_through_outer_holes_vias_poly.Simplify( SHAPE_POLY_SET::PM_FAST );
+    //m_through_inner_holes_vias_poly.Simplify( SHAPE_POLY_SET::PM_FAST ); // Not in use
+
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        returns[ii].wait();
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T10: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
+    unsigned stats_endLayersTime = GetRunningMicroSecs();
 #endif
 
-    // Add graphic item on copper layers to object containers
+
+    // Build BVH for holes and vias
     // /////////////////////////////////////////////////////////////////////////
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
-    {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
 
-        wxASSERT( m_layers_container2D.find( curr_layer_id ) != m_layers_container2D.end() );
+#ifdef PRINT_STATISTICS_3D_VIEWER
+    unsigned stats_startHolesBVHTime = GetRunningMicroSecs();
+#endif
+    if( aStatusTextReporter )
+        aStatusTextReporter->Report( _( "Build BVH for holes and vias" ) );
 
-        CBVHCONTAINER2D *layerContainer = m_layers_container2D[curr_layer_id];
+    m_through_holes_inner.BuildBVH();
+    m_through_holes_outer.BuildBVH();
 
-        // ADD GRAPHIC ITEMS ON COPPER LAYERS (texts)
-        for( auto item : m_board->Drawings() )
+    if( !m_layers_holes2D.empty() )
+    {
+        for( MAP_CONTAINER_2D::iterator ii = m_layers_holes2D.begin();
+             ii != m_layers_holes2D.end();
+             ++ii )
         {
-            if( !item->IsOnLayer( curr_layer_id ) )
-                continue;
-
-            switch( item->Type() )
-            {
-            case PCB_LINE_T:
-            {
-                AddShapeWithClearanceToContainer( (DRAWSEGMENT*)item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-            }
-            break;
-
-            case PCB_TEXT_T:
-                AddShapeWithClearanceToContainer( (TEXTE_PCB*) item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-            break;
-
-            case PCB_DIMENSION_T:
-                AddShapeWithClearanceToContainer( (DIMENSION*) item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-            break;
-
-            default:
-                wxLogTrace( m_logTrace,
-                            wxT( "createLayers: item type: %d not implemented" ),
-                            item->Type() );
-            break;
-            }
+            if( m_rebuildLayers[ii->first] )
+                ((CBVHCONTAINER2D *)(ii->second))->BuildBVH();
         }
     }
 
+    // We only need the Solder mask to initialize the BVH
+    // because..?
+    if( m_rebuildLayers[B_Mask] && (CBVHCONTAINER2D *)m_layers_container2D[B_Mask] )
+        ((CBVHCONTAINER2D *)m_layers_container2D[B_Mask])->BuildBVH();
+
+    if( m_rebuildLayers[F_Mask] && (CBVHCONTAINER2D *)m_layers_container2D[F_Mask] )
+        ((CBVHCONTAINER2D *)m_layers_container2D[F_Mask])->BuildBVH();
+
 #ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T11: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+    unsigned stats_endHolesBVHTime = GetRunningMicroSecs();
 
-    // Add graphic item on copper layers to poly contourns
-    // /////////////////////////////////////////////////////////////////////////
-    if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
-    {
-        for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
-        {
-            const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
+    printf( "CINFO3D_VISU::createLayers times\n" );
+    printf( "  Copper and Tech Layers: %.3f ms\n",
+            (float)( stats_endLayersTime        - stats_startLayersTime        ) / 1e3 );
+    printf( "  Holes BVH creation:     %.3f ms\n",
+            (float)( stats_endHolesBVHTime      - stats_startHolesBVHTime      ) / 1e3 );
+    printf( "Statistics:\n" );
+    printf( "  m_stats_nr_tracks                   %u\n", m_stats_nr_tracks );
+    printf( "  m_stats_nr_vias                     %u\n", m_stats_nr_vias );
+    printf( "  m_stats_nr_holes                    %u\n", m_stats_nr_holes );
+    printf( "  m_stats_via_med_hole_diameter (3DU) %f\n", m_stats_via_med_hole_diameter );
+    printf( "  m_stats_hole_med_diameter     (3DU) %f\n", m_stats_hole_med_diameter );
+    printf( "  m_calc_seg_min_factor3DU      (3DU) %f\n", m_calc_seg_min_factor3DU );
+    printf( "  m_calc_seg_max_factor3DU      (3DU) %f\n", m_calc_seg_max_factor3DU );
+#endif
+}
 
-            wxASSERT( m_layers_poly.find( curr_layer_id ) != m_layers_poly.end() );
 
-            SHAPE_POLY_SET *layerPoly = m_layers_poly[curr_layer_id];
+void CINFO3D_VISU::createCopperLayer( PCB_LAYER_ID aLayerId, const LAYER_ITEMS& aItems )
+{
+    // Number of segments to draw a circle using segments (used on countour zones
+    // and text copper elements )
+    const int    segcountforcircle = 12;
+    const double correctionFactor  = GetCircleCorrectionFactor( segcountforcircle );
 
-            // ADD GRAPHIC ITEMS ON COPPER LAYERS (texts)
-            for( auto item : m_board->Drawings() )
-            {
-                if( !item->IsOnLayer( curr_layer_id ) )
-                    continue;
+    // The maps are shared by the threads building the layers: only look them up
+    wxASSERT( m_layers_container2D.find( aLayerId ) != m_layers_container2D.end() );
 
-                switch( item->Type() )
-                {
-                case PCB_LINE_T:
-                {
-                    const int nrSegments =
-                            GetNrSegmentsCircle( item->GetBoundingBox().GetSizeMax() );
-
-                    ( (DRAWSEGMENT*) item )->TransformShapeWithClearanceToPolygon(
-                                *layerPoly,
-                                0,
-                                nrSegments,
-                                GetCircleCorrectionFactor( nrSegments ) );
-                }
-                break;
-
-                case PCB_TEXT_T:
-                    ( (TEXTE_PCB*) item )->TransformShapeWithClearanceToPolygonSet(
-                                *layerPoly,
-                                0,
-                                segcountforcircle,
-                                correctionFactor );
-                break;
-
-                default:
-                    wxLogTrace( m_logTrace,
-                                wxT( "createLayers: item type: %d not implemented" ),
-                                item->Type() );
-                break;
-                }
-            }
-        }
-    }
+    CBVHCONTAINER2D *layerContainer = m_layers_container2D.find( aLayerId )->second;
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T12: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+    // The contours are only built for the OpenGL copper thickness
+    MAP_POLY::const_iterator poly = m_layers_poly.find( aLayerId );
+    SHAPE_POLY_SET *layerPoly = ( poly != m_layers_poly.end() ) ? poly->second : NULL;
 
-    if( GetFlag( FL_ZONE ) )
+    // Add tracks and vias objects and contours
+    // /////////////////////////////////////////////////////////////////////////
+    for( const TRACK* track : aItems.m_tracks )
     {
-        if( aStatusTextReporter )
-            aStatusTextReporter->Report( _( "Create zones" ) );
-
-        // Add zones objects
-        // /////////////////////////////////////////////////////////////////////
-        std::atomic<size_t> nextZone( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
+        // Add object item to layer container
+        layerContainer->Add( createNewTrack( track, 0.0f ) );
 
-        size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        if( layerPoly )
         {
-            std::thread t = std::thread( [&]()
-            {
-                for( size_t areaId = nextZone.fetch_add( 1 );
-                            areaId < static_cast<size_t>( m_board->GetAreaCount() );
-                            areaId = nextZone.fetch_add( 1 ) )
-                {
-                    const ZONE_CONTAINER* zone = m_board->GetArea( areaId );
+            // Add the track contour
+            int nrSegments = GetNrSegmentsCircle( track->GetWidth() );
+
+            track->TransformShapeWithClearanceToPolygonCached(
+                        *layerPoly,
+                        0,
+                        nrSegments,
+                        GetCircleCorrectionFactor( nrSegments ) );
+        }
 
-                    if( zone == nullptr )
-                        break;
+        if( track->Type() != PCB_VIA_T )
+            continue;
 
-                    auto layerContainer = m_layers_container2D.find( zone->GetLayer() );
+        const VIA *via = static_cast< const VIA*>( track );
 
-                    if( layerContainer != m_layers_container2D.end() )
-                        AddSolidAreasShapesToContainer( zone, layerContainer->second,
-                                                        zone->GetLayer() );
-                }
+        // The through holes were added by createLayers()
+        if( via->GetViaType() == VIA_THROUGH )
+            continue;
 
-                threadsFinished++;
-            } );
+        // Add hole objects
+        // /////////////////////////////////////////////////////////////////////
+        wxASSERT( m_layers_holes2D.find( aLayerId ) != m_layers_holes2D.end() );
 
-            t.detach();
-        }
+        const float holediameter = via->GetDrillValue() * BiuTo3Dunits();
+        const float thickness = GetCopperThickness3DU();
+        const float hole_inner_radius = ( holediameter / 2.0f );
 
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        const SFVEC2F via_center(  via->GetStart().x * m_biuTo3Dunits,
+                                  -via->GetStart().y * m_biuTo3Dunits );
 
-    }
+        m_layers_holes2D.find( aLayerId )->second->Add(
+                    new CFILLEDCIRCLE2D( via_center, hole_inner_radius + thickness, *track ) );
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "fill zones T13: %.3f ms\n", (float)( GetRunningMicroSecs()  - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
+        // Add VIA hole contourns
+        // /////////////////////////////////////////////////////////////////////
+        const int holediameterBIU = via->GetDrillValue();
+        const int hole_outer_radius = (holediameterBIU / 2) + GetCopperThicknessBIU();
+
+        TransformCircleToPolygon( *m_layers_outer_holes_poly.find( aLayerId )->second,
+                                  via->GetStart(),
+                                  hole_outer_radius,
+                                  GetNrSegmentsCircle( hole_outer_radius * 2 ) );
+
+        TransformCircleToPolygon( *m_layers_inner_holes_poly.find( aLayerId )->second,
+                                  via->GetStart(),
+                                  holediameterBIU / 2,
+                                  GetNrSegmentsCircle( holediameterBIU ) );
+    }
 
-    if( GetFlag( FL_ZONE ) &&
-        GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
+    // Add modules PADs objects and contours
+    // /////////////////////////////////////////////////////////////////////////
+    for( const MODULE* module : aItems.m_modules )
     {
-        // ADD COPPER ZONES
-        for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
-        {
-            const ZONE_CONTAINER* zone = m_board->GetArea( ii );
+        // Note: NPTH pads are not drawn on copper layers when the pad
+        // has same shape as its hole
+        AddPadsShapesWithClearanceToContainer( module,
+                                               layerContainer,
+                                               aLayerId,
+                                               0,
+                                               true );
+
+        // Micro-wave modules may have items on copper layers
+        AddGraphicsShapesWithClearanceToContainer( module,
+                                                   layerContainer,
+                                                   aLayerId,
+                                                   0 );
+
+        if( !layerPoly )
+            continue;
 
-            if( zone == nullptr )
-                break;
+        transformPadsShapesWithClearanceToPolygon( module->PadsList(),
+                                                   aLayerId,
+                                                   *layerPoly,
+                                                   0,
+                                                   true );
 
-            auto layerContainer = m_layers_poly.find( zone->GetLayer() );
+        module->TransformGraphicTextWithClearanceToPolygonSet( aLayerId,
+                                                                *layerPoly,
+                                                                0,
+                                                                segcountforcircle,
+                                                                correctionFactor );
 
-            if( layerContainer != m_layers_poly.end() )
-                zone->TransformSolidAreasShapesToPolygonSet( *layerContainer->second, segcountforcircle, correctionFactor );
-        }
+        transformGraphicModuleEdgeToPolygonSet( module, aLayerId, *layerPoly );
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T14: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time  ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    // Simplify layer polygons
+    // Add graphic item on copper layers (texts) objects and contours
     // /////////////////////////////////////////////////////////////////////////
-
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Simplifying copper layers polygons" ) );
-
-    if( GetFlag( FL_RENDER_OPENGL_COPPER_THICKNESS ) &&
-        (m_render_engine == RENDER_ENGINE_OPENGL_LEGACY) )
+    for( const BOARD_ITEM* item : aItems.m_drawings )
     {
-        std::atomic<size_t> nextItem( 0 );
-        std::atomic<size_t> threadsFinished( 0 );
-
-        size_t parallelThreadCount = std::min<size_t>(
-                std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-                layer_id.size() );
-        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        switch( item->Type() )
         {
-            std::thread t = std::thread( [&nextItem, &threadsFinished, &layer_id, this]()
+        case PCB_LINE_T:
+        {
+            AddShapeWithClearanceToContainer( (DRAWSEGMENT*)item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+
+            if( layerPoly )
             {
-                for( size_t i = nextItem.fetch_add( 1 );
-                            i < layer_id.size();
-                            i = nextItem.fetch_add( 1 ) )
-                {
-                    auto layerPoly = m_layers_poly.find( layer_id[i] );
+                const int nrSegments =
+                        GetNrSegmentsCircle( item->GetBoundingBox().GetSizeMax() );
 
-                    if( layerPoly != m_layers_poly.end() )
-                        // This will make a union of all added contours
-                        layerPoly->second->Simplify( SHAPE_POLY_SET::PM_FAST );
-                }
+                ( (DRAWSEGMENT*) item )->TransformShapeWithClearanceToPolygonCached(
+                            *layerPoly,
+                            0,
+                            nrSegments,
+                            GetCircleCorrectionFactor( nrSegments ) );
+            }
+        }
+        break;
 
-                threadsFinished++;
-            } );
+        case PCB_TEXT_T:
+            AddShapeWithClearanceToContainer( (TEXTE_PCB*) item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
 
-            t.detach();
+            if( layerPoly )
+                ( (TEXTE_PCB*) item )->TransformShapeWithClearanceToPolygonSet(
+                            *layerPoly,
+                            0,
+                            segcountforcircle,
+                            correctionFactor );
+        break;
+
+        case PCB_DIMENSION_T:
+            AddShapeWithClearanceToContainer( (DIMENSION*) item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+        break;
+
+        default:
+            wxLogTrace( m_logTrace,
+                        wxT( "createLayers: item type: %d not implemented" ),
+                        item->Type() );
+        break;
         }
-
-        while( threadsFinished < parallelThreadCount )
-            std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T15: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
-    start_Time = GetRunningMicroSecs();
-#endif
-
-    // Simplify holes polygon contours
+    // Add zones objects and contours
     // /////////////////////////////////////////////////////////////////////////
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Simplify holes contours" ) );
-
-    for( unsigned int lIdx = 0; lIdx < layer_id.size(); ++lIdx )
+    for( const ZONE_CONTAINER* zone : aItems.m_zones )
     {
-        const PCB_LAYER_ID curr_layer_id = layer_id[lIdx];
-
-        if( m_layers_outer_holes_poly.find( curr_layer_id ) !=
-            m_layers_outer_holes_poly.end() )
-        {
-            // found
-            SHAPE_POLY_SET *polyLayer = m_layers_outer_holes_poly[curr_layer_id];
-            polyLayer->Simplify( SHAPE_POLY_SET::PM_FAST );
+        AddSolidAreasShapesToContainer( zone, layerContainer, aLayerId );
 
-            wxASSERT( m_layers_inner_holes_poly.find( curr_layer_id ) !=
-                      m_layers_inner_holes_poly.end() );
-
-            polyLayer = m_layers_inner_holes_poly[curr_layer_id];
-            polyLayer->Simplify( SHAPE_POLY_SET::PM_FAST );
-        }
+        if( layerPoly )
+            zone->TransformSolidAreasShapesToPolygonSet( *layerPoly,
+                                                         segcountforcircle,
+                                                         correctionFactor );
     }
 
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    printf( "T16: %.3f ms\n", (float)( GetRunningMicroSecs() - start_Time ) / 1e3 );
-#endif
-    // End Build Copper layers
-
-
-    // This will make a union of all added contourns
-    m_through_inner_holes_poly.Simplify( SHAPE_POLY_SET::PM_FAST );
-    m_through_outer_holes_poly.Simplify( SHAPE_POLY_SET::PM_FAST );
-    m_through_outer_holes_poly_NPTH.Simplify( SHAPE_POLY_SET::PM_FAST );
-    m_through_outer_holes_vias_poly.Simplify( SHAPE_POLY_SET::PM_FAST );
-    //m_through_inner_holes_vias_poly.Simplify( SHAPE_POLY_SET::PM_FAST ); // Not in use
-
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_endCopperLayersTime = GetRunningMicroSecs();
-#endif
-
-    // Build Tech layers
-    // Based on: https://github.com/KiCad/kicad-source-mirror/blob/master/3d-viewer/3d_draw.cpp#L1059
+    // Simplify layer polygons and holes polygon contours
     // /////////////////////////////////////////////////////////////////////////
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_startTechLayersTime = GetRunningMicroSecs();
-#endif
-
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Build Tech layers" ) );
-
-    // draw graphic items, on technical layers
-    static const PCB_LAYER_ID teckLayerList[] = {
-            B_Adhes,
-            F_Adhes,
-            B_Paste,
-            F_Paste,
-            B_SilkS,
-            F_SilkS,
-            B_Mask,
-            F_Mask,
-
-            // Aux Layers
-            Dwgs_User,
-            Cmts_User,
-            Eco1_User,
-            Eco2_User,
-            Edge_Cuts,
-            Margin
-        };
+    if( layerPoly )
+    {
+        // This will make a union of all added contours
+        layerPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
+    }
 
-    // User layers are not drawn here, only technical layers
+    MAP_POLY::const_iterator outerHoles = m_layers_outer_holes_poly.find( aLayerId );
 
-    for( LSEQ seq = LSET::AllNonCuMask().Seq( teckLayerList, arrayDim( teckLayerList ) );
-         seq;
-         ++seq )
+    if( outerHoles != m_layers_outer_holes_poly.end() )
     {
-        const PCB_LAYER_ID curr_layer_id = *seq;
+        outerHoles->second->Simplify( SHAPE_POLY_SET::PM_FAST );
 
-        if( !Is3DLayerEnabled( curr_layer_id ) )
-                    continue;
+        wxASSERT( m_layers_inner_holes_poly.find( aLayerId ) !=
+                  m_layers_inner_holes_poly.end() );
 
-        CBVHCONTAINER2D *layerContainer = new CBVHCONTAINER2D;
-        m_layers_container2D[curr_layer_id] = layerContainer;
+        m_layers_inner_holes_poly.find( aLayerId )->second->Simplify( SHAPE_POLY_SET::PM_FAST );
+    }
+}
 
-        SHAPE_POLY_SET *layerPoly = new SHAPE_POLY_SET;
-        m_layers_poly[curr_layer_id] = layerPoly;
 
-        // Add drawing objects
-        // /////////////////////////////////////////////////////////////////////
-        for( auto item : m_board->Drawings() )
-        {
-            if( !item->IsOnLayer( curr_layer_id ) )
-                continue;
+void CINFO3D_VISU::createTechLayer( PCB_LAYER_ID aLayerId, const LAYER_ITEMS& aItems )
+{
+    // segments to draw a circle to build texts. Is is used only to build
+    // the shape of each segment of the stroke font, therefore no need to have
+    // many segments per circle.
+    const int segcountInStrokeFont  = 12;
+    const double correctionFactorStroke = GetCircleCorrectionFactor( segcountInStrokeFont );
 
-            switch( item->Type() )
-            {
-            case PCB_LINE_T:
-                AddShapeWithClearanceToContainer( (DRAWSEGMENT*)item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-                break;
-
-            case PCB_TEXT_T:
-                AddShapeWithClearanceToContainer( (TEXTE_PCB*) item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-                break;
-
-            case PCB_DIMENSION_T:
-                AddShapeWithClearanceToContainer( (DIMENSION*) item,
-                                                  layerContainer,
-                                                  curr_layer_id,
-                                                  0 );
-                break;
-
-            default:
-                break;
-            }
-        }
+    // The maps are shared by the threads building the layers: only look them up
+    wxASSERT( m_layers_container2D.find( aLayerId ) != m_layers_container2D.end() );
+    wxASSERT( m_layers_poly.find( aLayerId ) != m_layers_poly.end() );
 
+    CBVHCONTAINER2D *layerContainer = m_layers_container2D.find( aLayerId )->second;
+    SHAPE_POLY_SET *layerPoly = m_layers_poly.find( aLayerId )->second;
 
-        // Add drawing contours
-        // /////////////////////////////////////////////////////////////////////
-        for( auto item : m_board->Drawings() )
+    // Add drawing objects and contours
+    // /////////////////////////////////////////////////////////////////////////
+    for( const BOARD_ITEM* item : aItems.m_drawings )
+    {
+        switch( item->Type() )
         {
-            if( !item->IsOnLayer( curr_layer_id ) )
-                continue;
+        case PCB_LINE_T:
+        {
+            AddShapeWithClearanceToContainer( (DRAWSEGMENT*)item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+
+            const unsigned int nr_segments =
+                    GetNrSegmentsCircle( item->GetBoundingBox().GetSizeMax() );
+
+            ((DRAWSEGMENT*) item)->TransformShapeWithClearanceToPolygonCached( *layerPoly,
+                                                                               0,
+                                                                               nr_segments,
+                                                                               0.0 );
+        }
+            break;
 
-            switch( item->Type() )
-            {
-            case PCB_LINE_T:
-            {
-                const unsigned int nr_segments =
-                        GetNrSegmentsCircle( item->GetBoundingBox().GetSizeMax() );
+        case PCB_TEXT_T:
+            AddShapeWithClearanceToContainer( (TEXTE_PCB*) item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
 
-                ((DRAWSEGMENT*) item)->TransformShapeWithClearanceToPolygon( *layerPoly,
-                                                                             0,
-                                                                             nr_segments,
-                                                                             0.0 );
-            }
-                break;
+            ((TEXTE_PCB*) item)->TransformShapeWithClearanceToPolygonSet( *layerPoly,
+                                                                          0,
+                                                                          segcountInStrokeFont,
+                                                                          1.0 );
+            break;
 
-            case PCB_TEXT_T:
-                ((TEXTE_PCB*) item)->TransformShapeWithClearanceToPolygonSet( *layerPoly,
-                                                                              0,
-                                                                              segcountInStrokeFont,
-                                                                              1.0 );
-                break;
+        case PCB_DIMENSION_T:
+            AddShapeWithClearanceToContainer( (DIMENSION*) item,
+                                              layerContainer,
+                                              aLayerId,
+                                              0 );
+            break;
 
-            default:
-                break;
-            }
+        default:
+            break;
         }
+    }
 
-
-        // Add modules tech layers - objects
-        // /////////////////////////////////////////////////////////////////////
-        for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
+    // Add modules tech layers - objects and contours
+    // /////////////////////////////////////////////////////////////////////////
+    for( const MODULE* module : aItems.m_modules )
+    {
+        if( (aLayerId == F_SilkS) || (aLayerId == B_SilkS) )
         {
-            if( (curr_layer_id == F_SilkS) || (curr_layer_id == B_SilkS) )
-            {
-                D_PAD*  pad = module->PadsList();
-                int     linewidth = g_DrawDefaultLineThickness;
-
-                for( ; pad; pad = pad->Next() )
-                {
-                    if( !pad->IsOnLayer( curr_layer_id ) )
-                        continue;
-
-                    buildPadShapeThickOutlineAsSegments( pad,
-                                                         layerContainer,
-                                                         linewidth );
-                }
-            }
-            else
-            {
-                AddPadsShapesWithClearanceToContainer( module,
-                                                       layerContainer,
-                                                       curr_layer_id,
-                                                       0,
-                                                       false );
-            }
-
-            AddGraphicsShapesWithClearanceToContainer( module,
-                                                       layerContainer,
-                                                       curr_layer_id,
-                                                       0 );
-        }
-
+            const D_PAD* pad = module->PadsList();
+            const int linewidth = g_DrawDefaultLineThickness;
 
-        // Add modules tech layers - contours
-        // /////////////////////////////////////////////////////////////////////
-        for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
-        {
-            if( (curr_layer_id == F_SilkS) || (curr_layer_id == B_SilkS) )
+            for( ; pad; pad = pad->Next() )
             {
-                D_PAD*  pad = module->PadsList();
-                const int linewidth = g_DrawDefaultLineThickness;
+                if( !pad->IsOnLayer( aLayerId ) )
+                    continue;
 
-                for( ; pad; pad = pad->Next() )
-                {
-                    if( !pad->IsOnLayer( curr_layer_id ) )
-                        continue;
+                buildPadShapeThickOutlineAsSegments( pad,
+                                                     layerContainer,
+                                                     linewidth );
 
-                    buildPadShapeThickOutlineAsPolygon( pad, *layerPoly, linewidth );
-                }
+                buildPadShapeThickOutlineAsPolygon( pad, *layerPoly, linewidth );
             }
-            else
-            {
-                transformPadsShapesWithClearanceToPolygon( module->PadsList(),
-                                                           curr_layer_id,
-                                                           *layerPoly,
-                                                           0,
-                                                           false );
-            }
-
-            // On tech layers, use a poor circle approximation, only for texts (stroke font)
-            module->TransformGraphicTextWithClearanceToPolygonSet( curr_layer_id,
-                                                                   *layerPoly,
-                                                                   0,
-                                                                   segcountInStrokeFont,
-                                                                   correctionFactorStroke,
-                                                                   segcountInStrokeFont );
-
-            // Add the remaining things with dynamic seg count for circles
-            transformGraphicModuleEdgeToPolygonSet( module, curr_layer_id, *layerPoly );
         }
-
-
-        // Draw non copper zones
-        // /////////////////////////////////////////////////////////////////////
-        if( GetFlag( FL_ZONE ) )
+        else
         {
-            for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
-            {
-                ZONE_CONTAINER* zone = m_board->GetArea( ii );
-
-                if( !zone->IsOnLayer( curr_layer_id ) )
-                    continue;
-
-                AddSolidAreasShapesToContainer( zone,
-                                                layerContainer,
-                                                curr_layer_id );
-            }
-
-            for( int ii = 0; ii < m_board->GetAreaCount(); ++ii )
-            {
-                ZONE_CONTAINER* zone = m_board->GetArea( ii );
-
-                if( !zone->IsOnLayer( curr_layer_id ) )
-                    continue;
+            AddPadsShapesWithClearanceToContainer( module,
+                                                   layerContainer,
+                                                   aLayerId,
+                                                   0,
+                                                   false );
 
-                zone->TransformSolidAreasShapesToPolygonSet( *layerPoly,
-                                                             // Use the same segcount as stroke font
-                                                             segcountInStrokeFont,
-                                                             correctionFactorStroke );
-            }
+            transformPadsShapesWithClearanceToPolygon( module->PadsList(),
+                                                       aLayerId,
+                                                       *layerPoly,
+                                                       0,
+                                                       false );
         }
 
-        // This will make a union of all added contours
-        layerPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
+        AddGraphicsShapesWithClearanceToContainer( module,
+                                                   layerContainer,
+                                                   aLayerId,
+                                                   0 );
+
+        // On tech layers, use a poor circle approximation, only for texts (stroke font)
+        module->TransformGraphicTextWithClearanceToPolygonSet( aLayerId,
+                                                               *layerPoly,
+                                                               0,
+                                                               segcountInStrokeFont,
+                                                               correctionFactorStroke,
+                                                               segcountInStrokeFont );
+
+        // Add the remaining things with dynamic seg count for circles
+        transformGraphicModuleEdgeToPolygonSet( module, aLayerId, *layerPoly );
     }
-    // End Build Tech layers
-
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_endTechLayersTime = GetRunningMicroSecs();
-#endif
 
-
-    // Build BVH for holes and vias
+    // Draw non copper zones
     // /////////////////////////////////////////////////////////////////////////
-
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_startHolesBVHTime = GetRunningMicroSecs();
-#endif
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( _( "Build BVH for holes and vias" ) );
-
-    m_through_holes_inner.BuildBVH();
-    m_through_holes_outer.BuildBVH();
-
-    if( !m_layers_holes2D.empty() )
+    for( const ZONE_CONTAINER* zone : aItems.m_zones )
     {
-        for( MAP_CONTAINER_2D::iterator ii = m_layers_holes2D.begin();
-             ii != m_layers_holes2D.end();
-             ++ii )
-        {
-            ((CBVHCONTAINER2D *)(ii->second))->BuildBVH();
-        }
+        AddSolidAreasShapesToContainer( zone,
+                                        layerContainer,
+                                        aLayerId );
+
+        zone->TransformSolidAreasShapesToPolygonSet( *layerPoly,
+                                                     // Use the same segcount as stroke font
+                                                     segcountInStrokeFont,
+                                                     correctionFactorStroke );
     }
 
-    // We only need the Solder mask to initialize the BVH
-    // because..?
-    if( (CBVHCONTAINER2D *)m_layers_container2D[B_Mask] )
-        ((CBVHCONTAINER2D *)m_layers_container2D[B_Mask])->BuildBVH();
-
-    if( (CBVHCONTAINER2D *)m_layers_container2D[F_Mask] )
-        ((CBVHCONTAINER2D *)m_layers_container2D[F_Mask])->BuildBVH();
-
-#ifdef PRINT_STATISTICS_3D_VIEWER
-    unsigned stats_endHolesBVHTime = GetRunningMicroSecs();
-
-    printf( "CINFO3D_VISU::createLayers times\n" );
-    printf( "  Copper Layers:          %.3f ms\n",
-            (float)( stats_endCopperLayersTime  - stats_startCopperLayersTime  ) / 1e3 );
-    printf( "  Holes BVH creation:     %.3f ms\n",
-            (float)( stats_endHolesBVHTime      - stats_startHolesBVHTime      ) / 1e3 );
-    printf( "  Tech Layers:            %.3f ms\n",
-            (float)( stats_endTechLayersTime    - stats_startTechLayersTime    ) / 1e3 );
-    printf( "Statistics:\n" );
-    printf( "  m_stats_nr_tracks                   %u\n", m_stats_nr_tracks );
-    printf( "  m_stats_nr_vias                     %u\n", m_stats_nr_vias );
-    printf( "  m_stats_nr_holes                    %u\n", m_stats_nr_holes );
-    printf( "  m_stats_via_med_hole_diameter (3DU) %f\n", m_stats_via_med_hole_diameter );
-    printf( "  m_stats_hole_med_diameter     (3DU) %f\n", m_stats_hole_med_diameter );
-    printf( "  m_calc_seg_min_factor3DU      (3DU) %f\n", m_calc_seg_min_factor3DU );
-    printf( "  m_calc_seg_max_factor3DU      (3DU) %f\n", m_calc_seg_max_factor3DU );
-#endif
+    // This will make a union of all added contours
+    layerPoly->Simplify( SHAPE_POLY_SET::PM_FAST );
 }
@@ -278,6 +278,17 @@ void EDA_3D_CANVAS::ReloadRequest( BOARD *aBoard , S3D_CACHE *aCachePointer )
     if( aBoard != NULL )
         m_settings.SetBoard( aBoard );
 
+    m_settings.SetAllLayersDirty();
+
+    if( m_3d_render )
+        m_3d_render->ReloadRequest();
+}
+
+
+void EDA_3D_CANVAS::ReloadLayersRequest( const LSET &aDirtyLayers )
+{
+    m_settings.SetLayersDirty( aDirtyLayers );
+
     if( m_3d_render )
         m_3d_render->ReloadRequest();
 }
@@ -74,6 +74,13 @@ class EDA_3D_CANVAS : public HIDPI_GL_CANVAS
 
     void ReloadRequest( BOARD *aBoard = NULL, S3D_CACHE *aCachePointer = NULL );
 
+    /**
+     * @brief ReloadLayersRequest - Request to reload only the layers whose board
+     * items were changed
+     * @param aDirtyLayers: the changed layers
+     */
+    void ReloadLayersRequest( const LSET &aDirtyLayers );
+
     /**
      * @brief IsReloadRequestPending - Query if there is a pending reload request
      * @return true if it wants to reload, false if there is no reload pending
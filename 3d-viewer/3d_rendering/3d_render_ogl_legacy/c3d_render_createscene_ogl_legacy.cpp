@@ -339,8 +339,6 @@ void C3D_RENDER_OGL_LEGACY::reload( REPORTER *aStatusTextReporter )
 {
     m_reloadRequested = false;
 
-    ogl_free_all_display_lists();
-
     COBJECT2D_STATS::Instance().ResetStats();
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
@@ -351,6 +349,10 @@ void C3D_RENDER_OGL_LEGACY::reload( REPORTER *aStatusTextReporter )
 
     m_settings.InitSettings( aStatusTextReporter );
 
+    // The display lists of the layers which were not rebuilt by the settings are kept
+    ogl_free_board_display_lists();
+    ogl_free_layers_display_lists( true );
+
 #ifdef PRINT_STATISTICS_3D_VIEWER
     unsigned stats_endReloadTime = GetRunningMicroSecs();
 #endif
@@ -536,6 +538,9 @@ void C3D_RENDER_OGL_LEGACY::reload( REPORTER *aStatusTextReporter )
         if( !m_settings.Is3DLayerEnabled( layer_id ) )
             continue;
 
+        if( m_ogl_disp_lists_layers.find( layer_id ) != m_ogl_disp_lists_layers.end() )
+            continue;   // Unchanged layer
+
         const CBVHCONTAINER2D *container2d = static_cast<const CBVHCONTAINER2D *>(ii->second);
         const LIST_OBJECT2D &listObject2d = container2d->GetList();
 
@@ -612,6 +617,7 @@ void C3D_RENDER_OGL_LEGACY::reload( REPORTER *aStatusTextReporter )
                                                                         m_ogl_circle_texture,
                                                                         layer_z_bot,
                                                                         layer_z_top );
+        m_ogl_disp_lists_layers_build_id[layer_id] = m_settings.GetLayerBuildId( layer_id );
     }// for each layer on map
 
 #ifdef PRINT_STATISTICS_3D_VIEWER
@@ -909,6 +915,26 @@ void C3D_RENDER_OGL_LEGACY::load_3D_models( REPORTER *aStatusTextReporter )
         (!m_settings.GetFlag( FL_MODULE_ATTRIBUTES_VIRTUAL )) )
         return;
 
+    // Load the models not in our cache map on parallel threads first: the openGL
+    // lists are then created below, on this thread
+    std::vector<wxString> modelFiles;
+
+    for( const MODULE* module = m_settings.GetBoard()->m_Modules;
+         module; module = module->Next() )
+    {
+        for( const MODULE_3D_SETTINGS& model : module->Models() )
+        {
+            if( !model.m_Filename.empty()
+                    && m_3dmodel_map.find( model.m_Filename ) == m_3dmodel_map.end() )
+                modelFiles.push_back( model.m_Filename );
+        }
+    }
+
+    if( aStatusTextReporter )
+        aStatusTextReporter->Report( _( "Loading 3D models" ) );
+
+    m_settings.Get3DCacheManager()->LoadModels( modelFiles );
+
     // Go for all modules
     for( const MODULE* module = m_settings.GetBoard()->m_Modules;
          module; module = module->Next() )
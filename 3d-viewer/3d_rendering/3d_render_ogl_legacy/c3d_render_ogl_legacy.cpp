@@ -68,6 +68,8 @@ C3D_RENDER_OGL_LEGACY::C3D_RENDER_OGL_LEGACY( CINFO3D_VISU &aSettings ) :
     m_last_grid_type = GRID3D_NONE;
 
     m_3dmodel_map.clear();
+
+    m_ogl_instancing = NULL;
 }
 
 
@@ -78,6 +80,9 @@ C3D_RENDER_OGL_LEGACY::~C3D_RENDER_OGL_LEGACY()
     ogl_free_all_display_lists();
 
     glDeleteTextures( 1, &m_ogl_circle_texture );
+
+    delete m_ogl_instancing;
+    m_ogl_instancing = NULL;
 }
 
 
@@ -804,6 +809,9 @@ bool C3D_RENDER_OGL_LEGACY::initializeOpenGL()
 
     init_lights();
 
+    if( C_OGL_INSTANCING::IsSupported() && !m_ogl_instancing )
+        m_ogl_instancing = new C_OGL_INSTANCING();
+
     // Use this mode if you want see the triangle lines (debug proposes)
     //glPolygonMode( GL_FRONT_AND_BACK,  GL_LINE );
 
@@ -834,21 +842,47 @@ void C3D_RENDER_OGL_LEGACY::ogl_set_arrow_material()
 
 void C3D_RENDER_OGL_LEGACY::ogl_free_all_display_lists()
 {
-    if( glIsList( m_ogl_disp_list_grid ) )
-        glDeleteLists( m_ogl_disp_list_grid, 1 );
+    ogl_free_layers_display_lists( false );
+    ogl_free_board_display_lists();
+}
 
-    m_ogl_disp_list_grid = 0;
 
-    for( MAP_OGL_DISP_LISTS::const_iterator ii = m_ogl_disp_lists_layers.begin();
-         ii != m_ogl_disp_lists_layers.end();
-         ++ii )
+void C3D_RENDER_OGL_LEGACY::ogl_free_layers_display_lists( bool aOnlyChanged )
+{
+    for( MAP_OGL_DISP_LISTS::iterator ii = m_ogl_disp_lists_layers.begin();
+         ii != m_ogl_disp_lists_layers.end(); )
     {
-        CLAYERS_OGL_DISP_LISTS *pLayerDispList = static_cast<CLAYERS_OGL_DISP_LISTS*>(ii->second);
-        delete pLayerDispList;
+        const PCB_LAYER_ID layer_id = ii->first;
+
+        if( aOnlyChanged && ( m_ogl_disp_lists_layers_build_id[layer_id] ==
+                              m_settings.GetLayerBuildId( layer_id ) ) )
+        {
+            ++ii;
+            continue;
+        }
+
+        delete ii->second;
+        ii = m_ogl_disp_lists_layers.erase( ii );
+
+        m_ogl_disp_lists_layers_build_id.erase( layer_id );
+
+        MAP_TRIANGLES::iterator triangles = m_triangles.find( layer_id );
+
+        if( triangles != m_triangles.end() )
+        {
+            delete triangles->second;
+            m_triangles.erase( triangles );
+        }
     }
+}
 
-    m_ogl_disp_lists_layers.clear();
 
+void C3D_RENDER_OGL_LEGACY::ogl_free_board_display_lists()
+{
+    if( glIsList( m_ogl_disp_list_grid ) )
+        glDeleteLists( m_ogl_disp_list_grid, 1 );
+
+    m_ogl_disp_list_grid = 0;
 
     for( MAP_OGL_DISP_LISTS::const_iterator ii = m_ogl_disp_lists_layers_holes_outer.begin();
          ii != m_ogl_disp_lists_layers_holes_outer.end();
@@ -871,17 +905,6 @@ void C3D_RENDER_OGL_LEGACY::ogl_free_all_display_lists()
 
     m_ogl_disp_lists_layers_holes_inner.clear();
 
-    for( MAP_TRIANGLES::const_iterator ii = m_triangles.begin();
-         ii != m_triangles.end();
-         ++ii )
-    {
-        CLAYER_TRIANGLES *pointer = static_cast<CLAYER_TRIANGLES*>(ii->second);
-        delete pointer;
-    }
-
-    m_triangles.clear();
-
-
     for( MAP_3DMODEL::const_iterator ii = m_3dmodel_map.begin();
          ii != m_3dmodel_map.end();
          ++ii )
@@ -979,6 +1002,10 @@ void C3D_RENDER_OGL_LEGACY::render_solder_mask_layer( PCB_LAYER_ID aLayerID,
 void C3D_RENDER_OGL_LEGACY::render_3D_models( bool aRenderTopOrBot,
                                               bool aRenderTransparentOnly )
 {
+    // Group the placements by model, so each model sets its buffers and
+    // materials once and then draws all of its instances
+    MODEL_INSTANCES_MAP instances;
+
     // Go for all modules
     if( m_settings.GetBoard()->m_Modules.GetCount() )
     {
@@ -990,41 +1017,87 @@ void C3D_RENDER_OGL_LEGACY::render_3D_models( bool aRenderTopOrBot,
                 if( m_settings.ShouldModuleBeDisplayed( (MODULE_ATTR_T)module->GetAttributes() ) )
                     if( ( aRenderTopOrBot && !module->IsFlipped()) ||
                         (!aRenderTopOrBot &&  module->IsFlipped()) )
-                        render_3D_module( module, aRenderTransparentOnly );
+                        get_3D_module_instances( module, aRenderTransparentOnly, instances );
+        }
+    }
+
+    for( const auto &modelInstances : instances )
+    {
+        const C_OGL_3DMODEL *modelPtr = modelInstances.first;
+
+        modelPtr->Draw_instances( aRenderTransparentOnly, modelInstances.second,
+                                  m_ogl_instancing );
+
+        if( m_settings.GetFlag( FL_RENDER_OPENGL_SHOW_MODEL_BBOX ) )
+        {
+            for( const glm::mat4 &instance : modelInstances.second )
+            {
+                glPushMatrix();
+                glMultMatrixf( &instance[0][0] );
+
+                glEnable( GL_BLEND );
+                glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+                glLineWidth( 1 );
+                modelPtr->Draw_bboxes();
+
+                glDisable( GL_LIGHTING );
+
+                glColor4f( 0.0f, 1.0f, 0.0f, 1.0f );
+
+                glLineWidth( 4 );
+                modelPtr->Draw_bbox();
+
+                glEnable( GL_LIGHTING );
+
+                glPopMatrix();
+            }
         }
     }
 }
 
 
-void C3D_RENDER_OGL_LEGACY::render_3D_module( const MODULE* module,
-                                              bool aRenderTransparentOnly )
+void C3D_RENDER_OGL_LEGACY::get_3D_module_instances( const MODULE* module,
+                                                     bool aRenderTransparentOnly,
+                                                     MODEL_INSTANCES_MAP &aInstances )
 {
     if( !module->Models().empty() )
     {
         const double zpos = m_settings.GetModulesZcoord3DIU( module->IsFlipped() );
 
-        glPushMatrix();
-
         wxPoint pos = module->GetPosition();
 
-        glTranslatef(  pos.x * m_settings.BiuTo3Dunits(),
-                      -pos.y * m_settings.BiuTo3Dunits(),
-                       zpos );
+        glm::mat4 moduleMatrix = glm::mat4( 1.0f );
+
+        moduleMatrix = glm::translate( moduleMatrix,
+                                       SFVEC3F(  pos.x * m_settings.BiuTo3Dunits(),
+                                                -pos.y * m_settings.BiuTo3Dunits(),
+                                                 zpos ) );
 
         if( module->GetOrientation() )
-            glRotated( (double) module->GetOrientation() / 10.0, 0.0, 0.0, 1.0 );
+            moduleMatrix = glm::rotate( moduleMatrix,
+                                        ( (float)(module->GetOrientation() / 10.0f) / 180.0f ) *
+                                        glm::pi<float>(),
+                                        SFVEC3F( 0.0f, 0.0f, 1.0f ) );
 
         if( module->IsFlipped() )
         {
-            glRotatef( 180.0f, 0.0f, 1.0f, 0.0f );
-            glRotatef( 180.0f, 0.0f, 0.0f, 1.0f );
+            moduleMatrix = glm::rotate( moduleMatrix,
+                                        glm::pi<float>(),
+                                        SFVEC3F( 0.0f, 1.0f, 0.0f ) );
+
+            moduleMatrix = glm::rotate( moduleMatrix,
+                                        glm::pi<float>(),
+                                        SFVEC3F( 0.0f, 0.0f, 1.0f ) );
         }
 
-        double modelunit_to_3d_units_factor = m_settings.BiuTo3Dunits() * UNITS3D_TO_UNITSPCB;
+        const float modelunit_to_3d_units_factor = m_settings.BiuTo3Dunits() *
+                                                   UNITS3D_TO_UNITSPCB;
 
-        glScaled( modelunit_to_3d_units_factor,
-                  modelunit_to_3d_units_factor,
-                  modelunit_to_3d_units_factor );
+        moduleMatrix = glm::scale( moduleMatrix,
+                                   SFVEC3F( modelunit_to_3d_units_factor,
+                                            modelunit_to_3d_units_factor,
+                                            modelunit_to_3d_units_factor ) );
 
         // Get the list of model files for this model
         auto sM = module->Models().begin();
@@ -1045,40 +1118,31 @@ void C3D_RENDER_OGL_LEGACY::render_3D_module( const MODULE* module,
                         if( ( (!aRenderTransparentOnly) && modelPtr->Have_opaque() ) ||
                             ( aRenderTransparentOnly && modelPtr->Have_transparent() ) )
                         {
-                            glPushMatrix();
-
-                            glTranslatef( sM->m_Offset.x, sM->m_Offset.y, sM->m_Offset.z );
-
-                            glRotatef( -sM->m_Rotation.z, 0.0f, 0.0f, 1.0f );
-                            glRotatef( -sM->m_Rotation.y, 0.0f, 1.0f, 0.0f );
-                            glRotatef( -sM->m_Rotation.x, 1.0f, 0.0f, 0.0f );
-
-                            glScalef( sM->m_Scale.x, sM->m_Scale.y, sM->m_Scale.z );
+                            glm::mat4 modelMatrix = moduleMatrix;
 
-                            if( aRenderTransparentOnly )
-                                modelPtr->Draw_transparent();
-                            else
-                                modelPtr->Draw_opaque();
+                            modelMatrix = glm::translate( modelMatrix,
+                                                          SFVEC3F( sM->m_Offset.x,
+                                                                   sM->m_Offset.y,
+                                                                   sM->m_Offset.z ) );
 
-                            if( m_settings.GetFlag( FL_RENDER_OPENGL_SHOW_MODEL_BBOX ) )
-                            {
-                                glEnable( GL_BLEND );
-                                glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+                            modelMatrix = glm::rotate( modelMatrix,
+                                (float)(-( sM->m_Rotation.z / 180.0f ) * glm::pi<float>() ),
+                                SFVEC3F( 0.0f, 0.0f, 1.0f ) );
 
-                                glLineWidth( 1 );
-                                modelPtr->Draw_bboxes();
+                            modelMatrix = glm::rotate( modelMatrix,
+                                (float)(-( sM->m_Rotation.y / 180.0f ) * glm::pi<float>() ),
+                                SFVEC3F( 0.0f, 1.0f, 0.0f ) );
 
-                                glDisable( GL_LIGHTING );
+                            modelMatrix = glm::rotate( modelMatrix,
+                                (float)(-( sM->m_Rotation.x / 180.0f ) * glm::pi<float>() ),
+                                SFVEC3F( 1.0f, 0.0f, 0.0f ) );
 
-                                glColor4f( 0.0f, 1.0f, 0.0f, 1.0f );
+                            modelMatrix = glm::scale( modelMatrix,
+                                                      SFVEC3F( sM->m_Scale.x,
+                                                               sM->m_Scale.y,
+                                                               sM->m_Scale.z ) );
 
-                                glLineWidth( 4 );
-                                modelPtr->Draw_bbox();
-
-                                glEnable( GL_LIGHTING );
-                            }
-
-                            glPopMatrix();
+                            aInstances[modelPtr].push_back( modelMatrix );
                         }
                     }
                 }
@@ -1086,8 +1150,6 @@ void C3D_RENDER_OGL_LEGACY::render_3D_module( const MODULE* module,
 
             ++sM;
         }
-
-        glPopMatrix();
     }
 }
 
@@ -50,6 +50,7 @@
 typedef std::map< PCB_LAYER_ID, CLAYERS_OGL_DISP_LISTS* > MAP_OGL_DISP_LISTS;
 typedef std::map< PCB_LAYER_ID, CLAYER_TRIANGLES * > MAP_TRIANGLES;
 typedef std::map< wxString, C_OGL_3DMODEL * > MAP_3DMODEL;
+typedef std::map< const C_OGL_3DMODEL *, std::vector< glm::mat4 > > MODEL_INSTANCES_MAP;
 
 #define SIZE_OF_CIRCLE_TEXTURE 1024
 
@@ -76,6 +77,17 @@ private:
     void ogl_set_arrow_material();
 
     void ogl_free_all_display_lists();
+
+    /// Free all the display lists and 3D models but the ones of the layers
+    void ogl_free_board_display_lists();
+
+    /**
+     * @brief ogl_free_layers_display_lists - free the display lists of the layers
+     * @param aOnlyChanged - true to free only the layers rebuilt by the settings since
+     * their display list was made, false to free all the layers
+     */
+    void ogl_free_layers_display_lists( bool aOnlyChanged );
+
     MAP_OGL_DISP_LISTS      m_ogl_disp_lists_layers;
     MAP_OGL_DISP_LISTS      m_ogl_disp_lists_layers_holes_outer;
     MAP_OGL_DISP_LISTS      m_ogl_disp_lists_layers_holes_inner;
@@ -95,6 +107,9 @@ private:
 
     MAP_TRIANGLES           m_triangles;
 
+    /// Settings build id of the layers of m_ogl_disp_lists_layers
+    std::map< PCB_LAYER_ID, unsigned int > m_ogl_disp_lists_layers_build_id;
+
     GLuint m_ogl_circle_texture;
 
     GLuint m_ogl_disp_list_grid;    ///< oGL list that stores current grid
@@ -106,6 +121,9 @@ private:
 
     MAP_3DMODEL m_3dmodel_map;
 
+    /// Shader to draw the placements of a model at once (NULL if not supported)
+    C_OGL_INSTANCING *m_ogl_instancing;
+
 private:
     void generate_through_outer_holes();
     void generate_through_inner_holes();
@@ -184,7 +202,17 @@ private:
      */
     void render_3D_models( bool aRenderTopOrBot, bool aRenderTransparentOnly );
 
-    void render_3D_module( const MODULE* module, bool aRenderTransparentOnly );
+    /**
+     * @brief get_3D_module_instances - add the placement matrices of the
+     * models of a module to the instances of each model
+     * @param module - module to get the models from
+     * @param aRenderTransparentOnly - true will add only the models that have
+     * transparent objects, false the ones that have opaque
+     * @param aInstances - map of model to its placement matrices
+     */
+    void get_3D_module_instances( const MODULE* module,
+                                  bool aRenderTransparentOnly,
+                                  MODEL_INSTANCES_MAP &aInstances );
 
     void setLight_Front( bool enabled );
     void setLight_Top( bool enabled );
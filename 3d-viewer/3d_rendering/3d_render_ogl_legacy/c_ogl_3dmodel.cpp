@@ -27,11 +27,160 @@
  * @brief
  */
 
+#include <GL/glew.h>
 #include "c_ogl_3dmodel.h"
 #include "ogl_legacy_utils.h"
 #include "../common_ogl/ogl_utils.h"
 #include "../3d_math.h"
 #include <wx/debug.h>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <cstddef>
+
+
+// Fixed pipeline lighting of the legacy render, for a placement given by the instance
+// matrices. Light positions are already in eye coordinates and the viewer is not local.
+static const char *s_instancing_vertex_shader =
+    "#version 120\n"
+    "attribute mat4 a_model;\n"
+    "attribute mat3 a_normal;\n"
+    "uniform bool u_colorMaterial;\n"
+    "uniform bool u_lights[3];\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 eyePos = gl_ModelViewMatrix * ( a_model * gl_Vertex );\n"
+    "    vec3 normal = normalize( gl_NormalMatrix * ( a_normal * gl_Normal ) );\n"
+    "    vec4 ambient = u_colorMaterial ? gl_Color : gl_FrontMaterial.ambient;\n"
+    "    vec4 diffuse = u_colorMaterial ? gl_Color : gl_FrontMaterial.diffuse;\n"
+    "    vec4 color = gl_FrontMaterial.emission + gl_LightModel.ambient * ambient;\n"
+    "    for( int i = 0; i < 3; ++i )\n"
+    "    {\n"
+    "        if( !u_lights[i] )\n"
+    "            continue;\n"
+    "        vec4 lightPos = gl_LightSource[i].position;\n"
+    "        vec3 L = normalize( ( lightPos.w == 0.0 ) ? lightPos.xyz :\n"
+    "                                                    lightPos.xyz - eyePos.xyz );\n"
+    "        float NdotL = max( dot( normal, L ), 0.0 );\n"
+    "        color += gl_LightSource[i].ambient * ambient +\n"
+    "                 gl_LightSource[i].diffuse * diffuse * NdotL;\n"
+    "        if( NdotL > 0.0 )\n"
+    "        {\n"
+    "            vec3 H = normalize( L + vec3( 0.0, 0.0, 1.0 ) );\n"
+    "            color += gl_LightSource[i].specular * gl_FrontMaterial.specular *\n"
+    "                     pow( max( dot( normal, H ), 0.0 ), gl_FrontMaterial.shininess );\n"
+    "        }\n"
+    "    }\n"
+    "    gl_FrontColor = vec4( color.rgb, diffuse.a );\n"
+    "    gl_Position = gl_ProjectionMatrix * eyePos;\n"
+    "}\n";
+
+static const char *s_instancing_fragment_shader =
+    "#version 120\n"
+    "void main()\n"
+    "{\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n";
+
+
+/// Per-instance data of the instance buffer
+struct INSTANCE_DATA
+{
+    glm::mat4 m_model;
+    glm::mat3 m_normal;     ///< inverse transpose of the model matrix
+};
+
+
+static GLuint compile_shader( GLenum aType, const char *aSource )
+{
+    GLuint shader = glCreateShader( aType );
+    GLint  status = GL_FALSE;
+
+    glShaderSource( shader, 1, &aSource, NULL );
+    glCompileShader( shader );
+    glGetShaderiv( shader, GL_COMPILE_STATUS, &status );
+
+    if( status != GL_TRUE )
+    {
+        glDeleteShader( shader );
+        return 0;
+    }
+
+    return shader;
+}
+
+
+bool C_OGL_INSTANCING::IsSupported()
+{
+    return GLEW_VERSION_2_0 && GLEW_ARB_vertex_buffer_object &&
+           GLEW_ARB_draw_instanced && GLEW_ARB_instanced_arrays;
+}
+
+
+C_OGL_INSTANCING::C_OGL_INSTANCING()
+{
+    m_program = 0;
+    m_instance_buffer = 0;
+    m_attrib_model = -1;
+    m_attrib_normal = -1;
+    m_uniform_color_material = -1;
+    m_uniform_lights = -1;
+
+    if( !IsSupported() )
+        return;
+
+    // A driver that fails to build the shader leaves the program invalid, and the
+    // models are then drawn one placement at a time
+    const GLuint vertexShader = compile_shader( GL_VERTEX_SHADER, s_instancing_vertex_shader );
+    const GLuint fragmentShader = compile_shader( GL_FRAGMENT_SHADER,
+                                                  s_instancing_fragment_shader );
+
+    if( vertexShader && fragmentShader )
+    {
+        GLint status = GL_FALSE;
+
+        m_program = glCreateProgram();
+        glAttachShader( m_program, vertexShader );
+        glAttachShader( m_program, fragmentShader );
+        glLinkProgram( m_program );
+        glGetProgramiv( m_program, GL_LINK_STATUS, &status );
+
+        if( status == GL_TRUE )
+        {
+            m_attrib_model = glGetAttribLocation( m_program, "a_model" );
+            m_attrib_normal = glGetAttribLocation( m_program, "a_normal" );
+            m_uniform_color_material = glGetUniformLocation( m_program, "u_colorMaterial" );
+            m_uniform_lights = glGetUniformLocation( m_program, "u_lights" );
+        }
+
+        if( (status != GL_TRUE) || (m_attrib_model < 0) || (m_attrib_normal < 0) )
+        {
+            glDeleteProgram( m_program );
+            m_program = 0;
+        }
+    }
+
+    // The program keeps the shaders until it is deleted
+    if( vertexShader )
+        glDeleteShader( vertexShader );
+
+    if( fragmentShader )
+        glDeleteShader( fragmentShader );
+
+    if( m_program )
+        glGenBuffersARB( 1, &m_instance_buffer );
+}
+
+
+C_OGL_INSTANCING::~C_OGL_INSTANCING()
+{
+    if( m_instance_buffer )
+        glDeleteBuffersARB( 1, &m_instance_buffer );
+
+    if( m_program )
+        glDeleteProgram( m_program );
+
+    m_instance_buffer = 0;
+    m_program = 0;
+}
 
 
 C_OGL_3DMODEL::C_OGL_3DMODEL( const S3DMODEL &a3DModel,
@@ -42,6 +191,11 @@ C_OGL_3DMODEL::C_OGL_3DMODEL( const S3DMODEL &a3DModel,
     m_ogl_idx_list_transparent = 0;
     m_nr_meshes = 0;
     m_meshs_bbox = NULL;
+    m_vertex_buffer = 0;
+    m_index_buffer = 0;
+    m_material_mode = aMaterialMode;
+    m_have_opaque = false;
+    m_have_transparent = false;
 
     // Validate a3DModel pointers
     wxASSERT( a3DModel.m_Materials != NULL );
@@ -56,288 +210,655 @@ C_OGL_3DMODEL::C_OGL_3DMODEL( const S3DMODEL &a3DModel,
 
         m_meshs_bbox = new CBBOX[a3DModel.m_MeshesSize];
 
-        // Generate m_MeshesSize auxiliar lists to render the meshes
-        m_ogl_idx_list_meshes = glGenLists( a3DModel.m_MeshesSize );
+        // Vertex buffer objects are drawn by Draw_instances for all the placements
+        // of a model at once, the display lists are kept for older openGL drivers
+        if( GLEW_ARB_vertex_buffer_object )
+            load_buffers( a3DModel, aMaterialMode );
+        else
+            load_display_lists( a3DModel, aMaterialMode );
 
-        // Render each mesh of the model
+        // Create the main bbox
         // /////////////////////////////////////////////////////////////////////
+        m_model_bbox.Reset();
+
         for( unsigned int mesh_i = 0; mesh_i < a3DModel.m_MeshesSize; ++mesh_i )
-        {
-            if( glIsList( m_ogl_idx_list_meshes + mesh_i ) )
-            {
-                const SMESH &mesh = a3DModel.m_Meshes[mesh_i];
+            m_model_bbox.Union( m_meshs_bbox[mesh_i] );
 
-                // Validate the mesh pointers
-                wxASSERT( mesh.m_Positions != NULL );
-                wxASSERT( mesh.m_FaceIdx != NULL );
-                wxASSERT( mesh.m_Normals != NULL );
+        glFlush();
+    }
+}
 
-                if( (mesh.m_Positions != NULL) &&
-                    (mesh.m_Normals != NULL) &&
-                    (mesh.m_FaceIdx != NULL) &&
-                    (mesh.m_FaceIdxSize > 0) && (mesh.m_VertexSize > 0) )
-                {
-                    SFVEC4F *pColorRGBA = NULL;
 
-                    // Create the bbox for this mesh
-                    // /////////////////////////////////////////////////////////
-                    m_meshs_bbox[mesh_i].Reset();
+void C_OGL_3DMODEL::load_display_lists( const S3DMODEL &a3DModel, MATERIAL_MODE aMaterialMode )
+{
+    // Generate m_MeshesSize auxiliar lists to render the meshes
+    m_ogl_idx_list_meshes = glGenLists( a3DModel.m_MeshesSize );
 
-                    for( unsigned int vertex_i = 0;
-                         vertex_i < mesh.m_VertexSize;
-                         ++vertex_i )
-                    {
-                        m_meshs_bbox[mesh_i].Union( mesh.m_Positions[vertex_i] );
-                    }
+    // Render each mesh of the model
+    // /////////////////////////////////////////////////////////////////////
+    for( unsigned int mesh_i = 0; mesh_i < a3DModel.m_MeshesSize; ++mesh_i )
+    {
+        if( glIsList( m_ogl_idx_list_meshes + mesh_i ) )
+        {
+            const SMESH &mesh = a3DModel.m_Meshes[mesh_i];
 
-                    // Make sure we start with client state disabled
-                    // /////////////////////////////////////////////////////////
-                    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
-                    glDisableClientState( GL_COLOR_ARRAY );
+            // Validate the mesh pointers
+            wxASSERT( mesh.m_Positions != NULL );
+            wxASSERT( mesh.m_FaceIdx != NULL );
+            wxASSERT( mesh.m_Normals != NULL );
 
+            if( (mesh.m_Positions != NULL) &&
+                (mesh.m_Normals != NULL) &&
+                (mesh.m_FaceIdx != NULL) &&
+                (mesh.m_FaceIdxSize > 0) && (mesh.m_VertexSize > 0) )
+            {
+                SFVEC4F *pColorRGBA = NULL;
 
-                    // Enable arrays client states
-                    // /////////////////////////////////////////////////////////
-                    glEnableClientState( GL_VERTEX_ARRAY );
-                    glEnableClientState( GL_NORMAL_ARRAY );
+                // Create the bbox for this mesh
+                // /////////////////////////////////////////////////////////
+                m_meshs_bbox[mesh_i].Reset();
 
-                    glVertexPointer( 3, GL_FLOAT, 0, mesh.m_Positions );
-                    glNormalPointer( GL_FLOAT, 0, mesh.m_Normals );
+                for( unsigned int vertex_i = 0;
+                     vertex_i < mesh.m_VertexSize;
+                     ++vertex_i )
+                {
+                    m_meshs_bbox[mesh_i].Union( mesh.m_Positions[vertex_i] );
+                }
 
-                    if( mesh.m_Color != NULL )
-                    {
-                        glEnableClientState( GL_COLOR_ARRAY );
+                // Make sure we start with client state disabled
+                // /////////////////////////////////////////////////////////
+                glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+                glDisableClientState( GL_COLOR_ARRAY );
 
-                        float transparency = 0.0f;
 
-                        if( mesh.m_MaterialIdx < a3DModel.m_MaterialsSize )
-                            transparency = a3DModel.m_Materials[mesh.m_MaterialIdx].m_Transparency;
+                // Enable arrays client states
+                // /////////////////////////////////////////////////////////
+                glEnableClientState( GL_VERTEX_ARRAY );
+                glEnableClientState( GL_NORMAL_ARRAY );
 
-                        if( (transparency > FLT_EPSILON) &&
-                            (aMaterialMode ==  MATERIAL_MODE_NORMAL) )
-                        {
-                            // Create a new array of RGBA colors
-                            pColorRGBA = new SFVEC4F[mesh.m_VertexSize];
+                glVertexPointer( 3, GL_FLOAT, 0, mesh.m_Positions );
+                glNormalPointer( GL_FLOAT, 0, mesh.m_Normals );
 
-                            // Copy RGB array and add the Alpha value
-                            for( unsigned int i = 0; i < mesh.m_VertexSize; ++i )
-                                pColorRGBA[i] = SFVEC4F( mesh.m_Color[i],
-                                                         1.0f - transparency );
+                if( mesh.m_Color != NULL )
+                {
+                    glEnableClientState( GL_COLOR_ARRAY );
 
-                            // Load an RGBA array
-                            glColorPointer( 4, GL_FLOAT, 0, pColorRGBA );
-                        }
-                        else
-                        {
-                            switch( aMaterialMode )
-                            {
-                            case MATERIAL_MODE_NORMAL:
-                            case MATERIAL_MODE_DIFFUSE_ONLY:
-                                // load the original RGB color array
-                                glColorPointer( 3, GL_FLOAT, 0, mesh.m_Color );
-                                break;
-                            case MATERIAL_MODE_CAD_MODE:
-                                // Create a new array of RGBA colors
-                                pColorRGBA = new SFVEC4F[mesh.m_VertexSize];
-
-                                // Copy RGB array and add the Alpha value
-                                for( unsigned int i = 0; i < mesh.m_VertexSize; ++i )
-                                {
-                                    pColorRGBA[i] =
-                                            SFVEC4F( MaterialDiffuseToColorCAD( mesh.m_Color[i] ),
-                                                     1.0f );
-                                }
-
-                                // Load an RGBA array
-                                glColorPointer( 4, GL_FLOAT, 0, pColorRGBA );
-                                break;
-                            default:
-                                break;
-                            }
-                        }
-                    }
+                    float transparency = 0.0f;
 
-                    if( mesh.m_Texcoords != NULL )
-                    {
-                        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-                        glTexCoordPointer( 2, GL_FLOAT, 0, mesh.m_Texcoords );
-                    }
+                    if( mesh.m_MaterialIdx < a3DModel.m_MaterialsSize )
+                        transparency = a3DModel.m_Materials[mesh.m_MaterialIdx].m_Transparency;
 
-                    // Compile the display list to store triangles
-                    // /////////////////////////////////////////////////////////
-                    glNewList( m_ogl_idx_list_meshes + mesh_i, GL_COMPILE );
+                    if( (transparency > FLT_EPSILON) &&
+                        (aMaterialMode ==  MATERIAL_MODE_NORMAL) )
+                    {
+                        // Create a new array of RGBA colors
+                        pColorRGBA = new SFVEC4F[mesh.m_VertexSize];
 
-                    // Set material properties
-                    // /////////////////////////////////////////////////////////
+                        // Copy RGB array and add the Alpha value
+                        for( unsigned int i = 0; i < mesh.m_VertexSize; ++i )
+                            pColorRGBA[i] = SFVEC4F( mesh.m_Color[i],
+                                                     1.0f - transparency );
 
-                    if( mesh.m_Color != NULL )
-                    {
-                        // This enables the use of the Color Pointer information
-                        glEnable( GL_COLOR_MATERIAL );
-                        glColorMaterial( GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE );
+                        // Load an RGBA array
+                        glColorPointer( 4, GL_FLOAT, 0, pColorRGBA );
                     }
                     else
-                    {
-                        glDisable( GL_COLOR_MATERIAL );
-                    }
-
-                    if( mesh.m_MaterialIdx < a3DModel.m_MaterialsSize )
                     {
                         switch( aMaterialMode )
                         {
                         case MATERIAL_MODE_NORMAL:
-                            OGL_SetMaterial( a3DModel.m_Materials[mesh.m_MaterialIdx] );
-                            break;
                         case MATERIAL_MODE_DIFFUSE_ONLY:
-                            OGL_SetDiffuseOnlyMaterial(
-                                        a3DModel.m_Materials[mesh.m_MaterialIdx].m_Diffuse );
+                            // load the original RGB color array
+                            glColorPointer( 3, GL_FLOAT, 0, mesh.m_Color );
                             break;
                         case MATERIAL_MODE_CAD_MODE:
-                            OGL_SetDiffuseOnlyMaterial(
-                                        MaterialDiffuseToColorCAD(
-                                            a3DModel.m_Materials[mesh.m_MaterialIdx].m_Diffuse ) );
+                            // Create a new array of RGBA colors
+                            pColorRGBA = new SFVEC4F[mesh.m_VertexSize];
+
+                            // Copy RGB array and add the Alpha value
+                            for( unsigned int i = 0; i < mesh.m_VertexSize; ++i )
+                            {
+                                pColorRGBA[i] =
+                                        SFVEC4F( MaterialDiffuseToColorCAD( mesh.m_Color[i] ),
+                                                 1.0f );
+                            }
+
+                            // Load an RGBA array
+                            glColorPointer( 4, GL_FLOAT, 0, pColorRGBA );
                             break;
                         default:
                             break;
                         }
                     }
+                }
+
+                if( mesh.m_Texcoords != NULL )
+                {
+                    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+                    glTexCoordPointer( 2, GL_FLOAT, 0, mesh.m_Texcoords );
+                }
+
+                // Compile the display list to store triangles
+                // /////////////////////////////////////////////////////////
+                glNewList( m_ogl_idx_list_meshes + mesh_i, GL_COMPILE );
 
-                    // Draw mesh
-                    // /////////////////////////////////////////////////////////
-                    glDrawElements( GL_TRIANGLES, mesh.m_FaceIdxSize,
-                                    GL_UNSIGNED_INT, mesh.m_FaceIdx );
+                // Set material properties
+                // /////////////////////////////////////////////////////////
 
+                if( mesh.m_Color != NULL )
+                {
+                    // This enables the use of the Color Pointer information
+                    glEnable( GL_COLOR_MATERIAL );
+                    glColorMaterial( GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE );
+                }
+                else
+                {
                     glDisable( GL_COLOR_MATERIAL );
+                }
 
-                    glEndList();
+                if( mesh.m_MaterialIdx < a3DModel.m_MaterialsSize )
+                {
+                    switch( aMaterialMode )
+                    {
+                    case MATERIAL_MODE_NORMAL:
+                        OGL_SetMaterial( a3DModel.m_Materials[mesh.m_MaterialIdx] );
+                        break;
+                    case MATERIAL_MODE_DIFFUSE_ONLY:
+                        OGL_SetDiffuseOnlyMaterial(
+                                    a3DModel.m_Materials[mesh.m_MaterialIdx].m_Diffuse );
+                        break;
+                    case MATERIAL_MODE_CAD_MODE:
+                        OGL_SetDiffuseOnlyMaterial(
+                                    MaterialDiffuseToColorCAD(
+                                        a3DModel.m_Materials[mesh.m_MaterialIdx].m_Diffuse ) );
+                        break;
+                    default:
+                        break;
+                    }
+                }
 
-                    // Disable arrays client states
-                    // /////////////////////////////////////////////////////////
-                    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
-                    glDisableClientState( GL_COLOR_ARRAY );
-                    glDisableClientState( GL_NORMAL_ARRAY );
-                    glDisableClientState( GL_VERTEX_ARRAY );
+                // Draw mesh
+                // /////////////////////////////////////////////////////////
+                glDrawElements( GL_TRIANGLES, mesh.m_FaceIdxSize,
+                                GL_UNSIGNED_INT, mesh.m_FaceIdx );
 
-                    glFlush();
+                glDisable( GL_COLOR_MATERIAL );
 
-                    delete [] pColorRGBA;
-                }
+                glEndList();
+
+                // Disable arrays client states
+                // /////////////////////////////////////////////////////////
+                glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+                glDisableClientState( GL_COLOR_ARRAY );
+                glDisableClientState( GL_NORMAL_ARRAY );
+                glDisableClientState( GL_VERTEX_ARRAY );
+
+                glFlush();
+
+                delete [] pColorRGBA;
             }
-        }// for each mesh
+        }
+    }// for each mesh
+
 
+    m_ogl_idx_list_opaque = glGenLists( 1 );
 
-        m_ogl_idx_list_opaque = glGenLists( 1 );
+    // Check if the generated list is valid
+    if( glIsList( m_ogl_idx_list_opaque ) )
+    {
+        bool have_opaque_meshes = false;
+        bool have_transparent_meshes = false;
 
-        // Check if the generated list is valid
-        if( glIsList( m_ogl_idx_list_opaque ) )
+        // Compile the model display list
+        glNewList( m_ogl_idx_list_opaque, GL_COMPILE );
+
+        // Render each mesh display list (opaque first)
+        // /////////////////////////////////////////////////////////////////
+        for( unsigned int mesh_i = 0; mesh_i < a3DModel.m_MeshesSize; ++mesh_i )
         {
-            bool have_opaque_meshes = false;
-            bool have_transparent_meshes = false;
+            const SMESH &mesh = a3DModel.m_Meshes[mesh_i];
+
+            if( mesh.m_MaterialIdx < a3DModel.m_MaterialsSize )
+            {
+                const SMATERIAL &material = a3DModel.m_Materials[mesh.m_MaterialIdx];
 
-            // Compile the model display list
-            glNewList( m_ogl_idx_list_opaque, GL_COMPILE );
+                if( material.m_Transparency == 0.0f )
+                {
+                    have_opaque_meshes = true; // Flag that we have at least one opaque mesh
+                    glCallList( m_ogl_idx_list_meshes + mesh_i );
+                }
+                else
+                {
+                    have_transparent_meshes = true; // Flag that we found a transparent mesh
+                }
+            }
+        }
 
-            // Render each mesh display list (opaque first)
-            // /////////////////////////////////////////////////////////////////
-            for( unsigned int mesh_i = 0; mesh_i < a3DModel.m_MeshesSize; ++mesh_i )
+        glEndList();
+
+        if( !have_opaque_meshes )
+        {
+            // If we dont have opaque meshes, we can free the list
+            glDeleteLists( m_ogl_idx_list_opaque, 1 );
+            m_ogl_idx_list_opaque = 0;
+        }
+
+        if( have_transparent_meshes )
+        {
+            m_ogl_idx_list_transparent = glGenLists( 1 );
+
+            // Check if the generated list is valid
+            if( glIsList( m_ogl_idx_list_transparent ) )
             {
-                const SMESH &mesh = a3DModel.m_Meshes[mesh_i];
+                // Compile the model display list
+                glNewList( m_ogl_idx_list_transparent, GL_COMPILE );
 
-                if( mesh.m_MaterialIdx < a3DModel.m_MaterialsSize )
+                glEnable( GL_BLEND );
+                glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+                // Render each mesh display list
+                // /////////////////////////////////////////////////////////
+                for( unsigned mesh_i = 0; mesh_i < a3DModel.m_MeshesSize; ++mesh_i )
                 {
-                    const SMATERIAL &material = a3DModel.m_Materials[mesh.m_MaterialIdx];
+                    const SMESH &mesh = a3DModel.m_Meshes[mesh_i];
 
-                    if( material.m_Transparency == 0.0f )
-                    {
-                        have_opaque_meshes = true; // Flag that we have at least one opaque mesh
-                        glCallList( m_ogl_idx_list_meshes + mesh_i );
-                    }
-                    else
+                    if( mesh.m_MaterialIdx < a3DModel.m_MaterialsSize )
                     {
-                        have_transparent_meshes = true; // Flag that we found a transparent mesh
+                        const SMATERIAL &material = a3DModel.m_Materials[mesh.m_MaterialIdx];
+
+                        // Render the transparent mesh if it have a transparency value
+                        if( material.m_Transparency != 0.0f )
+                            glCallList( m_ogl_idx_list_meshes + mesh_i );
                     }
                 }
-            }
 
-            glEndList();
+                glDisable( GL_BLEND );
 
-            if( !have_opaque_meshes )
+                glEndList();
+            }
+            else
             {
-                // If we dont have opaque meshes, we can free the list
-                glDeleteLists( m_ogl_idx_list_opaque, 1 );
-                m_ogl_idx_list_opaque = 0;
+                m_ogl_idx_list_transparent = 0;
             }
+        }
+    }
+    else
+    {
+        m_ogl_idx_list_opaque = 0;
+    }
 
-            if( have_transparent_meshes )
-            {
-                m_ogl_idx_list_transparent = glGenLists( 1 );
+    m_have_opaque = glIsList( m_ogl_idx_list_opaque );
+    m_have_transparent = glIsList( m_ogl_idx_list_transparent );
+}
 
-                // Check if the generated list is valid
-                if( glIsList( m_ogl_idx_list_transparent ) )
-                {
-                    // Compile the model display list
-                    glNewList( m_ogl_idx_list_transparent, GL_COMPILE );
 
-                    glEnable( GL_BLEND );
-                    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+/// Vertex layout of the vertex buffer objects
+struct MODEL_VERTEX
+{
+    SFVEC3F m_pos;
+    SFVEC3F m_normal;
+    SFVEC4F m_color;
+};
 
-                    // Render each mesh display list
-                    // /////////////////////////////////////////////////////////
-                    for( unsigned mesh_i = 0; mesh_i < a3DModel.m_MeshesSize; ++mesh_i )
-                    {
-                        const SMESH &mesh = a3DModel.m_Meshes[mesh_i];
 
-                        if( mesh.m_MaterialIdx < a3DModel.m_MaterialsSize )
-                        {
-                            const SMATERIAL &material = a3DModel.m_Materials[mesh.m_MaterialIdx];
+void C_OGL_3DMODEL::load_buffers( const S3DMODEL &a3DModel, MATERIAL_MODE aMaterialMode )
+{
+    std::vector<MODEL_VERTEX> vertexes;
+    std::vector<GLuint> indexes;
 
-                            // Render the transparent mesh if it have a transparency value
-                            if( material.m_Transparency != 0.0f )
-                                glCallList( m_ogl_idx_list_meshes + mesh_i );
-                        }
-                    }
+    for( unsigned int mesh_i = 0; mesh_i < a3DModel.m_MeshesSize; ++mesh_i )
+    {
+        const SMESH &mesh = a3DModel.m_Meshes[mesh_i];
 
-                    glDisable( GL_BLEND );
+        // Validate the mesh pointers
+        wxASSERT( mesh.m_Positions != NULL );
+        wxASSERT( mesh.m_FaceIdx != NULL );
+        wxASSERT( mesh.m_Normals != NULL );
 
-                    glEndList();
-                }
+        // Meshes without a valid material are not rendered by the display lists either
+        if( (mesh.m_Positions == NULL) ||
+            (mesh.m_Normals == NULL) ||
+            (mesh.m_FaceIdx == NULL) ||
+            (mesh.m_FaceIdxSize == 0) || (mesh.m_VertexSize == 0) ||
+            (mesh.m_MaterialIdx >= a3DModel.m_MaterialsSize) )
+            continue;
+
+        const SMATERIAL &material = a3DModel.m_Materials[mesh.m_MaterialIdx];
+
+        // Create the bbox for this mesh
+        m_meshs_bbox[mesh_i].Reset();
+
+        for( unsigned int vertex_i = 0; vertex_i < mesh.m_VertexSize; ++vertex_i )
+            m_meshs_bbox[mesh_i].Union( mesh.m_Positions[vertex_i] );
+
+        MESH_RANGE range;
+
+        range.m_first = indexes.size();
+        range.m_count = mesh.m_FaceIdxSize;
+        range.m_material = material;
+        range.m_have_colors = mesh.m_Color != NULL;
+        range.m_transparent = material.m_Transparency != 0.0f;
+
+        if( range.m_transparent )
+            m_have_transparent = true;
+        else
+            m_have_opaque = true;
+
+        // Same colors as loaded by the display lists
+        const float alpha = ( (material.m_Transparency > FLT_EPSILON) &&
+                              (aMaterialMode == MATERIAL_MODE_NORMAL) ) ?
+                            1.0f - material.m_Transparency : 1.0f;
+
+        const GLuint firstVertex = vertexes.size();
+
+        for( unsigned int vertex_i = 0; vertex_i < mesh.m_VertexSize; ++vertex_i )
+        {
+            MODEL_VERTEX vertex;
+
+            vertex.m_pos = mesh.m_Positions[vertex_i];
+            vertex.m_normal = mesh.m_Normals[vertex_i];
+            vertex.m_color = SFVEC4F( 1.0f );
+
+            if( mesh.m_Color != NULL )
+            {
+                if( aMaterialMode == MATERIAL_MODE_CAD_MODE )
+                    vertex.m_color = SFVEC4F( MaterialDiffuseToColorCAD( mesh.m_Color[vertex_i] ),
+                                              1.0f );
                 else
-                {
-                    m_ogl_idx_list_transparent = 0;
-                }
+                    vertex.m_color = SFVEC4F( mesh.m_Color[vertex_i], alpha );
             }
+
+            vertexes.push_back( vertex );
         }
-        else
+
+        for( unsigned int idx = 0; idx < mesh.m_FaceIdxSize; ++idx )
         {
-            m_ogl_idx_list_opaque = 0;
+            wxASSERT( mesh.m_FaceIdx[idx] < mesh.m_VertexSize );
+
+            indexes.push_back( firstVertex + mesh.m_FaceIdx[idx] );
         }
 
-        // Create the main bbox
-        // /////////////////////////////////////////////////////////////////////
-        m_model_bbox.Reset();
+        m_mesh_ranges.push_back( range );
+    }
 
-        for( unsigned int mesh_i = 0; mesh_i < a3DModel.m_MeshesSize; ++mesh_i )
-            m_model_bbox.Union( m_meshs_bbox[mesh_i] );
+    if( indexes.empty() )
+        return;
 
-        glFlush();
+    glGenBuffersARB( 1, &m_vertex_buffer );
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_vertex_buffer );
+    glBufferDataARB( GL_ARRAY_BUFFER_ARB, vertexes.size() * sizeof( MODEL_VERTEX ),
+                     vertexes.data(), GL_STATIC_DRAW_ARB );
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+
+    glGenBuffersARB( 1, &m_index_buffer );
+    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, m_index_buffer );
+    glBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB, indexes.size() * sizeof( GLuint ),
+                     indexes.data(), GL_STATIC_DRAW_ARB );
+    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+}
+
+
+void C_OGL_3DMODEL::set_range_material( const MESH_RANGE &aRange ) const
+{
+    if( aRange.m_have_colors )
+    {
+        // This enables the use of the Color Pointer information
+        glEnableClientState( GL_COLOR_ARRAY );
+        glEnable( GL_COLOR_MATERIAL );
+        glColorMaterial( GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE );
+    }
+    else
+    {
+        glDisableClientState( GL_COLOR_ARRAY );
+        glDisable( GL_COLOR_MATERIAL );
+    }
+
+    switch( m_material_mode )
+    {
+    case MATERIAL_MODE_NORMAL:
+        OGL_SetMaterial( aRange.m_material );
+        break;
+    case MATERIAL_MODE_DIFFUSE_ONLY:
+        OGL_SetDiffuseOnlyMaterial( aRange.m_material.m_Diffuse );
+        break;
+    case MATERIAL_MODE_CAD_MODE:
+        OGL_SetDiffuseOnlyMaterial( MaterialDiffuseToColorCAD( aRange.m_material.m_Diffuse ) );
+        break;
+    default:
+        break;
+    }
+}
+
+
+void C_OGL_3DMODEL::draw_buffers( bool aTransparent, const glm::mat4 *aInstances,
+                                  unsigned int aNrInstances ) const
+{
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_vertex_buffer );
+    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, m_index_buffer );
+
+    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_NORMAL_ARRAY );
+
+    glVertexPointer( 3, GL_FLOAT, sizeof( MODEL_VERTEX ),
+                     reinterpret_cast<const void*>( offsetof( MODEL_VERTEX, m_pos ) ) );
+    glNormalPointer( GL_FLOAT, sizeof( MODEL_VERTEX ),
+                     reinterpret_cast<const void*>( offsetof( MODEL_VERTEX, m_normal ) ) );
+    glColorPointer( 4, GL_FLOAT, sizeof( MODEL_VERTEX ),
+                    reinterpret_cast<const void*>( offsetof( MODEL_VERTEX, m_color ) ) );
+
+    if( aTransparent )
+    {
+        glEnable( GL_BLEND );
+        glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    }
+
+    for( const MESH_RANGE &range : m_mesh_ranges )
+    {
+        if( range.m_transparent != aTransparent )
+            continue;
+
+        set_range_material( range );
+
+        const void *firstIndex = reinterpret_cast<const void*>( range.m_first * sizeof( GLuint ) );
+
+        if( !aInstances )
+        {
+            glDrawElements( GL_TRIANGLES, range.m_count, GL_UNSIGNED_INT, firstIndex );
+            continue;
+        }
+
+        for( unsigned int i = 0; i < aNrInstances; ++i )
+        {
+            glPushMatrix();
+            glMultMatrixf( &aInstances[i][0][0] );
+
+            glDrawElements( GL_TRIANGLES, range.m_count, GL_UNSIGNED_INT, firstIndex );
+
+            glPopMatrix();
+        }
     }
+
+    if( aTransparent )
+        glDisable( GL_BLEND );
+
+    glDisable( GL_COLOR_MATERIAL );
+
+    glDisableClientState( GL_COLOR_ARRAY );
+    glDisableClientState( GL_NORMAL_ARRAY );
+    glDisableClientState( GL_VERTEX_ARRAY );
+
+    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+}
+
+
+void C_OGL_3DMODEL::draw_buffers_instanced( bool aTransparent,
+                                            const std::vector<glm::mat4> &aInstances,
+                                            const C_OGL_INSTANCING &aInstancing ) const
+{
+    std::vector<INSTANCE_DATA> instances( aInstances.size() );
+
+    for( unsigned int i = 0; i < aInstances.size(); ++i )
+    {
+        instances[i].m_model = aInstances[i];
+        instances[i].m_normal = glm::inverseTranspose( glm::mat3( aInstances[i] ) );
+    }
+
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, aInstancing.m_instance_buffer );
+    glBufferDataARB( GL_ARRAY_BUFFER_ARB, instances.size() * sizeof( INSTANCE_DATA ),
+                     instances.data(), GL_STREAM_DRAW_ARB );
+
+    // One attribute location for each column of the matrices
+    for( unsigned int col = 0; col < 4; ++col )
+    {
+        const GLuint attrib = aInstancing.m_attrib_model + col;
+
+        glEnableVertexAttribArray( attrib );
+        glVertexAttribPointer( attrib, 4, GL_FLOAT, GL_FALSE, sizeof( INSTANCE_DATA ),
+                               reinterpret_cast<const void*>( offsetof( INSTANCE_DATA, m_model ) +
+                                                              col * sizeof( glm::vec4 ) ) );
+        glVertexAttribDivisorARB( attrib, 1 );
+    }
+
+    for( unsigned int col = 0; col < 3; ++col )
+    {
+        const GLuint attrib = aInstancing.m_attrib_normal + col;
+
+        glEnableVertexAttribArray( attrib );
+        glVertexAttribPointer( attrib, 3, GL_FLOAT, GL_FALSE, sizeof( INSTANCE_DATA ),
+                               reinterpret_cast<const void*>( offsetof( INSTANCE_DATA, m_normal ) +
+                                                              col * sizeof( glm::vec3 ) ) );
+        glVertexAttribDivisorARB( attrib, 1 );
+    }
+
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, m_vertex_buffer );
+    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, m_index_buffer );
+
+    glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_NORMAL_ARRAY );
+
+    glVertexPointer( 3, GL_FLOAT, sizeof( MODEL_VERTEX ),
+                     reinterpret_cast<const void*>( offsetof( MODEL_VERTEX, m_pos ) ) );
+    glNormalPointer( GL_FLOAT, sizeof( MODEL_VERTEX ),
+                     reinterpret_cast<const void*>( offsetof( MODEL_VERTEX, m_normal ) ) );
+    glColorPointer( 4, GL_FLOAT, sizeof( MODEL_VERTEX ),
+                    reinterpret_cast<const void*>( offsetof( MODEL_VERTEX, m_color ) ) );
+
+    glUseProgram( aInstancing.m_program );
+
+    // The lights are switched on and off by the render, follow their current state
+    const GLint lights[3] = { glIsEnabled( GL_LIGHT0 ),
+                              glIsEnabled( GL_LIGHT1 ),
+                              glIsEnabled( GL_LIGHT2 ) };
+
+    glUniform1iv( aInstancing.m_uniform_lights, 3, lights );
+
+    if( aTransparent )
+    {
+        glEnable( GL_BLEND );
+        glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    }
+
+    for( const MESH_RANGE &range : m_mesh_ranges )
+    {
+        if( range.m_transparent != aTransparent )
+            continue;
+
+        set_range_material( range );
+
+        glUniform1i( aInstancing.m_uniform_color_material, range.m_have_colors );
+
+        glDrawElementsInstancedARB( GL_TRIANGLES, range.m_count, GL_UNSIGNED_INT,
+                                    reinterpret_cast<const void*>( range.m_first *
+                                                                   sizeof( GLuint ) ),
+                                    aInstances.size() );
+    }
+
+    glUseProgram( 0 );
+
+    if( aTransparent )
+        glDisable( GL_BLEND );
+
+    glDisable( GL_COLOR_MATERIAL );
+
+    glDisableClientState( GL_COLOR_ARRAY );
+    glDisableClientState( GL_NORMAL_ARRAY );
+    glDisableClientState( GL_VERTEX_ARRAY );
+
+    for( unsigned int col = 0; col < 4; ++col )
+    {
+        glVertexAttribDivisorARB( aInstancing.m_attrib_model + col, 0 );
+        glDisableVertexAttribArray( aInstancing.m_attrib_model + col );
+    }
+
+    for( unsigned int col = 0; col < 3; ++col )
+    {
+        glVertexAttribDivisorARB( aInstancing.m_attrib_normal + col, 0 );
+        glDisableVertexAttribArray( aInstancing.m_attrib_normal + col );
+    }
+
+    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
 }
 
 
 void C_OGL_3DMODEL::Draw_opaque() const
 {
-    if( glIsList( m_ogl_idx_list_opaque ) )
+    if( m_vertex_buffer )
+        draw_buffers( false, NULL, 0 );
+    else if( glIsList( m_ogl_idx_list_opaque ) )
         glCallList( m_ogl_idx_list_opaque );
 }
 
 
 void C_OGL_3DMODEL::Draw_transparent() const
 {
-    if( glIsList( m_ogl_idx_list_transparent ) )
+    if( m_vertex_buffer )
+        draw_buffers( true, NULL, 0 );
+    else if( glIsList( m_ogl_idx_list_transparent ) )
         glCallList( m_ogl_idx_list_transparent );
 }
 
 
+void C_OGL_3DMODEL::Draw_instances( bool aTransparent,
+                                    const std::vector<glm::mat4> &aInstances,
+                                    const C_OGL_INSTANCING *aInstancing ) const
+{
+    if( aInstances.empty() )
+        return;
+
+    // Drivers without instancing (e.g. older Mesa) draw the placements one by one
+    if( m_vertex_buffer && aInstancing && aInstancing->IsValid() )
+    {
+        draw_buffers_instanced( aTransparent, aInstances, *aInstancing );
+        return;
+    }
+
+    if( m_vertex_buffer )
+    {
+        draw_buffers( aTransparent, aInstances.data(), aInstances.size() );
+        return;
+    }
+
+    for( const glm::mat4 &instance : aInstances )
+    {
+        glPushMatrix();
+        glMultMatrixf( &instance[0][0] );
+
+        if( aTransparent )
+            Draw_transparent();
+        else
+            Draw_opaque();
+
+        glPopMatrix();
+    }
+}
+
+
 C_OGL_3DMODEL::~C_OGL_3DMODEL()
 {
     if( glIsList( m_ogl_idx_list_opaque ) )
@@ -349,6 +870,15 @@ C_OGL_3DMODEL::~C_OGL_3DMODEL()
     if( glIsList( m_ogl_idx_list_meshes ) )
         glDeleteLists( m_ogl_idx_list_meshes, m_nr_meshes );
 
+    if( m_vertex_buffer )
+        glDeleteBuffersARB( 1, &m_vertex_buffer );
+
+    if( m_index_buffer )
+        glDeleteBuffersARB( 1, &m_index_buffer );
+
+    m_vertex_buffer = 0;
+    m_index_buffer = 0;
+
     m_ogl_idx_list_meshes = 0;
     m_ogl_idx_list_opaque = 0;
     m_ogl_idx_list_transparent = 0;
@@ -373,11 +903,11 @@ void C_OGL_3DMODEL::Draw_bboxes() const
 
 bool C_OGL_3DMODEL::Have_opaque() const
 {
-    return glIsList( m_ogl_idx_list_opaque );
+    return m_have_opaque;
 }
 
 
 bool C_OGL_3DMODEL::Have_transparent() const
 {
-    return glIsList( m_ogl_idx_list_transparent );
+    return m_have_transparent;
 }
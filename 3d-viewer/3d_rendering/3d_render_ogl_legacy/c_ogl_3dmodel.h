@@ -34,8 +34,46 @@
 #include "../../common_ogl/openGL_includes.h"
 #include "../3d_render_raytracing/shapes3D/cbbox.h"
 #include "../../3d_enums.h"
+#include <vector>
+
+
+/**
+ * @brief C_OGL_INSTANCING - shader and buffer used to draw all the placements of a
+ * model with one instanced call per mesh. The shader reproduces the fixed pipeline
+ * lighting (lights 0 to 2, color material) used by the legacy render.
+ */
+class C_OGL_INSTANCING
+{
+public:
+    /**
+     * @brief C_OGL_INSTANCING - Create the shader. This must be called inside a gl context
+     */
+    C_OGL_INSTANCING();
+
+    ~C_OGL_INSTANCING();
+
+    /**
+     * @brief IsSupported - return true if the current context can draw instanced
+     */
+    static bool IsSupported();
+
+    /**
+     * @brief IsValid - return true if the shader was created and linked
+     */
+    bool IsValid() const { return m_program != 0; }
+
+private:
+    friend class C_OGL_3DMODEL;
+
+    GLuint  m_program;
+    GLuint  m_instance_buffer;          ///< per-instance model and normal matrices
+    GLint   m_attrib_model;             ///< first of the 4 model matrix columns
+    GLint   m_attrib_normal;            ///< first of the 3 normal matrix columns
+    GLint   m_uniform_color_material;
+    GLint   m_uniform_lights;
+};
+
 
-/// 
 class  C_OGL_3DMODEL
 {
 public:
@@ -58,6 +96,17 @@ public:
      */
     void Draw_transparent() const;
 
+    /**
+     * @brief Draw_instances - render the model once for each placement. The buffers
+     * and the material of each mesh are set only once for all the placements.
+     * @param aTransparent: true to render the transparent meshes, false the opaque ones
+     * @param aInstances: the placements, multiplied to the current modelview matrix
+     * @param aInstancing: shader to draw all the placements at once, or NULL to draw
+     * them one by one
+     */
+    void Draw_instances( bool aTransparent, const std::vector<glm::mat4> &aInstances,
+                         const C_OGL_INSTANCING *aInstancing = NULL ) const;
+
     /**
      * @brief Have_opaque - return true if have opaque meshs to render
      */
@@ -85,11 +134,38 @@ public:
     const CBBOX &GetBBox() const { return m_model_bbox; }
 
 private:
+    /// A mesh on the index buffer, when the model uses vertex buffer objects
+    struct MESH_RANGE
+    {
+        unsigned int m_first;           ///< first index of the mesh
+        unsigned int m_count;           ///< number of indexes of the mesh
+        SMATERIAL    m_material;
+        bool         m_have_colors;     ///< the vertexes have their own color
+        bool         m_transparent;
+    };
+
+    void load_display_lists( const S3DMODEL &a3DModel, MATERIAL_MODE aMaterialMode );
+    void load_buffers( const S3DMODEL &a3DModel, MATERIAL_MODE aMaterialMode );
+
+    void draw_buffers( bool aTransparent, const glm::mat4 *aInstances,
+                       unsigned int aNrInstances ) const;
+    void draw_buffers_instanced( bool aTransparent, const std::vector<glm::mat4> &aInstances,
+                                 const C_OGL_INSTANCING &aInstancing ) const;
+    void set_range_material( const MESH_RANGE &aRange ) const;
+
     GLuint  m_ogl_idx_list_opaque;      ///< display list for rendering opaque meshes
     GLuint  m_ogl_idx_list_transparent; ///< display list for rendering transparent meshes
     GLuint  m_ogl_idx_list_meshes;      ///< display lists for all meshes.
     unsigned int m_nr_meshes;           ///< number of meshes of this model
 
+    GLuint  m_vertex_buffer;            ///< vertexes of all the meshes (0 if not used)
+    GLuint  m_index_buffer;             ///< indexes of all the meshes (0 if not used)
+    std::vector<MESH_RANGE> m_mesh_ranges;
+    MATERIAL_MODE m_material_mode;
+
+    bool    m_have_opaque;
+    bool    m_have_transparent;
+
     CBBOX   m_model_bbox;               ///< global bounding box for this model
     CBBOX  *m_meshs_bbox;               ///< individual bbox for each mesh
 };
@@ -31,12 +31,16 @@
 #include <wx/debug.h>
 
 
-#define BVH_RANGED_TRAVERSAL
+#define BVH4_RANGED_TRAVERSAL
+//#define BVH_RANGED_TRAVERSAL
 //#define BVH_PARTITION_TRAVERSAL
 
 
 #define MAX_TODOS 64
 
+// Each level of the 4-wide BVH may push up to 3 nodes more than it pops
+#define MAX_TODOS4 ( 3 * MAX_TODOS )
+
 
 struct StackNode
 {
@@ -70,7 +74,7 @@ static inline unsigned int getFirstHit( const RAYPACKET &aRayPacket,
 }
 
 
-#ifdef BVH_RANGED_TRAVERSAL
+#if defined( BVH_RANGED_TRAVERSAL ) || defined( BVH4_RANGED_TRAVERSAL )
 
 static inline unsigned int getLastHit( const RAYPACKET &aRayPacket,
                                        const CBBOX &aBBox,
@@ -89,10 +93,158 @@ static inline unsigned int getLastHit( const RAYPACKET &aRayPacket,
     return ia + 1;
 }
 
+#endif
+
 
 // "Large Ray Packets for Real-time Whitted Ray Tracing"
 // http://cseweb.ucsd.edu/~ravir/whitted.pdf
 
+#ifdef BVH4_RANGED_TRAVERSAL
+
+// Ranged Traversal of the 4-wide BVH: for each child, the first ray of the
+// packet that hits it is found testing the 4 children at once for each ray
+bool CBVH_PBRT::Intersect( const RAYPACKET &aRayPacket,
+                           HITINFO_PACKET *aHitInfoPacket ) const
+{
+    if( m_nodes == NULL )
+        return false;
+
+    bool anyHitted = false;
+    int todoOffset = 0;
+    StackNode todo[MAX_TODOS4];
+
+    todo[todoOffset++] = { 0, 0 };
+
+    while( todoOffset > 0 )
+    {
+        const StackNode current = todo[--todoOffset];
+
+        if( current.cell < 0 )
+        {
+            // Leaf of the binary tree, the rays may have found nearer hits
+            // since it was pushed
+            const int nodeNum = ~current.cell;
+            const LinearBVHNode *curCell = &m_nodes[nodeNum];
+
+            const unsigned int ia = getFirstHit( aRayPacket,
+                                                 curCell->bounds,
+                                                 current.ia,
+                                                 aHitInfoPacket );
+
+            if( ia >= RAYPACKET_RAYS_PER_PACKET )
+                continue;
+
+            const unsigned int ie = getLastHit( aRayPacket,
+                                                curCell->bounds,
+                                                ia,
+                                                aHitInfoPacket );
+
+            for( int j = 0; j < curCell->nPrimitives; ++j )
+            {
+                const COBJECT *obj = m_primitives[curCell->primitivesOffset + j];
+
+                if( aRayPacket.m_Frustum.Intersect( obj->GetBBox() ) )
+                {
+                    for( unsigned int i = ia; i < ie; ++i )
+                    {
+                        const bool hitted = obj->Intersect( aRayPacket.m_ray[i],
+                                                            aHitInfoPacket[i].m_HitInfo );
+
+                        if( hitted )
+                        {
+                            anyHitted |= hitted;
+                            aHitInfoPacket[i].m_hitresult |= hitted;
+                            aHitInfoPacket[i].m_HitInfo.m_acc_node_info = nodeNum;
+                        }
+                    }
+                }
+            }
+
+            continue;
+        }
+
+        const LinearBVH4Node &node4 = m_nodes4[current.cell];
+
+        unsigned int firstHit[4] = { 0, 0, 0, 0 };
+        float        dist[4]     = { 0.0f, 0.0f, 0.0f, 0.0f };
+        int          pending = ( 1 << node4.nChildren ) - 1;
+        int          hitMask = 0;
+
+        for( unsigned int i = current.ia; ( i < RAYPACKET_RAYS_PER_PACKET ) && pending; ++i )
+        {
+            float rayDist[4];
+            const int mask = intersectBVH4Node( node4,
+                                                aRayPacket.m_ray[i],
+                                                aHitInfoPacket[i].m_HitInfo.m_tHit,
+                                                rayDist ) & pending;
+
+            for( int c = 0; c < 4; ++c )
+            {
+                if( mask & ( 1 << c ) )
+                {
+                    firstHit[c] = i;
+                    dist[c] = rayDist[c];
+                }
+            }
+
+            pending &= ~mask;
+            hitMask |= mask;
+
+            // The children missed by the first ray are only searched further if
+            // they are inside the frustum of the packet
+            if( ( i == current.ia ) && pending )
+            {
+                for( int c = 0; c < 4; ++c )
+                {
+                    if( !( pending & ( 1 << c ) ) )
+                        continue;
+
+                    const CBBOX childBBox( SFVEC3F( node4.bounds[0][c],
+                                                    node4.bounds[1][c],
+                                                    node4.bounds[2][c] ),
+                                           SFVEC3F( node4.bounds[3][c],
+                                                    node4.bounds[4][c],
+                                                    node4.bounds[5][c] ) );
+
+                    if( !aRayPacket.m_Frustum.Intersect( childBBox ) )
+                        pending &= ~( 1 << c );
+                }
+            }
+        }
+
+        // Push the children hit, farthest first, so the nearest is popped next
+        int order[4];
+        int nHit = 0;
+
+        for( int c = 0; c < 4; ++c )
+        {
+            if( !( hitMask & ( 1 << c ) ) )
+                continue;
+
+            int j = nHit++;
+
+            for( ; ( j > 0 ) && ( dist[order[j - 1]] < dist[c] ); --j )
+                order[j] = order[j - 1];
+
+            order[j] = c;
+        }
+
+        for( int k = 0; k < nHit; ++k )
+        {
+            wxASSERT( todoOffset < MAX_TODOS4 );
+
+            todo[todoOffset++] = { node4.children[order[k]], firstHit[order[k]] };
+        }
+    }
+
+    return anyHitted;
+
+}// Ranged Traversal of the 4-wide BVH
+#endif
+
+
+#ifdef BVH_RANGED_TRAVERSAL
+
 // Ranged Traversal
 bool CBVH_PBRT::Intersect( const RAYPACKET &aRayPacket,
                            HITINFO_PACKET *aHitInfoPacket ) const
@@ -76,6 +76,11 @@
 #include <stack>
 #include <wx/debug.h>
 
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define BVH4_USE_SSE
+#include <xmmintrin.h>
+#endif
+
 #ifdef PRINT_STATISTICS_3D_VIEWER
 #include <stdio.h>
 #endif
@@ -304,8 +309,23 @@ CBVH_PBRT::CBVH_PBRT( const CGENERICCONTAINER &aObjectContainer,
 
     wxASSERT( offset == (unsigned int)totalNodes );
 
+    // Collapse it to a 4-wide BVH for the traversals
+    m_nodes4.reserve( totalNodes / 2 + 1 );
+
+    if( m_nodes[0].nPrimitives > 0 )
+    {
+        m_nodes4.emplace_back();
+        m_nodes4[0].nChildren = 1;
+        setBVH4Child( 0, 0, 0 );
+    }
+    else
+    {
+        collapseBVH4( 0 );
+    }
+
 #ifdef PRINT_STATISTICS_3D_VIEWER
     uint32_t treeBytes = totalNodes * sizeof( LinearBVHNode ) + sizeof( *this ) +
+                         m_nodes4.size() * sizeof( LinearBVH4Node ) +
                          m_primitives.size() * sizeof( m_primitives[0] ) +
                          m_addresses_pointer_to_mm_free.size() * sizeof( void * );
 
@@ -1124,8 +1144,149 @@ int CBVH_PBRT::flattenBVHTree( BVHBuildNode *node, uint32_t *offset )
 }
 
 
+void CBVH_PBRT::setBVH4Child( int aNode4, int aSlot, int aBinaryNode )
+{
+    LinearBVH4Node &node4 = m_nodes4[aNode4];
+    const CBBOX &bounds = m_nodes[aBinaryNode].bounds;
+
+    for( int axis = 0; axis < 3; ++axis )
+    {
+        node4.bounds[axis][aSlot]     = bounds.Min()[axis];
+        node4.bounds[axis + 3][aSlot] = bounds.Max()[axis];
+    }
+
+    // Leaves are referred by their index on the binary tree, the interior nodes
+    // are set by collapseBVH4
+    node4.children[aSlot] = ~aBinaryNode;
+}
+
+
+int CBVH_PBRT::collapseBVH4( int aBinaryNode )
+{
+    wxASSERT( m_nodes[aBinaryNode].nPrimitives == 0 );
+
+    // Pull up the grandchildren of the largest interior children until there are 4
+    int slots[4] = { aBinaryNode + 1, m_nodes[aBinaryNode].secondChildOffset, 0, 0 };
+    int nSlots = 2;
+
+    while( nSlots < 4 )
+    {
+        int   largest = -1;
+        float largestArea = -1.0f;
+
+        for( int i = 0; i < nSlots; ++i )
+        {
+            const LinearBVHNode &node = m_nodes[slots[i]];
+
+            if( ( node.nPrimitives == 0 ) && ( node.bounds.SurfaceArea() > largestArea ) )
+            {
+                largest = i;
+                largestArea = node.bounds.SurfaceArea();
+            }
+        }
+
+        if( largest < 0 )
+            break;
+
+        const int interior = slots[largest];
+
+        slots[largest]  = interior + 1;
+        slots[nSlots++] = m_nodes[interior].secondChildOffset;
+    }
+
+    const int node4 = m_nodes4.size();
+
+    m_nodes4.emplace_back();
+    m_nodes4[node4].nChildren = nSlots;
+
+    for( int i = 0; i < 4; ++i )
+    {
+        // The unused slots get the first child, they are never tested
+        setBVH4Child( node4, i, slots[i < nSlots ? i : 0] );
+    }
+
+    for( int i = 0; i < nSlots; ++i )
+    {
+        if( m_nodes[slots[i]].nPrimitives == 0 )
+        {
+            // Do not keep a reference to m_nodes4 while it grows
+            const int child = collapseBVH4( slots[i] );
+
+            m_nodes4[node4].children[i] = child;
+        }
+    }
+
+    return node4;
+}
+
+
+int CBVH_PBRT::intersectBVH4Node( const LinearBVH4Node &aNode,
+                                  const RAY &aRay,
+                                  float aMaxDistance,
+                                  float aDist[4] )
+{
+#ifdef BVH4_USE_SSE
+    __m128 tNear = _mm_setzero_ps();
+    __m128 tFar  = _mm_set1_ps( aMaxDistance );
+
+    for( int axis = 0; axis < 3; ++axis )
+    {
+        const __m128 org    = _mm_set1_ps( aRay.m_Origin[axis] );
+        const __m128 invDir = _mm_set1_ps( aRay.m_InvDir[axis] );
+
+        const __m128 t0 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( aNode.bounds[axis] ), org ),
+                                      invDir );
+        const __m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( aNode.bounds[axis + 3] ),
+                                                  org ),
+                                      invDir );
+
+        // NaN (ray on the plane of a flat box) keeps the previous, conservative, value
+        tNear = _mm_max_ps( _mm_min_ps( t0, t1 ), tNear );
+        tFar  = _mm_min_ps( _mm_max_ps( t0, t1 ), tFar );
+    }
+
+    _mm_storeu_ps( aDist, tNear );
+
+    return _mm_movemask_ps( _mm_cmple_ps( tNear, tFar ) ) & ( ( 1 << aNode.nChildren ) - 1 );
+#else
+    int mask = 0;
+
+    for( int i = 0; i < aNode.nChildren; ++i )
+    {
+        float tNear = 0.0f;
+        float tFar  = aMaxDistance;
+
+        for( int axis = 0; axis < 3; ++axis )
+        {
+            const float t0 = ( aNode.bounds[axis][i]     - aRay.m_Origin[axis] ) *
+                             aRay.m_InvDir[axis];
+            const float t1 = ( aNode.bounds[axis + 3][i] - aRay.m_Origin[axis] ) *
+                             aRay.m_InvDir[axis];
+
+            // Same semantics as _mm_min_ps / _mm_max_ps: a NaN keeps the previous value
+            const float tMin = t0 < t1 ? t0 : t1;
+            const float tMax = t0 > t1 ? t0 : t1;
+
+            tNear = tMin > tNear ? tMin : tNear;
+            tFar  = tMax < tFar  ? tMax : tFar;
+        }
+
+        aDist[i] = tNear;
+
+        if( tNear <= tFar )
+            mask |= 1 << i;
+    }
+
+    return mask;
+#endif
+}
+
+
 #define MAX_TODOS 64
 
+// Each level of the 4-wide BVH may push up to 3 nodes more than it pops
+#define MAX_TODOS4 ( 3 * MAX_TODOS )
+
 bool CBVH_PBRT::Intersect( const RAY &aRay, HITINFO &aHitInfo ) const
 {
     if( !m_nodes )
@@ -1133,64 +1294,71 @@ bool CBVH_PBRT::Intersect( const RAY &aRay, HITINFO &aHitInfo ) const
 
     bool hit = false;
 
-    // Follow ray through BVH nodes to find primitive intersections
-    int todoOffset = 0, nodeNum = 0;
-    int todo[MAX_TODOS];
-
-    while( true )
+    // Follow ray through BVH nodes to find primitive intersections, nearest first
+    struct TODO
     {
-        const LinearBVHNode *node = &m_nodes[nodeNum];
+        int   node;     ///< >= 0 : node of m_nodes4, < 0 : ~leaf on m_nodes
+        float dist;
+    };
+
+    int todoOffset = 0;
+    TODO todo[MAX_TODOS4];
 
-        wxASSERT( todoOffset < MAX_TODOS );
+    todo[todoOffset++] = { 0, 0.0f };
 
-        // Check ray against BVH node
-        float hitBox = 0.0f;
+    while( todoOffset > 0 )
+    {
+        const TODO current = todo[--todoOffset];
 
-        const bool hitted = node->bounds.Intersect( aRay, &hitBox );
+        // A nearer hit may have been found since it was pushed
+        if( current.dist >= aHitInfo.m_tHit )
+            continue;
 
-        if( hitted && (hitBox < aHitInfo.m_tHit) )
+        if( current.node < 0 )
         {
-            if( node->nPrimitives > 0 )
+            // Intersect ray with primitives in leaf BVH node
+            const int nodeNum = ~current.node;
+            const LinearBVHNode *node = &m_nodes[nodeNum];
+
+            for( int i = 0; i < node->nPrimitives; ++i )
             {
-                // Intersect ray with primitives in leaf BVH node
-                for( int i = 0; i < node->nPrimitives; ++i )
+                if( m_primitives[node->primitivesOffset + i]->Intersect( aRay, aHitInfo ) )
                 {
-                    if( m_primitives[node->primitivesOffset + i]->Intersect( aRay,
-                                                                             aHitInfo ) )
-                    {
-                        aHitInfo.m_acc_node_info = nodeNum;
-                        hit = true;
-                    }
+                    aHitInfo.m_acc_node_info = nodeNum;
+                    hit = true;
                 }
             }
-            else
-            {
-                // Put far BVH node on _todo_ stack, advance to near node
-                if( aRay.m_dirIsNeg[node->axis] )
-                {
-                    todo[todoOffset++] = nodeNum + 1;
-                    nodeNum = node->secondChildOffset;
-                }
-                else
-                {
-                    todo[todoOffset++] = node->secondChildOffset;
-                    nodeNum = nodeNum + 1;
-                }
 
-                continue;
-            }
+            continue;
         }
 
-        if( todoOffset == 0 )
-            break;
+        const LinearBVH4Node &node4 = m_nodes4[current.node];
+
+        float dist[4];
+        int mask = intersectBVH4Node( node4, aRay, aHitInfo.m_tHit, dist );
+
+        // Push the children hit, farthest first, so the nearest is popped next
+        const int first = todoOffset;
+
+        for( int i = 0; mask; ++i, mask >>= 1 )
+        {
+            if( !( mask & 1 ) )
+                continue;
+
+            wxASSERT( todoOffset < MAX_TODOS4 );
+
+            int j = todoOffset++;
 
-        nodeNum = todo[--todoOffset];
+            for( ; ( j > first ) && ( todo[j - 1].dist < dist[i] ); --j )
+                todo[j] = todo[j - 1];
+
+            todo[j] = { node4.children[i], dist[i] };
+        }
     }
 
     return hit;
 }
 
-// !TODO: this may be optimized
 bool CBVH_PBRT::Intersect( const RAY &aRay,
                            HITINFO &aHitInfo,
                            unsigned int aAccNodeInfo ) const
@@ -1198,60 +1366,28 @@ bool CBVH_PBRT::Intersect( const RAY &aRay,
     if( !m_nodes )
         return false;
 
-    bool hit = false;
-
-    // Follow ray through BVH nodes to find primitive intersections
-    int todoOffset = 0, nodeNum = aAccNodeInfo;
-    int todo[MAX_TODOS];
+    const LinearBVHNode *node = &m_nodes[aAccNodeInfo];
 
-    while( true )
-    {
-        const LinearBVHNode *node = &m_nodes[nodeNum];
+    // The node info of a hit is a leaf of the binary tree, so the neighbour rays
+    // only test the box and the primitives of that leaf, there is no tree to walk.
+    // Any other node is searched from the root.
+    if( node->nPrimitives == 0 )
+        return Intersect( aRay, aHitInfo );
 
-        wxASSERT( todoOffset < MAX_TODOS );
+    float hitBox = 0.0f;
 
-        // Check ray against BVH node
-        float hitBox = 0.0f;
+    if( !node->bounds.Intersect( aRay, &hitBox ) || ( hitBox >= aHitInfo.m_tHit ) )
+        return false;
 
-        const bool hitted = node->bounds.Intersect( aRay, &hitBox );
+    bool hit = false;
 
-        if( hitted && (hitBox < aHitInfo.m_tHit) )
+    for( int i = 0; i < node->nPrimitives; ++i )
+    {
+        if( m_primitives[node->primitivesOffset + i]->Intersect( aRay, aHitInfo ) )
         {
-            if( node->nPrimitives > 0 )
-            {
-                // Intersect ray with primitives in leaf BVH node
-                for( int i = 0; i < node->nPrimitives; ++i )
-                {
-                    if( m_primitives[node->primitivesOffset + i]->Intersect( aRay,
-                                                                             aHitInfo ) )
-                    {
-                        //aHitInfo.m_acc_node_info = nodeNum;
-                        hit = true;
-                    }
-                }
-            }
-            else
-            {
-                // Put far BVH node on _todo_ stack, advance to near node
-                if( aRay.m_dirIsNeg[node->axis] )
-                {
-                    todo[todoOffset++] = nodeNum + 1;
-                    nodeNum = node->secondChildOffset;
-                }
-                else
-                {
-                    todo[todoOffset++] = node->secondChildOffset;
-                    nodeNum = nodeNum + 1;
-                }
-
-                continue;
-            }
+            aHitInfo.m_acc_node_info = aAccNodeInfo;
+            hit = true;
         }
-
-        if( todoOffset == 0 )
-            break;
-
-        nodeNum = todo[--todoOffset];
     }
 
     return hit;
@@ -1263,57 +1399,47 @@ bool CBVH_PBRT::IntersectP( const RAY &aRay, float aMaxDistance ) const
     if( !m_nodes )
         return false;
 
-    // Follow ray through BVH nodes to find primitive intersections
-    int todoOffset = 0, nodeNum = 0;
-    int todo[MAX_TODOS];
-
-    while( true )
-    {
-        const LinearBVHNode *node = &m_nodes[nodeNum];
+    // Follow ray through BVH nodes to find any primitive intersection
+    int todoOffset = 0;
+    int todo[MAX_TODOS4];
 
-        wxASSERT( todoOffset < MAX_TODOS );
+    todo[todoOffset++] = 0;
 
-        // Check ray against BVH node
-        float hitBox = 0.0f;
-
-        const bool hitted = node->bounds.Intersect( aRay, &hitBox );
+    while( todoOffset > 0 )
+    {
+        const int nodeNum = todo[--todoOffset];
 
-        if( hitted && (hitBox < aMaxDistance) )
+        if( nodeNum < 0 )
         {
-            if( node->nPrimitives > 0 )
-            {
-                // Intersect ray with primitives in leaf BVH node
-                for( int i = 0; i < node->nPrimitives; ++i )
-                {
-                    const COBJECT *obj = m_primitives[node->primitivesOffset + i];
+            // Intersect ray with primitives in leaf BVH node
+            const LinearBVHNode *node = &m_nodes[~nodeNum];
 
-                    if( obj->GetMaterial()->GetCastShadows() )
-                        if( obj->IntersectP( aRay, aMaxDistance ) )
-                            return true;
-                }
-            }
-            else
+            for( int i = 0; i < node->nPrimitives; ++i )
             {
-                // Put far BVH node on _todo_ stack, advance to near node
-                if( aRay.m_dirIsNeg[node->axis] )
-                {
-                    todo[todoOffset++] = nodeNum + 1;
-                    nodeNum = node->secondChildOffset;
-                }
-                else
-                {
-                    todo[todoOffset++] = node->secondChildOffset;
-                    nodeNum = nodeNum + 1;
-                }
+                const COBJECT *obj = m_primitives[node->primitivesOffset + i];
 
-                continue;
+                if( obj->GetMaterial()->GetCastShadows() )
+                    if( obj->IntersectP( aRay, aMaxDistance ) )
+                        return true;
             }
+
+            continue;
         }
 
-        if( todoOffset == 0 )
-            break;
+        const LinearBVH4Node &node4 = m_nodes4[nodeNum];
+
+        float dist[4];
+        int mask = intersectBVH4Node( node4, aRay, aMaxDistance, dist );
+
+        for( int i = 0; mask; ++i, mask >>= 1 )
+        {
+            if( mask & 1 )
+            {
+                wxASSERT( todoOffset < MAX_TODOS4 );
 
-        nodeNum = todo[--todoOffset];
+                todo[todoOffset++] = node4.children[i];
+            }
+        }
     }
 
     return false;
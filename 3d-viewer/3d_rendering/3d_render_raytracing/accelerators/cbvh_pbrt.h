@@ -72,6 +72,7 @@
 
 #include "caccelerator.h"
 #include <list>
+#include <vector>
 #include <stdint.h>
 
 // Forward Declarations
@@ -98,6 +99,23 @@ struct LinearBVHNode
 };
 
 
+/**
+ * Node of the 4-wide BVH, collapsed from the binary one so a ray can test the
+ * bounds of the 4 children at once with SIMD instructions.
+ */
+struct LinearBVH4Node
+{
+    // 96 bytes, the bounds of the children as structure of arrays
+    float bounds[6][4];    ///< min x, min y, min z, max x, max y, max z
+
+    // 16 bytes
+    int   children[4];     ///< >= 0 : interior node, < 0 : ~index of a leaf on the binary BVH
+
+    // 4 bytes
+    int   nChildren;       ///< 2 to 4 (only the root may have 1)
+};
+
+
 enum SPLITMETHOD
 {
     SPLIT_MIDDLE,
@@ -153,12 +171,31 @@ private:
     int flattenBVHTree( BVHBuildNode *node,
                         uint32_t *offset );
 
+    int collapseBVH4( int aBinaryNode );
+
+    void setBVH4Child( int aNode4, int aSlot, int aBinaryNode );
+
+    /**
+     * Test a ray against the bounds of the children of a 4-wide BVH node.
+     * @param aDist receives the entry distances of the children
+     * @return the mask of the children hit nearer than aMaxDistance
+     */
+    static int intersectBVH4Node( const LinearBVH4Node &aNode,
+                                  const RAY &aRay,
+                                  float aMaxDistance,
+                                  float aDist[4] );
+
     // BVH Private Data
     const int           m_maxPrimsInNode;
     SPLITMETHOD         m_splitMethod;
     CONST_VECTOR_OBJECT m_primitives;
     LinearBVHNode       *m_nodes;
 
+    /// The same tree collapsed to 4 children per node, used for the traversals.
+    /// The leaves refer to the nodes of m_nodes, so the node info of the hits
+    /// is still an index on the binary tree.
+    std::vector<LinearBVH4Node> m_nodes4;
+
     std::list<void *> m_addresses_pointer_to_mm_free;
 
     // Partition traversal
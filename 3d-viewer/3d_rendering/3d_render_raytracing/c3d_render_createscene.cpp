@@ -34,6 +34,7 @@
 #include "shapes3D/clayeritem.h"
 #include "shapes3D/ccylinder.h"
 #include "shapes3D/ctriangle.h"
+#include "shapes3D/cinstance.h"
 #include "shapes2D/citemlayercsg2d.h"
 #include "shapes2D/cring2d.h"
 #include "shapes2D/cpolygon2d.h"
@@ -65,11 +66,12 @@ void C3D_RENDER_RAYTRACING::setupMaterials()
 
         m_solder_mask_normal_perturbator = CSOLDERMASKNORMAL( &m_board_normal_perturbator );
 
-        m_plastic_normal_perturbator = CPLASTICNORMAL( 0.15f * IU_PER_MM * m_settings.BiuTo3Dunits() );
+        // These are used by the 3D models, that are traced in their own coordinates (mm)
+        m_plastic_normal_perturbator = CPLASTICNORMAL( 0.15f * IU_PER_MM / UNITS3D_TO_UNITSPCB );
 
-        m_plastic_shine_normal_perturbator = CPLASTICSHINENORMAL( 1.0f * IU_PER_MM * m_settings.BiuTo3Dunits() );
+        m_plastic_shine_normal_perturbator = CPLASTICSHINENORMAL( 1.0f * IU_PER_MM / UNITS3D_TO_UNITSPCB );
 
-        m_brushed_metal_normal_perturbator = CMETALBRUSHEDNORMAL( 1.0f * IU_PER_MM * m_settings.BiuTo3Dunits() );
+        m_brushed_metal_normal_perturbator = CMETALBRUSHEDNORMAL( 1.0f * IU_PER_MM / UNITS3D_TO_UNITSPCB );
     }
 
     // http://devernay.free.fr/cours/opengl/materials.html
@@ -273,6 +275,7 @@ void C3D_RENDER_RAYTRACING::reload( REPORTER *aStatusTextReporter )
 
     m_object_container.Clear();
     m_containerWithObjectsToDelete.Clear();
+    free_3D_models_geometry();
 
 
     // Create and add the outline board
@@ -1198,6 +1201,26 @@ void C3D_RENDER_RAYTRACING::add_3D_vias_and_pads_to_container()
 
 void C3D_RENDER_RAYTRACING::load_3D_models()
 {
+    // There is no cache manager when rendering without a project (e.g. from scripts)
+    if( !m_settings.Get3DCacheManager() )
+        return;
+
+    // Load the models of all the modules on parallel threads first
+    std::vector<wxString> modelFiles;
+
+    for( const MODULE* module = m_settings.GetBoard()->m_Modules;
+         module;
+         module = module->Next() )
+    {
+        if( m_settings.ShouldModuleBeDisplayed( (MODULE_ATTR_T)module->GetAttributes() ) )
+        {
+            for( const MODULE_3D_SETTINGS& model : module->Models() )
+                modelFiles.push_back( model.m_Filename );
+        }
+    }
+
+    m_settings.Get3DCacheManager()->LoadModels( modelFiles );
+
     // Go for all modules
     for( const MODULE* module = m_settings.GetBoard()->m_Modules;
          module;
@@ -1443,98 +1466,117 @@ void C3D_RENDER_RAYTRACING::add_3D_models( const S3DMODEL *a3DModel,
             }
         }
 
-        const glm::mat3 normalMatrix = glm::transpose( glm::inverse( glm::mat3( aModelMatrix ) ) );
+        MODEL_GEOMETRY *&geometry = m_model_geometry[a3DModel];
 
-        for( unsigned int mesh_i = 0;
-             mesh_i < a3DModel->m_MeshesSize;
-             ++mesh_i )
+        if( !geometry )
         {
-            const SMESH &mesh = a3DModel->m_Meshes[mesh_i];
-
-            // Validate the mesh pointers
-            wxASSERT( mesh.m_Positions != NULL );
-            wxASSERT( mesh.m_FaceIdx != NULL );
-            wxASSERT( mesh.m_Normals != NULL );
-            wxASSERT( mesh.m_FaceIdxSize > 0 );
-            wxASSERT( (mesh.m_FaceIdxSize % 3) == 0 );
-
-
-            if( (mesh.m_Positions != NULL) &&
-                (mesh.m_Normals != NULL) &&
-                (mesh.m_FaceIdx != NULL) &&
-                (mesh.m_FaceIdxSize > 0) &&
-                (mesh.m_VertexSize > 0) &&
-                ((mesh.m_FaceIdxSize % 3) == 0) &&
-                (mesh.m_MaterialIdx < a3DModel->m_MaterialsSize) )
-            {
-                const CBLINN_PHONG_MATERIAL &blinn_material = (*materialVector)[mesh.m_MaterialIdx];
+            // First instance of this model: create its triangles on model coordinates
+            geometry = new MODEL_GEOMETRY;
+            add_3D_model_triangles( a3DModel, *materialVector, geometry->m_objects );
 
-                // Add all face triangles
-                for( unsigned int faceIdx = 0;
-                     faceIdx < mesh.m_FaceIdxSize;
-                     faceIdx += 3 )
-                {
-                    const unsigned int idx0 = mesh.m_FaceIdx[faceIdx + 0];
-                    const unsigned int idx1 = mesh.m_FaceIdx[faceIdx + 1];
-                    const unsigned int idx2 = mesh.m_FaceIdx[faceIdx + 2];
+            if( !geometry->m_objects.GetList().empty() )
+                geometry->m_accelerator = new CBVH_PBRT( geometry->m_objects );
+        }
 
-                    wxASSERT( idx0 < mesh.m_VertexSize );
-                    wxASSERT( idx1 < mesh.m_VertexSize );
-                    wxASSERT( idx2 < mesh.m_VertexSize );
+        if( geometry->m_accelerator )
+            m_object_container.Add( new CINSTANCE( geometry->m_accelerator,
+                                                   geometry->m_objects.GetBBox(),
+                                                   aModelMatrix ) );
+    }
+}
 
-                    if( ( idx0 < mesh.m_VertexSize ) &&
-                        ( idx1 < mesh.m_VertexSize ) &&
-                        ( idx2 < mesh.m_VertexSize ) )
-                    {
-                        const SFVEC3F &v0 = mesh.m_Positions[idx0];
-                        const SFVEC3F &v1 = mesh.m_Positions[idx1];
-                        const SFVEC3F &v2 = mesh.m_Positions[idx2];
 
-                        const SFVEC3F &n0 = mesh.m_Normals[idx0];
-                        const SFVEC3F &n1 = mesh.m_Normals[idx1];
-                        const SFVEC3F &n2 = mesh.m_Normals[idx2];
+void C3D_RENDER_RAYTRACING::add_3D_model_triangles( const S3DMODEL *a3DModel,
+                                                    const MODEL_MATERIALS &aMaterials,
+                                                    CCONTAINER &aContainer )
+{
+    for( unsigned int mesh_i = 0;
+         mesh_i < a3DModel->m_MeshesSize;
+         ++mesh_i )
+    {
+        const SMESH &mesh = a3DModel->m_Meshes[mesh_i];
+
+        // Validate the mesh pointers
+        wxASSERT( mesh.m_Positions != NULL );
+        wxASSERT( mesh.m_FaceIdx != NULL );
+        wxASSERT( mesh.m_Normals != NULL );
+        wxASSERT( mesh.m_FaceIdxSize > 0 );
+        wxASSERT( (mesh.m_FaceIdxSize % 3) == 0 );
+
+
+        if( (mesh.m_Positions != NULL) &&
+            (mesh.m_Normals != NULL) &&
+            (mesh.m_FaceIdx != NULL) &&
+            (mesh.m_FaceIdxSize > 0) &&
+            (mesh.m_VertexSize > 0) &&
+            ((mesh.m_FaceIdxSize % 3) == 0) &&
+            (mesh.m_MaterialIdx < a3DModel->m_MaterialsSize) )
+        {
+            const CBLINN_PHONG_MATERIAL &blinn_material = aMaterials[mesh.m_MaterialIdx];
 
-                        // Transform vertex with the model matrix
-                        const SFVEC3F vt0 = SFVEC3F( aModelMatrix * glm::vec4( v0, 1.0f) );
-                        const SFVEC3F vt1 = SFVEC3F( aModelMatrix * glm::vec4( v1, 1.0f) );
-                        const SFVEC3F vt2 = SFVEC3F( aModelMatrix * glm::vec4( v2, 1.0f) );
+            // Add all face triangles
+            for( unsigned int faceIdx = 0;
+                 faceIdx < mesh.m_FaceIdxSize;
+                 faceIdx += 3 )
+            {
+                const unsigned int idx0 = mesh.m_FaceIdx[faceIdx + 0];
+                const unsigned int idx1 = mesh.m_FaceIdx[faceIdx + 1];
+                const unsigned int idx2 = mesh.m_FaceIdx[faceIdx + 2];
 
-                        const SFVEC3F nt0 = glm::normalize( SFVEC3F( normalMatrix * n0 ) );
-                        const SFVEC3F nt1 = glm::normalize( SFVEC3F( normalMatrix * n1 ) );
-                        const SFVEC3F nt2 = glm::normalize( SFVEC3F( normalMatrix * n2 ) );
+                wxASSERT( idx0 < mesh.m_VertexSize );
+                wxASSERT( idx1 < mesh.m_VertexSize );
+                wxASSERT( idx2 < mesh.m_VertexSize );
 
-                        CTRIANGLE *newTriangle = new  CTRIANGLE( vt0, vt2, vt1,
-                                                                 nt0, nt2, nt1 );
+                if( ( idx0 < mesh.m_VertexSize ) &&
+                    ( idx1 < mesh.m_VertexSize ) &&
+                    ( idx2 < mesh.m_VertexSize ) )
+                {
+                    const SFVEC3F &v0 = mesh.m_Positions[idx0];
+                    const SFVEC3F &v1 = mesh.m_Positions[idx1];
+                    const SFVEC3F &v2 = mesh.m_Positions[idx2];
 
+                    const SFVEC3F n0 = glm::normalize( mesh.m_Normals[idx0] );
+                    const SFVEC3F n1 = glm::normalize( mesh.m_Normals[idx1] );
+                    const SFVEC3F n2 = glm::normalize( mesh.m_Normals[idx2] );
 
+                    CTRIANGLE *newTriangle = new  CTRIANGLE( v0, v2, v1,
+                                                             n0, n2, n1 );
 
-                        m_object_container.Add( newTriangle );
-                        newTriangle->SetMaterial( (const CMATERIAL *)&blinn_material );
+                    aContainer.Add( newTriangle );
+                    newTriangle->SetMaterial( (const CMATERIAL *)&blinn_material );
 
-                        if( mesh.m_Color == NULL )
-                        {
-                            const SFVEC3F diffuseColor =
-                                a3DModel->m_Materials[mesh.m_MaterialIdx].m_Diffuse;
+                    if( mesh.m_Color == NULL )
+                    {
+                        const SFVEC3F diffuseColor =
+                            a3DModel->m_Materials[mesh.m_MaterialIdx].m_Diffuse;
 
-                            if( m_settings.MaterialModeGet() == MATERIAL_MODE_CAD_MODE )
-                                newTriangle->SetColor( ConvertSRGBToLinear( MaterialDiffuseToColorCAD( diffuseColor ) ) );
-                            else
-                                newTriangle->SetColor( ConvertSRGBToLinear( diffuseColor ) );
-                        }
+                        if( m_settings.MaterialModeGet() == MATERIAL_MODE_CAD_MODE )
+                            newTriangle->SetColor( ConvertSRGBToLinear( MaterialDiffuseToColorCAD( diffuseColor ) ) );
                         else
-                        {
-                            if( m_settings.MaterialModeGet() == MATERIAL_MODE_CAD_MODE )
-                                newTriangle->SetColor( ConvertSRGBToLinear( MaterialDiffuseToColorCAD( mesh.m_Color[idx0] ) ),
-                                                       ConvertSRGBToLinear( MaterialDiffuseToColorCAD( mesh.m_Color[idx1] ) ),
-                                                       ConvertSRGBToLinear( MaterialDiffuseToColorCAD( mesh.m_Color[idx2] ) ) );
-                            else
-                                newTriangle->SetColor( ConvertSRGBToLinear( mesh.m_Color[idx0] ),
-                                                       ConvertSRGBToLinear( mesh.m_Color[idx1] ),
-                                                       ConvertSRGBToLinear( mesh.m_Color[idx2] ) );
-                        }
+                            newTriangle->SetColor( ConvertSRGBToLinear( diffuseColor ) );
+                    }
+                    else
+                    {
+                        if( m_settings.MaterialModeGet() == MATERIAL_MODE_CAD_MODE )
+                            newTriangle->SetColor( ConvertSRGBToLinear( MaterialDiffuseToColorCAD( mesh.m_Color[idx0] ) ),
+                                                   ConvertSRGBToLinear( MaterialDiffuseToColorCAD( mesh.m_Color[idx1] ) ),
+                                                   ConvertSRGBToLinear( MaterialDiffuseToColorCAD( mesh.m_Color[idx2] ) ) );
+                        else
+                            newTriangle->SetColor( ConvertSRGBToLinear( mesh.m_Color[idx0] ),
+                                                   ConvertSRGBToLinear( mesh.m_Color[idx1] ),
+                                                   ConvertSRGBToLinear( mesh.m_Color[idx2] ) );
                     }
                 }
             }
         }
     }
 }
+
+
+void C3D_RENDER_RAYTRACING::free_3D_models_geometry()
+{
+    for( auto& geometry : m_model_geometry )
+        delete geometry.second;
+
+    m_model_geometry.clear();
+}
@@ -28,10 +28,13 @@
  */
 
 #include <GL/glew.h>
+#include <algorithm>
 #include <climits>
 #include <atomic>
 #include <thread>
 #include <chrono>
+#include <vector>
+#include <wx/image.h>
 
 #include "c3d_render_raytracing.h"
 #include "mortoncodes.h"
@@ -81,6 +84,8 @@ C3D_RENDER_RAYTRACING::~C3D_RENDER_RAYTRACING()
     delete m_accelerator;
     m_accelerator = NULL;
 
+    free_3D_models_geometry();
+
     delete m_outlineBoard2dObjects;
     m_outlineBoard2dObjects = NULL;
 
@@ -137,6 +142,9 @@ void C3D_RENDER_RAYTRACING::restart_render_state()
     std::fill( m_blockPositionsWasProcessed.begin(),
                m_blockPositionsWasProcessed.end(),
                0 );
+
+    m_blockVariance.resize( m_blockPositions.size() );
+    m_blockRefineOrder.clear();
 }
 
 
@@ -164,6 +172,7 @@ bool C3D_RENDER_RAYTRACING::Redraw( bool aIsMoving, REPORTER *aStatusTextReporte
         // revert to preview mode the first time the Redraw is called
         m_oldWindowsSize = m_windowSize;
         initialize_block_positions();
+        opengl_init_pbo();
     }
 
     wxBusyCursor dummy;
@@ -190,6 +199,7 @@ bool C3D_RENDER_RAYTRACING::Redraw( bool aIsMoving, REPORTER *aStatusTextReporte
         requestRedraw = true;
 
         initialize_block_positions();
+        opengl_init_pbo();
     }
 
 
@@ -297,6 +307,86 @@ bool C3D_RENDER_RAYTRACING::Redraw( bool aIsMoving, REPORTER *aStatusTextReporte
 }
 
 
+bool C3D_RENDER_RAYTRACING::RenderToImage( const wxSize &aSize, wxImage &aImage,
+                                           REPORTER *aStatusTextReporter )
+{
+    if( ( aSize.x <= 0 ) || ( aSize.y <= 0 ) )
+        return false;
+
+    // The traced buffer is always a bit smaller than the window, so grow the
+    // window until the buffer covers the requested size and crop it later.
+    // The block positions need a window larger than the fast preview margin
+    // (4 * RAYPACKET_DIM + 4), so very small images start from that size.
+    // /////////////////////////////////////////////////////////////////////////
+    const int minWindowSize = 4 * RAYPACKET_DIM + 4 + RAYPACKET_DIM;
+
+    wxSize windowSize( std::max( aSize.x, minWindowSize ), std::max( aSize.y, minWindowSize ) );
+
+    while( true )
+    {
+        m_windowSize = windowSize;
+        initialize_block_positions();
+
+        if( ( m_realBufferSize.x >= (unsigned int)aSize.x ) &&
+            ( m_realBufferSize.y >= (unsigned int)aSize.y ) )
+            break;
+
+        if( m_realBufferSize.x < (unsigned int)aSize.x )
+            windowSize.x += RAYPACKET_DIM;
+
+        if( m_realBufferSize.y < (unsigned int)aSize.y )
+            windowSize.y += RAYPACKET_DIM;
+    }
+
+    m_oldWindowsSize = m_windowSize;
+    m_settings.CameraGet().SetCurWindowSize( m_windowSize );
+
+    if( m_reloadRequested )
+    {
+        if( aStatusTextReporter )
+            aStatusTextReporter->Report( _( "Loading..." ) );
+
+        reload( aStatusTextReporter );
+    }
+
+    std::vector<GLubyte> buffer( m_realBufferSize.x * m_realBufferSize.y * 4, 0 );
+
+    m_rt_render_state = RT_RENDER_STATE_MAX;
+
+    do
+    {
+        render( buffer.data(), aStatusTextReporter );
+    } while( m_rt_render_state != RT_RENDER_STATE_FINISH );
+
+    // Copy the centered part of the buffer to the image. The buffer is RGBA and
+    // its first row is the bottom of the image.
+    // /////////////////////////////////////////////////////////////////////////
+    if( !aImage.Create( aSize.x, aSize.y, false ) )
+        return false;
+
+    const unsigned int x0 = ( m_realBufferSize.x - aSize.x ) / 2;
+    const unsigned int y0 = ( m_realBufferSize.y - aSize.y ) / 2;
+    unsigned char *dst = aImage.GetData();
+
+    for( int y = 0; y < aSize.y; ++y )
+    {
+        const GLubyte *src = &buffer[( ( y0 + aSize.y - 1 - y ) * m_realBufferSize.x + x0 ) * 4];
+
+        for( int x = 0; x < aSize.x; ++x )
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+
+            dst += 3;
+            src += 4;
+        }
+    }
+
+    return true;
+}
+
+
 void C3D_RENDER_RAYTRACING::render( GLubyte *ptrPBO , REPORTER *aStatusTextReporter )
 {
     if( (m_rt_render_state == RT_RENDER_STATE_FINISH) ||
@@ -330,6 +420,7 @@ void C3D_RENDER_RAYTRACING::render( GLubyte *ptrPBO , REPORTER *aStatusTextRepor
     switch( m_rt_render_state )
     {
     case RT_RENDER_STATE_TRACING:
+    case RT_RENDER_STATE_TRACING_REFINE:
             rt_render_tracing( ptrPBO, aStatusTextReporter );
         break;
 
@@ -359,11 +450,20 @@ void C3D_RENDER_RAYTRACING::render( GLubyte *ptrPBO , REPORTER *aStatusTextRepor
 }
 
 
+// Blocks with a lower luminance variance on the first pass are not anti-aliased
+#define REFINE_VARIANCE_THRESHOLD ( 0.01f * 0.01f )
+
 void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
                                                REPORTER *aStatusTextReporter )
 {
     m_isPreview = false;
 
+    // The first pass traces one sample per pixel of all the blocks, so the whole
+    // frame is shown soon. The refine pass anti-aliases only the blocks with
+    // details, the ones with the highest variance first.
+    const bool refine = ( m_rt_render_state == RT_RENDER_STATE_TRACING_REFINE );
+    const size_t nBlocks = refine ? m_blockRefineOrder.size() : m_blockPositions.size();
+
     auto startTime = std::chrono::steady_clock::now();
     bool breakLoop = false;
 
@@ -373,18 +473,20 @@ void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
 
     size_t parallelThreadCount = std::min<size_t>(
             std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-            m_blockPositions.size() );
+            nBlocks );
     for( size_t ii = 0; ii < parallelThreadCount; ++ii )
     {
         std::thread t = std::thread( [&]()
         {
             for( size_t iBlock = currentBlock.fetch_add( 1 );
-                        iBlock < m_blockPositions.size() && !breakLoop;
+                        iBlock < nBlocks && !breakLoop;
                         iBlock = currentBlock.fetch_add( 1 ) )
             {
                 if( !m_blockPositionsWasProcessed[iBlock] )
                 {
-                    rt_render_trace_block( ptrPBO, iBlock );
+                    rt_render_trace_block( ptrPBO,
+                                           refine ? m_blockRefineOrder[iBlock] : iBlock,
+                                           refine );
                     numBlocksRendered++;
                     m_blockPositionsWasProcessed[iBlock] = 1;
 
@@ -407,22 +509,50 @@ void C3D_RENDER_RAYTRACING::rt_render_tracing( GLubyte *ptrPBO ,
 
     m_nrBlocksRenderProgress += numBlocksRendered;
 
-    if( aStatusTextReporter )
-        aStatusTextReporter->Report( wxString::Format( _( "Rendering: %.0f %%" ),
+    if( aStatusTextReporter && nBlocks )
+        aStatusTextReporter->Report( wxString::Format( refine ? _( "Refining: %.0f %%" ) :
+                                                                _( "Rendering: %.0f %%" ),
                                                        (float)(m_nrBlocksRenderProgress * 100) /
-                                                       (float)m_blockPositions.size() ) );
+                                                       (float)nBlocks ) );
 
-    // Check if it finish the rendering and if should continue to a post processing
-    // or mark it as finished
-    if( m_nrBlocksRenderProgress >= m_blockPositions.size() )
+    if( m_nrBlocksRenderProgress < nBlocks )
+        return;
+
+    // Start the refine pass with the blocks that are not converged yet
+    if( !refine && m_settings.GetFlag( FL_RENDER_RAYTRACING_ANTI_ALIASING ) )
     {
-        if( m_settings.GetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING ) )
-            m_rt_render_state = RT_RENDER_STATE_POST_PROCESS_SHADE;
-        else
+        m_blockRefineOrder.clear();
+
+        for( size_t iBlock = 0; iBlock < m_blockPositions.size(); ++iBlock )
+        {
+            if( m_blockVariance[iBlock] > REFINE_VARIANCE_THRESHOLD )
+                m_blockRefineOrder.push_back( iBlock );
+        }
+
+        std::stable_sort( m_blockRefineOrder.begin(), m_blockRefineOrder.end(),
+                          [&]( size_t a, size_t b )
+                          {
+                              return m_blockVariance[a] > m_blockVariance[b];
+                          } );
+
+        if( !m_blockRefineOrder.empty() )
         {
-            m_rt_render_state = RT_RENDER_STATE_FINISH;
+            m_rt_render_state = RT_RENDER_STATE_TRACING_REFINE;
+            m_nrBlocksRenderProgress = 0;
+
+            std::fill( m_blockPositionsWasProcessed.begin(),
+                       m_blockPositionsWasProcessed.end(),
+                       0 );
+
+            return;
         }
     }
+
+    // Check if should continue to a post processing or mark it as finished
+    if( m_settings.GetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING ) )
+        m_rt_render_state = RT_RENDER_STATE_POST_PROCESS_SHADE;
+    else
+        m_rt_render_state = RT_RENDER_STATE_FINISH;
 }
 
 #ifdef USE_SRGB_SPACE
@@ -655,7 +785,8 @@ void C3D_RENDER_RAYTRACING::rt_trace_AA_packet( const SFVEC3F *aBgColorY,
 #define DISP_FACTOR 0.075f
 
 void C3D_RENDER_RAYTRACING::rt_render_trace_block( GLubyte *ptrPBO ,
-                                                   signed int iBlock )
+                                                   signed int iBlock,
+                                                   bool aRefine )
 {
     // Initialize ray packets
     // /////////////////////////////////////////////////////////////////////////
@@ -735,6 +866,9 @@ void C3D_RENDER_RAYTRACING::rt_render_trace_block( GLubyte *ptrPBO ,
 
         // There is nothing more here to do.. there are no hits ..
         // just background so continue
+        if( !aRefine )
+            m_blockVariance[iBlock] = 0.0f;
+
         return;
     }
 
@@ -749,7 +883,26 @@ void C3D_RENDER_RAYTRACING::rt_render_trace_block( GLubyte *ptrPBO ,
                       m_settings.GetFlag( FL_RENDER_RAYTRACING_SHADOWS ),
                       hitColor_X0Y0 );
 
-    if( m_settings.GetFlag( FL_RENDER_RAYTRACING_ANTI_ALIASING ) )
+    if( !aRefine )
+    {
+        // Measure the luminance variance of the block to know if it needs refinement
+        float sum = 0.0f;
+        float sumSquared = 0.0f;
+
+        for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+        {
+            const float luminance = glm::dot( hitColor_X0Y0[i],
+                                              SFVEC3F( 0.2126f, 0.7152f, 0.0722f ) );
+
+            sum += luminance;
+            sumSquared += luminance * luminance;
+        }
+
+        const float mean = sum / RAYPACKET_RAYS_PER_PACKET;
+
+        m_blockVariance[iBlock] = sumSquared / RAYPACKET_RAYS_PER_PACKET - mean * mean;
+    }
+    else if( m_settings.GetFlag( FL_RENDER_RAYTRACING_ANTI_ALIASING ) )
     {
         SFVEC3F hitColor_AA_X1Y1[RAYPACKET_RAYS_PER_PACKET];
 
@@ -1573,11 +1726,12 @@ void C3D_RENDER_RAYTRACING::render_preview( GLubyte *ptrPBO )
                             bool hitted = false;
 
                             if( hittedC )
-                                hitted = centerHitInfo.pHitObject->Intersect( rayLTC, hitInfoLTC );
+                                hitted = m_accelerator->Intersect( rayLTC, hitInfoLTC,
+                                                                   centerHitInfo.m_acc_node_info );
                             else
                                 if( hitPacket[ iLT ].m_hitresult )
-                                    hitted = hitPacket[ iLT ].m_HitInfo.pHitObject->Intersect( rayLTC,
-                                                                                               hitInfoLTC );
+                                    hitted = m_accelerator->Intersect( rayLTC, hitInfoLTC,
+                                             hitPacket[ iLT ].m_HitInfo.m_acc_node_info );
 
                             if( hitted )
                                 cLTC = CCOLORRGB( shadeHit( bgColorY, rayLTC, hitInfoLTC, false, 0, false ) );
@@ -1601,11 +1755,12 @@ void C3D_RENDER_RAYTRACING::render_preview( GLubyte *ptrPBO )
                             bool hitted = false;
 
                             if( hittedC )
-                                hitted = centerHitInfo.pHitObject->Intersect( rayRTC, hitInfoRTC );
+                                hitted = m_accelerator->Intersect( rayRTC, hitInfoRTC,
+                                                                   centerHitInfo.m_acc_node_info );
                             else
                                 if( hitPacket[ iRT ].m_hitresult )
-                                    hitted = hitPacket[ iRT ].m_HitInfo.pHitObject->Intersect( rayRTC,
-                                                                                               hitInfoRTC );
+                                    hitted = m_accelerator->Intersect( rayRTC, hitInfoRTC,
+                                             hitPacket[ iRT ].m_HitInfo.m_acc_node_info );
 
                             if( hitted )
                                 cRTC = CCOLORRGB( shadeHit( bgColorY, rayRTC, hitInfoRTC, false, 0, false ) );
@@ -1629,11 +1784,12 @@ void C3D_RENDER_RAYTRACING::render_preview( GLubyte *ptrPBO )
                             bool hitted = false;
 
                             if( hittedC )
-                                hitted = centerHitInfo.pHitObject->Intersect( rayLBC, hitInfoLBC );
+                                hitted = m_accelerator->Intersect( rayLBC, hitInfoLBC,
+                                                                   centerHitInfo.m_acc_node_info );
                             else
                                 if( hitPacket[ iLB ].m_hitresult )
-                                    hitted = hitPacket[ iLB ].m_HitInfo.pHitObject->Intersect( rayLBC,
-                                                                                               hitInfoLBC );
+                                    hitted = m_accelerator->Intersect( rayLBC, hitInfoLBC,
+                                             hitPacket[ iLB ].m_HitInfo.m_acc_node_info );
 
                             if( hitted )
                                 cLBC = CCOLORRGB( shadeHit( bgColorY, rayLBC, hitInfoLBC, false, 0, false ) );
@@ -1657,11 +1813,12 @@ void C3D_RENDER_RAYTRACING::render_preview( GLubyte *ptrPBO )
                             bool hitted = false;
 
                             if( hittedC )
-                                hitted = centerHitInfo.pHitObject->Intersect( rayRBC, hitInfoRBC );
+                                hitted = m_accelerator->Intersect( rayRBC, hitInfoRBC,
+                                                                   centerHitInfo.m_acc_node_info );
                             else
                                 if( hitPacket[ iRB ].m_hitresult )
-                                    hitted = hitPacket[ iRB ].m_HitInfo.pHitObject->Intersect( rayRBC,
-                                                                                               hitInfoRBC );
+                                    hitted = m_accelerator->Intersect( rayRBC, hitInfoRBC,
+                                             hitPacket[ iRB ].m_HitInfo.m_acc_node_info );
 
                             if( hitted )
                                 cRBC = CCOLORRGB( shadeHit( bgColorY, rayRBC, hitInfoRBC, false, 0, false ) );
@@ -2147,6 +2304,4 @@ void C3D_RENDER_RAYTRACING::initialize_block_positions()
     // Create m_shader buffer
     delete[] m_shaderBuffer;
     m_shaderBuffer = new SFVEC3F[m_realBufferSize.x * m_realBufferSize.y];
-
-    opengl_init_pbo();
 }
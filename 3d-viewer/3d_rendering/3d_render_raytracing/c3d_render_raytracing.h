@@ -41,15 +41,32 @@
 
 #include <map>
 
+class wxImage;
+
 /// Vector of materials
 typedef std::vector< CBLINN_PHONG_MATERIAL > MODEL_MATERIALS;
 
 /// Maps a S3DMODEL pointer with a created CBLINN_PHONG_MATERIAL vector
 typedef std::map< const S3DMODEL * , MODEL_MATERIALS > MAP_MODEL_MATERIALS;
 
+/// The triangles of a 3D model, in model coordinates, and their accelerator.
+/// They are shared by all the instances of the model on the board.
+struct MODEL_GEOMETRY
+{
+    MODEL_GEOMETRY() : m_accelerator( NULL ) {}
+    ~MODEL_GEOMETRY() { delete m_accelerator; }
+
+    CCONTAINER          m_objects;
+    CGENERICACCELERATOR *m_accelerator;
+};
+
+/// Maps a S3DMODEL pointer with its created geometry
+typedef std::map< const S3DMODEL * , MODEL_GEOMETRY * > MAP_MODEL_GEOMETRY;
+
 typedef enum
 {
-    RT_RENDER_STATE_TRACING = 0,
+    RT_RENDER_STATE_TRACING = 0,            ///< one sample per pixel on all the blocks
+    RT_RENDER_STATE_TRACING_REFINE,         ///< anti-aliasing of the blocks with details
     RT_RENDER_STATE_POST_PROCESS_SHADE,
     RT_RENDER_STATE_POST_PROCESS_BLUR_AND_FINISH,
     RT_RENDER_STATE_FINISH,
@@ -69,6 +86,18 @@ public:
 
     int GetWaitForEditingTimeOut() override;
 
+    /**
+     * @brief RenderToImage - Render the scene at full quality (including the post
+     * processing, if enabled) into an image, without OpenGL, so it can run on a
+     * machine without a display or GPU. The camera of the settings is used, with its
+     * window size set to aSize. The renderer must not be used by a canvas meanwhile.
+     * @param aSize: the size of the image
+     * @param aImage: receives the rendered image
+     * @param aStatusTextReporter: reports the progress, can be NULL
+     * @return true on success
+     */
+    bool RenderToImage( const wxSize &aSize, wxImage &aImage, REPORTER *aStatusTextReporter );
+
 private:
     bool initializeOpenGL();
     void initializeNewWindowSize();
@@ -80,7 +109,7 @@ private:
     void rt_render_tracing( GLubyte *ptrPBO , REPORTER *aStatusTextReporter );
     void rt_render_post_process_shade( GLubyte *ptrPBO , REPORTER *aStatusTextReporter );
     void rt_render_post_process_blur_finish( GLubyte *ptrPBO , REPORTER *aStatusTextReporter );
-    void rt_render_trace_block( GLubyte *ptrPBO , signed int iBlock );
+    void rt_render_trace_block( GLubyte *ptrPBO , signed int iBlock, bool aRefine );
     void rt_final_color( GLubyte *ptrPBO, const SFVEC3F &rgbColor, bool applyColorSpaceConversion );
 
     void rt_shades_packet( const SFVEC3F *bgColorY,
@@ -164,9 +193,15 @@ private:
     /// this encodes the Morton code positions
     std::vector< SFVEC2UI > m_blockPositions;
 
-    /// this flags if a position was already processed (cleared each new render)
+    /// this flags if a position was already processed (cleared each new render pass)
     std::vector< int > m_blockPositionsWasProcessed;
 
+    /// luminance variance of each block, measured on the first pass
+    std::vector< float > m_blockVariance;
+
+    /// blocks to anti-alias on the refine pass, the highest variance first
+    std::vector< size_t > m_blockRefineOrder;
+
     /// this encodes the Morton code positions (on fast preview mode)
     std::vector< SFVEC2UI > m_blockPositionsFast;
 
@@ -197,10 +232,18 @@ private:
     void load_3D_models();
     void add_3D_models( const S3DMODEL *a3DModel,
                         const glm::mat4 &aModelMatrix );
+    void add_3D_model_triangles( const S3DMODEL *a3DModel,
+                                 const MODEL_MATERIALS &aMaterials,
+                                 CCONTAINER &aContainer );
 
     /// Stores materials of the 3D models
     MAP_MODEL_MATERIALS m_model_materials;
 
+    /// Stores the geometry of the 3D models, referred by the instances on m_object_container
+    MAP_MODEL_GEOMETRY m_model_geometry;
+
+    void free_3D_models_geometry();
+
     void initialize_block_positions();
 
     void render( GLubyte *ptrPBO, REPORTER *aStatusTextReporter );
@@ -31,9 +31,6 @@
 #include <stdio.h>
 
 
-COBJECT2D_STATS *COBJECT2D_STATS::s_instance = 0;
-
-
 COBJECT2D::COBJECT2D( OBJECT2D_TYPE aObjType, const BOARD_ITEM &aBoardItem )
     : m_boardItem(aBoardItem)
 {
@@ -63,6 +60,6 @@ void COBJECT2D_STATS::PrintStats()
 
     for( unsigned int i = 0; i < OBJ2D_MAX; ++i )
     {
-        printf( "  %20s  %u\n", OBJECT2D_STR[i], m_counter[i] );
+        printf( "  %20s  %u\n", OBJECT2D_STR[i], m_counter[i].load() );
     }
 }
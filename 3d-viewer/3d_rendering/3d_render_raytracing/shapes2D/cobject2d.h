@@ -32,6 +32,7 @@
 
 #include "cbbox2d.h"
 #include <string.h>
+#include <atomic>
 
 #include <class_board_item.h>
 
@@ -132,23 +133,31 @@ public:
 class COBJECT2D_STATS
 {
 public:
-    void ResetStats() { memset( m_counter, 0, sizeof( unsigned int ) * OBJ2D_MAX ); }
+    void ResetStats()
+    {
+        for( unsigned int i = 0; i < OBJ2D_MAX; ++i )
+            m_counter[i] = 0;
+    }
 
     unsigned int GetCountOf( OBJECT2D_TYPE aObjType ) const
     {
         return m_counter[aObjType];
     }
 
-    void AddOne( OBJECT2D_TYPE aObjType ) { m_counter[aObjType]++; }
+    /// Thread-safe: the layers are converted to 2D objects by several threads
+    void AddOne( OBJECT2D_TYPE aObjType )
+    {
+        m_counter[aObjType].fetch_add( 1, std::memory_order_relaxed );
+    }
 
     void PrintStats();
 
     static COBJECT2D_STATS &Instance()
     {
-        if( !s_instance )
-            s_instance = new COBJECT2D_STATS;
+        // Function-local static: its initialization is thread-safe
+        static COBJECT2D_STATS s_instance;
 
-        return *s_instance;
+        return s_instance;
     }
 
 private:
@@ -158,9 +167,7 @@ private:
     ~COBJECT2D_STATS(){}
 
 private:
-    unsigned int m_counter[OBJ2D_MAX];
-
-    static COBJECT2D_STATS *s_instance;
+    std::atomic<unsigned int> m_counter[OBJ2D_MAX];
 };
 
 #endif // _COBJECT2D_H_
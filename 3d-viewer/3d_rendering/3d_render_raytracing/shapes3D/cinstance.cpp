@@ -0,0 +1,121 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2018 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  cinstance.cpp
+ * @brief
+ */
+
+#include "cinstance.h"
+#include "../accelerators/caccelerator.h"
+
+
+CINSTANCE::CINSTANCE( const CGENERICACCELERATOR *aAccelerator,
+                      const CBBOX &aBBox,
+                      const glm::mat4 &aMatrix ) : COBJECT( OBJ3D_INSTANCE )
+{
+    m_accelerator  = aAccelerator;
+    m_worldToLocal = glm::inverse( aMatrix );
+    m_normalMatrix = glm::transpose( glm::inverse( glm::mat3( aMatrix ) ) );
+
+    // The bounding box of the transformed corners
+    m_bbox.Reset();
+
+    for( unsigned int i = 0; i < 8; ++i )
+    {
+        const SFVEC3F corner( ( i & 1 ) ? aBBox.Max().x : aBBox.Min().x,
+                              ( i & 2 ) ? aBBox.Max().y : aBBox.Min().y,
+                              ( i & 4 ) ? aBBox.Max().z : aBBox.Min().z );
+
+        m_bbox.Union( SFVEC3F( aMatrix * glm::vec4( corner, 1.0f ) ) );
+    }
+
+    m_bbox.ScaleNextUp();
+    m_centroid = m_bbox.GetCenter();
+}
+
+
+void CINSTANCE::toLocal( const RAY &aRay, RAY &aLocalRay ) const
+{
+    // The direction is not normalized, so the distances along the ray are
+    // the same on both coordinates
+    aLocalRay.Init( SFVEC3F( m_worldToLocal * glm::vec4( aRay.m_Origin, 1.0f ) ),
+                    SFVEC3F( m_worldToLocal * glm::vec4( aRay.m_Dir, 0.0f ) ) );
+}
+
+
+bool CINSTANCE::Intersect( const RAY &aRay, HITINFO &aHitInfo ) const
+{
+    float tBBox;
+
+    if( !m_bbox.Intersect( aRay, &tBBox ) || ( tBBox >= aHitInfo.m_tHit ) )
+        return false;
+
+    RAY localRay;
+
+    toLocal( aRay, localRay );
+
+    // The accelerator of the objects stores its own node, keep the one of
+    // the accelerator that holds this instance
+    const unsigned int accNodeInfo = aHitInfo.m_acc_node_info;
+
+    if( !m_accelerator->Intersect( localRay, aHitInfo ) )
+        return false;
+
+    aHitInfo.m_acc_node_info = accNodeInfo;
+
+    // The hit object and its material already were set by the hit, the normal
+    // perturbation was done on the coordinates of the objects
+    aHitInfo.m_HitPoint  = aRay.at( aHitInfo.m_tHit );
+    aHitInfo.m_HitNormal = glm::normalize( m_normalMatrix * aHitInfo.m_HitNormal );
+
+    return true;
+}
+
+
+bool CINSTANCE::IntersectP( const RAY &aRay, float aMaxDistance ) const
+{
+    float tBBox;
+
+    if( !m_bbox.Intersect( aRay, &tBBox ) || ( tBBox >= aMaxDistance ) )
+        return false;
+
+    RAY localRay;
+
+    toLocal( aRay, localRay );
+
+    return m_accelerator->IntersectP( localRay, aMaxDistance );
+}
+
+
+bool CINSTANCE::Intersects( const CBBOX &aBBox ) const
+{
+    return m_bbox.Intersects( aBBox );
+}
+
+
+SFVEC3F CINSTANCE::GetDiffuseColor( const HITINFO &aHitInfo ) const
+{
+    // Not used: the hits refer to the instanced objects
+    return aHitInfo.pHitObject->GetDiffuseColor( aHitInfo );
+}
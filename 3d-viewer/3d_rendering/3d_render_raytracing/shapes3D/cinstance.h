@@ -0,0 +1,72 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2018 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file  cinstance.h
+ * @brief An object placing the objects of a shared accelerator with a transformation
+ */
+
+#ifndef _CINSTANCE_H_
+#define _CINSTANCE_H_
+
+#include "cobject.h"
+#include <glm/glm.hpp>
+
+class CGENERICACCELERATOR;
+
+/**
+ * An instance of a group of objects, that are defined in their own coordinates
+ * and stored in an accelerator shared by all the instances (e.g. the triangles
+ * of a 3D model). The rays are transformed to the coordinates of the objects,
+ * and the hits back to world coordinates, so the hit object is the instanced one.
+ */
+class  CINSTANCE : public COBJECT
+{
+
+public:
+    /**
+     * @param aAccelerator - the objects, it is not owned by the instance
+     * @param aBBox - the bounding box of the objects, in their coordinates
+     * @param aMatrix - the transformation from the objects to world coordinates
+     */
+    CINSTANCE( const CGENERICACCELERATOR *aAccelerator,
+               const CBBOX &aBBox,
+               const glm::mat4 &aMatrix );
+
+// Imported from COBJECT
+    bool Intersect( const RAY &aRay, HITINFO &aHitInfo ) const override;
+    bool IntersectP(const RAY &aRay , float aMaxDistance ) const override;
+    bool Intersects( const CBBOX &aBBox ) const override;
+    SFVEC3F GetDiffuseColor( const HITINFO &aHitInfo ) const override;
+
+private:
+    void toLocal( const RAY &aRay, RAY &aLocalRay ) const;
+
+    const CGENERICACCELERATOR *m_accelerator;
+
+    glm::mat4 m_worldToLocal;
+    glm::mat3 m_normalMatrix;   ///< transforms the normals to world coordinates
+};
+
+
+#endif // _CINSTANCE_H_
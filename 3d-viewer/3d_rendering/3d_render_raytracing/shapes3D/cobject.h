@@ -43,6 +43,7 @@ enum OBJECT3D_TYPE
     OBJ3D_XYPLANE,
     OBJ3D_ROUNDSEG,
     OBJ3D_TRIANGLE,
+    OBJ3D_INSTANCE,
     OBJ3D_MAX
 };
 
@@ -246,6 +246,18 @@ void EDA_3D_VIEWER::NewDisplay( bool aForceImmediateRedraw )
 }
 
 
+void EDA_3D_VIEWER::UpdateLayers( const LSET& aDirtyLayers, bool aForceImmediateRedraw )
+{
+    if( !m_canvas )
+        return;
+
+    m_canvas->ReloadLayersRequest( aDirtyLayers );
+
+    if( aForceImmediateRedraw )
+        m_canvas->Refresh();
+}
+
+
 void EDA_3D_VIEWER::Exit3DFrame( wxCommandEvent &event )
 {
     wxLogTrace( m_logTrace, "EDA_3D_VIEWER::Exit3DFrame" );
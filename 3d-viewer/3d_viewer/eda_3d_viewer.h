@@ -71,8 +71,6 @@ class EDA_3D_VIEWER : public KIWAY_PLAYER
      */
     void ReloadRequest();
 
-    // !TODO: review this function: it need a way to tell what changed,
-    // to only reload/rebuild things that have really changed
     /**
      * Reload and refresh (rebuild)  the 3D scene.
      * Warning: rebuilding the 3D scene can take a bit of time, so
@@ -83,6 +81,16 @@ class EDA_3D_VIEWER : public KIWAY_PLAYER
      */
     void NewDisplay( bool aForceImmediateRedraw = false );
 
+    /**
+     * Reload and refresh only the layers of the 3D scene whose board items were
+     * changed. The full scene is rebuilt if the change affects the whole board
+     * (e.g. its outline).
+     * @param aDirtyLayers = the layers of the changed board items
+     * @param aForceImmediateRedraw = true to immediately rebuild the 3D scene,
+     * false to wait a refresh later.
+     */
+    void UpdateLayers( const LSET& aDirtyLayers, bool aForceImmediateRedraw = false );
+
     /**
      *  Set the default file name (eg: to be suggested to a screenshot)
      *  @param aFn = file name to assign
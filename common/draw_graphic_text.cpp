@@ -87,6 +87,8 @@ int Clamp_Text_PenSize( int aPenSize, wxSize aSize, bool aBold )
 
 int GraphicTextWidth( const wxString& aText, const wxSize& aSize, bool aItalic, bool aBold )
 {
+    std::lock_guard<std::mutex> lock( basic_gal_mutex );
+
     basic_gal.SetFontItalic( aItalic );
     basic_gal.SetFontBold( aBold );
     basic_gal.SetGlyphSize( VECTOR2D( aSize ) );
@@ -149,9 +151,6 @@ void DrawGraphicText( EDA_RECT* aClipBox,
         fill_mode = false;
     }
 
-    basic_gal.SetIsFill( fill_mode );
-    basic_gal.SetLineWidth( aWidth );
-
     EDA_TEXT dummy;
     dummy.SetItalic( aItalic );
     dummy.SetBold( aBold );
@@ -166,6 +165,10 @@ void DrawGraphicText( EDA_RECT* aClipBox,
 
     dummy.SetTextSize( size );
 
+    std::lock_guard<std::mutex> lock( basic_gal_mutex );
+
+    basic_gal.SetIsFill( fill_mode );
+    basic_gal.SetLineWidth( aWidth );
     basic_gal.SetTextAttributes( &dummy );
     basic_gal.SetPlotter( aPlotter );
     basic_gal.SetCallback( aCallback, aCallbackData );
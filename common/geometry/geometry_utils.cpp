@@ -54,6 +54,28 @@ int GetArcToSegmentCount( int aRadius, int aErrorMax, double aArcAngleDegree )
 }
 
 
+int GetCircleToSegmentCount( int aRadius, int aErrorMax, int aMaxSegCount )
+{
+    // The smallest multiple of 4 not smaller than MIN_SEGCOUNT_FOR_CIRCLE
+    const int minSegCount = ( MIN_SEGCOUNT_FOR_CIRCLE + 3 ) / 4 * 4;
+
+    if( aErrorMax <= 0 )
+        return aMaxSegCount;
+
+    int segCount = minSegCount;
+
+    if( aRadius > aErrorMax )
+    {
+        // the max error is reached by the segment count nn = M_PI / acos(1.0 - error/radius)
+        double exact = M_PI / acos( 1.0 - (double) aErrorMax / aRadius );
+
+        segCount = std::max( segCount, (int) ceil( exact / 4 ) * 4 );
+    }
+
+    return std::min( segCount, aMaxSegCount );
+}
+
+
 double GetCircletoPolyCorrectionFactor( int aSegCountforCircle )
 {
     /* calculates the coeff to compensate radius reduction of circle
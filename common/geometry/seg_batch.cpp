@@ -0,0 +1,207 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+
+#include <geometry/seg_batch.h>
+
+#include "seg_batch_kernels.h"
+
+
+static_assert( sizeof( VECTOR2I ) == 2 * sizeof( int32_t ),
+               "the batch kernels read VECTOR2I arrays as pairs of int32_t" );
+
+
+/// Size of the blocks the kernel results are buffered in
+static const int BLOCK_SIZE = 64;
+
+
+static const int32_t* coords( const VECTOR2I* aP )
+{
+    return reinterpret_cast<const int32_t*>( aP );
+}
+
+
+static bool cpuSupports( SEG_BATCH::KERNEL aKernel )
+{
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) \
+        && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    switch( aKernel )
+    {
+    case SEG_BATCH::SCALAR: return true;
+    case SEG_BATCH::SSE42:  return __builtin_cpu_supports( "sse4.2" );
+    case SEG_BATCH::AVX2:   return __builtin_cpu_supports( "avx2" );
+    }
+
+    return false;
+#else
+    return aKernel == SEG_BATCH::SCALAR;
+#endif
+}
+
+
+const SEG_BATCH_KERNELS* SEG_BATCH::kernels( KERNEL aKernel )
+{
+    if( !cpuSupports( aKernel ) )
+        return nullptr;
+
+    switch( aKernel )
+    {
+    case SSE42: return SegBatchSse42Kernels();
+    case AVX2:  return SegBatchAvx2Kernels();
+    default:    return nullptr;
+    }
+}
+
+
+bool SEG_BATCH::HasKernel( KERNEL aKernel )
+{
+    return aKernel == SCALAR || kernels( aKernel ) != nullptr;
+}
+
+
+SEG_BATCH::KERNEL SEG_BATCH::BestKernel()
+{
+    static const KERNEL best = HasKernel( AVX2 ) ? AVX2 : HasKernel( SSE42 ) ? SSE42 : SCALAR;
+
+    return best;
+}
+
+
+SEG_BATCH::SEG_BATCH( const VECTOR2I* aA, const VECTOR2I* aB, int aCount, KERNEL aKernel ) :
+    m_a( aA ),
+    m_b( aB ),
+    m_count( aCount ),
+    m_kernels( kernels( aKernel ) )
+{
+}
+
+
+void SEG_BATCH::squaredDistances( const VECTOR2I& aP, int aFirst, int aCount,
+                                  SEG::ecoord* aDist ) const
+{
+    int i = 0;
+
+    if( m_kernels )
+    {
+        int done = m_kernels->pointToSegments( coords( &aP ), coords( m_a + aFirst ),
+                                               coords( m_b + aFirst ), aCount, aDist );
+
+        for( ; i < done; i++ )
+        {
+            if( aDist[i] == SEG_BATCH_KERNELS::UNDECIDED_DISTANCE )
+                aDist[i] = Segment( aFirst + i ).SquaredDistance( aP );
+        }
+    }
+
+    for( ; i < aCount; i++ )
+        aDist[i] = Segment( aFirst + i ).SquaredDistance( aP );
+}
+
+
+void SEG_BATCH::SquaredDistances( const VECTOR2I& aP, SEG::ecoord* aDist ) const
+{
+    squaredDistances( aP, 0, m_count, aDist );
+}
+
+
+SEG::ecoord SEG_BATCH::SquaredDistance( const VECTOR2I& aP ) const
+{
+    SEG::ecoord dist[BLOCK_SIZE];
+    SEG::ecoord d_min = VECTOR2I::ECOORD_MAX;
+
+    for( int first = 0; first < m_count; first += BLOCK_SIZE )
+    {
+        int count = std::min( BLOCK_SIZE, m_count - first );
+
+        squaredDistances( aP, first, count, dist );
+
+        for( int i = 0; i < count; i++ )
+            d_min = std::min( d_min, dist[i] );
+    }
+
+    return d_min;
+}
+
+
+int SEG_BATCH::Collide( const SEG& aSeg, int aClearance, int aFirst ) const
+{
+    if( !m_kernels )
+    {
+        for( int i = aFirst; i < m_count; i++ )
+        {
+            if( Segment( i ).Collide( aSeg, aClearance ) )
+                return i;
+        }
+
+        return -1;
+    }
+
+    uint8_t result[BLOCK_SIZE];
+
+    for( int first = aFirst; first < m_count; first += BLOCK_SIZE )
+    {
+        int count = std::min( BLOCK_SIZE, m_count - first );
+        int done = m_kernels->collide( coords( &aSeg.A ), coords( &aSeg.B ), aClearance,
+                                       coords( m_a + first ), coords( m_b + first ), count,
+                                       result );
+
+        for( int i = 0; i < count; i++ )
+        {
+            bool collide;
+
+            if( i >= done || result[i] == SEG_BATCH_KERNELS::UNDECIDED_COLLISION )
+                collide = Segment( first + i ).Collide( aSeg, aClearance );
+            else
+                collide = result[i] == SEG_BATCH_KERNELS::COLLISION;
+
+            if( collide )
+                return first + i;
+        }
+    }
+
+    return -1;
+}
+
+
+void SEG_BATCH::SquaredDistances( const SEG& aSeg, const VECTOR2I* aPoints, int aCount,
+                                  SEG::ecoord* aDist, KERNEL aKernel )
+{
+    const SEG_BATCH_KERNELS* k = kernels( aKernel );
+    int i = 0;
+
+    if( k )
+    {
+        int done = k->segmentToPoints( coords( &aSeg.A ), coords( &aSeg.B ), coords( aPoints ),
+                                       aCount, aDist );
+
+        for( ; i < done; i++ )
+        {
+            if( aDist[i] == SEG_BATCH_KERNELS::UNDECIDED_DISTANCE )
+                aDist[i] = aSeg.SquaredDistance( aPoints[i] );
+        }
+    }
+
+    for( ; i < aCount; i++ )
+        aDist[i] = aSeg.SquaredDistance( aPoints[i] );
+}
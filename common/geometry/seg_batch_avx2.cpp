@@ -0,0 +1,100 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+ * AVX2 kernels of SEG_BATCH.  This file is built with AVX2 enabled, and only used when the
+ * CPU supports it: see seg_batch_kernels.h before including anything here.
+ */
+
+#if defined( __AVX2__ )
+
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+struct AVX2_OPS
+{
+    typedef __m256i V;
+
+    static const int LANES = 4;
+
+    static V load( const int32_t* aP ) { return _mm256_loadu_si256( (const __m256i*) aP ); }
+    static void store( int64_t* aP, V a ) { _mm256_storeu_si256( (__m256i*) aP, a ); }
+
+    static V broadcast( const int32_t* aP )
+    {
+        int64_t v;
+        memcpy( &v, aP, sizeof( v ) );
+        return _mm256_set1_epi64x( v );
+    }
+
+    static V set32( int32_t a ) { return _mm256_set1_epi32( a ); }
+    static V set64( int64_t a ) { return _mm256_set1_epi64x( a ); }
+
+    static V sub32( V a, V b ) { return _mm256_sub_epi32( a, b ); }
+    static V abs32( V a ) { return _mm256_abs_epi32( a ); }
+    static V sign32( V a, V b ) { return _mm256_sign_epi32( a, b ); }
+    static V min32( V a, V b ) { return _mm256_min_epi32( a, b ); }
+    static V max32( V a, V b ) { return _mm256_max_epi32( a, b ); }
+    static V eq32( V a, V b ) { return _mm256_cmpeq_epi32( a, b ); }
+    static V swap32( V a ) { return _mm256_shuffle_epi32( a, 0xB1 ); }
+
+    static V mul( V a, V b ) { return _mm256_mul_epi32( a, b ); }
+    static V hi( V a ) { return _mm256_srli_epi64( a, 32 ); }
+    static V srl1( V a ) { return _mm256_srli_epi64( a, 1 ); }
+    static V add64( V a, V b ) { return _mm256_add_epi64( a, b ); }
+    static V sub64( V a, V b ) { return _mm256_sub_epi64( a, b ); }
+    static V gt64( V a, V b ) { return _mm256_cmpgt_epi64( a, b ); }
+    static V eq64( V a, V b ) { return _mm256_cmpeq_epi64( a, b ); }
+
+    static V and_( V a, V b ) { return _mm256_and_si256( a, b ); }
+    static V or_( V a, V b ) { return _mm256_or_si256( a, b ); }
+    static V xor_( V a, V b ) { return _mm256_xor_si256( a, b ); }
+    static V andnot( V a, V b ) { return _mm256_andnot_si256( a, b ); }
+
+    static V select( V aMask, V a, V b ) { return _mm256_blendv_epi8( b, a, aMask ); }
+
+    static int mask( V a ) { return _mm256_movemask_pd( _mm256_castsi256_pd( a ) ); }
+};
+
+#define SEG_BATCH_OPS AVX2_OPS
+
+#include "seg_batch_kernels.h"
+
+
+const SEG_BATCH_KERNELS* SegBatchAvx2Kernels()
+{
+    return &kernels;
+}
+
+#else
+
+#include "seg_batch_kernels.h"
+
+
+const SEG_BATCH_KERNELS* SegBatchAvx2Kernels()
+{
+    return nullptr;
+}
+
+#endif
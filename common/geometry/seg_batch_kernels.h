@@ -0,0 +1,311 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __SEG_BATCH_KERNELS_H
+#define __SEG_BATCH_KERNELS_H
+
+#include <cstdint>
+
+/**
+ * Vectorized kernels behind SEG_BATCH.
+ *
+ * The kernels only include this header and the intrinsics headers, as they are built with
+ * instruction set flags the rest of the code is not built with: any inline function of the
+ * common headers instantiated there might replace the generic one at link time.
+ *
+ * Points are passed as pairs of 32 bit integers (x, y), as stored by VECTOR2I.  Each kernel
+ * processes a multiple of its vector width and returns the number of items processed, the
+ * remaining ones are left to the caller.  The lanes which would need the integer rescaling
+ * of SEG::NearestPoint() are not computed, and are marked so to be done by SEG itself.
+ */
+struct SEG_BATCH_KERNELS
+{
+    /// Marks a squared distance not computed by the kernel
+    static const int64_t UNDECIDED_DISTANCE = -1;
+
+    /// Collision results of the kernels
+    enum COLLISION : uint8_t
+    {
+        NO_COLLISION = 0,
+        COLLISION,
+        UNDECIDED_COLLISION
+    };
+
+    /// Squared distances between a point and the segments aA[i] - aB[i]
+    int ( *pointToSegments )( const int32_t* aP, const int32_t* aA, const int32_t* aB,
+                              int aCount, int64_t* aDist );
+
+    /// Squared distances between the segment aA - aB and the points aP[i]
+    int ( *segmentToPoints )( const int32_t* aA, const int32_t* aB, const int32_t* aP,
+                              int aCount, int64_t* aDist );
+
+    /// Collisions between the segment aSegA - aSegB and the segments aA[i] - aB[i]
+    int ( *collide )( const int32_t* aSegA, const int32_t* aSegB, int aClearance,
+                      const int32_t* aA, const int32_t* aB, int aCount, uint8_t* aResult );
+};
+
+
+/// The SSE4.2 kernels, or nullptr if they are not built
+const SEG_BATCH_KERNELS* SegBatchSse42Kernels();
+
+/// The AVX2 kernels, or nullptr if they are not built
+const SEG_BATCH_KERNELS* SegBatchAvx2Kernels();
+
+
+#ifdef SEG_BATCH_OPS
+
+/*
+ * Kernels on a vector of 64 bit lanes, each holding the (x, y) pair of a point, written
+ * over the SEG_BATCH_OPS class of the including file.  They are in an anonymous namespace,
+ * as each instruction set gets its own copy.
+ */
+namespace
+{
+
+typedef SEG_BATCH_OPS OPS;
+typedef OPS::V        V;
+
+
+/// Integer cross product a.x * b.y - a.y * b.x, as VECTOR2I::Cross()
+inline V cross( V a, V b )
+{
+    return OPS::sub64( OPS::mul( a, OPS::hi( b ) ), OPS::mul( OPS::hi( a ), b ) );
+}
+
+
+/// Integer dot product, as VECTOR2I::Dot()
+inline V dot( V a, V b )
+{
+    return OPS::add64( OPS::mul( a, b ), OPS::mul( OPS::hi( a ), OPS::hi( b ) ) );
+}
+
+
+/// The x coordinates, sign extended to 64 bits
+inline V xs( V a )
+{
+    return OPS::mul( a, OPS::set64( 1 ) );
+}
+
+
+/// The y coordinates, sign extended to 64 bits
+inline V ys( V a )
+{
+    return OPS::mul( OPS::hi( a ), OPS::set64( 1 ) );
+}
+
+
+/**
+ * SEG::SquaredDistance( VECTOR2I ), or UNDECIDED_DISTANCE when the nearest point is inside
+ * the segment
+ */
+inline V squaredDistance( V a, V b, V p )
+{
+    V d = OPS::sub32( b, a );
+    V l_squared = dot( d, d );
+    V t = dot( d, OPS::sub32( p, a ) );
+
+    V zero = OPS::set64( 0 );
+    V nearA = OPS::or_( OPS::eq64( l_squared, zero ), OPS::gt64( zero, t ) );
+    V nearB = OPS::andnot( nearA, OPS::gt64( t, l_squared ) );
+
+    V distA = dot( OPS::sub32( a, p ), OPS::sub32( a, p ) );
+    V distB = dot( OPS::sub32( b, p ), OPS::sub32( b, p ) );
+
+    V dist = OPS::select( nearB, distB, OPS::set64( SEG_BATCH_KERNELS::UNDECIDED_DISTANCE ) );
+
+    return OPS::select( nearA, distA, dist );
+}
+
+
+/// SEG::ccw()
+inline V ccw( V a, V b, V c )
+{
+    V ca = OPS::sub32( c, a );
+    V ba = OPS::sub32( b, a );
+
+    return OPS::gt64( OPS::mul( OPS::hi( ca ), ba ), OPS::mul( OPS::hi( ba ), ca ) );
+}
+
+
+/**
+ * SEG::PointCloserThan().  Sets the lanes of aCloser where the point is closer than the
+ * clearance, and the lanes of aUndecided where the result needs the nearest point.
+ */
+inline void pointCloserThan( V a, V b, V p, V aDistSq, V aClearance, V& aCloser,
+                             V& aUndecided )
+{
+    V zero = OPS::set64( 0 );
+    V ones = OPS::eq64( zero, zero );
+
+    V d = OPS::sub32( b, a );
+    V l_squared = dot( d, d );
+    V t = dot( d, OPS::sub32( p, a ) );
+
+    V nearA = OPS::or_( OPS::eq64( l_squared, zero ), OPS::andnot( OPS::gt64( t, zero ), ones ) );
+    V nearB = OPS::andnot( nearA, OPS::andnot( OPS::gt64( l_squared, t ), ones ) );
+    V inner = OPS::andnot( OPS::or_( nearA, nearB ), ones );
+
+    V closerA = OPS::gt64( aDistSq, dot( OPS::sub32( p, a ), OPS::sub32( p, a ) ) );
+    V closerB = OPS::gt64( aDistSq, dot( OPS::sub32( p, b ), OPS::sub32( p, b ) ) );
+
+    // Segments close to horizontal, vertical or 45 degrees are first tested against the
+    // line of that direction
+    V absD = OPS::abs32( d );
+    V dxdy = xs( OPS::sub32( absD, OPS::hi( absD ) ) );
+    V one = OPS::set64( 1 );
+    V minusOne = OPS::set64( -1 );
+
+    V nearDiagonal = OPS::andnot( OPS::or_( OPS::gt64( dxdy, one ), OPS::gt64( minusOne, dxdy ) ),
+                                  ones );
+    V nearAxis = OPS::or_( OPS::andnot( OPS::gt64( xs( absD ), one ), ones ),
+                           OPS::andnot( OPS::gt64( ys( absD ), one ), ones ) );
+    V quick = OPS::or_( nearDiagonal, nearAxis );
+
+    // sgn( d ) in each half, then swapped to get ( -ca, cb )
+    V sgnD = OPS::sign32( OPS::set32( 1 ), d );
+    V swapped = OPS::swap32( sgnD );
+    V ca = OPS::sub32( zero, swapped );
+
+    V products = OPS::sign32( a, swapped );
+    V cc = xs( OPS::sub32( products, OPS::hi( products ) ) );
+
+    V num = OPS::add64( OPS::add64( OPS::mul( p, ca ), OPS::mul( OPS::hi( p ), sgnD ) ), cc );
+
+    // The square is computed by the kernel only when it can not overflow
+    V fits = OPS::and_( OPS::gt64( OPS::set64( INT32_MAX ), num ),
+                        OPS::gt64( num, OPS::set64( -INT32_MAX ) ) );
+
+    num = OPS::mul( num, num );
+
+    V diagonal = OPS::eq64( OPS::andnot( OPS::eq32( sgnD, zero ), ones ), ones );
+    num = OPS::select( diagonal, OPS::srl1( num ), num );
+
+    V quickFar = OPS::gt64( num, OPS::add64( aDistSq, OPS::set64( 100 ) ) );
+    V quickNear = OPS::gt64( OPS::sub64( aDistSq, OPS::set64( 100 ) ), num );
+
+    V quickDone = OPS::and_( quick, OPS::and_( fits, OPS::or_( quickFar, quickNear ) ) );
+    V overflow = OPS::andnot( fits, quick );
+
+    // The nearest point is inside the segment bounding box: a point farther from the box
+    // than the clearance on one axis is never closer
+    V lo = OPS::min32( a, b );
+    V hi = OPS::max32( a, b );
+
+    V outside = OPS::or_( OPS::or_( OPS::gt64( OPS::sub64( xs( p ), xs( hi ) ), aClearance ),
+                                    OPS::gt64( OPS::sub64( xs( lo ), xs( p ) ), aClearance ) ),
+                          OPS::or_( OPS::gt64( OPS::sub64( ys( p ), ys( hi ) ), aClearance ),
+                                    OPS::gt64( OPS::sub64( ys( lo ), ys( p ) ), aClearance ) ) );
+
+    V far = OPS::andnot( overflow, outside );
+
+    aCloser = OPS::or_( aCloser, OPS::or_( OPS::and_( nearA, closerA ),
+                                           OPS::and_( nearB, closerB ) ) );
+    aCloser = OPS::or_( aCloser, OPS::and_( inner, OPS::and_( quickDone, quickNear ) ) );
+
+    aUndecided = OPS::or_( aUndecided,
+                           OPS::andnot( OPS::or_( quickDone, far ), inner ) );
+}
+
+
+/// SEG::Collide()
+inline int collision( V a, V b, V segA, V segB, V aDistSq, V aClearance )
+{
+    V zero = OPS::set64( 0 );
+
+    V collide = OPS::and_( OPS::xor_( ccw( a, segA, segB ), ccw( b, segA, segB ) ),
+                           OPS::xor_( ccw( a, b, segA ), ccw( a, b, segB ) ) );
+    V undecided = zero;
+
+    pointCloserThan( a, b, segA, aDistSq, aClearance, collide, undecided );
+    pointCloserThan( a, b, segB, aDistSq, aClearance, collide, undecided );
+    pointCloserThan( segA, segB, a, aDistSq, aClearance, collide, undecided );
+    pointCloserThan( segA, segB, b, aDistSq, aClearance, collide, undecided );
+
+    return OPS::mask( collide ) | ( OPS::mask( OPS::andnot( collide, undecided ) ) << OPS::LANES );
+}
+
+
+int pointToSegments( const int32_t* aP, const int32_t* aA, const int32_t* aB, int aCount,
+                     int64_t* aDist )
+{
+    V   p = OPS::broadcast( aP );
+    int i = 0;
+
+    for( ; i + OPS::LANES <= aCount; i += OPS::LANES )
+        OPS::store( aDist + i, squaredDistance( OPS::load( aA + 2 * i ),
+                                                OPS::load( aB + 2 * i ), p ) );
+
+    return i;
+}
+
+
+int segmentToPoints( const int32_t* aA, const int32_t* aB, const int32_t* aP, int aCount,
+                     int64_t* aDist )
+{
+    V   a = OPS::broadcast( aA );
+    V   b = OPS::broadcast( aB );
+    int i = 0;
+
+    for( ; i + OPS::LANES <= aCount; i += OPS::LANES )
+        OPS::store( aDist + i, squaredDistance( a, b, OPS::load( aP + 2 * i ) ) );
+
+    return i;
+}
+
+
+int collide( const int32_t* aSegA, const int32_t* aSegB, int aClearance, const int32_t* aA,
+             const int32_t* aB, int aCount, uint8_t* aResult )
+{
+    V segA = OPS::broadcast( aSegA );
+    V segB = OPS::broadcast( aSegB );
+    V distSq = OPS::set64( (int64_t) aClearance * aClearance );
+    V clearance = OPS::set64( aClearance < 0 ? -(int64_t) aClearance : aClearance );
+    int i = 0;
+
+    for( ; i + OPS::LANES <= aCount; i += OPS::LANES )
+    {
+        int bits = collision( OPS::load( aA + 2 * i ), OPS::load( aB + 2 * i ), segA, segB,
+                              distSq, clearance );
+
+        for( int lane = 0; lane < OPS::LANES; lane++ )
+        {
+            if( bits & ( 1 << lane ) )
+                aResult[i + lane] = SEG_BATCH_KERNELS::COLLISION;
+            else if( bits & ( 1 << ( lane + OPS::LANES ) ) )
+                aResult[i + lane] = SEG_BATCH_KERNELS::UNDECIDED_COLLISION;
+            else
+                aResult[i + lane] = SEG_BATCH_KERNELS::NO_COLLISION;
+        }
+    }
+
+    return i;
+}
+
+
+const SEG_BATCH_KERNELS kernels = { pointToSegments, segmentToPoints, collide };
+
+} // namespace
+
+#endif // SEG_BATCH_OPS
+
+#endif // __SEG_BATCH_KERNELS_H
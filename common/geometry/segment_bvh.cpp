@@ -0,0 +1,87 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+
+#include <geometry/segment_bvh.h>
+#include <geometry/shape_line_chain.h>
+
+
+SEGMENT_BVH::SEGMENT_BVH( const SHAPE_LINE_CHAIN& aChain ) :
+    m_segmentCount( aChain.SegmentCount() )
+{
+    std::vector<BOX2I> leaves;
+    leaves.reserve( ( m_segmentCount + LEAF_SIZE - 1 ) / LEAF_SIZE );
+
+    for( int first = 0; first < m_segmentCount; first += LEAF_SIZE )
+    {
+        int last = std::min( first + LEAF_SIZE, m_segmentCount );
+
+        const SEG& seg = aChain.CSegment( first );
+        int x1 = std::min( seg.A.x, seg.B.x );
+        int y1 = std::min( seg.A.y, seg.B.y );
+        int x2 = std::max( seg.A.x, seg.B.x );
+        int y2 = std::max( seg.A.y, seg.B.y );
+
+        // The segments of a run share their end points: only the B points are new
+        for( int i = first + 1; i < last; i++ )
+        {
+            const VECTOR2I& p = aChain.CSegment( i ).B;
+
+            x1 = std::min( x1, p.x );
+            y1 = std::min( y1, p.y );
+            x2 = std::max( x2, p.x );
+            y2 = std::max( y2, p.y );
+        }
+
+        leaves.emplace_back( VECTOR2I( x1, y1 ), VECTOR2I( x2 - x1, y2 - y1 ) );
+    }
+
+    m_levels.push_back( std::move( leaves ) );
+
+    while( m_levels.back().size() > FANOUT )
+    {
+        const std::vector<BOX2I>& children = m_levels.back();
+        std::vector<BOX2I>        nodes;
+
+        nodes.reserve( ( children.size() + FANOUT - 1 ) / FANOUT );
+
+        for( size_t first = 0; first < children.size(); first += FANOUT )
+        {
+            BOX2I box = children[first];
+            size_t last = std::min( first + FANOUT, children.size() );
+
+            for( size_t i = first + 1; i < last; i++ )
+                box.Merge( children[i] );
+
+            nodes.push_back( box );
+        }
+
+        m_levels.push_back( std::move( nodes ) );
+    }
+
+    m_bbox = m_levels.back()[0];
+
+    for( const BOX2I& box : m_levels.back() )
+        m_bbox.Merge( box );
+}
@@ -23,12 +23,140 @@
  */
 
 #include <algorithm>
+#include <limits>
 
+#include <geometry/seg_batch.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_circle.h>
 #include "clipper.hpp"
 
 
+/**
+ * Returns the squared distance between a box and a point (0 if the point is inside the box)
+ */
+static SEG::ecoord squaredDistance( const BOX2I& aBox, const VECTOR2I& aP )
+{
+    SEG::ecoord dx = std::max<SEG::ecoord>( { (SEG::ecoord) aBox.GetX() - aP.x, 0,
+                                              (SEG::ecoord) aP.x - aBox.GetRight() } );
+    SEG::ecoord dy = std::max<SEG::ecoord>( { (SEG::ecoord) aBox.GetY() - aP.y, 0,
+                                              (SEG::ecoord) aP.y - aBox.GetBottom() } );
+
+    return dx * dx + dy * dy;
+}
+
+
+/**
+ * Returns the smallest squared distance between aP and the segments aFirst to aLast - 1
+ * of aChain
+ */
+static SEG::ecoord squaredDistance( const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP,
+                                    int aFirst, int aLast )
+{
+    // The closing segment of a closed chain does not end at the point following its start
+    int open = std::min( aLast, aChain.PointCount() - 1 );
+    SEG::ecoord d_sq = VECTOR2I::ECOORD_MAX;
+
+    if( aFirst < open )
+    {
+        SEG_BATCH batch( &aChain.CPoint( aFirst ), &aChain.CPoint( aFirst + 1 ), open - aFirst );
+        d_sq = batch.SquaredDistance( aP );
+    }
+
+    for( int i = std::max( aFirst, open ); i < aLast; i++ )
+        d_sq = std::min( d_sq, aChain.CSegment( i ).SquaredDistance( aP ) );
+
+    return d_sq;
+}
+
+
+/**
+ * Returns the index of the first segment from aFirst to aLast - 1 of aChain colliding with
+ * aSeg, or -1
+ */
+static int firstCollision( const SHAPE_LINE_CHAIN& aChain, const SEG& aSeg, int aClearance,
+                           int aFirst, int aLast )
+{
+    int open = std::min( aLast, aChain.PointCount() - 1 );
+
+    if( aFirst < open )
+    {
+        SEG_BATCH batch( &aChain.CPoint( aFirst ), &aChain.CPoint( aFirst + 1 ), open - aFirst );
+        int i = batch.Collide( aSeg, aClearance );
+
+        if( i >= 0 )
+            return aFirst + i;
+    }
+
+    for( int i = std::max( aFirst, open ); i < aLast; i++ )
+    {
+        if( aChain.CSegment( i ).Collide( aSeg, aClearance ) )
+            return i;
+    }
+
+    return -1;
+}
+
+
+std::shared_ptr<const SEGMENT_BVH> SHAPE_LINE_CHAIN::segmentIndex() const
+{
+    if( SegmentCount() < SEGMENT_BVH::MIN_SEGMENTS )
+        return nullptr;
+
+    std::shared_ptr<const SEGMENT_BVH> index = std::atomic_load( &m_segmentIndex );
+
+    // Several threads may build the index of a shared chain at the same time: they build
+    // the same index, so it does not matter which one is kept
+    if( !index )
+    {
+        index = std::make_shared<const SEGMENT_BVH>( *this );
+        std::atomic_store( &m_segmentIndex, index );
+    }
+
+    return index;
+}
+
+
+const BOX2I SHAPE_LINE_CHAIN::cachedBBox() const
+{
+    if( m_bboxValid.load( std::memory_order_acquire ) )
+    {
+        return BOX2I( VECTOR2I( m_bboxCache[0].load( std::memory_order_relaxed ),
+                                m_bboxCache[1].load( std::memory_order_relaxed ) ),
+                      VECTOR2I( m_bboxCache[2].load( std::memory_order_relaxed ),
+                                m_bboxCache[3].load( std::memory_order_relaxed ) ) );
+    }
+
+    BOX2I bbox;
+    bbox.Compute( m_points );
+
+    m_bboxCache[0].store( bbox.GetX(), std::memory_order_relaxed );
+    m_bboxCache[1].store( bbox.GetY(), std::memory_order_relaxed );
+    m_bboxCache[2].store( bbox.GetWidth(), std::memory_order_relaxed );
+    m_bboxCache[3].store( bbox.GetHeight(), std::memory_order_relaxed );
+    m_bboxValid.store( true, std::memory_order_release );
+
+    return bbox;
+}
+
+
+void SHAPE_LINE_CHAIN::copyCachedBBox( const SHAPE_LINE_CHAIN& aOther )
+{
+    if( !aOther.m_bboxValid.load( std::memory_order_acquire ) )
+    {
+        m_bboxValid.store( false, std::memory_order_relaxed );
+        return;
+    }
+
+    for( int i = 0; i < 4; i++ )
+    {
+        m_bboxCache[i].store( aOther.m_bboxCache[i].load( std::memory_order_relaxed ),
+                              std::memory_order_relaxed );
+    }
+
+    m_bboxValid.store( true, std::memory_order_release );
+}
+
+
 ClipperLib::Path SHAPE_LINE_CHAIN::convertToClipper( bool aRequiredOrientation ) const
 {
     ClipperLib::Path c_path;
@@ -56,6 +184,8 @@ bool SHAPE_LINE_CHAIN::Collide( const VECTOR2I& aP, int aClearance ) const
 
 void SHAPE_LINE_CHAIN::Rotate( double aAngle, const VECTOR2I& aCenter )
 {
+    invalidateCaches();
+
     for( std::vector<VECTOR2I>::iterator i = m_points.begin(); i != m_points.end(); ++i )
     {
         (*i) -= aCenter;
@@ -70,21 +200,40 @@ bool SHAPE_LINE_CHAIN::Collide( const SEG& aSeg, int aClearance ) const
     BOX2I box_a( aSeg.A, aSeg.B - aSeg.A );
     BOX2I::ecoord_type dist_sq = (BOX2I::ecoord_type) aClearance * aClearance;
 
-    for( int i = 0; i < SegmentCount(); i++ )
-    {
-        const SEG& s = CSegment( i );
-        BOX2I box_b( s.A, s.B - s.A );
-
-        BOX2I::ecoord_type d = box_a.SquaredDistance( box_b );
+    // No segment can be nearer than the bounding box of the chain
+    if( box_a.SquaredDistance( BBox() ) >= dist_sq )
+        return false;
 
-        if( d < dist_sq )
+    // The segments are only tested when their bounding boxes are close enough
+    auto collides = [&]( int aFirst, int aLast )
+    {
+        for( int i = firstCollision( *this, aSeg, aClearance, aFirst, aLast ); i >= 0;
+                i = firstCollision( *this, aSeg, aClearance, i + 1, aLast ) )
         {
-            if( s.Collide( aSeg, aClearance ) )
+            const SEG& s = CSegment( i );
+            BOX2I box_b( s.A, s.B - s.A );
+
+            if( box_a.SquaredDistance( box_b ) < dist_sq )
                 return true;
         }
+
+        return false;
+    };
+
+    if( auto index = segmentIndex() )
+    {
+        return !index->QueryLeaves(
+                [&]( const BOX2I& aBox )
+                {
+                    return box_a.SquaredDistance( aBox ) < dist_sq;
+                },
+                [&]( int aFirst, int aLast )
+                {
+                    return !collides( aFirst, aLast );
+                } );
     }
 
-    return false;
+    return collides( 0, SegmentCount() );
 }
 
 
@@ -92,6 +241,7 @@ const SHAPE_LINE_CHAIN SHAPE_LINE_CHAIN::Reverse() const
 {
     SHAPE_LINE_CHAIN a( *this );
 
+    a.invalidateCaches();
     reverse( a.m_points.begin(), a.m_points.end() );
     a.m_closed = m_closed;
 
@@ -118,6 +268,8 @@ void SHAPE_LINE_CHAIN::Replace( int aStartIndex, int aEndIndex, const VECTOR2I&
     if( aStartIndex < 0 )
         aStartIndex += PointCount();
 
+    invalidateCaches();
+
     if( aStartIndex == aEndIndex )
         m_points[aStartIndex] = aP;
     else
@@ -136,6 +288,8 @@ void SHAPE_LINE_CHAIN::Replace( int aStartIndex, int aEndIndex, const SHAPE_LINE
     if( aStartIndex < 0 )
         aStartIndex += PointCount();
 
+    invalidateCaches();
+
     m_points.erase( m_points.begin() + aStartIndex, m_points.begin() + aEndIndex + 1 );
     m_points.insert( m_points.begin() + aStartIndex, aLine.m_points.begin(), aLine.m_points.end() );
 }
@@ -149,6 +303,8 @@ void SHAPE_LINE_CHAIN::Remove( int aStartIndex, int aEndIndex )
     if( aStartIndex < 0 )
         aStartIndex += PointCount();
 
+    invalidateCaches();
+
     m_points.erase( m_points.begin() + aStartIndex, m_points.begin() + aEndIndex + 1 );
 }
 
@@ -160,8 +316,61 @@ int SHAPE_LINE_CHAIN::Distance( const VECTOR2I& aP, bool aOutlineOnly ) const
     if( IsClosed() && PointInside( aP ) && !aOutlineOnly )
         return 0;
 
-    for( int s = 0; s < SegmentCount(); s++ )
-        d = std::min( d, CSegment( s ).Distance( aP ) );
+    if( auto index = segmentIndex() )
+    {
+        SEG::ecoord d_sq = index->QueryNearest(
+                [&]( const BOX2I& aBox )
+                {
+                    return squaredDistance( aBox, aP );
+                },
+                [&]( int aFirst, int aLast )
+                {
+                    return squaredDistance( *this, aP, aFirst, aLast );
+                },
+                std::numeric_limits<SEG::ecoord>::max() );
+
+        return sqrt( d_sq );
+    }
+
+    if( SegmentCount() > 0 )
+        d = sqrt( squaredDistance( *this, aP, 0, SegmentCount() ) );
+
+    return d;
+}
+
+
+int SHAPE_LINE_CHAIN::Distance( const SEG& aSeg, bool aOutlineOnly ) const
+{
+    int d = INT_MAX;
+
+    if( IsClosed() && PointInside( aSeg.A ) && !aOutlineOnly )
+        return 0;
+
+    if( auto index = segmentIndex() )
+    {
+        BOX2I box_a( aSeg.A, aSeg.B - aSeg.A );
+
+        SEG::ecoord d_sq = index->QueryNearest(
+                [&]( const BOX2I& aBox )
+                {
+                    return box_a.SquaredDistance( aBox );
+                },
+                [&]( int aFirst, int aLast )
+                {
+                    SEG::ecoord d_sq = std::numeric_limits<SEG::ecoord>::max();
+
+                    for( int i = aFirst; i < aLast; i++ )
+                        d_sq = std::min( d_sq, CSegment( i ).SquaredDistance( aSeg ) );
+
+                    return d_sq;
+                },
+                std::numeric_limits<SEG::ecoord>::max() );
+
+        return sqrt( d_sq );
+    }
+
+    for( int s = 0; s < SegmentCount() && d > 0; s++ )
+        d = std::min( d, CSegment( s ).Distance( aSeg ) );
 
     return d;
 }
@@ -196,6 +405,7 @@ int SHAPE_LINE_CHAIN::Split( const VECTOR2I& aP )
 
     if( ii >= 0 )
     {
+        invalidateCaches();
         m_points.insert( m_points.begin() + ii + 1, aP );
 
         return ii + 1;
@@ -350,9 +560,14 @@ int SHAPE_LINE_CHAIN::PathLength( const VECTOR2I& aP ) const
 
 bool SHAPE_LINE_CHAIN::PointInside( const VECTOR2I& aP ) const
 {
-    if( !m_closed || PointCount() < 3 || !BBox().Contains( aP ) )
+    if( !m_closed || PointCount() < 3 )
+        return false;
+
+    if( !BBox().Contains( aP ) )
         return false;
 
+    std::shared_ptr<const SEGMENT_BVH> index = segmentIndex();
+
     bool inside = false;
 
     /**
@@ -363,7 +578,7 @@ bool SHAPE_LINE_CHAIN::PointInside( const VECTOR2I& aP ) const
      * Note: slope might be denormal here in the case of a horizontal line but we require our
      * y to move from above to below the point (or vice versa)
      */
-    for( int i = 0; i < PointCount(); i++ )
+    auto crossEdge = [&]( int i )
     {
         const auto p1 = CPoint( i );
         const auto p2 = CPoint( i + 1 ); // CPoint wraps, so ignore counts
@@ -376,7 +591,27 @@ bool SHAPE_LINE_CHAIN::PointInside( const VECTOR2I& aP ) const
             if( ( ( p1.y > aP.y ) != ( p2.y > aP.y ) ) && ( aP.x - p1.x < d ) )
                 inside = !inside;
         }
+
+        return true;
+    };
+
+    if( index )
+    {
+        // Only the edges crossing the horizontal line of the point, on its right, count
+        index->Query(
+                [&]( const BOX2I& aBox )
+                {
+                    return aBox.GetY() <= aP.y && aP.y < aBox.GetBottom()
+                            && aP.x < aBox.GetRight();
+                },
+                crossEdge );
+    }
+    else
+    {
+        for( int i = 0; i < PointCount(); i++ )
+            crossEdge( i );
     }
+
     return inside && !PointOnEdge( aP );
 }
 
@@ -394,6 +629,27 @@ int SHAPE_LINE_CHAIN::EdgeContainingPoint( const VECTOR2I& aP ) const
 	else if( PointCount() == 1 )
         return m_points[0] == aP ? 0 : -1;
 
+    if( auto index = segmentIndex() )
+    {
+        int edge = -1;
+
+        // A distance of at most 1 means a squared distance below 4
+        index->Query(
+                [&]( const BOX2I& aBox )
+                {
+                    return squaredDistance( aBox, aP ) < 4;
+                },
+                [&]( int i )
+                {
+                    if( CSegment( i ).Distance( aP ) <= 1 )
+                        edge = i;
+
+                    return edge < 0;
+                } );
+
+        return edge;
+    }
+
     for( int i = 0; i < SegmentCount(); i++ )
     {
         const SEG s = CSegment( i );
@@ -484,6 +740,8 @@ SHAPE_LINE_CHAIN& SHAPE_LINE_CHAIN::Simplify()
 {
     std::vector<VECTOR2I> pts_unique;
 
+    invalidateCaches();
+
     if( PointCount() < 2 )
     {
         return *this;
@@ -634,6 +892,7 @@ bool SHAPE_LINE_CHAIN::Parse( std::stringstream& aStream )
 {
     int n_pts;
 
+    invalidateCaches();
     m_points.clear();
     aStream >> n_pts;
 
@@ -34,6 +34,9 @@
 #include <algorithm>
 #include <unordered_set>
 #include <memory>
+#include <atomic>
+#include <future>
+#include <thread>
 
 #include <md5_hash.h>
 #include <map>
@@ -482,13 +485,13 @@ void SHAPE_POLY_SET::booleanOp( ClipperLib::ClipType aType,
 
     c.StrictlySimple( aFastMode == PM_STRICTLY_SIMPLE );
 
-    for( auto poly : aShape.m_polys )
+    for( const POLYGON& poly : aShape.m_polys )
     {
         for( size_t i = 0 ; i < poly.size(); i++ )
             c.AddPath( poly[i].convertToClipper( i == 0 ), ptSubject, true );
     }
 
-    for( auto poly : aOtherShape.m_polys )
+    for( const POLYGON& poly : aOtherShape.m_polys )
     {
         for( size_t i = 0; i < poly.size(); i++ )
             c.AddPath( poly[i].convertToClipper( i == 0 ), ptClip, true );
@@ -544,7 +547,11 @@ void SHAPE_POLY_SET::BooleanIntersection( const SHAPE_POLY_SET& a,
 }
 
 
-void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount )
+/**
+ * Returns the Clipper arc tolerance giving aCircleSegmentsCount segments by circle
+ * when inflating by aFactor.
+ */
+static double inflateArcTolerance( int aFactor, int aCircleSegmentsCount )
 {
     // A static table to avoid repetitive calculations of the coefficient
     // 1.0 - cos( M_PI/aCircleSegmentsCount)
@@ -552,16 +559,6 @@ void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount )
     #define SEG_CNT_MAX 64
     static double arc_tolerance_factor[SEG_CNT_MAX + 1];
 
-    ClipperOffset c;
-
-    for( const POLYGON& poly : m_polys )
-    {
-        for( size_t i = 0; i < poly.size(); i++ )
-            c.AddPath( poly[i].convertToClipper( i == 0 ), jtRound, etClosedPolygon );
-    }
-
-    PolyTree solution;
-
     // Calculate the arc tolerance (arc error) from the seg count by circle.
     // the seg count is nn = M_PI / acos(1.0 - c.ArcTolerance / abs(aFactor))
     // see:
@@ -582,7 +579,23 @@ void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount )
     else
         coeff = arc_tolerance_factor[aCircleSegmentsCount];
 
-    c.ArcTolerance = std::abs( aFactor ) * coeff;
+    return std::abs( aFactor ) * coeff;
+}
+
+
+void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount )
+{
+    ClipperOffset c;
+
+    for( const POLYGON& poly : m_polys )
+    {
+        for( size_t i = 0; i < poly.size(); i++ )
+            c.AddPath( poly[i].convertToClipper( i == 0 ), jtRound, etClosedPolygon );
+    }
+
+    PolyTree solution;
+
+    c.ArcTolerance = inflateArcTolerance( aFactor, aCircleSegmentsCount );
 
     c.Execute( solution, aFactor );
 
@@ -611,16 +624,137 @@ void SHAPE_POLY_SET::importTree( PolyTree* tree )
 }
 
 
-struct FractureEdge
+SHAPE_POLY_SET::PIPELINE::PIPELINE( const SHAPE_POLY_SET& aPolySet )
 {
-    FractureEdge( bool connected, SHAPE_LINE_CHAIN* owner, int index ) :
-        m_connected( connected ),
-        m_next( NULL )
+    m_contourCounts.reserve( aPolySet.m_polys.size() );
+
+    for( const POLYGON& poly : aPolySet.m_polys )
+    {
+        for( size_t i = 0; i < poly.size(); i++ )
+            m_paths.push_back( poly[i].convertToClipper( i == 0 ) );
+
+        m_contourCounts.push_back( poly.size() );
+    }
+}
+
+
+SHAPE_POLY_SET::PIPELINE& SHAPE_POLY_SET::PIPELINE::BooleanAdd( const PIPELINE& b,
+        POLYGON_MODE aFastMode )
+{
+    booleanOp( ctUnion, b, aFastMode );
+    return *this;
+}
+
+
+SHAPE_POLY_SET::PIPELINE& SHAPE_POLY_SET::PIPELINE::BooleanSubtract( const PIPELINE& b,
+        POLYGON_MODE aFastMode )
+{
+    booleanOp( ctDifference, b, aFastMode );
+    return *this;
+}
+
+
+SHAPE_POLY_SET::PIPELINE& SHAPE_POLY_SET::PIPELINE::BooleanIntersection( const PIPELINE& b,
+        POLYGON_MODE aFastMode )
+{
+    booleanOp( ctIntersection, b, aFastMode );
+    return *this;
+}
+
+
+SHAPE_POLY_SET::PIPELINE& SHAPE_POLY_SET::PIPELINE::Simplify( POLYGON_MODE aFastMode )
+{
+    Clipper c;
+
+    c.StrictlySimple( aFastMode == PM_STRICTLY_SIMPLE );
+    c.AddPaths( m_paths, ptSubject, true );
+    c.Execute( ctUnion, m_tree, pftNonZero, pftNonZero );
+
+    importTree();
+    return *this;
+}
+
+
+SHAPE_POLY_SET::PIPELINE& SHAPE_POLY_SET::PIPELINE::Inflate( int aFactor,
+        int aCircleSegmentsCount )
+{
+    ClipperOffset c;
+
+    c.AddPaths( m_paths, jtRound, etClosedPolygon );
+    c.ArcTolerance = inflateArcTolerance( aFactor, aCircleSegmentsCount );
+    c.Execute( m_tree, aFactor );
+
+    importTree();
+    return *this;
+}
+
+
+SHAPE_POLY_SET SHAPE_POLY_SET::PIPELINE::Result() const
+{
+    SHAPE_POLY_SET result;
+    size_t         path = 0;
+
+    result.m_polys.reserve( m_contourCounts.size() );
+
+    for( int count : m_contourCounts )
     {
-        m_p1    = owner->CPoint( index );
-        m_p2    = owner->CPoint( index + 1 );
+        POLYGON poly;
+        poly.reserve( count );
+
+        for( int i = 0; i < count; i++ )
+            poly.emplace_back( m_paths[path++] );
+
+        result.m_polys.push_back( std::move( poly ) );
     }
 
+    return result;
+}
+
+
+void SHAPE_POLY_SET::PIPELINE::booleanOp( ClipperLib::ClipType aType, const PIPELINE& aOther,
+        POLYGON_MODE aFastMode )
+{
+    Clipper c;
+
+    c.StrictlySimple( aFastMode == PM_STRICTLY_SIMPLE );
+    c.AddPaths( m_paths, ptSubject, true );
+    c.AddPaths( aOther.m_paths, ptClip, true );
+    c.Execute( aType, m_tree, pftNonZero, pftNonZero );
+
+    importTree();
+}
+
+
+void SHAPE_POLY_SET::PIPELINE::importTree()
+{
+    m_paths.clear();
+    m_contourCounts.clear();
+
+    auto addContour = [&]( const Path& aContour, bool aOutline )
+    {
+        m_paths.push_back( aContour );
+
+        if( Orientation( aContour ) != aOutline )
+            ReversePath( m_paths.back() );
+    };
+
+    for( PolyNode* n = m_tree.GetFirst(); n; n = n->GetNext() )
+    {
+        if( !n->IsHole() )
+        {
+            addContour( n->Contour, true );
+
+            for( PolyNode* hole : n->Childs )
+                addContour( hole->Contour, false );
+
+            m_contourCounts.push_back( n->Childs.size() + 1 );
+        }
+    }
+}
+
+
+struct FractureEdge
+{
     FractureEdge( int y = 0 ) :
         m_connected( false ),
         m_next( NULL )
@@ -650,55 +784,160 @@ struct FractureEdge
 };
 
 
-typedef std::vector<FractureEdge*> FractureEdgeSet;
+/**
+ * The edges of a polygon being fractured.
+ *
+ * The edges are allocated in a single block, and indexed by horizontal bands so that the
+ * edge nearest to the left of a hole only needs to be searched among the edges crossing
+ * the band of the hole, rather than among all the edges of the polygon.
+ */
+class FRACTURE_EDGES
+{
+public:
+    /**
+     * @param aMaxEdges is the maximum number of edges that will be added.
+     * @param aPaths are the outline and holes of the polygon, used to size the bands.
+     */
+    FRACTURE_EDGES( int aMaxEdges, const SHAPE_POLY_SET::POLYGON& aPaths )
+    {
+        // The edges are linked by pointers, so they must never move
+        m_edges.reserve( aMaxEdges );
 
+        BOX2I bbox = aPaths[0].BBox();
+        m_yMin = bbox.GetY();
 
-static int processEdge( FractureEdgeSet& edges, FractureEdge* edge )
-{
-    int x   = edge->m_p1.x;
-    int y   = edge->m_p1.y;
-    int min_dist    = std::numeric_limits<int>::max();
-    int x_nearest   = 0;
+        int64_t height = (int64_t) bbox.GetHeight() + 1;
+        int     bandCount = std::max( 1, aMaxEdges / 16 );
+
+        // Long edges are stored in each band they cross: use less bands when they would
+        // make the index much larger than the edges themselves
+        while( bandCount > 1 )
+        {
+            m_bandHeight = ( height + bandCount - 1 ) / bandCount;
+
+            int64_t indexSize = 0;
+
+            for( const SHAPE_LINE_CHAIN& path : aPaths )
+            {
+                for( int i = 0; i < path.PointCount(); i++ )
+                {
+                    int y1 = path.CPoint( i ).y;
+                    int y2 = path.CPoint( i + 1 ).y;
+
+                    indexSize += band( std::max( y1, y2 ) ) - band( std::min( y1, y2 ) ) + 1;
+                }
+            }
 
-    FractureEdge* e_nearest = NULL;
+            if( indexSize <= 4 * (int64_t) aMaxEdges )
+                break;
 
-    for( FractureEdgeSet::iterator i = edges.begin(); i != edges.end(); ++i )
+            bandCount /= 2;
+        }
+
+        m_bandHeight = ( height + bandCount - 1 ) / bandCount;
+        m_bands.resize( bandCount );
+    }
+
+    FractureEdge* Add( bool aConnected, const VECTOR2I& aP1, const VECTOR2I& aP2 )
     {
-        if( !(*i)->matches( y ) )
-            continue;
+        assert( m_edges.size() < m_edges.capacity() );
 
-        int x_intersect;
+        m_edges.emplace_back( aConnected, aP1, aP2 );
+        FractureEdge* edge = &m_edges.back();
 
-        if( (*i)->m_p1.y == (*i)->m_p2.y ) // horizontal edge
-            x_intersect = std::max( (*i)->m_p1.x, (*i)->m_p2.x );
-        else
-            x_intersect = (*i)->m_p1.x + rescale( (*i)->m_p2.x - (*i)->m_p1.x, y - (*i)->m_p1.y,
-                    (*i)->m_p2.y - (*i)->m_p1.y );
+        addToBands( edge, std::min( aP1.y, aP2.y ), std::max( aP1.y, aP2.y ) );
 
-        int dist = ( x - x_intersect );
+        return edge;
+    }
 
-        if( dist >= 0 && dist < min_dist && (*i)->m_connected )
+    /**
+     * Find the connected edge nearest to the left of a point.
+     *
+     * Edges are tested in the order they were added, so the first of several edges at
+     * the same distance is returned.
+     *
+     * @param aPoint is the point to test.
+     * @param aNearestX receives the x coordinate of the intersection with the returned edge.
+     * @return the nearest edge, or NULL if there is no connected edge on the left.
+     */
+    FractureEdge* FindNearestLeft( const VECTOR2I& aPoint, int& aNearestX ) const
+    {
+        int x   = aPoint.x;
+        int y   = aPoint.y;
+        int min_dist    = std::numeric_limits<int>::max();
+
+        FractureEdge* e_nearest = NULL;
+
+        for( FractureEdge* edge : m_bands[ band( y ) ] )
         {
-            min_dist    = dist;
-            x_nearest   = x_intersect;
-            e_nearest   = (*i);
+            if( !edge->m_connected || !edge->matches( y ) )
+                continue;
+
+            int x_intersect;
+
+            if( edge->m_p1.y == edge->m_p2.y ) // horizontal edge
+                x_intersect = std::max( edge->m_p1.x, edge->m_p2.x );
+            else
+                x_intersect = edge->m_p1.x + rescale( edge->m_p2.x - edge->m_p1.x,
+                        y - edge->m_p1.y, edge->m_p2.y - edge->m_p1.y );
+
+            int dist = ( x - x_intersect );
+
+            if( dist >= 0 && dist < min_dist )
+            {
+                min_dist    = dist;
+                aNearestX   = x_intersect;
+                e_nearest   = edge;
+            }
         }
+
+        return e_nearest;
     }
 
-    if( e_nearest && e_nearest->m_connected )
+private:
+    int band( int aY ) const
     {
-        int count = 0;
+        int64_t b = ( (int64_t) aY - m_yMin ) / m_bandHeight;
+
+        // Bridges are horizontal, so edges never leave the outline bounding box
+        return (int) std::max<int64_t>( 0, std::min<int64_t>( b, (int64_t) m_bands.size() - 1 ) );
+    }
+
+    void addToBands( FractureEdge* aEdge, int aYMin, int aYMax )
+    {
+        for( int b = band( aYMin ); b <= band( aYMax ); b++ )
+            m_bands[b].push_back( aEdge );
+    }
 
-        FractureEdge* lead1 =
-            new FractureEdge( true, VECTOR2I( x_nearest, y ), VECTOR2I( x, y ) );
-        FractureEdge* lead2 =
-            new FractureEdge( true, VECTOR2I( x, y ), VECTOR2I( x_nearest, y ) );
-        FractureEdge* split_2 =
-            new FractureEdge( true, VECTOR2I( x_nearest, y ), e_nearest->m_p2 );
+    std::vector<FractureEdge>                m_edges;
+    std::vector<std::vector<FractureEdge*>>  m_bands;
+    int                                      m_yMin;
+    int64_t                                  m_bandHeight = 1;
+};
 
-        edges.push_back( split_2 );
-        edges.push_back( lead1 );
-        edges.push_back( lead2 );
+
+/**
+ * Connect a hole to the outline, with a bridge from its leading (left-most) vertex to
+ * the nearest connected edge on its left.
+ *
+ * @return the number of hole edges connected by the bridge.
+ */
+static int processEdge( FRACTURE_EDGES& edges, FractureEdge* edge )
+{
+    int x   = edge->m_p1.x;
+    int y   = edge->m_p1.y;
+    int x_nearest   = 0;
+
+    FractureEdge* e_nearest = edges.FindNearestLeft( edge->m_p1, x_nearest );
+
+    if( e_nearest )
+    {
+        int count = 0;
+
+        // The edge split by the bridge keeps its place in the index: it only gets shorter
+        FractureEdge* split_2 = edges.Add( true, VECTOR2I( x_nearest, y ), e_nearest->m_p2 );
+        FractureEdge* lead1 = edges.Add( true, VECTOR2I( x_nearest, y ), VECTOR2I( x, y ) );
+        FractureEdge* lead2 = edges.Add( true, VECTOR2I( x, y ), VECTOR2I( x_nearest, y ) );
 
         FractureEdge* link = e_nearest->m_next;
 
@@ -728,22 +967,26 @@ static int processEdge( FractureEdgeSet& edges, FractureEdge* edge )
 
 void SHAPE_POLY_SET::fractureSingle( POLYGON& paths )
 {
-    FractureEdgeSet edges;
-    FractureEdgeSet border_edges;
-    FractureEdge*   root = NULL;
-
-    bool first = true;
-
     if( paths.size() == 1 )
         return;
 
-    int num_unconnected = 0;
+    int edgeCount = 0;
+
+    for( const SHAPE_LINE_CHAIN& path : paths )
+        edgeCount += path.PointCount();
+
+    // Each hole adds 3 edges when bridged to the outline
+    FRACTURE_EDGES edges( edgeCount + 3 * ( paths.size() - 1 ), paths );
+    FractureEdge*  root = NULL;
+
+    // The leading (left-most) edge of each hole, with its x coordinate
+    std::vector<std::pair<int, FractureEdge*>> holes;
+
+    bool first = true;
 
     for( SHAPE_LINE_CHAIN& path : paths )
     {
-        int index = 0;
-
-        FractureEdge* prev = NULL, * first_edge = NULL;
+        FractureEdge* prev = NULL, * first_edge = NULL, * lead = NULL;
 
         int x_min = std::numeric_limits<int>::max();
 
@@ -757,7 +1000,7 @@ void SHAPE_POLY_SET::fractureSingle( POLYGON& paths )
 
         for( int i = 0; i < path.PointCount(); i++ )
         {
-            FractureEdge* fe = new FractureEdge( first, &path, index++ );
+            FractureEdge* fe = edges.Add( first, path.CPoint( i ), path.CPoint( i + 1 ) );
 
             if( !root )
                 root = fe;
@@ -772,42 +1015,27 @@ void SHAPE_POLY_SET::fractureSingle( POLYGON& paths )
                 fe->m_next = first_edge;
 
             prev = fe;
-            edges.push_back( fe );
 
-            if( !first )
-            {
-                if( fe->m_p1.x == x_min )
-                    border_edges.push_back( fe );
-            }
-
-            if( !fe->m_connected )
-                num_unconnected++;
+            if( !first && !lead && fe->m_p1.x == x_min )
+                lead = fe;
         }
 
+        if( lead )
+            holes.emplace_back( x_min, lead );
+
         first = false;    // first path is always the outline
     }
 
-    // keep connecting holes to the main outline, until there's no holes left...
-    while( num_unconnected > 0 )
-    {
-        int x_min = std::numeric_limits<int>::max();
-
-        FractureEdge* smallestX = NULL;
-
-        // find the left-most hole edge and merge with the outline
-        for( FractureEdgeSet::iterator i = border_edges.begin(); i != border_edges.end(); ++i )
-        {
-            int xt = (*i)->m_p1.x;
-
-            if( ( xt < x_min ) && !(*i)->m_connected )
+    // Sweep the holes from left to right, connecting each one to the outline, or to a hole
+    // already connected: everything on the left of a hole is then connected.
+    std::stable_sort( holes.begin(), holes.end(),
+            []( const std::pair<int, FractureEdge*>& a, const std::pair<int, FractureEdge*>& b )
             {
-                x_min = xt;
-                smallestX = *i;
-            }
-        }
+                return a.first < b.first;
+            } );
 
-        num_unconnected -= processEdge( edges, smallestX );
-    }
+    for( const auto& hole : holes )
+        processEdge( edges, hole.second );
 
     paths.clear();
     SHAPE_LINE_CHAIN newPath;
@@ -821,9 +1049,6 @@ void SHAPE_POLY_SET::fractureSingle( POLYGON& paths )
 
     newPath.Append( e->m_p1 );
 
-    for( FractureEdgeSet::iterator i = edges.begin(); i != edges.end(); ++i )
-        delete *i;
-
     paths.push_back( newPath );
 }
 
@@ -1187,16 +1412,19 @@ bool SHAPE_POLY_SET::PointOnEdge( const VECTOR2I& aP ) const
 
 bool SHAPE_POLY_SET::Collide( const SEG& aSeg, int aClearance ) const
 {
+    // Only copy the polygon if it must be inflated
+    SHAPE_POLY_SET inflated;
 
-    SHAPE_POLY_SET polySet = SHAPE_POLY_SET( *this );
-
-    // Inflate the polygon if necessary.
     if( aClearance > 0 )
     {
+        inflated = *this;
+
         // fixme: the number of arc segments should not be hardcoded
-        polySet.Inflate( aClearance, 8 );
+        inflated.Inflate( aClearance, 8 );
     }
 
+    const SHAPE_POLY_SET& polySet = aClearance > 0 ? inflated : *this;
+
     // We are going to check to see if the segment crosses an external
     // boundary.  However, if the full segment is inside the polyset, this
     // will not be true.  So we first test to see if one of the points is
@@ -1204,12 +1432,21 @@ bool SHAPE_POLY_SET::Collide( const SEG& aSeg, int aClearance ) const
     if( polySet.Contains( aSeg.A ) )
         return true;
 
-    for( SEGMENT_ITERATOR iterator = polySet.IterateSegmentsWithHoles(); iterator; iterator++ )
+    const BOX2I segBox( aSeg.A, aSeg.B - aSeg.A );
+
+    for( const POLYGON& poly : polySet.m_polys )
     {
-        SEG polygonEdge = *iterator;
+        for( const SHAPE_LINE_CHAIN& contour : poly )
+        {
+            if( !contour.BBox().Intersects( segBox ) )
+                continue;
 
-        if( polygonEdge.Intersect( aSeg, true ) )
-            return true;
+            for( int i = 0; i < contour.SegmentCount(); i++ )
+            {
+                if( contour.CSegment( i ).Intersect( aSeg, true ) )
+                    return true;
+            }
+        }
     }
 
     return false;
@@ -1218,14 +1455,14 @@ bool SHAPE_POLY_SET::Collide( const SEG& aSeg, int aClearance ) const
 
 bool SHAPE_POLY_SET::Collide( const VECTOR2I& aP, int aClearance ) const
 {
+    // Without clearance, the segment indexes of the contours are used by Contains()
+    if( aClearance <= 0 )
+        return Contains( aP );
+
     SHAPE_POLY_SET polySet = SHAPE_POLY_SET( *this );
 
-    // Inflate the polygon if necessary.
-    if( aClearance > 0 )
-    {
-        // fixme: the number of arc segments should not be hardcoded
-        polySet.Inflate( aClearance, 8 );
-    }
+    // fixme: the number of arc segments should not be hardcoded
+    polySet.Inflate( aClearance, 8 );
 
     // There is a collision if and only if the point is inside of the polygon.
     return polySet.Contains( aP );
@@ -1435,7 +1672,7 @@ bool SHAPE_POLY_SET::containsSingle( const VECTOR2I& aP, int aSubpolyIndex, bool
             // Check that the point is not in any of the holes
             for( int holeIdx = 0; holeIdx < HoleCount( aSubpolyIndex ); holeIdx++ )
             {
-                const SHAPE_LINE_CHAIN hole = CHole( aSubpolyIndex, holeIdx );
+                const SHAPE_LINE_CHAIN& hole = CHole( aSubpolyIndex, holeIdx );
 
                 // If the point is inside a hole (and not on its edge),
                 // it is outside of the polygon
@@ -1511,6 +1748,17 @@ SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::FilletPolygon( unsigned int aRadius,
 }
 
 
+/**
+ * @return true if no point of aChain can be nearer than aDistance to aBox, judging
+ * by the bounding box of the chain
+ */
+static bool fartherThan( const SHAPE_LINE_CHAIN& aChain, const BOX2I& aBox,
+                         SEG::ecoord aDistance )
+{
+    return aChain.BBox().SquaredDistance( aBox ) >= aDistance * aDistance;
+}
+
+
 int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
 {
     // We calculate the min dist between the segment and each outline segment
@@ -1520,19 +1768,19 @@ int SHAPE_POLY_SET::DistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex )
     if( containsSingle( aPoint, aPolygonIndex ) )
         return 0;
 
-    SEGMENT_ITERATOR iterator = IterateSegmentsWithHoles( aPolygonIndex );
+    int minDistance = std::numeric_limits<int>::max();
+    const BOX2I pointBox( aPoint, VECTOR2I( 0, 0 ) );
 
-    SEG polygonEdge = *iterator;
-    int minDistance = polygonEdge.Distance( aPoint );
-
-    for( iterator++; iterator && minDistance > 0; iterator++ )
+    // The distances to the contours use their segment indexes, if any
+    for( const SHAPE_LINE_CHAIN& contour : m_polys[aPolygonIndex] )
     {
-        polygonEdge = *iterator;
+        if( fartherThan( contour, pointBox, minDistance ) )
+            continue;
 
-        int currentDistance = polygonEdge.Distance( aPoint );
+        minDistance = std::min( minDistance, contour.Distance( aPoint, true ) );
 
-        if( currentDistance < minDistance )
-            minDistance = currentDistance;
+        if( minDistance == 0 )
+            break;
     }
 
     return minDistance;
@@ -1548,19 +1796,18 @@ int SHAPE_POLY_SET::DistanceToPolygon( SEG aSegment, int aPolygonIndex, int aSeg
     if( containsSingle( aSegment.A, aPolygonIndex ) )
         return 0;
 
-    SEGMENT_ITERATOR iterator = IterateSegmentsWithHoles( aPolygonIndex );
-
-    SEG polygonEdge = *iterator;
-    int minDistance = polygonEdge.Distance( aSegment );
+    int minDistance = std::numeric_limits<int>::max();
+    const BOX2I segBox( aSegment.A, aSegment.B - aSegment.A );
 
-    for( iterator++; iterator && minDistance > 0; iterator++ )
+    for( const SHAPE_LINE_CHAIN& contour : m_polys[aPolygonIndex] )
     {
-        polygonEdge = *iterator;
+        if( fartherThan( contour, segBox, minDistance ) )
+            continue;
 
-        int currentDistance = polygonEdge.Distance( aSegment );
+        minDistance = std::min( minDistance, contour.Distance( aSegment, true ) );
 
-        if( currentDistance < minDistance )
-            minDistance = currentDistance;
+        if( minDistance == 0 )
+            break;
     }
 
     // Take into account the width of the segment
@@ -1576,10 +1823,15 @@ int SHAPE_POLY_SET::Distance( VECTOR2I aPoint )
 {
     int currentDistance;
     int minDistance = DistanceToPolygon( aPoint, 0 );
+    const BOX2I pointBox( aPoint, VECTOR2I( 0, 0 ) );
 
     // Iterate through all the polygons and get the minimum distance.
     for( unsigned int polygonIdx = 1; polygonIdx < m_polys.size(); polygonIdx++ )
     {
+        // A polygon is not nearer than its outline bounding box
+        if( fartherThan( m_polys[polygonIdx][0], pointBox, minDistance ) )
+            continue;
+
         currentDistance = DistanceToPolygon( aPoint, polygonIdx );
 
         if( currentDistance < minDistance )
@@ -1594,10 +1846,21 @@ int SHAPE_POLY_SET::Distance( const SEG& aSegment, int aSegmentWidth )
 {
     int currentDistance;
     int minDistance = DistanceToPolygon( aSegment, 0, aSegmentWidth );
+    const BOX2I segBox( aSegment.A, aSegment.B - aSegment.A );
 
     // Iterate through all the polygons and get the minimum distance.
     for( unsigned int polygonIdx = 1; polygonIdx < m_polys.size(); polygonIdx++ )
     {
+        if( minDistance == 0 )
+            break;
+
+        // A polygon is not nearer than its outline bounding box
+        if( fartherThan( m_polys[polygonIdx][0], segBox,
+                         (SEG::ecoord) minDistance + std::max( aSegmentWidth, 0 ) / 2 ) )
+        {
+            continue;
+        }
+
         currentDistance = DistanceToPolygon( aSegment, polygonIdx, aSegmentWidth );
 
         if( currentDistance < minDistance )
@@ -1841,8 +2104,89 @@ bool SHAPE_POLY_SET::IsTriangulationUpToDate() const
 }
 
 
+/**
+ * Triangulates the outlines of a polygon set without holes, removing them from the set.
+ * Outlines failing to triangulate are fractured again with the rest of the set.
+ * @return false if the triangulation failed
+ */
+static bool triangulateOutlines( SHAPE_POLY_SET& aPolySet,
+        std::vector<std::unique_ptr<SHAPE_POLY_SET::TRIANGULATED_POLYGON>>& aResult,
+        PolygonTriangulation::VERTEX_ARENA& aVertices )
+{
+    bool valid = true;
+
+    while( aPolySet.OutlineCount() > 0 )
+    {
+        aResult.push_back( std::make_unique<SHAPE_POLY_SET::TRIANGULATED_POLYGON>() );
+        PolygonTriangulation tess( *aResult.back(), aVertices );
+
+        // If the tesselation fails, we re-fracture the polygon, which will
+        // first simplify the system before fracturing and removing the holes
+        // This may result in multiple, disjoint polygons.
+        if( !tess.TesselatePolygon( aPolySet.Polygon( 0 ).front() ) )
+        {
+            aPolySet.Fracture( SHAPE_POLY_SET::PM_FAST );
+            valid = false;
+            continue;
+        }
+
+        aPolySet.DeletePolygon( 0 );
+        valid = true;
+    }
+
+    return valid;
+}
+
+
+/**
+ * Calls aFunc( item, thread ) for the aCount items, on as many threads as there are cores.
+ * The calling thread is thread 0.
+ */
+template <typename FUNC>
+static void parallelForEach( size_t aCount, size_t aThreadCount, FUNC aFunc )
+{
+    std::atomic<size_t> nextItem( 0 );
+
+    auto worker = [&]( size_t aThread )
+    {
+        for( size_t i = nextItem++; i < aCount; i = nextItem++ )
+            aFunc( i, aThread );
+    };
+
+    std::vector<std::future<void>> returns;
+
+    for( size_t ii = 1; ii < aThreadCount; ++ii )
+        returns.push_back( std::async( std::launch::async, worker, ii ) );
+
+    worker( 0 );
+
+    for( auto& ret : returns )
+        ret.wait();
+}
+
+
+static int totalPointCount( const SHAPE_POLY_SET& aPolySet )
+{
+    int count = 0;
+
+    for( int i = 0; i < aPolySet.OutlineCount(); i++ )
+    {
+        for( const SHAPE_LINE_CHAIN& contour : aPolySet.CPolygon( i ) )
+            count += contour.PointCount();
+    }
+
+    return count;
+}
+
+
 void SHAPE_POLY_SET::CacheTriangulation()
 {
+    // Polygon sets having more points than this are cut in pieces triangulated in parallel
+    const int maxPiecePointCount = 4096;
+
+    // Limits the cuts if the point count does not decrease, e.g. for degenerate shapes
+    const int maxCutLevels = 16;
+
     bool recalculate = !m_hash.IsValid();
     MD5_HASH hash;
 
@@ -1865,29 +2209,125 @@ void SHAPE_POLY_SET::CacheTriangulation()
 
     SHAPE_POLY_SET tmpSet = *this;
 
-    if( tmpSet.HasHoles() )
-        tmpSet.Fracture( PM_FAST );
-
     m_triangulatedPolys.clear();
-    m_triangulationValid = true;
 
-    while( tmpSet.OutlineCount() > 0 )
+    if( totalPointCount( tmpSet ) <= maxPiecePointCount )
     {
-        m_triangulatedPolys.push_back( std::make_unique<TRIANGULATED_POLYGON>() );
-        PolygonTriangulation tess( *m_triangulatedPolys.back() );
+        PolygonTriangulation::VERTEX_ARENA vertices;
 
-        // If the tesselation fails, we re-fracture the polygon, which will
-        // first simplify the system before fracturing and removing the holes
-        // This may result in multiple, disjoint polygons.
-        if( !tess.TesselatePolygon( tmpSet.Polygon( 0 ).front() ) )
-        {
+        if( tmpSet.HasHoles() )
             tmpSet.Fracture( PM_FAST );
-            m_triangulationValid = false;
-            continue;
+
+        m_triangulationValid = triangulateOutlines( tmpSet, m_triangulatedPolys, vertices );
+    }
+    else
+    {
+        // Cut the set in halves across the longest side of their bounding box, until the
+        // pieces are small enough.  The pieces are cut before fracturing, as triangulating
+        // a large fractured outline is slow, and the halves of a piece share the points
+        // along their cut, so their triangulations meet without gaps.
+        size_t threadCount = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+        std::vector<SHAPE_POLY_SET> pieces;
+
+        // Fractured sets, like zone fills, are given back their holes first: clipping
+        // keeps the fracture bridges, and the pieces would stay slow to triangulate
+        if( !tmpSet.HasHoles() )
+            tmpSet.Unfracture( PM_FAST );
+
+        pieces.push_back( std::move( tmpSet ) );
+
+        for( int level = 0; level < maxCutLevels; level++ )
+        {
+            std::vector<std::vector<SHAPE_POLY_SET>> halves( pieces.size() );
+            bool cut = false;
+
+            for( size_t i = 0; i < pieces.size(); i++ )
+                cut |= totalPointCount( pieces[i] ) > maxPiecePointCount;
+
+            if( !cut )
+                break;
+
+            parallelForEach( pieces.size(), std::min( threadCount, pieces.size() ),
+                    [&]( size_t aPiece, size_t )
+                    {
+                        SHAPE_POLY_SET& piece = pieces[aPiece];
+
+                        if( totalPointCount( piece ) <= maxPiecePointCount )
+                        {
+                            halves[aPiece].push_back( std::move( piece ) );
+                            return;
+                        }
+
+                        const BOX2I bbox = piece.BBox();
+                        BOX2I       boxes[2] = { bbox, bbox };
+
+                        if( bbox.GetWidth() >= bbox.GetHeight() )
+                        {
+                            int cutCoord = bbox.GetX() + bbox.GetWidth() / 2;
+                            boxes[0].SetEnd( cutCoord, bbox.GetBottom() );
+                            boxes[1].SetOrigin( cutCoord, bbox.GetY() );
+                        }
+                        else
+                        {
+                            int cutCoord = bbox.GetY() + bbox.GetHeight() / 2;
+                            boxes[0].SetEnd( bbox.GetRight(), cutCoord );
+                            boxes[1].SetOrigin( bbox.GetX(), cutCoord );
+                        }
+
+                        boxes[1].SetEnd( bbox.GetEnd() );
+
+                        for( const BOX2I& half : boxes )
+                        {
+                            SHAPE_LINE_CHAIN rect;
+                            rect.Append( half.GetLeft(), half.GetTop() );
+                            rect.Append( half.GetRight(), half.GetTop() );
+                            rect.Append( half.GetRight(), half.GetBottom() );
+                            rect.Append( half.GetLeft(), half.GetBottom() );
+                            rect.SetClosed( true );
+
+                            SHAPE_POLY_SET clip;
+                            clip.AddOutline( rect );
+
+                            halves[aPiece].emplace_back();
+                            halves[aPiece].back().BooleanIntersection( piece, clip, PM_FAST );
+                        }
+                    } );
+
+            pieces.clear();
+
+            for( auto& pieceHalves : halves )
+            {
+                for( auto& half : pieceHalves )
+                {
+                    if( half.OutlineCount() > 0 )
+                        pieces.push_back( std::move( half ) );
+                }
+            }
         }
 
-        tmpSet.DeletePolygon( 0 );
-        m_triangulationValid = true;
+        std::vector<std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>> results( pieces.size() );
+        std::vector<PolygonTriangulation::VERTEX_ARENA> vertices( threadCount );
+        std::atomic<bool> valid( true );
+
+        parallelForEach( pieces.size(), std::min( threadCount, pieces.size() ),
+                [&]( size_t aPiece, size_t aThread )
+                {
+                    SHAPE_POLY_SET& piece = pieces[aPiece];
+
+                    if( piece.HasHoles() )
+                        piece.Fracture( PM_FAST );
+
+                    if( !triangulateOutlines( piece, results[aPiece], vertices[aThread] ) )
+                        valid = false;
+                } );
+
+        m_triangulationValid = valid;
+
+        for( auto& pieceResult : results )
+        {
+            for( auto& triangulated : pieceResult )
+                m_triangulatedPolys.push_back( std::move( triangulated ) );
+        }
     }
 
     if( m_triangulationValid )
@@ -41,6 +41,16 @@
 #include <connection_graph.h>
 
 
+/**
+ * Units used in ERC marker messages: the frame ones, or millimetres when the
+ * connection graph is used without a frame (batch ERC).
+ */
+static EDA_UNITS_T messageUnits( SCH_EDIT_FRAME* aFrame )
+{
+    return aFrame ? aFrame->GetUserUnits() : MILLIMETRES;
+}
+
+
 bool CONNECTION_SUBGRAPH::ResolveDrivers( bool aCreateMarkers )
 {
     int highest_priority = -1;
@@ -173,8 +183,8 @@ bool CONNECTION_SUBGRAPH::ResolveDrivers( bool aCreateMarkers )
             wxString msg;
             msg.Printf( _( "%s and %s are both attached to the same wires. "
                            "%s was picked as the label to use for netlisting." ),
-                        candidates[0]->GetSelectMenuText( m_frame->GetUserUnits() ),
-                        candidates[1]->GetSelectMenuText( m_frame->GetUserUnits() ),
+                        candidates[0]->GetSelectMenuText( messageUnits( m_frame ) ),
+                        candidates[1]->GetSelectMenuText( messageUnits( m_frame ) ),
                         candidates[0]->Connection( m_sheet )->Name() );
 
             wxASSERT( candidates[0] != candidates[1] );
@@ -374,6 +384,11 @@ void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
 
             component->UpdatePins( &aSheet );
 
+            // GetRef() may store the reference the first time it is called for a sheet,
+            // so the default net names are prepared here rather than in the threads that
+            // read them
+            component->UpdateDefaultNetNamePrefix( aSheet );
+
             for( auto& it : component->GetPinMap() )
             {
                 SCH_PIN* pin = &it.second;
@@ -381,8 +396,6 @@ void CONNECTION_GRAPH::updateItemConnectivity( SCH_SHEET_PATH aSheet,
                 wxPoint pos = component->GetTransform().TransformCoordinate( pin->GetPosition() )
                               + component->GetPosition();
 
-                // because calling the first time is not thread-safe
-                pin->GetDefaultNetName( aSheet );
                 pin->ConnectedItems().clear();
 
                 // Invisible power pins need to be post-processed later
@@ -747,7 +760,6 @@ void CONNECTION_GRAPH::buildConnectionGraph()
                 case SCH_PIN_T:
                 {
                     auto pin = static_cast<SCH_PIN*>( driver );
-                    // NOTE(JE) GetDefaultNetName is not thread-safe.
                     connection->ConfigureFromLabel( pin->GetDefaultNetName( sheet ) );
 
                     break;
@@ -1780,8 +1792,8 @@ bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( CONNECTION_SUBGRAPH* aSubgraph
             msg.Printf( _( "%s and %s are graphically connected but cannot"
                            " electrically connect because one is a bus and"
                            " the other is a net." ),
-                        bus_item->GetSelectMenuText( m_frame->GetUserUnits() ),
-                        net_item->GetSelectMenuText( m_frame->GetUserUnits() ) );
+                        bus_item->GetSelectMenuText( messageUnits( m_frame ) ),
+                        net_item->GetSelectMenuText( messageUnits( m_frame ) ) );
 
             auto marker = new SCH_MARKER();
             marker->SetTimeStamp( GetNewTimeStamp() );
@@ -1861,8 +1873,8 @@ bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( CONNECTION_SUBGRAPH* aSubgraph
             {
                 msg.Printf( _( "%s and %s are graphically connected but do "
                                "not share any bus members" ),
-                            label->GetSelectMenuText( m_frame->GetUserUnits() ),
-                            port->GetSelectMenuText( m_frame->GetUserUnits() ) );
+                            label->GetSelectMenuText( messageUnits( m_frame ) ),
+                            port->GetSelectMenuText( messageUnits( m_frame ) ) );
 
                 auto marker = new SCH_MARKER();
                 marker->SetTimeStamp( GetNewTimeStamp() );
@@ -1937,9 +1949,9 @@ bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( CONNECTION_SUBGRAPH* aSub
         if( aCreateMarkers )
         {
             msg.Printf( _( "%s (%s) is connected to %s (%s) but is not a member of the bus" ),
-                        bus_entry->GetSelectMenuText( m_frame->GetUserUnits() ),
+                        bus_entry->GetSelectMenuText( messageUnits( m_frame ) ),
                         bus_entry->Connection( sheet )->Name(),
-                        bus_wire->GetSelectMenuText( m_frame->GetUserUnits() ),
+                        bus_wire->GetSelectMenuText( messageUnits( m_frame ) ),
                         bus_wire->Connection( sheet )->Name() );
 
             auto marker = new SCH_MARKER();
@@ -37,11 +37,13 @@
 #include <netlist_object.h>
 #include <lib_pin.h>
 #include <erc.h>
+#include <erc_settings.h>
 #include <sch_marker.h>
 #include <sch_sheet.h>
 #include <sch_reference_list.h>
 
 #include <wx/ffile.h>
+#include <unordered_map>
 
 
 /* ERC tests :
@@ -442,140 +444,268 @@ void Diagnose( NETLIST_OBJECT* aNetItemRef, NETLIST_OBJECT* aNetItemTst,
 }
 
 
+ERC_PIN_INDEX::ERC_PIN_INDEX( NETLIST_OBJECT_LIST* aList ) :
+    m_list( aList ),
+    m_netStart( UINT_MAX ),
+    m_noConnectCount( 0 )
+{
+}
+
+
+void ERC_PIN_INDEX::SetNet( unsigned aNetStart )
+{
+    if( aNetStart == m_netStart )
+        return;
+
+    m_netStart = aNetStart;
+    m_noConnectCount = 0;
+
+    for( std::vector<unsigned>& pins : m_pinsByType )
+        pins.clear();
+
+    int net = m_list->GetItemNet( aNetStart );
+
+    for( unsigned ii = aNetStart; ii < m_list->size() && m_list->GetItemNet( ii ) == net; ii++ )
+    {
+        if( m_list->GetItemType( ii ) == NET_PIN )
+            m_pinsByType[ m_list->GetItem( ii )->m_ElectricalPinType ].push_back( ii );
+        else if( m_list->GetItemType( ii ) == NET_NOCONNECT )
+            m_noConnectCount++;
+    }
+}
+
+
+const std::vector<unsigned>& ERC_PIN_INDEX::GetSamePins( unsigned aPinIdx )
+{
+    if( m_pinsByName.empty() )
+    {
+        for( unsigned ii = 0; ii < m_list->size(); ii++ )
+        {
+            NETLIST_OBJECT* item = m_list->GetItem( ii );
+
+            if( item->m_Type != NET_PIN || !item->GetComponentParent() )
+                continue;
+
+            wxString ref = item->GetComponentParent()->GetRef( &item->m_SheetPath );
+            m_pinsByName[ std::make_pair( ref, item->m_PinNum ) ].push_back( ii );
+        }
+    }
+
+    NETLIST_OBJECT* pin = m_list->GetItem( aPinIdx );
+    wxString ref = pin->GetComponentParent()->GetRef( &pin->m_SheetPath );
+
+    return m_pinsByName[ std::make_pair( ref, pin->m_PinNum ) ];
+}
+
+
 void TestOthersItems( NETLIST_OBJECT_LIST* aList,
                       unsigned aNetItemRef, unsigned aNetStart,
-                      int* aMinConnexion )
+                      int* aMinConnexion, ERC_PIN_INDEX& aPinIndex )
 {
-    unsigned netItemTst = aNetStart;
-    ELECTRICAL_PINTYPE jj;
     int erc = OK;
 
     /* Analysis of the table of connections. */
     ELECTRICAL_PINTYPE ref_elect_type = aList->GetItem( aNetItemRef )->m_ElectricalPinType;
+    bool ref_is_pin = aList->GetItemType( aNetItemRef ) == NET_PIN;
     int local_minconn = NOC;
 
     if( ref_elect_type == PIN_NC )
         local_minconn = NPI;
 
-    /* Test pins connected to NetItemRef */
-    for( ; ; netItemTst++ )
+    aPinIndex.SetNet( aNetStart );
+
+    /* Test pins connected to NetItemRef.
+     * Only the pin types found in the net matter for the minimal connection test,
+     * and only the first conflicting pin found after NetItemRef is diagnosed.
+     */
+    if( aPinIndex.GetNoConnectCount() > ( aList->GetItemType( aNetItemRef ) == NET_NOCONNECT ) )
+        local_minconn = std::max( NET_NC, local_minconn );
+
+    unsigned firstConflict = UINT_MAX;
+
+    for( int jj = 0; jj < PINTYPE_COUNT; jj++ )
     {
-        if( aNetItemRef == netItemTst )
+        const std::vector<unsigned>& pins = aPinIndex.GetPins( (ELECTRICAL_PINTYPE) jj );
+
+        // Do not count NetItemRef itself
+        size_t count = pins.size();
+
+        if( ref_is_pin && jj == ref_elect_type )
+            count--;
+
+        if( count == 0 )
             continue;
 
-        // We examine only a given net. We stop the search if the net changes
-        if( ( netItemTst >= aList->size() ) // End of list
-            || ( aList->GetItemNet( aNetItemRef ) !=
-                 aList->GetItemNet( netItemTst ) ) ) // End of net
+        local_minconn = std::max( MinimalReq[ref_elect_type][jj], local_minconn );
+
+        if( DiagErc[ref_elect_type][jj] == OK )
+            continue;
+
+        auto next = std::upper_bound( pins.begin(), pins.end(), aNetItemRef );
+
+        if( next != pins.end() && *next < firstConflict )
+            firstConflict = *next;
+    }
+
+    if( firstConflict != UINT_MAX )
+    {
+        ELECTRICAL_PINTYPE jj = aList->GetItem( firstConflict )->m_ElectricalPinType;
+        erc = DiagErc[ref_elect_type][jj];
+
+        if( aList->GetConnectionType( firstConflict ) == UNCONNECTED )
         {
-            /* End net code found: minimum connection test. */
-            if( ( *aMinConnexion < NET_NC ) && ( local_minconn < NET_NC ) )
-            {
-                /* Not connected or not driven pin. */
-                bool seterr = true;
+            Diagnose( aList->GetItem( aNetItemRef ), aList->GetItem( firstConflict ), 0, erc );
+            aList->SetConnectionType( firstConflict, NOCONNECT_SYMBOL_PRESENT );
+        }
+    }
 
-                if( local_minconn == NOC &&
-                    aList->GetItemType( aNetItemRef ) == NET_PIN )
-                {
-                    /* This pin is not connected: for multiple part per
-                     * package, and duplicated pin,
-                     * search for another instance of this pin
-                     * this will be flagged only if all instances of this pin
-                     * are not connected
-                     * TODO test also if instances connected are connected to
-                     * the same net
-                     */
-                    for( unsigned duplicate = 0; duplicate < aList->size(); duplicate++ )
-                    {
-                        if( aList->GetItemType( duplicate ) != NET_PIN )
-                            continue;
-
-                        if( duplicate == aNetItemRef )
-                            continue;
-
-                        if( aList->GetItem( aNetItemRef )->m_PinNum !=
-                            aList->GetItem( duplicate )->m_PinNum )
-                            continue;
-
-                        if( ( (SCH_COMPONENT*) aList->GetItem( aNetItemRef )->
-                             m_Link )->GetRef( &aList->GetItem( aNetItemRef )-> m_SheetPath ) !=
-                            ( (SCH_COMPONENT*) aList->GetItem( duplicate )->m_Link )
-                           ->GetRef( &aList->GetItem( duplicate )->m_SheetPath ) )
-                            continue;
-
-                        // Same component and same pin. Do dot create error for this pin
-                        // if the other pin is connected (i.e. if duplicate net has another
-                        // item)
-                        if( (duplicate > 0)
-                          && ( aList->GetItemNet( duplicate ) ==
-                               aList->GetItemNet( duplicate - 1 ) ) )
-                            seterr = false;
-
-                        if( (duplicate < aList->size() - 1)
-                          && ( aList->GetItemNet( duplicate ) ==
-                               aList->GetItemNet( duplicate + 1 ) ) )
-                            seterr = false;
-                    }
-                }
+    /* End net code found: minimum connection test. */
+    if( ( *aMinConnexion < NET_NC ) && ( local_minconn < NET_NC ) )
+    {
+        /* Not connected or not driven pin. */
+        bool seterr = true;
 
-                if( seterr )
-                    Diagnose( aList->GetItem( aNetItemRef ), NULL, local_minconn, WAR );
+        if( local_minconn == NOC && ref_is_pin )
+        {
+            /* This pin is not connected: for multiple part per
+             * package, and duplicated pin,
+             * search for another instance of this pin
+             * this will be flagged only if all instances of this pin
+             * are not connected
+             * TODO test also if instances connected are connected to
+             * the same net
+             */
+            for( unsigned duplicate : aPinIndex.GetSamePins( aNetItemRef ) )
+            {
+                if( duplicate == aNetItemRef )
+                    continue;
 
-                *aMinConnexion = DRV;   // inhibiting other messages of this
-                                       // type for the net.
+                // Same component and same pin. Do dot create error for this pin
+                // if the other pin is connected (i.e. if duplicate net has another
+                // item)
+                if( (duplicate > 0)
+                  && ( aList->GetItemNet( duplicate ) ==
+                       aList->GetItemNet( duplicate - 1 ) ) )
+                    seterr = false;
+
+                if( (duplicate < aList->size() - 1)
+                  && ( aList->GetItemNet( duplicate ) ==
+                       aList->GetItemNet( duplicate + 1 ) ) )
+                    seterr = false;
             }
-            return;
         }
 
-        switch( aList->GetItemType( netItemTst ) )
+        if( seterr )
+            Diagnose( aList->GetItem( aNetItemRef ), NULL, local_minconn, WAR );
+
+        *aMinConnexion = DRV;   // inhibiting other messages of this
+                               // type for the net.
+    }
+}
+
+void TestNetlistErc( NETLIST_OBJECT_LIST* aList, const ERC_SETTINGS& aSettings )
+{
+    // Reset the connection type indicator
+    aList->ResetConnectionsType();
+
+    unsigned lastItemIdx = 0;
+    unsigned nextItemIdx = 0;
+    int MinConn    = NOC;
+
+    /* Check that a pin appears in only one net.  This check is necessary
+     * because multi-unit components that have shared pins can be wired to
+     * different nets.
+     */
+    std::unordered_map<wxString, wxString> pin_to_net_map;
+
+    ERC_PIN_INDEX pinIndex( aList );
+
+    /* The netlist generated by SCH_EDIT_FRAME::BuildNetListBase is sorted
+     * by net number, which means we can group netlist items into ranges
+     * that live in the same net. The range from nextItem to the current
+     * item (exclusive) needs to be checked against the current item. The
+     * lastItem variable is used as a helper to pass the last item's number
+     * from one loop iteration to the next, which simplifies the initial
+     * pass.
+     */
+
+    for( unsigned itemIdx = 0; itemIdx < aList->size(); itemIdx++ )
+    {
+        auto item = aList->GetItem( itemIdx );
+        auto lastItem = aList->GetItem( lastItemIdx );
+
+        auto lastNet = lastItem->GetNet();
+        auto net = item->GetNet();
+
+        wxASSERT_MSG( lastNet <= net, wxT( "Netlist not correctly ordered" ) );
+
+        if( lastNet != net )
+        {
+            // New net found:
+            MinConn      = NOC;
+            nextItemIdx = itemIdx;
+        }
+
+        switch( item->m_Type )
         {
+        // These items do not create erc problems
         case NET_ITEM_UNSPECIFIED:
         case NET_SEGMENT:
         case NET_BUS:
         case NET_JUNCTION:
         case NET_LABEL:
-        case NET_HIERLABEL:
         case NET_BUSLABELMEMBER:
-        case NET_HIERBUSLABELMEMBER:
-        case NET_SHEETBUSLABELMEMBER:
-        case NET_SHEETLABEL:
-        case NET_GLOBLABEL:
-        case NET_GLOBBUSLABELMEMBER:
         case NET_PINLABEL:
+        case NET_GLOBBUSLABELMEMBER:
             break;
 
-        case NET_NOCONNECT:
-            local_minconn = std::max( NET_NC, local_minconn );
-            break;
-
+        // TODO(JE) Port this to the new system
         case NET_PIN:
-            jj = aList->GetItem( netItemTst )->m_ElectricalPinType;
-            local_minconn = std::max( MinimalReq[ref_elect_type][jj], local_minconn );
-
-            if( netItemTst <= aNetItemRef )
-                break;
-
-            if( erc == OK )
+        {
+            // Check if this pin has appeared before on a different net
+            if( item->m_Link )
             {
-                erc = DiagErc[ref_elect_type][jj];
+                auto ref = item->GetComponentParent()->GetRef( &item->m_SheetPath );
+                wxString pin_name = ref + "_" + item->m_PinNum;
 
-                if( erc != OK )
+                if( pin_to_net_map.count( pin_name ) == 0 )
                 {
-                    if( aList->GetConnectionType( netItemTst ) == UNCONNECTED )
-                    {
-                        Diagnose( aList->GetItem( aNetItemRef ),
-                                  aList->GetItem( netItemTst ),
-                                  0, erc );
-                        aList->SetConnectionType( netItemTst, NOCONNECT_SYMBOL_PRESENT );
-                    }
+                    pin_to_net_map[pin_name] = item->GetNetName();
+                }
+                else if( pin_to_net_map[pin_name] != item->GetNetName() )
+                {
+                    SCH_MARKER* marker = new SCH_MARKER();
+
+                    marker->SetTimeStamp( GetNewTimeStamp() );
+                    marker->SetData( ERCE_DIFFERENT_UNIT_NET, item->m_Start,
+                        wxString::Format( _( "Pin %s on %s is connected to both %s and %s" ),
+                        item->m_PinNum, ref, pin_to_net_map[pin_name], item->GetNetName() ),
+                        item->m_Start );
+                    marker->SetMarkerType( MARKER_BASE::MARKER_ERC );
+                    marker->SetErrorLevel( MARKER_BASE::MARKER_SEVERITY_ERROR );
+
+                    item->m_SheetPath.LastScreen()->Append( marker );
                 }
             }
 
+            // Look for ERC problems between pins:
+            TestOthersItems( aList, itemIdx, nextItemIdx, &MinConn, pinIndex );
             break;
         }
+        default:
+        break;
+        }
+
+        lastItemIdx = itemIdx;
     }
+
+    // Test similar labels (i;e. labels which are identical when
+    // using case insensitive comparisons)
+    if( aSettings.check_similar_labels )
+        aList->TestforSimilarLabels();
 }
 
+
 int NETLIST_OBJECT_LIST::CountPinsInNet( unsigned aNetStart )
 {
     int count = 0;
@@ -715,16 +845,28 @@ struct compare_label_names
     }
 };
 
-struct compare_paths
+typedef std::set<NETLIST_OBJECT*, compare_label_names> LABELS_BY_NAME;
+
+// Count of identical labels:
+//  for global label: global labels in the full project, keyed by label name
+//  for local label: all labels in the current sheet, keyed by sheetpath+label
+struct IDENTICAL_LABEL_COUNTS
 {
-    bool operator() ( const NETLIST_OBJECT* lab1, const NETLIST_OBJECT* lab2 )
+    std::unordered_map<wxString, int> m_global;
+    std::unordered_map<wxString, int> m_local;
+
+    int Get( const NETLIST_OBJECT* aLabel )
     {
-        return lab1->m_SheetPath.Path().Cmp( lab2->m_SheetPath.Path() ) < 0;
+        if( aLabel->IsLabelGlobal() )
+            return m_global[aLabel->m_Label];
+
+        return m_local[aLabel->m_SheetPath.Path() + aLabel->m_Label];
     }
 };
 
 // Helper functions to build the warning messages about Similar Labels:
-static int countIndenticalLabels( std::vector<NETLIST_OBJECT*>& aList, NETLIST_OBJECT* aLabel );
+static void testSimilarLabelNames( const LABELS_BY_NAME& aLabels, bool aSkipGlobalPairs,
+                                   IDENTICAL_LABEL_COUNTS& aCounts );
 static void SimilarLabelsDiagnose( NETLIST_OBJECT* aItemA, NETLIST_OBJECT* aItemB );
 
 
@@ -733,11 +875,10 @@ void NETLIST_OBJECT_LIST::TestforSimilarLabels()
     // Similar labels which are different when using case sensitive comparisons
     // but are equal when using case insensitive comparisons
 
-    // list of all labels (used the better item to build diag messages)
-    std::vector<NETLIST_OBJECT*> fullLabelList;
+    // count of identical labels (used the better item to build diag messages)
+    IDENTICAL_LABEL_COUNTS identicalCounts;
     // list of all labels , each label appears only once (used to to detect similar labels)
     std::set<NETLIST_OBJECT*, compare_labels> uniqueLabelList;
-    wxString msg;
 
     // Build a list of differents labels. If inside a given sheet there are
     // more than one given label, only one label is stored.
@@ -747,6 +888,8 @@ void NETLIST_OBJECT_LIST::TestforSimilarLabels()
     //    already detected by ERC
     for( unsigned netItem = 0; netItem < size(); ++netItem )
     {
+        NETLIST_OBJECT* item = GetItem( netItem );
+
         switch( GetItemType( netItem ) )
         {
         case NET_LABEL:
@@ -757,8 +900,12 @@ void NETLIST_OBJECT_LIST::TestforSimilarLabels()
         case NET_HIERBUSLABELMEMBER:
         case NET_GLOBLABEL:
             // add this label in lists
-            uniqueLabelList.insert( GetItem( netItem ) );
-            fullLabelList.push_back( GetItem( netItem ) );
+            uniqueLabelList.insert( item );
+
+            if( item->IsLabelGlobal() )
+                identicalCounts.m_global[item->m_Label]++;
+
+            identicalCounts.m_local[item->m_SheetPath.Path() + item->m_Label]++;
             break;
 
         case NET_SHEETLABEL:
@@ -768,118 +915,63 @@ void NETLIST_OBJECT_LIST::TestforSimilarLabels()
         }
     }
 
-    // build global labels and compare
-    std::set<NETLIST_OBJECT*, compare_label_names> loc_labelList;
-    std::set<NETLIST_OBJECT*>::const_iterator it;
+    // build global labels list and the list of labels of each sheet path
+    LABELS_BY_NAME globalLabels;
+    std::map<wxString, LABELS_BY_NAME> sheetLabels;
 
-    for( it = uniqueLabelList.begin(); it != uniqueLabelList.end(); ++it )
+    for( NETLIST_OBJECT* label : uniqueLabelList )
     {
-        if( (*it)->IsLabelGlobal() )
-            loc_labelList.insert( *it );
-    }
+        if( label->IsLabelGlobal() )
+            globalLabels.insert( label );
 
-    // compare global labels (same label names appears only once in list)
-    for( it = loc_labelList.begin(); it != loc_labelList.end(); ++it )
-    {
-        std::set<NETLIST_OBJECT*>::const_iterator it_aux = it;
-
-        for( ++it_aux; it_aux != loc_labelList.end(); ++it_aux )
-        {
-            if( (*it)->m_Label.CmpNoCase( (*it_aux)->m_Label ) == 0 )
-            {
-                // Create new marker for ERC.
-                int cntA = countIndenticalLabels( fullLabelList, *it );
-                int cntB = countIndenticalLabels( fullLabelList, *it_aux );
-
-                if( cntA <= cntB )
-                    SimilarLabelsDiagnose( (*it), (*it_aux) );
-                else
-                    SimilarLabelsDiagnose( (*it_aux), (*it) );
-            }
-        }
+        sheetLabels[label->m_SheetPath.Path()].insert( label );
     }
 
-    // Build paths list
-    std::set<NETLIST_OBJECT*, compare_paths> pathsList;
-
-    for( it = uniqueLabelList.begin(); it != uniqueLabelList.end(); ++it )
-        pathsList.insert( *it );
-
-    // Examine each label inside a sheet path:
-    for( it = pathsList.begin(); it != pathsList.end(); ++it )
-    {
-        loc_labelList.clear();
-
-        std::set<NETLIST_OBJECT*>::const_iterator it_aux = uniqueLabelList.begin();
-
-        for( ; it_aux != uniqueLabelList.end(); ++it_aux )
-        {
-            if( (*it)->m_SheetPath.Path() == (*it_aux)->m_SheetPath.Path() )
-                loc_labelList.insert( *it_aux );
-        }
+    // compare global labels (same label names appears only once in list)
+    testSimilarLabelNames( globalLabels, false, identicalCounts );
 
-        // at this point, loc_labelList contains labels of the current sheet path.
-        // Detect similar labels (same label names appears only once in list)
-        std::set<NETLIST_OBJECT*>::const_iterator ref_it;
+    // Examine labels inside each sheet path.
+    // global label versus global label was already examined:
+    // here, at least one label must be local
+    for( auto& sheet : sheetLabels )
+        testSimilarLabelNames( sheet.second, true, identicalCounts );
+}
 
-        for( ref_it = loc_labelList.begin(); ref_it != loc_labelList.end(); ++ref_it )
-        {
-            NETLIST_OBJECT* ref_item = *ref_it;
-            it_aux = ref_it;
 
-            for( ++it_aux; it_aux != loc_labelList.end(); ++it_aux )
-            {
-                // global label versus global label was already examined.
-                // here, at least one label must be local
-                if( ref_item->IsLabelGlobal() && (*it_aux)->IsLabelGlobal() )
-                    continue;
+// Helper function: creates a marker for each pair of labels of aLabels (label names
+// are unique in aLabels) which are equal when using case insensitive comparisons.
+// Labels are grouped by their case folded name, so only similar labels are compared.
+static void testSimilarLabelNames( const LABELS_BY_NAME& aLabels, bool aSkipGlobalPairs,
+                                   IDENTICAL_LABEL_COUNTS& aCounts )
+{
+    std::unordered_map<wxString, std::vector<NETLIST_OBJECT*>> foldedNames;
 
-                if( ref_item->m_Label.CmpNoCase( (*it_aux)->m_Label ) == 0 )
-                {
-                    // Create new marker for ERC.
-                    int cntA = countIndenticalLabels( fullLabelList, ref_item );
-                    int cntB = countIndenticalLabels( fullLabelList, *it_aux );
-
-                    if( cntA <= cntB )
-                        SimilarLabelsDiagnose( ref_item, (*it_aux) );
-                    else
-                        SimilarLabelsDiagnose( (*it_aux), ref_item );
-                }
-            }
-        }
-    }
-}
+    for( NETLIST_OBJECT* label : aLabels )
+        foldedNames[label->m_Label.Lower()].push_back( label );
 
-// Helper function: count the number of labels identical to aLabel
-//  for global label: global labels in the full project
-//  for local label: all labels in the current sheet
-static int countIndenticalLabels( std::vector<NETLIST_OBJECT*>& aList, NETLIST_OBJECT* aLabel )
-{
-    int count = 0;
+    // Diagnose pairs in the label name order
+    std::unordered_map<wxString, size_t> position;
 
-    if( aLabel->IsLabelGlobal() )
+    for( NETLIST_OBJECT* ref_item : aLabels )
     {
-        for( unsigned netItem = 0; netItem < aList.size(); ++netItem )
-        {
-            NETLIST_OBJECT* item = aList[netItem];
+        wxString folded = ref_item->m_Label.Lower();
+        const std::vector<NETLIST_OBJECT*>& similar = foldedNames[folded];
 
-            if( item->IsLabelGlobal() && item->m_Label == aLabel->m_Label )
-                count++;
-        }
-    }
-    else
-    {
-        for( unsigned netItem = 0; netItem < aList.size(); ++netItem )
+        for( size_t ii = ++position[folded]; ii < similar.size(); ii++ )
         {
-            NETLIST_OBJECT* item = aList[netItem];
+            if( aSkipGlobalPairs && ref_item->IsLabelGlobal() && similar[ii]->IsLabelGlobal() )
+                continue;
+
+            // Create new marker for ERC.
+            int cntA = aCounts.Get( ref_item );
+            int cntB = aCounts.Get( similar[ii] );
 
-            if( item->m_Label == aLabel->m_Label &&
-                item->m_SheetPath.Path() == aLabel->m_SheetPath.Path() )
-                count++;
+            if( cntA <= cntB )
+                SimilarLabelsDiagnose( ref_item, similar[ii] );
+            else
+                SimilarLabelsDiagnose( similar[ii], ref_item );
         }
     }
-
-    return count;
 }
 
 // Helper function: creates a marker for similar labels ERC warning
@@ -30,10 +30,15 @@
 #ifndef _ERC_H
 #define _ERC_H
 
+#include <map>
+#include <vector>
+#include <pin_type.h>
+
 
 class NETLIST_OBJECT;
 class NETLIST_OBJECT_LIST;
 class SCH_SHEET_LIST;
+class ERC_SETTINGS;
 
 /* For ERC markers: error types (used in diags, and to set the color):
 */
@@ -98,6 +103,52 @@ bool WriteDiagnosticERC( EDA_UNITS_T aUnits, const wxString& aFullFileName );
 void Diagnose( NETLIST_OBJECT* NetItemRef, NETLIST_OBJECT* NetItemTst,
                       int MinConnexion, int Diag );
 
+/**
+ * Class ERC_PIN_INDEX
+ * gives, for the net currently tested in a NETLIST_OBJECT_LIST sorted by net code,
+ * the pins of this net grouped by electrical type, so that a pin can be tested
+ * against the other pins of its net without scanning the net for each pin.
+ */
+class ERC_PIN_INDEX
+{
+public:
+    ERC_PIN_INDEX( NETLIST_OBJECT_LIST* aList );
+
+    /**
+     * Select the net starting at \a aNetStart (the pin lists are rebuilt only
+     * when the net changes).
+     */
+    void SetNet( unsigned aNetStart );
+
+    /**
+     * @return the list indexes of the pins of type \a aType in the current net,
+     * in increasing order.
+     */
+    const std::vector<unsigned>& GetPins( ELECTRICAL_PINTYPE aType ) const
+    {
+        return m_pinsByType[aType];
+    }
+
+    /// @return the number of no connect symbols in the current net.
+    int GetNoConnectCount() const { return m_noConnectCount; }
+
+    /**
+     * @return the list indexes of all the pins in the netlist having the same
+     * component reference and pin number as the pin \a aPinIdx, including itself.
+     * Used to find other instances of shared pins of multiple unit components.
+     */
+    const std::vector<unsigned>& GetSamePins( unsigned aPinIdx );
+
+private:
+    NETLIST_OBJECT_LIST*  m_list;
+    unsigned              m_netStart;
+    int                   m_noConnectCount;
+    std::vector<unsigned> m_pinsByType[PINTYPE_COUNT];
+
+    // (reference, pin number) -> pins, built on first use
+    std::map<std::pair<wxString, wxString>, std::vector<unsigned>> m_pinsByName;
+};
+
 /**
  * Perform ERC testing for electrical conflicts between \a NetItemRef and other items
  * (mainly pin) on the same net.
@@ -106,10 +157,22 @@ void Diagnose( NETLIST_OBJECT* NetItemRef, NETLIST_OBJECT* NetItemTst,
  * @param aNetStart = index in list of net objects of the first item
  * @param aMinConnexion = a pointer to a variable to store the minimal connection
  * found( NOD, DRV, NPI, NET_NC)
+ * @param aPinIndex = the pin index of \a aList
  */
 void TestOthersItems( NETLIST_OBJECT_LIST* aList,
                              unsigned aNetItemRef, unsigned aNetStart,
-                             int* aMinConnexion );
+                             int* aMinConnexion, ERC_PIN_INDEX& aPinIndex );
+
+/**
+ * Perform the ERC tests done on a netlist object list: electrical conflicts between
+ * connected pins, minimal connection requirements, shared pins of multiple unit
+ * components connected to different nets and, if enabled in \a aSettings, similar labels.
+ * ERC markers are added to the screens of the faulty items.  This does not require
+ * any frame, so it is also used by batch (command line) ERC.
+ * @param aList = the list of connected objects, sorted by net code
+ * @param aSettings = the ERC settings to use
+ */
+void TestNetlistErc( NETLIST_OBJECT_LIST* aList, const ERC_SETTINGS& aSettings );
 
 /**
  * Function TestDuplicateSheetNames( )
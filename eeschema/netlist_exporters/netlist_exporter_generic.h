@@ -76,6 +76,18 @@ public:
         m_graph( aGraph )
     {}
 
+    /**
+     * Constructor not requiring a frame, for batch (command line) netlist export.
+     * @param aLibTable is the symbol library table of the project
+     */
+    NETLIST_EXPORTER_GENERIC( SYMBOL_LIB_TABLE* aLibTable,
+                              NETLIST_OBJECT_LIST* aMasterList,
+                              CONNECTION_GRAPH* aGraph = nullptr  ) :
+        NETLIST_EXPORTER( aMasterList ),
+        m_libTable( aLibTable ),
+        m_graph( aGraph )
+    {}
+
     /**
      * Function WriteNetlist
      * writes to specified output file
@@ -38,6 +38,7 @@
 
 class NETLIST_OBJECT_LIST;
 class SCH_COMPONENT;
+class SHEET_CONNECTION_INDEX;
 
 
 /* Type of Net objects (wires, labels, pins...) */
@@ -302,6 +303,9 @@ class NETLIST_OBJECT_LIST : public NETLIST_OBJECTS
     int m_lastBusNetCode;   // Used in intermediate calculation:
                             // last net code created for bus members
 
+    std::vector<int> m_netParent;       // Union-find tables used in intermediate calculation:
+    std::vector<int> m_busNetParent;    // parent net code of each net code (resp. bus net code)
+
 public:
     /**
      * Constructor.
@@ -435,15 +439,37 @@ private:
      * Propagate aNewNetCode to items having an internal netcode aOldNetCode
      * used to interconnect group of items already physically connected,
      * when a new connection is found between aOldNetCode and aNewNetCode
+     * Net codes are only merged in the union-find tables: the net code stored
+     * in items is updated by resolveNetCodes()
      */
     void propagateNetCode( int aOldNetCode, int aNewNetCode, bool aIsBus );
 
+    /**
+     * Create a new net code (resp. bus net code), not yet connected to other net codes
+     */
+    int newNetCode();
+    int newBusNetCode();
+
+    /**
+     * @return the net code (resp. bus net code) which aNetCode has been merged into,
+     * i.e. the actual net code of items having aNetCode.
+     */
+    int findNetCode( int aNetCode );
+    int findBusNetCode( int aBusNetCode );
+
+    /**
+     * Replace the net code and bus net code of all items by the net code their
+     * net code has been merged into.
+     */
+    void resolveNetCodes();
+
     /*
      * This function merges the net codes of groups of objects already connected
      * to labels (wires, bus, pins ... ) when 2 labels are equivalents
      * (i.e. group objects connected by labels)
+     * @param aSameNameLabels = the label type items having the same name as aLabelRef
      */
-    void labelConnect( NETLIST_OBJECT* aLabelRef );
+    void labelConnect( NETLIST_OBJECT* aLabelRef, const NETLIST_OBJECTS& aSameNameLabels );
 
     /* Comparison function to sort by increasing Netcode the list of connected items
      */
@@ -462,26 +488,33 @@ private:
     /**
      * Propagate net codes from a parent sheet to an include sheet,
      * from a pin sheet connection
+     * @param aSameNameLabels = the label type items having the same name as aSheetLabel
      */
-    void sheetLabelConnect( NETLIST_OBJECT* aSheetLabel );
+    void sheetLabelConnect( NETLIST_OBJECT* aSheetLabel, const NETLIST_OBJECTS& aSameNameLabels );
 
-    void pointToPointConnect( NETLIST_OBJECT* aRef, bool aIsBus, int start );
+    /**
+     * Search connections between aRef and items of the same sheet having
+     * a common end point with aRef.
+     * @param aSheetIndex = the connection index of the sheet containing aRef
+     */
+    void pointToPointConnect( NETLIST_OBJECT* aRef, bool aIsBus,
+                              const SHEET_CONNECTION_INDEX& aSheetIndex );
 
     /**
      * Search connections between a junction and segments
      * Propagate the junction net code to objects connected by this junction.
      * The junction must have a valid net code
-     * The list of objects is expected sorted by sheets.
-     * Search is done from index aIdxStart to the last element of list
+     * @param aSheetIndex = the connection index of the sheet containing aJonction
      */
-    void segmentToPointConnect( NETLIST_OBJECT* aJonction, bool aIsBus, int aIdxStart );
+    void segmentToPointConnect( NETLIST_OBJECT* aJonction, bool aIsBus,
+                                const SHEET_CONNECTION_INDEX& aSheetIndex );
 
 
     /**
      * Function connectBusLabels
      * Propagate the net code (and create it, if not yet existing) between
      * all bus label member objects connected by they name.
-     * Search is done in the entire list
+     * Search is done in the entire list, using a (bus net code, member) hash
      */
     void connectBusLabels();
 
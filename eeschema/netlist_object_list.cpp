@@ -39,12 +39,156 @@
 #include <sch_sheet.h>
 #include <sch_screen.h>
 #include <algorithm>
+#include <unordered_map>
 
 #define IS_WIRE false
 #define IS_BUS true
 
 //#define NETLIST_DEBUG
 
+
+/**
+ * Lookup tables of the items of a single sheet, used by BuildNetListInfo() to find
+ * the items sharing an end point with a given item, and the wires or buses going
+ * through a given point, without scanning all the items of the sheet each time.
+ * Items are referenced by their index in the NETLIST_OBJECT_LIST, and each list of
+ * candidates is given in increasing index order, i.e. in the order the full scan
+ * of the sheet would have found them.
+ */
+class SHEET_CONNECTION_INDEX
+{
+public:
+    /**
+     * Fill the tables from the items aStart to aEnd - 1 of aList, which are expected
+     * to be the items of one sheet.
+     */
+    void Build( const NETLIST_OBJECT_LIST& aList, unsigned aStart, unsigned aEnd )
+    {
+        for( int ii = 0; ii < 2; ++ii )
+        {
+            m_ends[ii].clear();
+            m_horizSegments[ii].clear();
+            m_vertSegments[ii].clear();
+            m_otherSegments[ii].clear();
+        }
+
+        for( unsigned ii = aStart; ii < aEnd; ii++ )
+        {
+            NETLIST_OBJECT* item = aList.GetItem( ii );
+
+            switch( item->m_Type )
+            {
+            case NET_SEGMENT:
+                addSegment( item, ii, IS_WIRE );
+                // Fall through
+            case NET_PIN:
+            case NET_LABEL:
+            case NET_HIERLABEL:
+            case NET_GLOBLABEL:
+            case NET_SHEETLABEL:
+            case NET_PINLABEL:
+            case NET_NOCONNECT:
+                addEnds( item, ii, IS_WIRE );
+                break;
+
+            case NET_BUS:
+                addSegment( item, ii, IS_BUS );
+                // Fall through
+            case NET_BUSLABELMEMBER:
+            case NET_SHEETBUSLABELMEMBER:
+            case NET_HIERBUSLABELMEMBER:
+            case NET_GLOBBUSLABELMEMBER:
+                addEnds( item, ii, IS_BUS );
+                break;
+
+            case NET_JUNCTION:
+                addEnds( item, ii, IS_WIRE );
+                addEnds( item, ii, IS_BUS );
+                break;
+
+            case NET_ITEM_UNSPECIFIED:
+                break;
+            }
+        }
+    }
+
+    /**
+     * Fill aCandidates with the items (wire or bus items, according to aIsBus) having
+     * an end point in common with aRef.
+     */
+    void FindPointConnections( const NETLIST_OBJECT* aRef, bool aIsBus,
+                               std::vector<unsigned>& aCandidates ) const
+    {
+        aCandidates.clear();
+        appendAt( m_ends[aIsBus], aRef->m_Start, aCandidates );
+
+        if( aRef->m_End != aRef->m_Start )
+            appendAt( m_ends[aIsBus], aRef->m_End, aCandidates );
+
+        sortUnique( aCandidates );
+    }
+
+    /**
+     * Fill aCandidates with the segments (wires or buses, according to aIsBus) which
+     * could go through aPos.  Candidates must still be tested by IsPointOnSegment().
+     */
+    void FindSegmentsThrough( const wxPoint& aPos, bool aIsBus,
+                              std::vector<unsigned>& aCandidates ) const
+    {
+        aCandidates.clear();
+        appendAt( m_horizSegments[aIsBus], aPos.y, aCandidates );
+        appendAt( m_vertSegments[aIsBus], aPos.x, aCandidates );
+        aCandidates.insert( aCandidates.end(), m_otherSegments[aIsBus].begin(),
+                            m_otherSegments[aIsBus].end() );
+        sortUnique( aCandidates );
+    }
+
+private:
+    void addEnds( const NETLIST_OBJECT* aItem, unsigned aIdx, bool aIsBus )
+    {
+        m_ends[aIsBus][aItem->m_Start].push_back( aIdx );
+
+        if( aItem->m_End != aItem->m_Start )
+            m_ends[aIsBus][aItem->m_End].push_back( aIdx );
+    }
+
+    void addSegment( const NETLIST_OBJECT* aItem, unsigned aIdx, bool aIsBus )
+    {
+        // Schematic wires are almost always horizontal or vertical: a point can be
+        // on such a segment only if it has the same y (resp. x) coordinate.
+        if( aItem->m_Start.y == aItem->m_End.y )
+            m_horizSegments[aIsBus][aItem->m_Start.y].push_back( aIdx );
+        else if( aItem->m_Start.x == aItem->m_End.x )
+            m_vertSegments[aIsBus][aItem->m_Start.x].push_back( aIdx );
+        else
+            m_otherSegments[aIsBus].push_back( aIdx );
+    }
+
+    template <typename KEY>
+    static void appendAt( const std::unordered_map<KEY, std::vector<unsigned>>& aMap,
+                          const KEY& aKey, std::vector<unsigned>& aCandidates )
+    {
+        auto it = aMap.find( aKey );
+
+        if( it != aMap.end() )
+            aCandidates.insert( aCandidates.end(), it->second.begin(), it->second.end() );
+    }
+
+    static void sortUnique( std::vector<unsigned>& aCandidates )
+    {
+        std::sort( aCandidates.begin(), aCandidates.end() );
+        aCandidates.erase( std::unique( aCandidates.begin(), aCandidates.end() ),
+                           aCandidates.end() );
+    }
+
+    // All tables are indexed by IS_WIRE / IS_BUS
+    std::unordered_map<wxPoint, std::vector<unsigned>> m_ends[2];
+    std::unordered_map<int, std::vector<unsigned>>     m_horizSegments[2];
+    std::unordered_map<int, std::vector<unsigned>>     m_vertSegments[2];
+    std::vector<unsigned>                              m_otherSegments[2];
+};
+
+
 NETLIST_OBJECT_LIST::~NETLIST_OBJECT_LIST()
 {
     Clear();
@@ -62,6 +206,8 @@ void NETLIST_OBJECT_LIST::Clear()
     }
 
     clear();
+    m_netParent.clear();
+    m_busNetParent.clear();
 }
 
 
@@ -98,17 +244,26 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
     // Sort objects by Sheet
     SortListbySheet();
 
-    sheet = &(GetItem( 0 )->m_SheetPath);
+    // Net codes are merged through union-find tables, net code 0 meaning "no net".
+    m_netParent.assign( 1, 0 );
+    m_busNetParent.assign( 1, 0 );
     m_lastNetCode = m_lastBusNetCode = 1;
 
-    for( unsigned ii = 0, istart = 0; ii < size(); ii++ )
+    SHEET_CONNECTION_INDEX sheetIndex;
+    unsigned sheetEnd = 0;
+
+    for( unsigned ii = 0; ii < size(); ii++ )
     {
         NETLIST_OBJECT* net_item = GetItem( ii );
 
-        if( net_item->m_SheetPath != *sheet )   // Sheet change
+        if( ii == sheetEnd )   // Sheet change
         {
-            sheet  = &(net_item->m_SheetPath);
-            istart = ii;
+            sheet = &(net_item->m_SheetPath);
+
+            while( sheetEnd < size() && GetItem( sheetEnd )->m_SheetPath == *sheet )
+                sheetEnd++;
+
+            sheetIndex.Build( *this, ii, sheetEnd );
         }
 
         switch( net_item->m_Type )
@@ -127,32 +282,23 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
         case NET_SEGMENT:
             // Test connections point to point type without bus.
             if( net_item->GetNet() == 0 )
-            {
-                net_item->SetNet( m_lastNetCode );
-                m_lastNetCode++;
-            }
+                net_item->SetNet( newNetCode() );
 
-            pointToPointConnect( net_item, IS_WIRE, istart );
+            pointToPointConnect( net_item, IS_WIRE, sheetIndex );
             break;
 
         case NET_JUNCTION:
             // Control of the junction outside BUS.
             if( net_item->GetNet() == 0 )
-            {
-                net_item->SetNet( m_lastNetCode );
-                m_lastNetCode++;
-            }
+                net_item->SetNet( newNetCode() );
 
-            segmentToPointConnect( net_item, IS_WIRE, istart );
+            segmentToPointConnect( net_item, IS_WIRE, sheetIndex );
 
             // Control of the junction, on BUS.
             if( net_item->m_BusNetCode == 0 )
-            {
-                net_item->m_BusNetCode = m_lastBusNetCode;
-                m_lastBusNetCode++;
-            }
+                net_item->m_BusNetCode = newBusNetCode();
 
-            segmentToPointConnect( net_item, IS_BUS, istart );
+            segmentToPointConnect( net_item, IS_BUS, sheetIndex );
             break;
 
         case NET_LABEL:
@@ -160,12 +306,9 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
         case NET_GLOBLABEL:
             // Test connections type junction without bus.
             if( net_item->GetNet() == 0 )
-            {
-                net_item->SetNet( m_lastNetCode );
-                m_lastNetCode++;
-            }
+                net_item->SetNet( newNetCode() );
 
-            segmentToPointConnect( net_item, IS_WIRE, istart );
+            segmentToPointConnect( net_item, IS_WIRE, sheetIndex );
             break;
 
         case NET_SHEETBUSLABELMEMBER:
@@ -175,12 +318,9 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
         case NET_BUS:
             // Control type connections point to point mode bus
             if( net_item->m_BusNetCode == 0 )
-            {
-                net_item->m_BusNetCode = m_lastBusNetCode;
-                m_lastBusNetCode++;
-            }
+                net_item->m_BusNetCode = newBusNetCode();
 
-            pointToPointConnect( net_item, IS_BUS, istart );
+            pointToPointConnect( net_item, IS_BUS, sheetIndex );
             break;
 
         case NET_BUSLABELMEMBER:
@@ -188,16 +328,15 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
         case NET_GLOBBUSLABELMEMBER:
             // Control connections similar has on BUS
             if( net_item->GetNet() == 0 )
-            {
-                net_item->m_BusNetCode = m_lastBusNetCode;
-                m_lastBusNetCode++;
-            }
+                net_item->m_BusNetCode = newBusNetCode();
 
-            segmentToPointConnect( net_item, IS_BUS, istart );
+            segmentToPointConnect( net_item, IS_BUS, sheetIndex );
             break;
         }
     }
 
+    resolveNetCodes();
+
 #if defined(NETLIST_DEBUG) && defined(DEBUG)
     std::cout << "\n\nafter sheet local\n\n";
     DumpNetTable();
@@ -207,6 +346,15 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
     connectBusLabels();
 
     // Group objects by label.
+    // Labels can only be connected to labels having the same name: index them by name.
+    std::unordered_map<wxString, NETLIST_OBJECTS> labelsByName;
+
+    for( unsigned ii = 0; ii < size(); ii++ )
+    {
+        if( GetItem( ii )->IsLabelType() )
+            labelsByName[ GetItem( ii )->m_Label ].push_back( GetItem( ii ) );
+    }
+
     for( unsigned ii = 0; ii < size(); ii++ )
     {
         switch( GetItem( ii )->m_Type )
@@ -224,7 +372,7 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
         case NET_PINLABEL:
         case NET_BUSLABELMEMBER:
         case NET_GLOBBUSLABELMEMBER:
-            labelConnect( GetItem( ii ) );
+            labelConnect( GetItem( ii ), labelsByName[ GetItem( ii )->m_Label ] );
             break;
 
         case NET_SHEETBUSLABELMEMBER:
@@ -238,6 +386,7 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
     }
 
 #if defined(NETLIST_DEBUG) && defined(DEBUG)
+    resolveNetCodes();
     std::cout << "\n\nafter sheet global\n\n";
     DumpNetTable();
 #endif
@@ -247,9 +396,12 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
     {
         if( GetItem( ii )->m_Type == NET_SHEETLABEL
             || GetItem( ii )->m_Type == NET_SHEETBUSLABELMEMBER )
-            sheetLabelConnect( GetItem( ii ) );
+            sheetLabelConnect( GetItem( ii ), labelsByName[ GetItem( ii )->m_Label ] );
     }
 
+    // Give to each item the final net code of its group
+    resolveNetCodes();
+
     // Sort objects by NetCode
     SortListbyNetcode();
 
@@ -273,6 +425,10 @@ bool NETLIST_OBJECT_LIST::BuildNetListInfo( SCH_SHEET_LIST& aSheets )
         GetItem( ii )->SetNet( NetCode );
     }
 
+    // The union-find tables are no longer meaningful once net codes are compressed
+    m_netParent.clear();
+    m_busNetParent.clear();
+
     // Set the minimal connection info:
     setUnconnectedFlag();
 
@@ -497,32 +653,28 @@ void NETLIST_OBJECT_LIST::findBestNetNameForEachNet()
 }
 
 
-void NETLIST_OBJECT_LIST::sheetLabelConnect( NETLIST_OBJECT* SheetLabel )
+void NETLIST_OBJECT_LIST::sheetLabelConnect( NETLIST_OBJECT* SheetLabel,
+                                             const NETLIST_OBJECTS& aSameNameLabels )
 {
     if( SheetLabel->GetNet() == 0 )
         return;
 
-    for( unsigned ii = 0; ii < size(); ii++ )
+    for( NETLIST_OBJECT* ObjetNet : aSameNameLabels )
     {
-        NETLIST_OBJECT* ObjetNet = GetItem( ii );
+        if( (ObjetNet->m_Type != NET_HIERLABEL ) && (ObjetNet->m_Type != NET_HIERBUSLABELMEMBER ) )
+            continue;
 
         if( ObjetNet->m_SheetPath != SheetLabel->m_SheetPathInclude )
             continue;  //use SheetInclude, not the sheet!!
 
-        if( (ObjetNet->m_Type != NET_HIERLABEL ) && (ObjetNet->m_Type != NET_HIERBUSLABELMEMBER ) )
-            continue;
-
-        if( ObjetNet->GetNet() == SheetLabel->GetNet() )
+        if( ObjetNet->GetNet() && findNetCode( ObjetNet->GetNet() ) == findNetCode( SheetLabel->GetNet() ) )
             continue;  //already connected.
 
-        if( ObjetNet->m_Label != SheetLabel->m_Label )
-            continue;  //different names.
-
         // Propagate Netcode having all the objects of the same Netcode.
         if( ObjetNet->GetNet() )
             propagateNetCode( ObjetNet->GetNet(), SheetLabel->GetNet(), IS_WIRE );
         else
-            ObjetNet->SetNet( SheetLabel->GetNet() );
+            ObjetNet->SetNet( findNetCode( SheetLabel->GetNet() ) );
     }
 }
 
@@ -531,189 +683,168 @@ void NETLIST_OBJECT_LIST::connectBusLabels()
 {
     // Propagate the net code between all bus label member objects connected by they name.
     // If the net code is not yet existing, a new one is created
-    // Search is done in the entire list
+    // Two bus label members are connected if they have the same bus net code and
+    // the same member number: the first label found for a given (bus, member) pair
+    // gives its net code to the others.
+    std::unordered_map<long long, NETLIST_OBJECT*> firstLabels;
+
     for( unsigned ii = 0; ii < size(); ii++ )
     {
         NETLIST_OBJECT* Label = GetItem( ii );
 
-        if( Label->IsLabelBusMemberType() )
+        if( !Label->IsLabelBusMemberType() )
+            continue;
+
+        long long key = ( (long long) findBusNetCode( Label->m_BusNetCode ) << 32 )
+                        | (unsigned) Label->m_Member;
+
+        auto first = firstLabels.find( key );
+
+        if( first == firstLabels.end() )
         {
             if( Label->GetNet() == 0 )
             {
                 // Not yet existiing net code: create a new one.
-                Label->SetNet( m_lastNetCode );
-                m_lastNetCode++;
+                Label->SetNet( newNetCode() );
             }
 
-            for( unsigned jj = ii + 1; jj < size(); jj++ )
-            {
-                NETLIST_OBJECT* LabelInTst =  GetItem( jj );
-
-                if( LabelInTst->IsLabelBusMemberType() )
-                {
-                    if( LabelInTst->m_BusNetCode != Label->m_BusNetCode )
-                        continue;
-
-                    if( LabelInTst->m_Member != Label->m_Member )
-                        continue;
-
-                    if( LabelInTst->GetNet() == 0 )
-                        // Append this object to the current net
-                        LabelInTst->SetNet( Label->GetNet() );
-                    else
-                        // Merge the 2 net codes, they are connected.
-                        propagateNetCode( LabelInTst->GetNet(), Label->GetNet(), IS_WIRE );
-                }
-            }
+            firstLabels[ key ] = Label;
+        }
+        else if( Label->GetNet() == 0 )
+        {
+            // Append this object to the current net
+            Label->SetNet( findNetCode( first->second->GetNet() ) );
+        }
+        else
+        {
+            // Merge the 2 net codes, they are connected.
+            propagateNetCode( Label->GetNet(), first->second->GetNet(), IS_WIRE );
         }
     }
 }
 
 
-void NETLIST_OBJECT_LIST::propagateNetCode( int aOldNetCode, int aNewNetCode, bool aIsBus )
+int NETLIST_OBJECT_LIST::newNetCode()
 {
-    if( aOldNetCode == aNewNetCode )
-        return;
+    m_netParent.push_back( m_lastNetCode );
+    return m_lastNetCode++;
+}
 
-    if( aIsBus == false )    // Propagate NetCode
-    {
-        for( unsigned jj = 0; jj < size(); jj++ )
-        {
-            NETLIST_OBJECT* object = GetItem( jj );
 
-            if( object->GetNet() == aOldNetCode )
-                object->SetNet( aNewNetCode );
-        }
+int NETLIST_OBJECT_LIST::newBusNetCode()
+{
+    m_busNetParent.push_back( m_lastBusNetCode );
+    return m_lastBusNetCode++;
+}
+
+
+/*
+ * Find the root of a net code in a union-find table, compressing the path on the way
+ */
+static int findRoot( std::vector<int>& aParent, int aCode )
+{
+    int root = aCode;
+
+    while( aParent[root] != root )
+        root = aParent[root];
+
+    while( aParent[aCode] != root )
+    {
+        int next = aParent[aCode];
+        aParent[aCode] = root;
+        aCode = next;
     }
-    else               // Propagate BusNetCode
+
+    return root;
+}
+
+
+int NETLIST_OBJECT_LIST::findNetCode( int aNetCode )
+{
+    return findRoot( m_netParent, aNetCode );
+}
+
+
+int NETLIST_OBJECT_LIST::findBusNetCode( int aBusNetCode )
+{
+    return findRoot( m_busNetParent, aBusNetCode );
+}
+
+
+void NETLIST_OBJECT_LIST::propagateNetCode( int aOldNetCode, int aNewNetCode, bool aIsBus )
+{
+    std::vector<int>& parent = aIsBus ? m_busNetParent : m_netParent;
+
+    aOldNetCode = findRoot( parent, aOldNetCode );
+    aNewNetCode = findRoot( parent, aNewNetCode );
+
+    // Items having aOldNetCode are now considered as having aNewNetCode.
+    // The actual net code of items is updated by resolveNetCodes()
+    if( aOldNetCode != aNewNetCode )
+        parent[aOldNetCode] = aNewNetCode;
+}
+
+
+void NETLIST_OBJECT_LIST::resolveNetCodes()
+{
+    for( unsigned ii = 0; ii < size(); ii++ )
     {
-        for( unsigned jj = 0; jj < size(); jj++ )
-        {
-            NETLIST_OBJECT* object = GetItem( jj );
+        NETLIST_OBJECT* object = GetItem( ii );
 
-            if( object->m_BusNetCode == aOldNetCode )
-                object->m_BusNetCode = aNewNetCode;
-        }
+        object->SetNet( findNetCode( object->GetNet() ) );
+        object->m_BusNetCode = findBusNetCode( object->m_BusNetCode );
     }
 }
 
 
-void NETLIST_OBJECT_LIST::pointToPointConnect( NETLIST_OBJECT* aRef, bool aIsBus, int start )
+void NETLIST_OBJECT_LIST::pointToPointConnect( NETLIST_OBJECT* aRef, bool aIsBus,
+                                               const SHEET_CONNECTION_INDEX& aSheetIndex )
 {
-    int netCode;
+    std::vector<unsigned> candidates;
+
+    aSheetIndex.FindPointConnections( aRef, aIsBus, candidates );
 
     if( aIsBus == false )    // Objects other than BUS and BUSLABELS
     {
-        netCode = aRef->GetNet();
+        int netCode = findNetCode( aRef->GetNet() );
 
-        for( unsigned i = start; i < size(); i++ )
+        for( unsigned i : candidates )
         {
             NETLIST_OBJECT* item = GetItem( i );
 
-            if( item->m_SheetPath != aRef->m_SheetPath )  //used to be > (why?)
-                continue;
-
-            switch( item->m_Type )
-            {
-            case NET_SEGMENT:
-            case NET_PIN:
-            case NET_LABEL:
-            case NET_HIERLABEL:
-            case NET_GLOBLABEL:
-            case NET_SHEETLABEL:
-            case NET_PINLABEL:
-            case NET_JUNCTION:
-            case NET_NOCONNECT:
-                if( aRef->m_Start == item->m_Start
-                    || aRef->m_Start == item->m_End
-                    || aRef->m_End   == item->m_Start
-                    || aRef->m_End   == item->m_End )
-                {
-                    if( item->GetNet() == 0 )
-                        item->SetNet( netCode );
-                    else
-                        propagateNetCode( item->GetNet(), netCode, IS_WIRE );
-                }
-                break;
-
-            case NET_BUS:
-            case NET_BUSLABELMEMBER:
-            case NET_SHEETBUSLABELMEMBER:
-            case NET_HIERBUSLABELMEMBER:
-            case NET_GLOBBUSLABELMEMBER:
-            case NET_ITEM_UNSPECIFIED:
-                break;
-            }
+            if( item->GetNet() == 0 )
+                item->SetNet( netCode );
+            else
+                propagateNetCode( item->GetNet(), netCode, IS_WIRE );
         }
     }
     else    // Object type BUS, BUSLABELS, and junctions.
     {
-        netCode = aRef->m_BusNetCode;
+        int netCode = findBusNetCode( aRef->m_BusNetCode );
 
-        for( unsigned i = start; i < size(); i++ )
+        for( unsigned i : candidates )
         {
             NETLIST_OBJECT* item = GetItem( i );
 
-            if( item->m_SheetPath != aRef->m_SheetPath )
-                continue;
-
-            switch( item->m_Type )
-            {
-            case NET_ITEM_UNSPECIFIED:
-            case NET_SEGMENT:
-            case NET_PIN:
-            case NET_LABEL:
-            case NET_HIERLABEL:
-            case NET_GLOBLABEL:
-            case NET_SHEETLABEL:
-            case NET_PINLABEL:
-            case NET_NOCONNECT:
-                break;
-
-            case NET_BUS:
-            case NET_BUSLABELMEMBER:
-            case NET_SHEETBUSLABELMEMBER:
-            case NET_HIERBUSLABELMEMBER:
-            case NET_GLOBBUSLABELMEMBER:
-            case NET_JUNCTION:
-                if(  aRef->m_Start == item->m_Start
-                  || aRef->m_Start == item->m_End
-                  || aRef->m_End   == item->m_Start
-                  || aRef->m_End   == item->m_End )
-                {
-                    if( item->m_BusNetCode == 0 )
-                        item->m_BusNetCode = netCode;
-                    else
-                        propagateNetCode( item->m_BusNetCode, netCode, IS_BUS );
-                }
-                break;
-            }
+            if( item->m_BusNetCode == 0 )
+                item->m_BusNetCode = netCode;
+            else
+                propagateNetCode( item->m_BusNetCode, netCode, IS_BUS );
         }
     }
 }
 
 
-void NETLIST_OBJECT_LIST::segmentToPointConnect( NETLIST_OBJECT* aJonction,
-                                                 bool aIsBus, int aIdxStart )
+void NETLIST_OBJECT_LIST::segmentToPointConnect( NETLIST_OBJECT* aJonction, bool aIsBus,
+                                                 const SHEET_CONNECTION_INDEX& aSheetIndex )
 {
-    for( unsigned i = aIdxStart; i < size(); i++ )
-    {
-        NETLIST_OBJECT* segment = GetItem( i );
+    std::vector<unsigned> candidates;
 
-        // if different sheets, obviously no physical connection between elements.
-        if( segment->m_SheetPath != aJonction->m_SheetPath )
-            continue;
+    aSheetIndex.FindSegmentsThrough( aJonction->m_Start, aIsBus, candidates );
 
-        if( aIsBus == IS_WIRE )
-        {
-            if( segment->m_Type != NET_SEGMENT )
-                continue;
-        }
-        else
-        {
-            if( segment->m_Type != NET_BUS )
-                continue;
-        }
+    for( unsigned i : candidates )
+    {
+        NETLIST_OBJECT* segment = GetItem( i );
 
         if( IsPointOnSegment( segment->m_Start, segment->m_End, aJonction->m_Start ) )
         {
@@ -723,30 +854,29 @@ void NETLIST_OBJECT_LIST::segmentToPointConnect( NETLIST_OBJECT* aJonction,
                 if( segment->GetNet() )
                     propagateNetCode( segment->GetNet(), aJonction->GetNet(), aIsBus );
                 else
-                    segment->SetNet( aJonction->GetNet() );
+                    segment->SetNet( findNetCode( aJonction->GetNet() ) );
             }
             else
             {
                 if( segment->m_BusNetCode )
                     propagateNetCode( segment->m_BusNetCode, aJonction->m_BusNetCode, aIsBus );
                 else
-                    segment->m_BusNetCode = aJonction->m_BusNetCode;
+                    segment->m_BusNetCode = findBusNetCode( aJonction->m_BusNetCode );
             }
         }
     }
 }
 
 
-void NETLIST_OBJECT_LIST::labelConnect( NETLIST_OBJECT* aLabelRef )
+void NETLIST_OBJECT_LIST::labelConnect( NETLIST_OBJECT* aLabelRef,
+                                        const NETLIST_OBJECTS& aSameNameLabels )
 {
     if( aLabelRef->GetNet() == 0 )
         return;
 
-    for( unsigned i = 0; i < size(); i++ )
+    for( NETLIST_OBJECT* item : aSameNameLabels )
     {
-        NETLIST_OBJECT* item = GetItem( i );
-
-        if( item->GetNet() == aLabelRef->GetNet() )
+        if( item->GetNet() && findNetCode( item->GetNet() ) == findNetCode( aLabelRef->GetNet() ) )
             continue;
 
         if( item->m_SheetPath != aLabelRef->m_SheetPath )
@@ -766,16 +896,11 @@ void NETLIST_OBJECT_LIST::labelConnect( NETLIST_OBJECT* aLabelRef )
         // NET_LABEL are local to a sheet
         // NET_GLOBLABEL are global.
         // NET_PINLABEL is a kind of global label (generated by a power pin invisible)
-        if( item->IsLabelType() )
-        {
-            if( item->m_Label != aLabelRef->m_Label )
-                continue;
-
-            if( item->GetNet() )
-                propagateNetCode( item->GetNet(), aLabelRef->GetNet(), IS_WIRE );
-            else
-                item->SetNet( aLabelRef->GetNet() );
-        }
+        // aSameNameLabels contains only label type items having the same name.
+        if( item->GetNet() )
+            propagateNetCode( item->GetNet(), aLabelRef->GetNet(), IS_WIRE );
+        else
+            item->SetNet( findNetCode( aLabelRef->GetNet() ) );
     }
 }
 
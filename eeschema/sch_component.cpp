@@ -369,7 +369,7 @@ static bool sort_by_libid( const SCH_COMPONENT* ref, SCH_COMPONENT* cmp )
 
 
 void SCH_COMPONENT::ResolveAll( const SCH_COLLECTOR& aComponents, SYMBOL_LIB_TABLE& aLibTable,
-                                PART_LIB* aCacheLib )
+                                PART_LIB* aCacheLib, RESOLVED_PARTS* aResolved )
 {
     std::vector<SCH_COMPONENT*> cmp_list;
 
@@ -391,7 +391,15 @@ void SCH_COMPONENT::ResolveAll( const SCH_COLLECTOR& aComponents, SYMBOL_LIB_TAB
     {
         SCH_COMPONENT* cmp = cmp_list[ii];
         curr_libid = cmp->m_lib_id;
-        cmp->Resolve( aLibTable, aCacheLib );
+
+        // A part resolved for another screen is reused as long as it is still alive
+        auto cached = aResolved ? aResolved->find( curr_libid ) : RESOLVED_PARTS::iterator();
+
+        if( aResolved && cached != aResolved->end() && !cached->second.expired() )
+            cmp->m_part = cached->second;
+        else if( cmp->Resolve( aLibTable, aCacheLib ) && aResolved )
+            (*aResolved)[curr_libid] = cmp->m_part;
+
         cmp->UpdatePins();
 
         // Propagate the m_part pointer to other members using the same lib_id
@@ -665,6 +673,9 @@ void SCH_COMPONENT::SetRef( const SCH_SHEET_PATH* sheet, const wxString& ref )
     if( notInArray )
         AddHierarchicalReference( path, ref, m_unit );
 
+    if( sheet )
+        m_netNamePrefixes.erase( *sheet );
+
     SCH_FIELD* rf = GetField( REFERENCE );
 
     if( rf->GetText().IsEmpty()
@@ -710,6 +721,8 @@ void SCH_COMPONENT::SetTimeStamp( timestamp_t aNewTimeStamp )
         m_PathsAndReferences[ii].Replace( string_oldtimestamp.GetData(),
                                           string_timestamp.GetData() );
     }
+
+    m_netNamePrefixes.clear();
 }
 
 
@@ -929,6 +942,34 @@ void SCH_COMPONENT::GetPins( std::vector<LIB_PIN*>& aPinsList )
 }
 
 
+void SCH_COMPONENT::UpdateDefaultNetNamePrefix( const SCH_SHEET_PATH& aSheet )
+{
+    m_netNamePrefixes.erase( aSheet );
+    m_netNamePrefixes[ aSheet ] = GetDefaultNetNamePrefix( aSheet );
+}
+
+
+wxString SCH_COMPONENT::GetDefaultNetNamePrefix( const SCH_SHEET_PATH& aSheet )
+{
+    auto it = m_netNamePrefixes.find( aSheet );
+
+    if( it != m_netNamePrefixes.end() )
+        return it->second;
+
+    wxString prefix = "Net-(";
+
+    prefix << GetRef( &aSheet );
+
+    // TODO(JE) do we need adoptTimestamp?
+    if( /* adoptTimestamp && */ prefix.Last() == '?' )
+        prefix << GetTimeStamp();
+
+    prefix << "-Pad";
+
+    return prefix;
+}
+
+
 SCH_PINS& SCH_COMPONENT::GetPinMap()
 {
     return m_pins;
@@ -965,6 +1006,7 @@ void SCH_COMPONENT::SwapData( SCH_ITEM* aItem )
         GetField( ii )->SetParent( this );
 
     std::swap( m_PathsAndReferences, component->m_PathsAndReferences );
+    std::swap( m_netNamePrefixes, component->m_netNamePrefixes );
 }
 
 
@@ -1014,6 +1056,11 @@ void SCH_COMPONENT::ClearAnnotation( SCH_SHEET_PATH* aSheetPath )
     // But this call cannot made here.
     m_Fields[REFERENCE].SetText( defRef ); //for drawing.
 
+    if( aSheetPath )
+        m_netNamePrefixes.erase( *aSheetPath );
+    else
+        m_netNamePrefixes.clear();
+
     SetModified();
 }
 
@@ -1756,6 +1803,7 @@ SCH_ITEM& SCH_COMPONENT::operator=( const SCH_ITEM& aItem )
         m_transform = c->m_transform;
 
         m_PathsAndReferences = c->m_PathsAndReferences;
+        m_netNamePrefixes.clear();
 
         m_Fields = c->m_Fields;    // std::vector's assignment operator.
 
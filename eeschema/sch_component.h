@@ -39,6 +39,7 @@
 #include <general.h>
 #include <vector>
 #include <set>
+#include <map>
 #include <lib_draw_item.h>
 #include <sch_pin.h>
 
@@ -63,6 +64,9 @@ typedef std::vector<SCH_FIELD>    SCH_FIELDS;
 
 typedef std::weak_ptr<LIB_PART>   PART_REF;
 
+/// LIB_PARTs already resolved, mapped by the LIB_ID used to resolve them.
+typedef std::map<LIB_ID, PART_REF> RESOLVED_PARTS;
+
 
 extern std::string toUTFTildaText( const wxString& txt );
 
@@ -98,6 +102,10 @@ private:
 
     SCH_PINS      m_pins;
 
+    /// The "Net-(REF-Pad" start of the default net names of the pins, for each sheet path.
+    /// Shared by all the pins so that they do not each keep a copy per sheet.
+    std::map<SCH_SHEET_PATH, wxString> m_netNamePrefixes;
+
     AUTOPLACED  m_fieldsAutoplaced; ///< indicates status of field autoplacement
 
     bool        m_isInNetlist;  ///< True if the component should appear in the netlist
@@ -197,8 +205,14 @@ public:
 
     bool Resolve( SYMBOL_LIB_TABLE& aLibTable, PART_LIB* aCacheLib = NULL );
 
+    /**
+     * Resolve all the components in \a aComponents.
+     *
+     * @param aResolved if not NULL, parts already resolved are taken from it instead of being
+     *                  looked up in the libraries, and newly resolved parts are added to it.
+     */
     static void ResolveAll( const SCH_COLLECTOR& aComponents, SYMBOL_LIB_TABLE& aLibTable,
-                            PART_LIB* aCacheLib = NULL );
+                            PART_LIB* aCacheLib = NULL, RESOLVED_PARTS* aResolved = NULL );
 
     int GetUnit() const { return m_unit; }
 
@@ -467,6 +481,21 @@ public:
      */
     SCH_PINS& GetPinMap();
 
+    /**
+     * Store the start of the default net names of the pins for \a aSheet, i.e.
+     * "Net-(REF-Pad".
+     *
+     * This calls GetRef(), which may write the component, so it must be called before the
+     * default net names are read by several threads (see SCH_PIN::GetDefaultNetName()).
+     */
+    void UpdateDefaultNetNamePrefix( const SCH_SHEET_PATH& aSheet );
+
+    /**
+     * Return the start of the default net names of the pins for \a aSheet, built again when
+     * it was not stored by UpdateDefaultNetNamePrefix().
+     */
+    wxString GetDefaultNetNamePrefix( const SCH_SHEET_PATH& aSheet );
+
     /**
      * Draw a component
      *
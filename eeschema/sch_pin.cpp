@@ -29,21 +29,10 @@ SCH_PIN::SCH_PIN( LIB_PIN* aLibPin, SCH_COMPONENT* aParentComponent ) :
     m_pin( aLibPin ),
     m_comp( aParentComponent )
 {
-    SetPosition( aLibPin->GetPosition() );
     m_isDangling = true;
 }
 
 
-SCH_PIN::SCH_PIN( const SCH_PIN& aPin ) :
-    SCH_ITEM( aPin )
-{
-    m_pin = aPin.m_pin;
-    m_comp = aPin.m_comp;
-    m_position = aPin.m_position;
-    m_isDangling = aPin.m_isDangling;
-}
-
-
 wxString SCH_PIN::GetSelectMenuText( EDA_UNITS_T aUnits ) const
 {
     wxString tmp;
@@ -62,29 +51,12 @@ wxString SCH_PIN::GetSelectMenuText( EDA_UNITS_T aUnits ) const
 }
 
 
-wxString SCH_PIN::GetDefaultNetName( const SCH_SHEET_PATH aPath )
+wxString SCH_PIN::GetDefaultNetName( const SCH_SHEET_PATH& aPath ) const
 {
     if( m_pin->IsPowerConnection() )
         return m_pin->GetName();
 
-    std::lock_guard<std::mutex> lock( m_netmap_mutex );
-
-    if( m_net_name_map.count( aPath ) > 0 )
-        return m_net_name_map.at( aPath );
-
-    wxString name = "Net-(";
-
-    name << m_comp->GetRef( &aPath );
-
-    // TODO(JE) do we need adoptTimestamp?
-    if( /* adoptTimestamp && */ name.Last() == '?' )
-        name << m_comp->GetTimeStamp();
-
-    name << "-Pad" << m_pin->GetNumber() << ")";
-
-    m_net_name_map[ aPath ] = name;
-
-    return name;
+    return m_comp->GetDefaultNetNamePrefix( aPath ) + m_pin->GetNumber() + ")";
 }
 
 
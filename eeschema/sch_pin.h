@@ -26,28 +26,25 @@
 #include <sch_sheet_path.h>
 #include <lib_pin.h>
 
-#include <mutex>
-#include <map>
-
 class SCH_COMPONENT;
 
+/**
+ * A pin of a placed component, as seen by the connectivity.
+ *
+ * This is a light view of a #LIB_PIN of the (shared) #LIB_PART of a component: everything
+ * but the connectivity state is read from the library pin, so a schematic with many
+ * instances of the same part does not duplicate the pin data.
+ */
 class SCH_PIN : public SCH_ITEM
 {
     LIB_PIN*       m_pin;
     SCH_COMPONENT* m_comp;
 
-    wxPoint        m_position;
     bool           m_isDangling;
 
-    /// The name that this pin connection will drive onto a net
-    std::mutex m_netmap_mutex;
-    std::map<const SCH_SHEET_PATH, wxString> m_net_name_map;
-
 public:
     SCH_PIN( LIB_PIN* aLibPin, SCH_COMPONENT* aParentComponent );
 
-    SCH_PIN( const SCH_PIN& aPin );
-
     wxString GetClass() const override
     {
         return wxT( "SCH_PIN" );
@@ -58,7 +55,14 @@ public:
     SCH_COMPONENT* GetParentComponent() const { return m_comp; }
     void SetParentComponent( SCH_COMPONENT* aComp ) { m_comp = aComp; }
 
-    wxString GetDefaultNetName( const SCH_SHEET_PATH aPath );
+    /**
+     * Return the name that this pin drives onto a net when nothing else names the net.
+     *
+     * The name is the start stored once per sheet in the component, followed by the pin
+     * number.  It only reads the component, so it is thread-safe once
+     * SCH_COMPONENT::UpdateDefaultNetNamePrefix() was called for \a aPath.
+     */
+    wxString GetDefaultNetName( const SCH_SHEET_PATH& aPath ) const;
 
     wxString GetSelectMenuText( EDA_UNITS_T aUnits ) const override;
 
@@ -72,9 +76,14 @@ public:
 
     void Rotate( wxPoint aPosition ) override {}
 
-    wxPoint GetPosition() const override { return m_position; }
+    /// The position of the pin in the symbol, i.e. that of the library pin
+    wxPoint GetPosition() const override { return m_pin->GetPosition(); }
 
-    void SetPosition( const wxPoint& aPosition ) override { m_position = aPosition; }
+    /// The position is that of the library pin and cannot be changed here
+    void SetPosition( const wxPoint& aPosition ) override
+    {
+        wxFAIL_MSG( "SCH_PIN position is that of its library pin; move the component instead" );
+    }
 
     bool IsDangling() const override { return m_isDangling; }
 
@@ -489,7 +489,63 @@ bool SCH_SCREEN::IsTerminalPoint( const wxPoint& aPosition, int aLayer )
 }
 
 
+/**
+ * The parts resolved for the schematic symbols, shared by all the screens of a project so a
+ * symbol used on many sheets is looked up in the libraries only once.  It is owned by the
+ * project, next to its symbol library table, and is only valid for the table (and the
+ * modification hash of this table) it was filled from.
+ */
+class RESOLVED_PARTS_CACHE : public PROJECT::_ELEM
+{
+public:
+    RESOLVED_PARTS    m_parts;
+    SYMBOL_LIB_TABLE* m_libTable = nullptr;
+    int               m_sync = 0;
+
+    KICAD_T Type() override { return SCH_RESOLVED_PARTS_T; }
+
+    void Clear()
+    {
+        m_parts.clear();
+        m_libTable = nullptr;
+    }
+
+    static RESOLVED_PARTS_CACHE& Get( PROJECT& aProject )
+    {
+        auto cache = (RESOLVED_PARTS_CACHE*) aProject.GetElem( PROJECT::ELEM_SCH_RESOLVED_PARTS );
+
+        // its gotta be NULL or a RESOLVED_PARTS_CACHE, or a bug.
+        wxASSERT( !cache || cache->Type() == SCH_RESOLVED_PARTS_T );
+
+        if( !cache )
+        {
+            cache = new RESOLVED_PARTS_CACHE;
+            aProject.SetElem( PROJECT::ELEM_SCH_RESOLVED_PARTS, cache );
+        }
+
+        return *cache;
+    }
+};
+
+
+void SCH_SCREEN::ClearResolvedParts( PROJECT& aProject )
+{
+    RESOLVED_PARTS_CACHE::Get( aProject ).Clear();
+}
+
+
 void SCH_SCREEN::UpdateSymbolLinks( bool aForce )
+{
+    // A forced refresh follows a library change that may leave the modification hash of the
+    // library table unchanged, so the parts resolved for the other screens can be stale
+    if( aForce )
+        ClearResolvedParts( Prj() );
+
+    resolveSymbolLinks( aForce );
+}
+
+
+void SCH_SCREEN::resolveSymbolLinks( bool aForce )
 {
     // Initialize or reinitialize the pointer to the LIB_PART for each component
     // found in m_drawList, but only if needed (change in lib or schematic)
@@ -505,7 +561,17 @@ void SCH_SCREEN::UpdateSymbolLinks( bool aForce )
         // Must we resolve?
         if( (m_modification_sync != mod_hash) || aForce )
         {
-            SCH_COMPONENT::ResolveAll( c, *libs, Prj().SchLibs()->GetCacheLibrary() );
+            RESOLVED_PARTS_CACHE& resolved = RESOLVED_PARTS_CACHE::Get( Prj() );
+
+            if( resolved.m_libTable != libs || resolved.m_sync != mod_hash )
+            {
+                resolved.Clear();
+                resolved.m_libTable = libs;
+                resolved.m_sync = mod_hash;
+            }
+
+            SCH_COMPONENT::ResolveAll( c, *libs, Prj().SchLibs()->GetCacheLibrary(),
+                                       &resolved.m_parts );
 
             m_modification_sync = mod_hash;     // note the last mod_hash
         }
@@ -1559,8 +1625,14 @@ int SCH_SCREENS::GetMarkerCount( enum MARKER_BASE::TYPEMARKER aMarkerType,
 
 void SCH_SCREENS::UpdateSymbolLinks( bool aForce )
 {
+    // A forced update must look up the symbols again, but only once for all the screens.
+    // All the screens are resolved here, not lazily when they are first shown: the
+    // connectivity of the whole hierarchy is built right after, and needs every pin.
+    if( aForce && GetFirst() )
+        SCH_SCREEN::ClearResolvedParts( GetFirst()->Prj() );
+
     for( SCH_SCREEN* screen = GetFirst(); screen; screen = GetNext() )
-        screen->UpdateSymbolLinks( aForce );
+        screen->resolveSymbolLinks( aForce );
 }
 
 
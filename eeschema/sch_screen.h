@@ -73,6 +73,8 @@ class SCH_SCREEN : public BASE_SCREEN, public KIWAY_HOLDER
 {
 private:
 
+    friend class SCH_SCREENS;
+
     wxString    m_fileName;     ///< File used to load the screen.
 
     int         m_refCount;     ///< Number of sheets referencing this screen.
@@ -114,6 +116,12 @@ private:
      */
     void addConnectedItemsToBlock( const SCH_ITEM* aItem, const wxPoint& aPosition );
 
+    /**
+     * UpdateSymbolLinks() without forgetting the parts already resolved, so that
+     * SCH_SCREENS::UpdateSymbolLinks() clears them only once for all the screens.
+     */
+    void resolveSymbolLinks( bool aForce );
+
 public:
 
     /**
@@ -246,10 +254,20 @@ public:
      * - before creating a netlist (in case a library is modified)
      * - whenever a symbol library is modified
      *
+     * Parts are resolved once for all the screens: a symbol already resolved for another
+     * screen is not looked up again in the libraries while the library table is unchanged.
+     *
      * @param aForce true forces a refresh even if the library modification has hasn't changed.
+     *               The parts resolved for the other screens are then forgotten too.
      */
     void UpdateSymbolLinks( bool aForce = false );
 
+    /**
+     * Forget the parts resolved by UpdateSymbolLinks() for \a aProject, so the next resolution
+     * looks up the symbols in the libraries again.
+     */
+    static void ClearResolvedParts( PROJECT& aProject );
+
     /**
      * Draw all the items in the screen to \a aCanvas.
      *
@@ -25,6 +25,8 @@
 #ifndef BASIC_GAL_H
 #define BASIC_GAL_H
 
+#include <mutex>
+
 #include <eda_rect.h>
 
 #include <gal/stroke_font.h>
@@ -167,4 +169,8 @@ private:
 
 extern BASIC_GAL basic_gal;
 
+// basic_gal keeps the attributes of the text being drawn or measured: several threads
+// (zone filling, 3D viewer) may convert texts to segments, so its users hold this lock
+extern std::mutex basic_gal_mutex;
+
 #endif      // define BASIC_GAL_H
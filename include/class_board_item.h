@@ -35,6 +35,9 @@
 #include <gr_basic.h>
 #include <layers_id_colors_and_visibility.h>
 
+#include <memory>
+#include <vector>
+
 
 class BOARD;
 class BOARD_ITEM_CONTAINER;
@@ -58,6 +61,55 @@ enum STROKE_T
 };
 
 
+/**
+ * Class BOARD_ITEM_SHAPE_CACHE
+ * keeps the polygons built by BOARD_ITEM::TransformShapeWithClearanceToPolygonCached().
+ * A copy of an item does not share the cache of the item, as the copy is usually
+ * modified afterwards: copies start with an empty cache.
+ */
+class BOARD_ITEM_SHAPE_CACHE
+{
+public:
+    struct ENTRY;
+
+    BOARD_ITEM_SHAPE_CACHE()
+    {
+    }
+
+    BOARD_ITEM_SHAPE_CACHE( const BOARD_ITEM_SHAPE_CACHE& )
+    {
+    }
+
+    BOARD_ITEM_SHAPE_CACHE& operator=( const BOARD_ITEM_SHAPE_CACHE& )
+    {
+        Clear();
+        return *this;
+    }
+
+    /**
+     * Function Find
+     * @return the cached entry having the same parameters and item bounding box as aKey,
+     * or nullptr
+     */
+    std::shared_ptr<const ENTRY> Find( const ENTRY& aKey ) const;
+
+    /**
+     * Function Add
+     * Caches aEntry, forgetting the oldest entry if the cache is full
+     */
+    void Add( const std::shared_ptr<const ENTRY>& aEntry );
+
+    void Clear();
+
+private:
+    typedef std::vector<std::shared_ptr<const ENTRY>> ENTRIES;
+
+    // Several threads may use the cache of an item at the same time, e.g. when filling
+    // zones: the entries are replaced, not modified, and accessed with atomic_load/store
+    std::shared_ptr<const ENTRIES> m_entries;
+};
+
+
 /**
  * Class BOARD_ITEM
  * is a base class for any item which can be embedded within the BOARD
@@ -328,6 +380,34 @@ public:
                                                int aCircleToSegmentsCount,
                                                double aCorrectionFactor,
                                                bool ignoreLineWidth = false ) const;
+
+    /**
+     * Function TransformShapeWithClearanceToPolygonCached
+     * Same as TransformShapeWithClearanceToPolygon(), but reuses the polygon built by a
+     * previous call with the same parameters, until the item is changed.
+     * BOARD_COMMIT and the undo commands call ClearCachedShapes() for the items they
+     * change.  A polygon built for another item bounding box is not reused either, to
+     * catch the items moved without a commit, e.g. by scripts.
+     * Zones are not cached, as their shape changes when they are filled.
+     */
+    void TransformShapeWithClearanceToPolygonCached( SHAPE_POLY_SET& aCornerBuffer,
+                                                     int aClearanceValue,
+                                                     int aCircleToSegmentsCount,
+                                                     double aCorrectionFactor,
+                                                     bool ignoreLineWidth = false ) const;
+
+    /**
+     * Function ClearCachedShapes
+     * Forgets the polygons cached by TransformShapeWithClearanceToPolygonCached(),
+     * to be called when the item is changed
+     */
+    virtual void ClearCachedShapes()
+    {
+        m_shapeCache.Clear();
+    }
+
+private:
+    mutable BOARD_ITEM_SHAPE_CACHE m_shapeCache;
 };
 
 #endif /* BOARD_ITEM_STRUCT_H */
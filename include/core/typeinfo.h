@@ -177,6 +177,7 @@ enum KICAD_T
     PART_LIBS_T,
     SEARCH_STACK_T,
     CACHE_WRAPPER_T,
+    SCH_RESOLVED_PARTS_T,
 
     // End value
     MAX_STRUCT_TYPE_ID
@@ -45,6 +45,17 @@ class EDA_RECT;
  */
 int GetArcToSegmentCount( int aRadius, int aErrorMax, double aArcAngleDegree );
 
+/**
+ * @return the number of segments to approximate a circle by segments with a given max
+ * error, but not more than a given count
+ * The count is a multiple of 4, to keep the symmetries of pads and rounded ends.
+ * @param aRadius is the radius of the circle
+ * @param aErrorMax is the max distance between the middle of a segment and the circle
+ * @param aMaxSegCount is the maximal segment count, usually the count used when the
+ * error is not taken in account
+ */
+int GetCircleToSegmentCount( int aRadius, int aErrorMax, int aMaxSegCount );
+
 /**
  * @return the correction factor to approximate a circle by segments
  * @param aSegCountforCircle is the number of segments to approximate the circle
@@ -0,0 +1,224 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __PACKED_RTREE_H
+#define __PACKED_RTREE_H
+
+#include <vector>
+#include <geometry/rtree.h>
+
+/**
+ * Class PACKED_RTREE
+ *
+ * An immutable R-tree for read-mostly spatial indices: built once by Sort-Tile-Recursive
+ * packing and stored in two flat arrays, the bounding boxes of all levels one after the other
+ * (leaves first, root last) and the leaf data.  The children of a node are contiguous in the
+ * level below, so no child pointers are stored and a search walks memory mostly forward.
+ *
+ * Searches do not modify the tree and may run concurrently.  Rebuild it to change its contents.
+ */
+template <class DATATYPE, class ELEMTYPE, int NUMDIMS, int NODE_SIZE = 16>
+class PACKED_RTREE
+{
+public:
+    PACKED_RTREE()
+    {
+    }
+
+    /**
+     * Function Build()
+     * Replaces the tree contents with aCount entries.
+     * @param aGetEntry functor filling the bounding box and data of an entry:
+     *                  aGetEntry( index, ELEMTYPE min[NUMDIMS], ELEMTYPE max[NUMDIMS], DATATYPE& )
+     */
+    template <class GETTER>
+    void Build( size_t aCount, GETTER aGetEntry )
+    {
+        std::vector<ENTRY> entries( aCount );
+
+        for( size_t i = 0; i < aCount; ++i )
+            aGetEntry( i, entries[i].box.min, entries[i].box.max, entries[i].data );
+
+        RTreeSortTileRecursive( entries.begin(), entries.end(), NUMDIMS, NODE_SIZE,
+                []( const ENTRY& aEntry, int aAxis )
+                {
+                    return (double) aEntry.box.min[aAxis] + (double) aEntry.box.max[aAxis];
+                } );
+
+        Clear();
+
+        size_t boxCount = aCount;
+
+        for( size_t n = aCount; n > 1; n = ( n + NODE_SIZE - 1 ) / NODE_SIZE )
+            boxCount += ( n + NODE_SIZE - 1 ) / NODE_SIZE;
+
+        m_boxes.reserve( boxCount );
+        m_data.reserve( aCount );
+
+        for( const ENTRY& entry : entries )
+        {
+            m_boxes.push_back( entry.box );
+            m_data.push_back( entry.data );
+        }
+
+        m_levelStart.push_back( 0 );
+
+        // Cover each run of NODE_SIZE boxes of a level with a box of the level above
+        for( size_t begin = 0, end = m_boxes.size(); end - begin > 1; )
+        {
+            for( size_t first = begin; first < end; first += NODE_SIZE )
+            {
+                BOX cover = m_boxes[first];
+                size_t last = std::min<size_t>( first + NODE_SIZE, end );
+
+                for( size_t i = first + 1; i < last; ++i )
+                {
+                    for( int axis = 0; axis < NUMDIMS; ++axis )
+                    {
+                        cover.min[axis] = std::min( cover.min[axis], m_boxes[i].min[axis] );
+                        cover.max[axis] = std::max( cover.max[axis], m_boxes[i].max[axis] );
+                    }
+                }
+
+                m_boxes.push_back( cover );
+            }
+
+            m_levelStart.push_back( end );
+            begin = end;
+            end = m_boxes.size();
+        }
+
+        m_levelStart.push_back( m_boxes.size() );
+    }
+
+    /**
+     * Function Clear()
+     * Removes all entries.
+     */
+    void Clear()
+    {
+        m_boxes.clear();
+        m_data.clear();
+        m_levelStart.clear();
+    }
+
+    size_t Size() const
+    {
+        return m_data.size();
+    }
+
+    /**
+     * Function Search()
+     * Calls aVisitor( const DATATYPE& ) for every entry whose bounding box intersects the
+     * box [aMin, aMax].  The visitor returns false to stop the search.
+     * @return the number of entries visited
+     */
+    template <class VISITOR>
+    int Search( const ELEMTYPE aMin[NUMDIMS], const ELEMTYPE aMax[NUMDIMS],
+                VISITOR& aVisitor ) const
+    {
+        if( m_boxes.empty() )
+            return 0;
+
+        BOX box;
+
+        for( int axis = 0; axis < NUMDIMS; ++axis )
+        {
+            box.min[axis] = aMin[axis];
+            box.max[axis] = aMax[axis];
+        }
+
+        int count = 0;
+        size_t root = m_boxes.size() - 1;
+
+        if( !overlaps( m_boxes[root], box ) )
+            return 0;
+
+        if( m_levelStart.size() == 2 )     // a single entry: the root is a leaf
+        {
+            aVisitor( m_data[root] );
+            return 1;
+        }
+
+        searchNode( m_levelStart.size() - 2, root, box, aVisitor, count );
+        return count;
+    }
+
+private:
+    struct BOX
+    {
+        ELEMTYPE min[NUMDIMS];
+        ELEMTYPE max[NUMDIMS];
+    };
+
+    struct ENTRY
+    {
+        BOX      box;
+        DATATYPE data;
+    };
+
+    static bool overlaps( const BOX& aA, const BOX& aB )
+    {
+        for( int axis = 0; axis < NUMDIMS; ++axis )
+        {
+            if( aA.min[axis] > aB.max[axis] || aB.min[axis] > aA.max[axis] )
+                return false;
+        }
+
+        return true;
+    }
+
+    template <class VISITOR>
+    bool searchNode( size_t aLevel, size_t aNode, const BOX& aBox, VISITOR& aVisitor,
+                     int& aCount ) const
+    {
+        size_t first = m_levelStart[aLevel - 1] + ( aNode - m_levelStart[aLevel] ) * NODE_SIZE;
+        size_t last = std::min<size_t>( first + NODE_SIZE, m_levelStart[aLevel] );
+
+        for( size_t i = first; i < last; ++i )
+        {
+            if( !overlaps( m_boxes[i], aBox ) )
+                continue;
+
+            if( aLevel == 1 )
+            {
+                aCount++;
+
+                if( !aVisitor( m_data[i] ) )
+                    return false;
+            }
+            else if( !searchNode( aLevel - 1, i, aBox, aVisitor, aCount ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::vector<BOX>      m_boxes;          ///< boxes of all levels, leaves first
+    std::vector<DATATYPE> m_data;           ///< data of the leaves
+    std::vector<size_t>   m_levelStart;     ///< index of the first box of each level, and the end
+};
+
+#endif // __PACKED_RTREE_H
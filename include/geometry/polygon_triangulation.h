@@ -48,6 +48,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <vector>
 #include <math/box2.h>
 
@@ -57,8 +60,20 @@ class PolygonTriangulation
 {
 
 public:
+    class VERTEX_ARENA;
 
     PolygonTriangulation( SHAPE_POLY_SET::TRIANGULATED_POLYGON& aResult ) :
+        m_vertices( m_ownVertices ),
+        m_result( aResult )
+    {};
+
+    /**
+     * Uses aVertices to store the vertices, so that its storage is reused by all the
+     * triangulations sharing it.  These triangulations must run one after another.
+     */
+    PolygonTriangulation( SHAPE_POLY_SET::TRIANGULATED_POLYGON& aResult,
+                          VERTEX_ARENA& aVertices ) :
+        m_vertices( aVertices ),
         m_result( aResult )
     {};
 
@@ -92,10 +107,8 @@ private:
          */
         Vertex* split( Vertex* b )
         {
-            parent->m_vertices.emplace_back( i, x, y, parent );
-            Vertex* a2 = &parent->m_vertices.back();
-            parent->m_vertices.emplace_back( b->i, b->x, b->y, parent );
-            Vertex* b2 = &parent->m_vertices.back();
+            Vertex* a2 = parent->m_vertices.Create( i, x, y, parent );
+            Vertex* b2 = parent->m_vertices.Create( b->i, b->x, b->y, parent );
             Vertex* an = next;
             Vertex* bp = b->prev;
 
@@ -229,8 +242,49 @@ private:
         Vertex* nextZ = nullptr;
     };
 
+public:
+    /**
+     * Class VERTEX_ARENA
+     *
+     * Allocates the vertices of a triangulation in fixed size blocks, so that they keep
+     * their address.  Clearing the arena keeps the blocks for the next triangulation.
+     */
+    class VERTEX_ARENA
+    {
+    public:
+        Vertex* Create( size_t aIndex, double aX, double aY, PolygonTriangulation* aParent )
+        {
+            if( m_used == m_blocks.size() * BLOCK_SIZE )
+                m_blocks.emplace_back( new STORAGE[BLOCK_SIZE] );
+
+            void* slot = &m_blocks[m_used / BLOCK_SIZE][m_used % BLOCK_SIZE];
+            m_used++;
+
+            return new( slot ) Vertex( aIndex, aX, aY, aParent );
+        }
+
+        void Clear()
+        {
+            // Vertices need no destruction, see the static_assert below
+            m_used = 0;
+        }
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 4096;
+
+        typedef typename std::aligned_storage<sizeof( Vertex ), alignof( Vertex )>::type STORAGE;
+
+        std::vector<std::unique_ptr<STORAGE[]>> m_blocks;
+        size_t m_used = 0;
+    };
+
+private:
+    static_assert( std::is_trivially_destructible<Vertex>::value,
+                   "VERTEX_ARENA does not destroy the vertices" );
+
     BOX2I m_bbox;
-    std::deque<Vertex> m_vertices;
+    VERTEX_ARENA m_ownVertices;
+    VERTEX_ARENA& m_vertices;
     SHAPE_POLY_SET::TRIANGULATED_POLYGON& m_result;
 
     /**
@@ -631,9 +685,8 @@ private:
     Vertex* insertVertex( const VECTOR2I& pt, Vertex* last )
     {
         m_result.AddVertex( pt );
-        m_vertices.emplace_back( m_result.GetVertexCount() - 1, pt.x, pt.y, this );
 
-        Vertex* p = &m_vertices.back();
+        Vertex* p = m_vertices.Create( m_result.GetVertexCount() - 1, pt.x, pt.y, this );
         if( !last )
         {
             p->prev = p;
@@ -656,6 +709,7 @@ public:
     {
         m_bbox = aPoly.BBox();
         m_result.Clear();
+        m_vertices.Clear();
 
         if( !m_bbox.GetWidth() || !m_bbox.GetHeight() )
             return false;
@@ -670,7 +724,7 @@ public:
         firstVertex->updateList();
 
         auto retval = earcutList( firstVertex );
-        m_vertices.clear();
+        m_vertices.Clear();
         return retval;
     }
 };
@@ -32,6 +32,8 @@
 
 #include <algorithm>
 #include <functional>
+#include <iterator>
+#include <vector>
 
 #define ASSERT assert    // RTree uses ASSERT( condition )
 
@@ -55,6 +57,41 @@
 class RTFileStream;    // File I/O helper class, look below for implementation and notes.
 
 
+/// Order entries for packing into nodes of a_nodeSize entries, using the Sort-Tile-Recursive
+/// method of Leutenegger et al.: the entries are sorted by the centre of their bounding rect
+/// along the first axis, cut into slabs, and each slab is ordered the same way along the next axes.
+/// Consecutive runs of a_nodeSize entries then make compact, little overlapping nodes.
+/// \param a_centre Functor returning the centre (or any monotonic function of it) of an entry
+///                 along an axis: a_centre( entry, axis )
+template <class ITER, class CENTRE>
+void RTreeSortTileRecursive( ITER a_first, ITER a_last, int a_numDims, int a_nodeSize,
+                             CENTRE a_centre, int a_axis = 0 )
+{
+    typedef typename std::iterator_traits<ITER>::value_type ENTRY;
+
+    std::sort( a_first, a_last, [&]( const ENTRY& a, const ENTRY& b )
+                                {
+                                    return a_centre( a, a_axis ) < a_centre( b, a_axis );
+                                } );
+
+    size_t count = a_last - a_first;
+
+    if( a_axis + 1 >= a_numDims || count <= (size_t) a_nodeSize )
+        return;
+
+    size_t nodeCount = ( count + a_nodeSize - 1 ) / a_nodeSize;
+    size_t slabCount = (size_t) ceil( pow( (double) nodeCount, 1.0 / ( a_numDims - a_axis ) ) );
+    size_t slabSize  = a_nodeSize * ( ( nodeCount + slabCount - 1 ) / slabCount );
+
+    for( size_t start = 0; start < count; start += slabSize )
+    {
+        size_t end = std::min( start + slabSize, count );
+        RTreeSortTileRecursive( a_first + start, a_first + end, a_numDims, a_nodeSize,
+                                a_centre, a_axis + 1 );
+    }
+}
+
+
 /// \class RTree
 /// Implementation of RTree, a multidimensional bounding rectangle tree.
 /// Example usage: For a 3-dimensional tree use RTree<Object*, float, 3> myTree;
@@ -109,6 +146,16 @@ public:
                  const ELEMTYPE     a_max[NUMDIMS],
                  const DATATYPE&    a_dataId );
 
+    /// Insert many entries at once.  If the tree is empty it is built bottom-up with the
+    /// Sort-Tile-Recursive packing, which is several times faster than inserting the entries
+    /// one by one and gives fuller nodes that overlap less, so later searches are faster too.
+    /// Otherwise the entries are inserted one by one.
+    /// \param a_count Number of entries
+    /// \param a_getEntry Functor filling the bounding rect and data of an entry:
+    ///                   a_getEntry( index, ELEMTYPE min[NUMDIMS], ELEMTYPE max[NUMDIMS], DATATYPE& data )
+    template <class GETTER>
+    void BulkInsert( size_t a_count, GETTER a_getEntry );
+
     /// Remove entry
     /// \param a_min Min of bounding rect
     /// \param a_max Max of bounding rect
@@ -660,6 +707,80 @@ void RTREE_QUAL::Insert( const ELEMTYPE     a_min[NUMDIMS],
 }
 
 
+RTREE_TEMPLATE
+template <class GETTER>
+void RTREE_QUAL::BulkInsert( size_t a_count, GETTER a_getEntry )
+{
+    if( m_root->m_count > 0 )
+    {
+        for( size_t i = 0; i < a_count; ++i )
+        {
+            ELEMTYPE    min[NUMDIMS], max[NUMDIMS];
+            DATATYPE    data;
+
+            a_getEntry( i, min, max, data );
+            Insert( min, max, data );
+        }
+
+        return;
+    }
+
+    if( a_count == 0 )
+        return;
+
+    std::vector<Branch> branches( a_count );
+
+    for( size_t i = 0; i < a_count; ++i )
+    {
+        Branch& branch = branches[i];
+        a_getEntry( i, branch.m_rect.m_min, branch.m_rect.m_max, branch.m_data );
+    }
+
+    auto centre = []( const Branch& a_branch, int a_axis )
+                  {
+                      return (ELEMTYPEREAL) a_branch.m_rect.m_min[a_axis]
+                             + (ELEMTYPEREAL) a_branch.m_rect.m_max[a_axis];
+                  };
+
+    // Pack the branches into nodes level by level, until a single node is left: the root
+    for( int level = 0; ; ++level )
+    {
+        RTreeSortTileRecursive( branches.begin(), branches.end(), NUMDIMS, MAXNODES, centre );
+
+        size_t count     = branches.size();
+        size_t nodeCount = ( count + MAXNODES - 1 ) / MAXNODES;
+        std::vector<Branch> parents( nodeCount );
+
+        for( size_t n = 0, first = 0; n < nodeCount; ++n )
+        {
+            size_t size = std::min<size_t>( MAXNODES, count - first );
+
+            // Share the last two nodes' branches so that none is left underfull
+            if( n + 2 == nodeCount && count - first - MAXNODES < MINNODES )
+                size = ( count - first + 1 ) / 2;
+
+            Node* node = AllocNode();
+            node->m_level = level;
+            node->m_count = (int) size;
+            std::copy( branches.begin() + first, branches.begin() + first + size, node->m_branch );
+
+            parents[n].m_rect  = NodeCover( node );
+            parents[n].m_child = node;
+            first += size;
+        }
+
+        if( nodeCount == 1 )
+        {
+            FreeNode( m_root );
+            m_root = parents[0].m_child;
+            return;
+        }
+
+        branches.swap( parents );
+    }
+}
+
+
 RTREE_TEMPLATE
 bool RTREE_QUAL::Remove( const ELEMTYPE     a_min[NUMDIMS],
                          const ELEMTYPE     a_max[NUMDIMS],
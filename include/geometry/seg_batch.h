@@ -0,0 +1,122 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __SEG_BATCH_H
+#define __SEG_BATCH_H
+
+#include <geometry/seg.h>
+
+struct SEG_BATCH_KERNELS;
+
+/**
+ * Class SEG_BATCH
+ *
+ * Distance and collision queries of one point or segment against a batch of segments.  The
+ * segments are given as two arrays of start and end points, which may overlap: the segments
+ * of a line chain are a batch of its points and the same points shifted by one.
+ *
+ * The queries use SSE4.2 or AVX2 where the CPU supports them, and give exactly the same
+ * results as the SEG methods they stand for.
+ */
+class SEG_BATCH
+{
+public:
+    /// Implementations of the queries
+    enum KERNEL
+    {
+        SCALAR,     ///< The SEG methods, one segment at a time
+        SSE42,
+        AVX2
+    };
+
+    /**
+     * Constructor
+     * Creates a batch of the aCount segments from aA[i] to aB[i], which must outlive it.
+     */
+    SEG_BATCH( const VECTOR2I* aA, const VECTOR2I* aB, int aCount,
+               KERNEL aKernel = BestKernel() );
+
+    int Size() const
+    {
+        return m_count;
+    }
+
+    const SEG Segment( int aIndex ) const
+    {
+        return SEG( m_a[aIndex], m_b[aIndex], aIndex );
+    }
+
+    /**
+     * Function SquaredDistances()
+     *
+     * Computes SEG::SquaredDistance( aP ) for each segment of the batch.
+     * @param aDist receives the Size() distances
+     */
+    void SquaredDistances( const VECTOR2I& aP, SEG::ecoord* aDist ) const;
+
+    /**
+     * Function SquaredDistance()
+     *
+     * @return the smallest squared distance between aP and the segments of the batch,
+     * VECTOR2I::ECOORD_MAX if the batch is empty.
+     */
+    SEG::ecoord SquaredDistance( const VECTOR2I& aP ) const;
+
+    /**
+     * Function Collide()
+     *
+     * Finds the first segment of the batch for which SEG::Collide( aSeg, aClearance ) is true.
+     * @param aFirst is the index to start the search from
+     * @return the index of the segment, or -1 if none collides.
+     */
+    int Collide( const SEG& aSeg, int aClearance, int aFirst = 0 ) const;
+
+    /**
+     * Function SquaredDistances()
+     *
+     * Computes aSeg.SquaredDistance( aPoints[i] ) for aCount points.
+     */
+    static void SquaredDistances( const SEG& aSeg, const VECTOR2I* aPoints, int aCount,
+                                  SEG::ecoord* aDist, KERNEL aKernel = BestKernel() );
+
+    /// The fastest implementation supported by this build and CPU
+    static KERNEL BestKernel();
+
+    /// Whether an implementation is supported by this build and CPU
+    static bool HasKernel( KERNEL aKernel );
+
+private:
+    static const SEG_BATCH_KERNELS* kernels( KERNEL aKernel );
+
+    void squaredDistances( const VECTOR2I& aP, int aFirst, int aCount,
+                           SEG::ecoord* aDist ) const;
+
+    const VECTOR2I* m_a;
+    const VECTOR2I* m_b;
+    int             m_count;
+
+    ///> Vector kernels, or nullptr to use SEG
+    const SEG_BATCH_KERNELS* m_kernels;
+};
+
+#endif // __SEG_BATCH_H
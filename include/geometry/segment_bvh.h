@@ -0,0 +1,226 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __SEGMENT_BVH_H
+#define __SEGMENT_BVH_H
+
+#include <math/box2.h>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+class SHAPE_LINE_CHAIN;
+
+/**
+ * Class SEGMENT_BVH
+ *
+ * A bounding volume hierarchy over the segments of a line chain, used to speed up the
+ * collision, distance and point-inside queries on large line chains.
+ *
+ * As consecutive segments of a line chain are close to each other, the hierarchy is built
+ * over runs of consecutive segments, without sorting: the leaves are the bounding boxes of
+ * LEAF_SIZE consecutive segments, and each node above the leaves bounds FANOUT nodes of the
+ * level below.  The tree is walked in segment order, so the first segment found by a query
+ * is the one with the lowest index.
+ *
+ * The hierarchy is immutable: it must be rebuilt when the line chain changes.
+ */
+class SEGMENT_BVH
+{
+public:
+    SEGMENT_BVH( const SHAPE_LINE_CHAIN& aChain );
+
+    /**
+     * Function Query()
+     *
+     * Visits the segments whose bounding boxes may be accepted by aAccept.
+     *
+     * @param aAccept is called with the bounding box of each node (down to the leaves).  When
+     *      it returns false, none of the segments in the node are visited.
+     * @param aVisitor is called with the index of each visited segment, in ascending order.
+     *      The query stops when it returns false.
+     * @return false if the query was stopped by aVisitor.
+     */
+    template <class ACCEPT, class VISITOR>
+    bool Query( ACCEPT aAccept, VISITOR aVisitor ) const
+    {
+        return QueryLeaves( aAccept,
+                [&]( int aFirst, int aLast )
+                {
+                    for( int i = aFirst; i < aLast; i++ )
+                    {
+                        if( !aVisitor( i ) )
+                            return false;
+                    }
+
+                    return true;
+                } );
+    }
+
+    /**
+     * Function QueryLeaves()
+     *
+     * Same as Query(), but visits the segments of each accepted leaf at once.
+     *
+     * @param aVisitor is called with the index of the first segment of the leaf and the index
+     *      past its last segment.  The query stops when it returns false.
+     */
+    template <class ACCEPT, class VISITOR>
+    bool QueryLeaves( ACCEPT aAccept, VISITOR aVisitor ) const
+    {
+        int top = m_levels.size() - 1;
+
+        for( int i = 0; i < (int) m_levels[top].size(); i++ )
+        {
+            if( !queryNode( top, i, aAccept, aVisitor ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Function QueryNearest()
+     *
+     * Finds the smallest value of a distance over the segments, visiting the nodes nearest
+     * first and skipping the nodes that can not hold a segment nearer than the nearest one
+     * found so far.  The segments are not visited in order.
+     *
+     * @param aBoxDistance is called with the bounding box of each node, and returns a lower
+     *      bound of the distance of the segments in the node.
+     * @param aDistance is called with the index of the first segment of each visited leaf
+     *      and the index past its last segment, and returns their smallest distance.
+     * @param aNearest is the initial distance: only the segments nearer than it are found.
+     * @return the smallest distance found, or aNearest if no segment is nearer.
+     */
+    template <class BOX_DISTANCE, class DISTANCE, class T>
+    T QueryNearest( BOX_DISTANCE aBoxDistance, DISTANCE aDistance, T aNearest ) const
+    {
+        int top = m_levels.size() - 1;
+
+        nearestNode( top, 0, m_levels[top].size(), aBoxDistance, aDistance, aNearest );
+
+        return aNearest;
+    }
+
+    /// Bounding box of the line chain the hierarchy was built for
+    const BOX2I& BBox() const
+    {
+        return m_bbox;
+    }
+
+    /// Number of segments of the line chain the hierarchy was built for
+    int SegmentCount() const
+    {
+        return m_segmentCount;
+    }
+
+    /// The segments of a chain are only indexed from this count
+    static const int MIN_SEGMENTS = 32;
+
+private:
+    static const int LEAF_SIZE = 8;
+    static const int FANOUT = 8;
+
+    template <class ACCEPT, class VISITOR>
+    bool queryNode( int aLevel, int aNode, ACCEPT& aAccept, VISITOR& aVisitor ) const
+    {
+        if( !aAccept( m_levels[aLevel][aNode] ) )
+            return true;
+
+        if( aLevel == 0 )
+        {
+            int last = std::min( ( aNode + 1 ) * LEAF_SIZE, m_segmentCount );
+
+            return aVisitor( aNode * LEAF_SIZE, last );
+        }
+
+        int last = std::min( ( aNode + 1 ) * FANOUT, (int) m_levels[aLevel - 1].size() );
+
+        for( int i = aNode * FANOUT; i < last; i++ )
+        {
+            if( !queryNode( aLevel - 1, i, aAccept, aVisitor ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    template <class BOX_DISTANCE, class DISTANCE, class T>
+    void nearestNode( int aLevel, int aFirst, int aLast, BOX_DISTANCE& aBoxDistance,
+                      DISTANCE& aDistance, T& aNearest ) const
+    {
+        // A node has at most FANOUT children, and the top level at most FANOUT nodes
+        assert( aLast - aFirst <= FANOUT );
+
+        std::pair<T, int> children[FANOUT];
+        int count = 0;
+        int end = std::min( aLast, aFirst + FANOUT );
+
+        // Insertion sort of the (at most FANOUT) children, nearest first
+        for( int i = aFirst; i < end; i++ )
+        {
+            T d = aBoxDistance( m_levels[aLevel][i] );
+
+            if( !( d < aNearest ) )
+                continue;
+
+            int c = count++;
+
+            for( ; c > 0 && d < children[c - 1].first; c-- )
+                children[c] = children[c - 1];
+
+            children[c] = std::make_pair( d, i );
+        }
+
+        for( int c = 0; c < count && children[c].first < aNearest; c++ )
+        {
+            int node = children[c].second;
+
+            if( aLevel == 0 )
+            {
+                int last = std::min( ( node + 1 ) * LEAF_SIZE, m_segmentCount );
+
+                aNearest = std::min( aNearest, aDistance( node * LEAF_SIZE, last ) );
+            }
+            else
+            {
+                int last = std::min( ( node + 1 ) * FANOUT, (int) m_levels[aLevel - 1].size() );
+
+                nearestNode( aLevel - 1, node * FANOUT, last, aBoxDistance, aDistance,
+                             aNearest );
+            }
+        }
+    }
+
+    int m_segmentCount;
+
+    BOX2I m_bbox;
+
+    /// Node bounding boxes, from the leaves (level 0) to the top level
+    std::vector<std::vector<BOX2I>> m_levels;
+};
+
+#endif // __SEGMENT_BVH_H
@@ -338,17 +338,21 @@ void SHAPE_INDEX<T>::Reindex()
     RTree<T, int, 2, double>* newTree;
     newTree = new RTree<T, int, 2, double>();
 
-    Iterator iter = this->Begin();
-
-    while( !iter.IsNull() )
-    {
-        T shape = *iter;
-        BOX2I box = boundingBox( shape );
-        int min[2] = { box.GetX(), box.GetY() };
-        int max[2] = { box.GetRight(), box.GetBottom() };
-        newTree->Insert( min, max, shape );
-        iter++;
-    }
+    std::vector<T> shapes;
+
+    for( Iterator iter = this->Begin(); !iter.IsNull(); iter++ )
+        shapes.push_back( *iter );
+
+    newTree->BulkInsert( shapes.size(), [&]( size_t aIndex, int aMin[2], int aMax[2], T& aData )
+                                        {
+                                            aData = shapes[aIndex];
+
+                                            BOX2I box = boundingBox( aData );
+                                            aMin[0] = box.GetX();
+                                            aMin[1] = box.GetY();
+                                            aMax[0] = box.GetRight();
+                                            aMax[1] = box.GetBottom();
+                                        } );
 
     delete this->m_tree;
     this->m_tree = newTree;
@@ -26,6 +26,8 @@
 #ifndef __SHAPE_LINE_CHAIN
 #define __SHAPE_LINE_CHAIN
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <sstream>
 
@@ -34,6 +36,7 @@
 #include <math/vector2d.h>
 #include <geometry/shape.h>
 #include <geometry/seg.h>
+#include <geometry/segment_bvh.h>
 
 #include <clipper.hpp>
 
@@ -82,8 +85,23 @@ public:
      * Copy Constructor
      */
     SHAPE_LINE_CHAIN( const SHAPE_LINE_CHAIN& aShape ) :
-        SHAPE( SH_LINE_CHAIN ), m_points( aShape.m_points ), m_closed( aShape.m_closed )
-    {}
+        SHAPE( SH_LINE_CHAIN ), m_points( aShape.m_points ), m_closed( aShape.m_closed ),
+        m_segmentIndex( std::atomic_load( &aShape.m_segmentIndex ) )
+    {
+        copyCachedBBox( aShape );
+    }
+
+    SHAPE_LINE_CHAIN& operator=( const SHAPE_LINE_CHAIN& aShape )
+    {
+        m_points = aShape.m_points;
+        m_closed = aShape.m_closed;
+
+        // The caches only depend on the points, so they can be shared
+        copyCachedBBox( aShape );
+        m_segmentIndex = std::atomic_load( &aShape.m_segmentIndex );
+
+        return *this;
+    }
 
     /**
      * Constructor
@@ -150,6 +168,7 @@ public:
     {
         m_points.clear();
         m_closed = false;
+        invalidateCaches();
     }
 
     /**
@@ -161,6 +180,9 @@ public:
      */
     void SetClosed( bool aClosed )
     {
+        if( aClosed != m_closed )
+            invalidateCaches();
+
         m_closed = aClosed;
     }
 
@@ -243,12 +265,15 @@ public:
     /**
      * Function Point()
      *
-     * Returns a reference to a given point in the line chain.
+     * Returns a reference to a given point in the line chain.  As the point may be modified
+     * through the reference, the reference must not be kept across queries on the chain.
      * @param aIndex index of the point
      * @return reference to the point
      */
     VECTOR2I& Point( int aIndex )
     {
+        invalidateCaches();
+
         if( aIndex < 0 )
             aIndex += PointCount();
 
@@ -282,6 +307,7 @@ public:
      */
     VECTOR2I& LastPoint()
     {
+        invalidateCaches();
         return m_points[PointCount() - 1];
     }
 
@@ -296,8 +322,7 @@ public:
     /// @copydoc SHAPE::BBox()
     const BOX2I BBox( int aClearance = 0 ) const override
     {
-        BOX2I bbox;
-        bbox.Compute( m_points );
+        BOX2I bbox = cachedBBox();
 
         if( aClearance != 0 )
             bbox.Inflate( aClearance );
@@ -334,6 +359,17 @@ public:
      */
     int Distance( const VECTOR2I& aP, bool aOutlineOnly = false ) const;
 
+    /**
+     * Function Distance()
+     *
+     * Computes the minimum distance between the line chain and a segment aSeg.
+     * @param aSeg the segment
+     * @param aOutlineOnly true to ignore the inside of a closed line chain: only the distance
+     * to its edges is computed.  Otherwise, the distance is 0 if aSeg.A is inside.
+     * @return minimum distance.
+     */
+    int Distance( const SEG& aSeg, bool aOutlineOnly = false ) const;
+
     /**
      * Function Reverse()
      *
@@ -377,13 +413,10 @@ public:
      */
     void Append( const VECTOR2I& aP, bool aAllowDuplication = false )
     {
-        if( m_points.size() == 0 )
-            m_bbox = BOX2I( aP, VECTOR2I( 0, 0 ) );
-
         if( m_points.size() == 0 || aAllowDuplication || CPoint( -1 ) != aP )
         {
             m_points.push_back( aP );
-            m_bbox.Merge( aP );
+            invalidateCaches();
         }
     }
 
@@ -398,23 +431,20 @@ public:
         if( aOtherLine.PointCount() == 0 )
             return;
 
-        else if( PointCount() == 0 || aOtherLine.CPoint( 0 ) != CPoint( -1 ) )
+        invalidateCaches();
+
+        if( PointCount() == 0 || aOtherLine.CPoint( 0 ) != CPoint( -1 ) )
         {
-            const VECTOR2I p = aOtherLine.CPoint( 0 );
-            m_points.push_back( p );
-            m_bbox.Merge( p );
+            m_points.push_back( aOtherLine.CPoint( 0 ) );
         }
 
         for( int i = 1; i < aOtherLine.PointCount(); i++ )
-        {
-            const VECTOR2I p = aOtherLine.CPoint( i );
-            m_points.push_back( p );
-            m_bbox.Merge( p );
-        }
+            m_points.push_back( aOtherLine.CPoint( i ) );
     }
 
     void Insert( int aVertex, const VECTOR2I& aP )
     {
+        invalidateCaches();
         m_points.insert( m_points.begin() + aVertex, aP );
     }
 
@@ -656,6 +686,8 @@ public:
 
     void Move( const VECTOR2I& aVector ) override
     {
+        invalidateCaches();
+
         for( std::vector<VECTOR2I>::iterator i = m_points.begin(); i != m_points.end(); ++i )
             (*i) += aVector;
     }
@@ -678,14 +710,41 @@ public:
     double Area() const;
 
 private:
+    /**
+     * Returns the index of the segments of the line chain, building it if needed, or
+     * nullptr if the chain is too small to need one.
+     */
+    std::shared_ptr<const SEGMENT_BVH> segmentIndex() const;
+
+    /// Returns the bounding box of the points, computing it if it is not cached
+    const BOX2I cachedBBox() const;
+
+    /// Takes the cached bounding box of aOther, if any
+    void copyCachedBBox( const SHAPE_LINE_CHAIN& aOther );
+
+    /// Drops the cached bounding box and segment index: must be called whenever the
+    /// points change
+    void invalidateCaches()
+    {
+        m_bboxValid.store( false, std::memory_order_relaxed );
+
+        if( m_segmentIndex )
+            m_segmentIndex.reset();
+    }
+
     /// array of vertices
     std::vector<VECTOR2I> m_points;
 
     /// is the line chain closed?
     bool m_closed;
 
-    /// cached bounding box
-    BOX2I m_bbox;
+    /// cached bounding box (origin and size), only valid when m_bboxValid is set.  Several
+    /// threads may compute it at the same time: they store the same values.
+    mutable std::atomic<int>  m_bboxCache[4];
+    mutable std::atomic<bool> m_bboxValid { false };
+
+    /// segment index, built on the first query on a large chain (see segmentIndex())
+    mutable std::shared_ptr<const SEGMENT_BVH> m_segmentIndex;
 };
 
 #endif // __SHAPE_LINE_CHAIN
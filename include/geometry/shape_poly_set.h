@@ -849,6 +849,60 @@ class SHAPE_POLY_SET : public SHAPE
         ///> For aFastMode meaning, see function booleanOp
         void Simplify( POLYGON_MODE aFastMode );
 
+        /**
+         * Class PIPELINE
+         *
+         * Chains boolean operations, simplifications and inflations on a copy of a polygon
+         * set.  Between the operations, the polygons stay in the Clipper representation, and
+         * the Clipper result tree is reused, instead of converting the polygons to and from
+         * SHAPE_LINE_CHAINs for each operation.  The result is the same as running the same
+         * operations on the polygon set; without any operation, the contours are only
+         * reoriented, as for any Clipper operation.
+         */
+        class PIPELINE
+        {
+        public:
+            PIPELINE( const SHAPE_POLY_SET& aPolySet );
+
+            PIPELINE( const PIPELINE& ) = delete;
+            PIPELINE& operator=( const PIPELINE& ) = delete;
+
+            ///> @copydoc SHAPE_POLY_SET::BooleanAdd()
+            PIPELINE& BooleanAdd( const PIPELINE& b, POLYGON_MODE aFastMode );
+
+            ///> @copydoc SHAPE_POLY_SET::BooleanSubtract()
+            PIPELINE& BooleanSubtract( const PIPELINE& b, POLYGON_MODE aFastMode );
+
+            ///> @copydoc SHAPE_POLY_SET::BooleanIntersection()
+            PIPELINE& BooleanIntersection( const PIPELINE& b, POLYGON_MODE aFastMode );
+
+            ///> @copydoc SHAPE_POLY_SET::Inflate()
+            PIPELINE& Inflate( int aFactor, int aCircleSegmentsCount );
+
+            ///> @copydoc SHAPE_POLY_SET::Simplify()
+            PIPELINE& Simplify( POLYGON_MODE aFastMode );
+
+            ///> Converts the current polygons to a polygon set
+            SHAPE_POLY_SET Result() const;
+
+        private:
+            void booleanOp( ClipperLib::ClipType aType, const PIPELINE& aOther,
+                            POLYGON_MODE aFastMode );
+
+            ///> Takes the polygons from m_tree, in the order of SHAPE_POLY_SET::importTree()
+            void importTree();
+
+            ///> The contours of all polygons, outlines followed by their holes, oriented
+            ///> as SHAPE_LINE_CHAIN::convertToClipper() does
+            ClipperLib::Paths m_paths;
+
+            ///> Number of contours of each polygon
+            std::vector<int> m_contourCounts;
+
+            ///> Result of the last operation, kept to reuse its storage
+            ClipperLib::PolyTree m_tree;
+        };
+
         /**
          * Function NormalizeAreaOutlines
          * Convert a self-intersecting polygon to one (or more) non self-intersecting polygon(s)
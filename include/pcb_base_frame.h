@@ -79,6 +79,8 @@ protected:
 
     PCB_GENERAL_SETTINGS m_configSettings;
 
+    LSET                 m_3DDirtyLayers;   // Layers changed by the pending 3D view update
+
     void updateZoomSelectBox();
     virtual void unitsChangeRefresh() override;
 
@@ -115,6 +117,13 @@ public:
      */
     bool Update3DView( const wxString* aTitle = nullptr );
 
+    /**
+     * Set the layers changed by the board items of the next OnModify(), so the 3D view
+     * only rebuilds these layers. An empty set rebuilds the full 3D view.
+     * @param aLayers = the layers of the changed items
+     */
+    void Set3DDirtyLayers( const LSET& aLayers ) { m_3DDirtyLayers = aLayers; }
+
     /**
      * Function LoadFootprint
      * attempts to load \a aFootprintId from the footprint library table.
@@ -29,6 +29,7 @@
 #ifndef IFSG_API_H
 #define IFSG_API_H
 
+#include <string>
 #include "plugins/3dapi/sg_types.h"
 #include "plugins/3dapi/sg_base.h"
 #include "plugins/3dapi/c3dmodel.h"
@@ -83,6 +84,34 @@ namespace S3D
     SGLIB_API SGNODE* ReadCache( const char* aFileName, void* aPluginMgr,
         bool (*aTagCheck)( const char*, void* ) );
 
+    /**
+     * Function WriteModelCache
+     * writes the render data of a model to a flat binary cache file: the material,
+     * vertex and index arrays are stored as they are in memory, 32 bit aligned, so
+     * that reading them back needs no parsing
+     *
+     * @param aFileName is the name of the file to write
+     * @param aModel is the render data to write
+     * @param aPluginInfo is the PluginName:Version string of the plugin which loaded the model
+     * @return true on success
+     */
+    SGLIB_API bool WriteModelCache( const char* aFileName, const S3DMODEL* aModel,
+        const char* aPluginInfo );
+
+    /**
+     * Function ReadModelCache
+     * reads a flat binary cache file written by WriteModelCache()
+     *
+     * @param aFileName is the name of the cache file to be read
+     * @param aPluginMgr and aTagCheck check the plugin tag stored in the file, as in ReadCache()
+     * @param aPluginInfo receives the PluginName:Version string stored in the file
+     * @return NULL on failure (including a file written by another plugin version or
+     * on a platform with another data layout), on success the render data, to be
+     * released with Destroy3DModel()
+     */
+    SGLIB_API S3DMODEL* ReadModelCache( const char* aFileName, void* aPluginMgr,
+        bool (*aTagCheck)( const char*, void* ), std::string& aPluginInfo );
+
     /**
      * Function WriteVRML
      * writes out the given node and its subnodes to a VRML2 file
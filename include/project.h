@@ -209,6 +209,7 @@ public:
         ELEM_SCH_SEARCH_STACK,
         ELEM_3DCACHE,
         ELEM_SYMBOL_LIB_TABLE,
+        ELEM_SCH_RESOLVED_PARTS,
 
         ELEM_COUNT
     };
@@ -25,6 +25,8 @@
 #ifndef __VIEW_RTREE_H
 #define __VIEW_RTREE_H
 
+#include <vector>
+
 #include <math/box2.h>
 
 #include <geometry/rtree.h>
@@ -45,14 +47,12 @@ public:
     /**
      * Function Insert()
      * Inserts an item into the tree. Item's bounding box is taken via its ViewBBox() method.
+     * The insertion is deferred until the next query or removal, so that the items added
+     * in a row (e.g. when loading a board) are packed into the tree at once.
      */
     void Insert( VIEW_ITEM* aItem )
     {
-        const BOX2I&    bbox    = aItem->ViewBBox();
-        const int       mmin[2] = { bbox.GetX(), bbox.GetY() };
-        const int       mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
-
-        VIEW_RTREE_BASE::Insert( mmin, mmax, aItem );
+        m_pending.emplace_back( aItem, aItem->ViewBBox() );
     }
 
     /**
@@ -62,6 +62,8 @@ public:
      */
     void Remove( VIEW_ITEM* aItem )
     {
+        flush();
+
         // const BOX2I&    bbox    = aItem->ViewBBox();
 
         // FIXME: use cached bbox or ptr_map to speed up pointer <-> node lookups.
@@ -79,6 +81,8 @@ public:
     template <class Visitor>
     void Query( const BOX2I& aBounds, Visitor& aVisitor )    // const
     {
+        flush();
+
         int   mmin[2] = { aBounds.GetX(), aBounds.GetY() };
         int   mmax[2] = { aBounds.GetRight(), aBounds.GetBottom() };
 
@@ -98,7 +102,41 @@ public:
         VIEW_RTREE_BASE::Search( mmin, mmax, aVisitor );
     }
 
+    /**
+     * Function RemoveAll()
+     * Removes all items from the tree.
+     */
+    void RemoveAll()
+    {
+        m_pending.clear();
+        VIEW_RTREE_BASE::RemoveAll();
+    }
+
 private:
+
+    ///> Adds the pending items to the tree
+    void flush()
+    {
+        if( m_pending.empty() )
+            return;
+
+        BulkInsert( m_pending.size(),
+                    [&]( size_t aIndex, int aMin[2], int aMax[2], VIEW_ITEM*& aItem )
+                    {
+                        const BOX2I& bbox = m_pending[aIndex].second;
+
+                        aItem   = m_pending[aIndex].first;
+                        aMin[0] = bbox.GetX();
+                        aMin[1] = bbox.GetY();
+                        aMax[0] = bbox.GetRight();
+                        aMax[1] = bbox.GetBottom();
+                    } );
+
+        m_pending.clear();
+    }
+
+    ///> Items inserted since the last query or removal, with their bounding boxes
+    std::vector<std::pair<VIEW_ITEM*, BOX2I>> m_pending;
 };
 } // namespace KIGFX
 
@@ -24,6 +24,7 @@
 
 #include <class_board.h>
 #include <class_module.h>
+#include <class_pad.h>
 #include <pcb_edit_frame.h>
 #include <tool/tool_manager.h>
 #include <view/view.h>
@@ -37,6 +38,28 @@ using namespace std::placeholders;
 
 #include "pcb_draw_panel_gal.h"
 
+// The layers where a board item, or the items of a module, are drawn
+static LSET itemLayers( const BOARD_ITEM* aItem )
+{
+    if( aItem->Type() != PCB_MODULE_T )
+        return aItem->GetLayerSet();
+
+    const MODULE* module = static_cast<const MODULE*>( aItem );
+    LSET layers;
+
+    for( const D_PAD* pad = module->PadsList(); pad; pad = pad->Next() )
+        layers |= pad->GetLayerSet();
+
+    for( const BOARD_ITEM* item = module->GraphicalItemsList(); item; item = item->Next() )
+        layers |= item->GetLayerSet();
+
+    layers.set( module->Reference().GetLayer() );
+    layers.set( module->Value().GetLayer() );
+
+    return layers;
+}
+
+
 BOARD_COMMIT::BOARD_COMMIT( PCB_TOOL* aTool )
 {
     m_toolMgr = aTool->GetManager();
@@ -66,6 +89,7 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
     auto              connectivity = board->GetConnectivity();
     std::set<EDA_ITEM*>      savedModules;
     std::vector<BOARD_ITEM*> itemsToDeselect;
+    LSET                     changedLayers;     // Layers the 3D viewer has to rebuild
 
     if( Empty() )
         return;
@@ -108,6 +132,18 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
             }
         }
 
+        // The polygons cached for the item (or its module) are no longer valid
+        static_cast<BOARD_ITEM*>( ent.m_item )->ClearCachedShapes();
+
+        // Both the old and the new state of the item have to be redrawn
+        if( !m_editModules )
+        {
+            changedLayers |= itemLayers( boardItem );
+
+            if( ent.m_copy )
+                changedLayers |= itemLayers( static_cast<BOARD_ITEM*>( ent.m_copy ) );
+        }
+
         switch( changeType )
         {
             case CHT_ADD:
@@ -270,7 +306,11 @@ void BOARD_COMMIT::Push( const wxString& aMessage, bool aCreateUndoEntry, bool a
     }
 
     if( aSetDirtyBit )
+    {
+        frame->Set3DDirtyLayers( changedLayers );
         frame->OnModify();
+        frame->Set3DDirtyLayers( LSET() );
+    }
 
     frame->UpdateMsgPanel();
 
@@ -342,6 +382,7 @@ void BOARD_COMMIT::Revert()
 
             item->SwapData( copy );
             item->ClearFlags( SELECTED );
+            item->ClearCachedShapes();
 
             // Update all pads/drawings/texts, as they become invalid
             // for the VIEW after SwapData() called for modules
@@ -59,7 +59,6 @@ struct TSEGM_2_POLY_PRMS {
     int m_textCircle2SegmentCount;
     SHAPE_POLY_SET* m_cornerBuffer;
 };
-TSEGM_2_POLY_PRMS prms;
 
 // The max error is the distance between the middle of a segment, and the circle
 // for circle/arc to segment approximation.
@@ -89,7 +88,7 @@ void BOARD::ConvertBrdLayerToPolygonalContours( PCB_LAYER_ID aLayer, SHAPE_POLY_
         if( !track->IsOnLayer( aLayer ) )
             continue;
 
-        track->TransformShapeWithClearanceToPolygon( aOutlines,
+        track->TransformShapeWithClearanceToPolygonCached( aOutlines,
                 0, segcountforcircle, correctionFactor );
     }
 
@@ -124,7 +123,7 @@ void BOARD::ConvertBrdLayerToPolygonalContours( PCB_LAYER_ID aLayer, SHAPE_POLY_
         switch( item->Type() )
         {
         case PCB_LINE_T:
-            ( (DRAWSEGMENT*) item )->TransformShapeWithClearanceToPolygon(
+            ( (DRAWSEGMENT*) item )->TransformShapeWithClearanceToPolygonCached(
                 aOutlines, 0, segcountforcircle, correctionFactor );
             break;
 
@@ -266,6 +265,7 @@ void MODULE::TransformGraphicShapesWithClearanceToPolygonSet(
     if( Value().GetLayer() == aLayer && Value().IsVisible() )
         texts.push_back( &Value() );
 
+    TSEGM_2_POLY_PRMS prms;
     prms.m_cornerBuffer = &aCornerBuffer;
 
     // To allow optimization of circles approximated by segments,
@@ -335,6 +335,7 @@ void MODULE::TransformGraphicTextWithClearanceToPolygonSet(
     if( Value().GetLayer() == aLayer && Value().IsVisible() )
         texts.push_back( &Value() );
 
+    TSEGM_2_POLY_PRMS prms;
     prms.m_cornerBuffer = &aCornerBuffer;
 
     // To allow optimization of circles approximated by segments,
@@ -465,6 +466,7 @@ void TEXTE_PCB::TransformShapeWithClearanceToPolygonSet(
     if( IsMirrored() )
         size.x = -size.x;
 
+    TSEGM_2_POLY_PRMS prms;
     prms.m_cornerBuffer = &aCornerBuffer;
     prms.m_textWidth  = GetThickness() + ( 2 * aClearanceValue );
     prms.m_textCircle2SegmentCount = aCircleToSegmentsCount;
@@ -1374,10 +1376,13 @@ void    CreateThermalReliefPadPolygon( SHAPE_POLY_SET& aCornerBuffer,
         }
 
         stubs.Append( stub );
-        stubs.Simplify( SHAPE_POLY_SET::PM_FAST );
 
-        antipad.BooleanSubtract( stubs, SHAPE_POLY_SET::PM_FAST );
-        aCornerBuffer.Append( antipad );
+        SHAPE_POLY_SET::PIPELINE stubsPipeline( stubs );
+        stubsPipeline.Simplify( SHAPE_POLY_SET::PM_FAST );
+
+        SHAPE_POLY_SET::PIPELINE antipadPipeline( antipad );
+        antipadPipeline.BooleanSubtract( stubsPipeline, SHAPE_POLY_SET::PM_FAST );
+        aCornerBuffer.Append( antipadPipeline.Result() );
 
         break;
         }
@@ -34,6 +34,7 @@
 #include <wx/debug.h>
 
 #include <class_board.h>
+#include <geometry/shape_poly_set.h>
 #include <string>
 
 wxString BOARD_ITEM::ShowShape( STROKE_T aShape )
@@ -148,3 +149,106 @@ void BOARD_ITEM::TransformShapeWithClearanceToPolygon( SHAPE_POLY_SET& aCornerBu
 {
     wxASSERT_MSG( false, "Called TransformShapeWithClearanceToPolygon() on unsupported BOARD_ITEM." );
 };
+
+
+struct BOARD_ITEM_SHAPE_CACHE::ENTRY
+{
+    bool SameKey( const ENTRY& aOther ) const
+    {
+        return m_clearance == aOther.m_clearance
+                && m_circleToSegmentsCount == aOther.m_circleToSegmentsCount
+                && m_correctionFactor == aOther.m_correctionFactor
+                && m_ignoreLineWidth == aOther.m_ignoreLineWidth
+                && m_bbox.GetPosition() == aOther.m_bbox.GetPosition()
+                && m_bbox.GetSize() == aOther.m_bbox.GetSize();
+    }
+
+    int            m_clearance;
+    int            m_circleToSegmentsCount;
+    double         m_correctionFactor;
+    bool           m_ignoreLineWidth;
+    EDA_RECT       m_bbox;
+    SHAPE_POLY_SET m_shape;
+};
+
+
+std::shared_ptr<const BOARD_ITEM_SHAPE_CACHE::ENTRY> BOARD_ITEM_SHAPE_CACHE::Find(
+        const ENTRY& aKey ) const
+{
+    std::shared_ptr<const ENTRIES> entries = std::atomic_load( &m_entries );
+
+    if( entries )
+    {
+        for( const auto& entry : *entries )
+        {
+            if( entry->SameKey( aKey ) )
+                return entry;
+        }
+    }
+
+    return nullptr;
+}
+
+
+void BOARD_ITEM_SHAPE_CACHE::Add( const std::shared_ptr<const ENTRY>& aEntry )
+{
+    // The zone filler, the plotter and the 3D viewer use a few parameter sets at most
+    const size_t maxEntries = 4;
+
+    std::shared_ptr<const ENTRIES> entries = std::atomic_load( &m_entries );
+    auto newEntries = std::make_shared<ENTRIES>();
+
+    if( entries )
+    {
+        size_t first = entries->size() < maxEntries ? 0 : entries->size() - maxEntries + 1;
+        newEntries->assign( entries->begin() + first, entries->end() );
+    }
+
+    newEntries->push_back( aEntry );
+
+    // Another thread may have added an entry meanwhile: one of them is lost, which only
+    // costs building it again
+    std::atomic_store( &m_entries, std::shared_ptr<const ENTRIES>( std::move( newEntries ) ) );
+}
+
+
+void BOARD_ITEM_SHAPE_CACHE::Clear()
+{
+    std::atomic_store( &m_entries, std::shared_ptr<const ENTRIES>() );
+}
+
+
+void BOARD_ITEM::TransformShapeWithClearanceToPolygonCached( SHAPE_POLY_SET& aCornerBuffer,
+                                                             int aClearanceValue,
+                                                             int aCircleToSegmentsCount,
+                                                             double aCorrectionFactor,
+                                                             bool ignoreLineWidth ) const
+{
+    if( Type() == PCB_ZONE_AREA_T )
+    {
+        TransformShapeWithClearanceToPolygon( aCornerBuffer, aClearanceValue,
+                                              aCircleToSegmentsCount, aCorrectionFactor,
+                                              ignoreLineWidth );
+        return;
+    }
+
+    auto entry = std::make_shared<BOARD_ITEM_SHAPE_CACHE::ENTRY>();
+    entry->m_clearance = aClearanceValue;
+    entry->m_circleToSegmentsCount = aCircleToSegmentsCount;
+    entry->m_correctionFactor = aCorrectionFactor;
+    entry->m_ignoreLineWidth = ignoreLineWidth;
+    entry->m_bbox = GetBoundingBox();
+
+    if( auto cached = m_shapeCache.Find( *entry ) )
+    {
+        aCornerBuffer.Append( cached->m_shape );
+        return;
+    }
+
+    TransformShapeWithClearanceToPolygon( entry->m_shape, aClearanceValue,
+                                          aCircleToSegmentsCount, aCorrectionFactor,
+                                          ignoreLineWidth );
+    aCornerBuffer.Append( entry->m_shape );
+
+    m_shapeCache.Add( entry );
+}
@@ -906,6 +906,13 @@ void MODULE::RunOnChildren( const std::function<void (BOARD_ITEM*)>& aFunction )
 }
 
 
+void MODULE::ClearCachedShapes()
+{
+    BOARD_ITEM::ClearCachedShapes();
+    RunOnChildren( []( BOARD_ITEM* aItem ) { aItem->ClearCachedShapes(); } );
+}
+
+
 void MODULE::GetAllDrawingLayers( int aLayers[], int& aCount, bool aIncludePads ) const
 {
     std::unordered_set<int> layers;
@@ -611,6 +611,12 @@ public:
      */
     void RunOnChildren( const std::function<void (BOARD_ITEM*)>& aFunction );
 
+    /**
+     * Function ClearCachedShapes
+     * Forgets the polygons cached for the module and all its pads, drawings and texts.
+     */
+    void ClearCachedShapes() override;
+
     /**
      * Returns a set of all layers that this module has drawings on
      * similar to ViewGetLayers()
@@ -195,6 +195,7 @@ void CN_CONNECTIVITY_ALGO::searchConnections()
     std::vector<CN_ITEM*> garbage;
     garbage.reserve( 1024 );
 
+    m_itemList.IndexItems();
     m_itemList.RemoveInvalidItems( garbage );
 
     for( auto item : garbage )
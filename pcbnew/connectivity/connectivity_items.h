@@ -383,12 +383,15 @@ private:
 
     CN_RTREE<CN_ITEM*> m_index;
 
+    ///> Items added since the last IndexItems() call, not yet in m_index
+    std::vector<CN_ITEM*> m_unindexedItems;
+
 protected:
     std::vector<CN_ITEM*> m_items;
 
     void addItemtoTree( CN_ITEM* item )
     {
-        m_index.Insert( item );
+        m_unindexedItems.push_back( item );
     }
 
 public:
@@ -404,9 +407,22 @@ public:
             delete item;
 
         m_items.clear();
+        m_unindexedItems.clear();
         m_index.RemoveAll();
     }
 
+    /**
+     * Function IndexItems()
+     * Adds the items added since the last call to the spatial index, all at once: when
+     * a whole board is added this packs the index much faster than inserting the items
+     * one by one.  Must be called before FindNearby(), which may run on several threads.
+     */
+    void IndexItems()
+    {
+        m_index.BulkInsert( m_unindexedItems );
+        m_unindexedItems.clear();
+    }
+
     using ITER = decltype(m_items)::iterator;
 
     ITER begin() { return m_items.begin(); };
@@ -417,6 +433,7 @@ public:
     template <class T>
     void FindNearby( CN_ITEM *aItem, T aFunc )
     {
+        assert( m_unindexedItems.empty() );
         m_index.Query( aItem->BBox(), aItem->Layers(), aFunc );
     }
 
@@ -24,6 +24,8 @@
 #ifndef PCBNEW_CONNECTIVITY_RTREE_H_
 #define PCBNEW_CONNECTIVITY_RTREE_H_
 
+#include <vector>
+
 #include <math/box2.h>
 #include <router/pns_layerset.h>
 
@@ -65,6 +67,29 @@ public:
         m_tree->Insert( mmin, mmax, aItem );
     }
 
+    /**
+     * Function BulkInsert()
+     * Inserts several items into the tree, packing them at once if the tree is empty.
+     */
+    void BulkInsert( const std::vector<T>& aItems )
+    {
+        m_tree->BulkInsert( aItems.size(),
+                            [&]( size_t aIndex, int aMin[3], int aMax[3], T& aItem )
+                            {
+                                aItem = aItems[aIndex];
+
+                                const BOX2I&        bbox    = aItem->BBox();
+                                const LAYER_RANGE   layers  = aItem->Layers();
+
+                                aMin[0] = layers.Start();
+                                aMin[1] = bbox.GetX();
+                                aMin[2] = bbox.GetY();
+                                aMax[0] = layers.End();
+                                aMax[1] = bbox.GetRight();
+                                aMax[2] = bbox.GetBottom();
+                            } );
+    }
+
     /**
      * Function Remove()
      * Removes an item from the tree. Removal is done by comparing pointers, attempting
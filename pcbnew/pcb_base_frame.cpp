@@ -169,7 +169,10 @@ bool PCB_BASE_FRAME::Update3DView( const wxString* aTitle )
     if( IsType( FRAME_PCB ) )
         immediate_update = false;
 
-    draw3DFrame->NewDisplay( immediate_update );
+    if( m_3DDirtyLayers.any() )
+        draw3DFrame->UpdateLayers( m_3DDirtyLayers, immediate_update );
+    else
+        draw3DFrame->NewDisplay( immediate_update );
 
     return true;
 }
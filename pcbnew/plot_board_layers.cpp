@@ -842,10 +842,10 @@ void PlotSolderMaskLayer( BOARD *aBoard, PLOTTER* aPlotter,
             if( !( via_set & aLayerMask ).any() )
                 continue;
 
-            via->TransformShapeWithClearanceToPolygon( areas, via_margin,
+            via->TransformShapeWithClearanceToPolygonCached( areas, via_margin,
                     circleToSegmentsCount,
                     correction );
-            via->TransformShapeWithClearanceToPolygon( initialPolys, via_clearance,
+            via->TransformShapeWithClearanceToPolygonCached( initialPolys, via_clearance,
                     circleToSegmentsCount,
                     correction );
         }
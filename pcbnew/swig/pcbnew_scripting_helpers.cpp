@@ -42,6 +42,12 @@
 #include <stdlib.h>
 #include <pcb_draw_panel_gal.h>
 #include <action_plugin.h>
+#include <3d_canvas/cinfo3d_visu.h>
+#include <3d_cache/3d_cache.h>
+#include <3d_rendering/3d_render_raytracing/c3d_render_raytracing.h>
+#include <wx/image.h>
+#include <wx/filename.h>
+#include <memory>
 
 static PCB_EDIT_FRAME* s_PcbEditFrame = NULL;
 
@@ -139,6 +145,105 @@ void WindowZoom( int xl, int yl, int width, int height )
 }
 
 
+bool Render3DImage( BOARD* aBoard, wxString& aFileName, int aWidth, int aHeight,
+                    const wxString& aView, const wxString& aProjectPath )
+{
+    if( !aBoard || aWidth <= 0 || aHeight <= 0 )
+        return false;
+
+    // The 3D models of the running Pcbnew are already in its project cache. Without it (for
+    // instance from a standalone python script), models are loaded by a cache of our own,
+    // which resolves ${KIPRJMOD} from the board folder
+    std::unique_ptr<S3D_CACHE> localCache;
+    S3D_CACHE*                 cache;
+
+    if( s_PcbEditFrame && s_PcbEditFrame->GetBoard() == aBoard )
+    {
+        cache = s_PcbEditFrame->Prj().Get3DCacheManager();
+    }
+    else
+    {
+        localCache.reset( new S3D_CACHE );
+
+        wxFileName cfgpath;
+        cfgpath.AssignDir( GetKicadConfigPath() );
+        cfgpath.AppendDir( wxT( "3d" ) );
+        localCache->Set3DConfigDir( cfgpath.GetFullPath() );
+
+        wxString projectPath = aProjectPath;
+
+        if( projectPath.IsEmpty() )
+            projectPath = wxFileName( aBoard->GetFileName() ).GetPath();
+
+        if( !projectPath.IsEmpty() )
+            localCache->SetProjectDir( projectPath );
+
+        cache = localCache.get();
+    }
+
+    CINFO3D_VISU settings;
+
+    settings.SetBoard( aBoard );
+    settings.RenderEngineSet( RENDER_ENGINE_RAYTRACING );
+
+    // Same defaults as the 3D viewer
+    settings.SetFlag( FL_RENDER_RAYTRACING_SHADOWS, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_BACKFLOOR, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_REFRACTIONS, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_REFLECTIONS, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_POST_PROCESSING, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_ANTI_ALIASING, true );
+    settings.SetFlag( FL_RENDER_RAYTRACING_PROCEDURAL_TEXTURES, true );
+
+    settings.Set3DCacheManager( cache );
+
+    C3D_RENDER_RAYTRACING renderer( settings );
+
+    // The same views as the 3D viewer hotkeys
+    CCAMERA& camera = settings.CameraGet();
+
+    camera.Reset();
+
+    if( aView == wxT( "bottom" ) )
+    {
+        camera.RotateY( glm::radians( 180.0f ) );
+    }
+    else if( aView == wxT( "front" ) )
+    {
+        camera.RotateX( glm::radians( -90.0f ) );
+    }
+    else if( aView == wxT( "back" ) )
+    {
+        camera.RotateX( glm::radians( -90.0f ) );
+        camera.RotateZ( glm::radians( -180.0f ) );
+    }
+    else if( aView == wxT( "right" ) )
+    {
+        camera.RotateZ( glm::radians( -90.0f ) );
+        camera.RotateX( glm::radians( -90.0f ) );
+    }
+    else if( aView == wxT( "left" ) )
+    {
+        camera.RotateZ( glm::radians( 90.0f ) );
+        camera.RotateX( glm::radians( -90.0f ) );
+    }
+    else if( aView != wxT( "top" ) )
+    {
+        return false;
+    }
+
+    wxImage image;
+
+    if( !renderer.RenderToImage( wxSize( aWidth, aHeight ), image, NULL ) )
+        return false;
+
+    if( !wxImage::FindHandler( wxBITMAP_TYPE_PNG ) )
+        wxImage::AddHandler( new wxPNGHandler );
+
+    return image.SaveFile( aFileName, wxBITMAP_TYPE_PNG );
+}
+
+
 void UpdateUserInterface()
 {
     if( s_PcbEditFrame )
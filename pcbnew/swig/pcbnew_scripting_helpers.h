@@ -61,6 +61,23 @@ void    Refresh();
 
 void    WindowZoom( int xl, int yl, int width, int height );
 
+/**
+ * Render the board with the 3D raytracing engine into a .png file, without a window
+ * or an OpenGL context (for automated board renders).
+ * The 3D models are taken from the project cache of the running Pcbnew when the board
+ * is its board, and are loaded by a temporary cache otherwise.
+ * @param aBoard is the board to render
+ * @param aFileName is the .png file to create
+ * @param aWidth and aHeight are the size of the image, in pixels
+ * @param aView is the camera view: "top", "bottom", "front", "back", "left" or "right"
+ * @param aProjectPath is the project folder used to resolve ${KIPRJMOD} in model paths
+ * when there is no running Pcbnew (defaults to the folder of the board file)
+ * @return true on success
+ */
+bool    Render3DImage( BOARD* aBoard, wxString& aFileName, int aWidth, int aHeight,
+                       const wxString& aView = "top",
+                       const wxString& aProjectPath = wxEmptyString );
+
 /**
  * Update the layer manager and other widgets from the board setup
  * (layer and items visibility, colors ...)
@@ -219,6 +219,9 @@ void PCB_BASE_EDIT_FRAME::SaveCopyInUndoList( const PICKED_ITEMS_LIST& aItemsLis
         ITEM_PICKER curr_picker = aItemsList.GetItemWrapper(ii);
         BOARD_ITEM* item    = (BOARD_ITEM*) aItemsList.GetPickedItem( ii );
 
+        // The item is about to be changed
+        item->ClearCachedShapes();
+
         // For items belonging to modules, we need to save state of the parent module
         if( item->Type() == PCB_MODULE_TEXT_T || item->Type() == PCB_MODULE_EDGE_T
                 || item->Type() == PCB_PAD_T )
@@ -456,6 +459,7 @@ void PCB_BASE_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool
         }
 
         item->ClearFlags();
+        item->ClearCachedShapes();
 
         // see if we must rebuild ratsnets and pointers lists
         switch( item->Type() )
@@ -47,6 +47,7 @@
 #include <geometry/shape_file_io.h>
 #include <geometry/convex_hull.h>
 #include <geometry/geometry_utils.h>
+#include <convert_to_biu.h>
 #include <confirm.h>
 
 #include "zone_filler.h"
@@ -83,6 +84,30 @@ static double s_thermalRot = 450;   // angle of stubs in thermal reliefs for rou
 static const bool s_DumpZonesWhenFilling = false;
 
 
+/**
+ * Returns the radius of the smallest arcs of a pad shape inflated by aClearance
+ */
+static int padClearanceArcRadius( const D_PAD* aPad, int aClearance )
+{
+    switch( aPad->GetShape() )
+    {
+    case PAD_SHAPE_CIRCLE:
+        return aPad->GetSize().x / 2 + aClearance;
+
+    case PAD_SHAPE_OVAL:
+        return std::min( aPad->GetSize().x, aPad->GetSize().y ) / 2 + aClearance;
+
+    case PAD_SHAPE_ROUNDRECT:
+    case PAD_SHAPE_CHAMFERED_RECT:
+        return aPad->GetRoundRectCornerRadius() + aClearance;
+
+    default:
+        // The corners of the other shapes are rounded by the clearance only
+        return aClearance;
+    }
+}
+
+
 ZONE_FILLER::ZONE_FILLER(  BOARD* aBoard, COMMIT* aCommit ) :
     m_board( aBoard ), m_commit( aCommit ), m_progressReporter( nullptr )
 {
@@ -137,6 +162,8 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
         zone->UnFill();
     }
 
+    buildTrackIndex();
+
     std::atomic<size_t> nextItem( 0 );
     size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(), toFill.size() );
     std::vector<std::future<size_t>> returns( parallelThreadCount );
@@ -323,6 +350,29 @@ bool ZONE_FILLER::Fill( const std::vector<ZONE_CONTAINER*>& aZones, bool aCheck
 }
 
 
+void ZONE_FILLER::buildTrackIndex()
+{
+    std::vector<TRACK*> tracks;
+    tracks.reserve( m_board->Tracks().Size() );
+
+    for( auto track : m_board->Tracks() )
+        tracks.push_back( track );
+
+    m_trackIndex.Build( tracks.size(),
+            [&]( size_t aIndex, int aMin[2], int aMax[2], TRACK*& aTrack )
+            {
+                aTrack = tracks[aIndex];
+
+                EDA_RECT bbox = aTrack->GetBoundingBox();
+                bbox.Normalize();
+                aMin[0] = bbox.GetX();
+                aMin[1] = bbox.GetY();
+                aMax[0] = bbox.GetRight();
+                aMax[1] = bbox.GetBottom();
+            } );
+}
+
+
 void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
         SHAPE_POLY_SET& aFeatures ) const
 {
@@ -340,6 +390,18 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
      */
     double correctionFactor = GetCircletoPolyCorrectionFactor( segsPerCircle );
 
+    /* Pads and tracks use segsPerCircle only for their largest arcs: smaller arcs,
+     * like the clearance of vias, need fewer segments for the same chord error.
+     * The correction factor follows the segment count of each item.
+     */
+    const int maxError = ARC_HIGH_DEF;
+
+    auto itemArcApprox = [&]( int aArcRadius, int& aSegCount, double& aCorrectionFactor )
+    {
+        aSegCount = GetCircleToSegmentCount( aArcRadius, maxError, segsPerCircle );
+        aCorrectionFactor = GetCircletoPolyCorrectionFactor( aSegCount );
+    };
+
     aFeatures.RemoveAllContours();
 
     int zone_clearance = aZone->GetClearance();
@@ -420,6 +482,11 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
                 if( item_boundingbox.Intersects( zone_boundingbox ) )
                 {
                     int clearance = std::max( zone_clearance, item_clearance );
+                    int padSegsPerCircle;
+                    double padCorrectionFactor;
+
+                    itemArcApprox( padClearanceArcRadius( pad, clearance ), padSegsPerCircle,
+                                   padCorrectionFactor );
 
                     // PAD_SHAPE_CUSTOM can have a specific keepout, to avoid to break the shape
                     if( pad->GetShape() == PAD_SHAPE_CUSTOM
@@ -428,7 +495,8 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
                         // the pad shape in zone can be its convex hull or
                         // the shape itself
                         SHAPE_POLY_SET outline( pad->GetCustomShapeAsPolygon() );
-                        outline.Inflate( KiROUND( clearance * correctionFactor ), segsPerCircle );
+                        outline.Inflate( KiROUND( clearance * padCorrectionFactor ),
+                                         padSegsPerCircle );
                         pad->CustomShapeAsPolygonToBoardPosition( &outline,
                                 pad->GetPosition(), pad->GetOrientation() );
 
@@ -446,10 +514,10 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
                             aFeatures.Append( outline );
                     }
                     else
-                        pad->TransformShapeWithClearanceToPolygon( aFeatures,
+                        pad->TransformShapeWithClearanceToPolygonCached( aFeatures,
                                 clearance,
-                                segsPerCircle,
-                                correctionFactor );
+                                padSegsPerCircle,
+                                padCorrectionFactor );
                 }
 
                 continue;
@@ -470,6 +538,12 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
 
                 if( item_boundingbox.Intersects( zone_boundingbox ) )
                 {
+                    int padSegsPerCircle;
+                    double padCorrectionFactor;
+
+                    itemArcApprox( padClearanceArcRadius( pad, gap ), padSegsPerCircle,
+                                   padCorrectionFactor );
+
                     // PAD_SHAPE_CUSTOM has a specific keepout, to avoid to break the shape
                     // the pad shape in zone can be its convex hull or the shape itself
                     if( pad->GetShape() == PAD_SHAPE_CUSTOM
@@ -478,7 +552,7 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
                         // the pad shape in zone can be its convex hull or
                         // the shape itself
                         SHAPE_POLY_SET outline( pad->GetCustomShapeAsPolygon() );
-                        outline.Inflate( KiROUND( gap * correctionFactor ), segsPerCircle );
+                        outline.Inflate( KiROUND( gap * padCorrectionFactor ), padSegsPerCircle );
                         pad->CustomShapeAsPolygonToBoardPosition( &outline,
                                 pad->GetPosition(), pad->GetOrientation() );
 
@@ -491,8 +565,8 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
                             aFeatures.Append( convex_hull[ii] );
                     }
                     else
-                        pad->TransformShapeWithClearanceToPolygon( aFeatures,
-                                gap, segsPerCircle, correctionFactor );
+                        pad->TransformShapeWithClearanceToPolygonCached( aFeatures,
+                                gap, padSegsPerCircle, padCorrectionFactor );
                 }
             }
         }
@@ -501,13 +575,18 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
     /* Add holes (i.e. tracks and vias areas as polygons outlines)
      * in cornerBufferPolysToSubstract
      */
-    for( auto track : m_board->Tracks() )
+    EDA_RECT searchBox = zone_boundingbox;
+    searchBox.Normalize();
+    const int searchMin[2] = { searchBox.GetX(), searchBox.GetY() };
+    const int searchMax[2] = { searchBox.GetRight(), searchBox.GetBottom() };
+
+    auto doTrack = [&]( TRACK* track ) -> bool
     {
         if( !track->IsOnLayer( aZone->GetLayer() ) )
-            continue;
+            return true;
 
         if( track->GetNetCode() == aZone->GetNetCode()  && ( aZone->GetNetCode() != 0) )
-            continue;
+            return true;
 
         int item_clearance = track->GetClearance() + outline_half_thickness;
         item_boundingbox = track->GetBoundingBox();
@@ -515,10 +594,20 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
         if( item_boundingbox.Intersects( zone_boundingbox ) )
         {
             int clearance = std::max( zone_clearance, item_clearance );
-            track->TransformShapeWithClearanceToPolygon( aFeatures,
-                    clearance, segsPerCircle, correctionFactor );
+            int trackSegsPerCircle;
+            double trackCorrectionFactor;
+
+            itemArcApprox( track->GetWidth() / 2 + clearance, trackSegsPerCircle,
+                           trackCorrectionFactor );
+
+            track->TransformShapeWithClearanceToPolygonCached( aFeatures,
+                    clearance, trackSegsPerCircle, trackCorrectionFactor );
         }
-    }
+
+        return true;
+    };
+
+    m_trackIndex.Search( searchMin, searchMax, doTrack );
 
     /* Add graphic items that are on copper layers.  These have no net, so we just
      * use the zone clearance (or edge clearance).
@@ -548,7 +637,7 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
         switch( aItem->Type() )
         {
         case PCB_LINE_T:
-            static_cast<DRAWSEGMENT*>( aItem )->TransformShapeWithClearanceToPolygon(
+            static_cast<DRAWSEGMENT*>( aItem )->TransformShapeWithClearanceToPolygonCached(
                     aFeatures, zclearance, segsPerCircle, correctionFactor, ignoreLineWidth );
             break;
 
@@ -558,7 +647,7 @@ void ZONE_FILLER::buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
             break;
 
         case PCB_MODULE_EDGE_T:
-            static_cast<EDGE_MODULE*>( aItem )->TransformShapeWithClearanceToPolygon(
+            static_cast<EDGE_MODULE*>( aItem )->TransformShapeWithClearanceToPolygonCached(
                     aFeatures, zclearance, segsPerCircle, correctionFactor, ignoreLineWidth );
             break;
 
@@ -727,31 +816,36 @@ void ZONE_FILLER::computeRawFilledAreas( const ZONE_CONTAINER* aZone,
     if( s_DumpZonesWhenFilling )
         dumper->BeginGroup( "clipper-zone" );
 
-    SHAPE_POLY_SET solidAreas = aSmoothedOutline;
+    // The deflated outline and the holes stay in the Clipper representation until the
+    // holes are removed; they are only converted back when dumped
+    SHAPE_POLY_SET::PIPELINE solidAreasPipeline( aSmoothedOutline );
 
-    solidAreas.Inflate( -outline_half_thickness, segsPerCircle );
-    solidAreas.Simplify( SHAPE_POLY_SET::PM_FAST );
+    solidAreasPipeline.Inflate( -outline_half_thickness, segsPerCircle )
+                      .Simplify( SHAPE_POLY_SET::PM_FAST );
 
     SHAPE_POLY_SET holes;
 
     if( s_DumpZonesWhenFilling )
-        dumper->Write( &solidAreas, "solid-areas" );
+        dumper->Write( solidAreasPipeline.Result(), "solid-areas" );
 
     buildZoneFeatureHoleList( aZone, holes );
 
     if( s_DumpZonesWhenFilling )
         dumper->Write( &holes, "feature-holes" );
 
-    holes.Simplify( SHAPE_POLY_SET::PM_FAST );
+    SHAPE_POLY_SET::PIPELINE holesPipeline( holes );
+    holesPipeline.Simplify( SHAPE_POLY_SET::PM_FAST );
 
     if( s_DumpZonesWhenFilling )
-        dumper->Write( &holes, "feature-holes-postsimplify" );
+        dumper->Write( holesPipeline.Result(), "feature-holes-postsimplify" );
 
     // Generate the filled areas (currently, without thermal shapes, which will
     // be created later).
     // Use SHAPE_POLY_SET::PM_STRICTLY_SIMPLE to generate strictly simple polygons
     // needed by Gerber files and Fracture()
-    solidAreas.BooleanSubtract( holes, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+    solidAreasPipeline.BooleanSubtract( holesPipeline, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+
+    SHAPE_POLY_SET solidAreas = solidAreasPipeline.Result();
 
     // Now remove the non filled areas due to the hatch pattern
     if( aZone->GetFillMode() == ZFM_HATCH_PATTERN )
@@ -1164,8 +1258,12 @@ void ZONE_FILLER::addHatchFillTypeOnZone( const ZONE_CONTAINER* aZone, SHAPE_POL
     // Clamp holes to the area of filled zones with a outline thickness
     // > aZone->GetMinThickness() to be sure the thermal pads can be built
     int outline_margin = std::max( (aZone->GetMinThickness()*10)/9, linethickness/2 );
-    filledPolys.Inflate( -outline_margin, 16 );
-    holes.BooleanIntersection( filledPolys, SHAPE_POLY_SET::PM_FAST );
+    SHAPE_POLY_SET::PIPELINE marginPipeline( filledPolys );
+    marginPipeline.Inflate( -outline_margin, 16 );
+
+    SHAPE_POLY_SET::PIPELINE holesPipeline( holes );
+    holesPipeline.BooleanIntersection( marginPipeline, SHAPE_POLY_SET::PM_FAST );
+    holes = holesPipeline.Result();
 
     if( orientation != 0.0 )
         holes.Rotate( -M_PI/180.0 * orientation, VECTOR2I( 0,0 ) );
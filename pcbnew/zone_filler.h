@@ -28,12 +28,14 @@
 
 #include <vector>
 #include <class_zone.h>
+#include <geometry/packed_rtree.h>
 
 class WX_PROGRESS_REPORTER;
 class BOARD;
 class COMMIT;
 class SHAPE_POLY_SET;
 class SHAPE_LINE_CHAIN;
+class TRACK;
 
 class ZONE_FILLER
 {
@@ -46,6 +48,12 @@ public:
 
 private:
 
+    /**
+     * Indexes the board tracks by bounding box in m_trackIndex.  The index is read only
+     * while the zones are filled, so the filling threads share it without locking.
+     */
+    void buildTrackIndex();
+
     void buildZoneFeatureHoleList( const ZONE_CONTAINER* aZone,
             SHAPE_POLY_SET& aFeatures ) const;
 
@@ -111,6 +119,8 @@ private:
     BOARD* m_board;
     COMMIT* m_commit;
     WX_PROGRESS_REPORTER* m_progressReporter;
+
+    PACKED_RTREE<TRACK*, int, 2> m_trackIndex;
 };
 
 #endif
@@ -0,0 +1,201 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2018 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <climits>
+#include <cmath>
+#include <stdint.h>
+#include "wrlnumber.h"
+
+
+// significant digits which fit in the 64 bit mantissa accumulator
+#define MAX_MANTISSA_DIGITS 19
+
+// powers of 10 which are exactly representable as double
+static const double pow10[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_EXACT_POW10 22
+
+
+static inline bool isDigit( char aChar )
+{
+    return aChar >= '0' && aChar <= '9';
+}
+
+
+bool WRLParseNumber( const char*& aCursor, double& aResult )
+{
+    const char* cp = aCursor;
+    bool negative = false;
+
+    if( '-' == *cp || '+' == *cp )
+    {
+        negative = ( '-' == *cp );
+        ++cp;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    bool haveDigits = false;
+
+    // integer part; digits beyond the mantissa precision only scale the value
+    while( isDigit( *cp ) )
+    {
+        if( digits < MAX_MANTISSA_DIGITS )
+        {
+            mantissa = mantissa * 10 + ( *cp - '0' );
+
+            if( mantissa )
+                ++digits;
+        }
+        else
+        {
+            ++exponent;
+        }
+
+        haveDigits = true;
+        ++cp;
+    }
+
+    // fractional part; digits beyond the mantissa precision are dropped
+    if( '.' == *cp )
+    {
+        ++cp;
+
+        while( isDigit( *cp ) )
+        {
+            if( digits < MAX_MANTISSA_DIGITS )
+            {
+                mantissa = mantissa * 10 + ( *cp - '0' );
+                --exponent;
+
+                if( mantissa )
+                    ++digits;
+            }
+
+            haveDigits = true;
+            ++cp;
+        }
+    }
+
+    if( !haveDigits )
+        return false;
+
+    if( 'e' == *cp || 'E' == *cp )
+    {
+        const char* ep = cp + 1;
+        bool negativeExp = false;
+
+        if( '-' == *ep || '+' == *ep )
+        {
+            negativeExp = ( '-' == *ep );
+            ++ep;
+        }
+
+        if( !isDigit( *ep ) )
+            return false;
+
+        int value = 0;
+
+        while( isDigit( *ep ) )
+        {
+            if( value < 10000 )
+                value = value * 10 + ( *ep - '0' );
+
+            ++ep;
+        }
+
+        exponent += negativeExp ? -value : value;
+        cp = ep;
+    }
+
+    double value = (double) mantissa;
+
+    if( mantissa && exponent )
+    {
+        // leave the extreme cases to the generic conversion
+        if( exponent > 308 || exponent < -330 )
+            return false;
+
+        // 10^309 and above overflow, so subnormal results are scaled in two steps
+        if( exponent < -308 )
+        {
+            value /= pow10[MAX_EXACT_POW10];
+            exponent += MAX_EXACT_POW10;
+        }
+
+        if( exponent > 0 )
+            value *= ( exponent <= MAX_EXACT_POW10 ) ? pow10[exponent] : std::pow( 10.0, exponent );
+        else
+            value /= ( -exponent <= MAX_EXACT_POW10 ) ? pow10[-exponent] :
+                     std::pow( 10.0, -exponent );
+    }
+
+    aResult = negative ? -value : value;
+    aCursor = cp;
+
+    return true;
+}
+
+
+bool WRLParseInt( const char*& aCursor, int& aResult )
+{
+    const char* cp = aCursor;
+    bool negative = false;
+
+    if( '-' == *cp || '+' == *cp )
+    {
+        negative = ( '-' == *cp );
+        ++cp;
+    }
+
+    if( !isDigit( *cp ) )
+        return false;
+
+    int64_t value = 0;
+
+    while( isDigit( *cp ) )
+    {
+        value = value * 10 + ( *cp - '0' );
+
+        if( value > (int64_t) INT_MAX + 1 )
+            return false;
+
+        ++cp;
+    }
+
+    if( negative )
+        value = -value;
+
+    if( value > INT_MAX )
+        return false;
+
+    aResult = (int) value;
+    aCursor = cp;
+
+    return true;
+}
@@ -0,0 +1,57 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2018 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file wrlnumber.h
+ * declares the plain number parsers used for the large numeric arrays
+ * of VRML and X3D files
+ */
+
+
+#ifndef WRLNUMBER_H
+#define WRLNUMBER_H
+
+/**
+ * Function WRLParseNumber
+ * parses a decimal floating point number of the form [+-]123.456e[+-]7
+ * starting at aCursor. The conversion does not depend on the current locale.
+ *
+ * @param aCursor is the start of the number and is advanced past it on success
+ * @param aResult receives the value of the number
+ * @return true if a number was parsed; false if the text is not a plain decimal
+ * number (e.g. inf, nan or an out of range exponent) and must be converted by
+ * the generic code
+ */
+bool WRLParseNumber( const char*& aCursor, double& aResult );
+
+/**
+ * Function WRLParseInt
+ * parses a decimal integer of the form [+-]123 starting at aCursor.
+ *
+ * @param aCursor is the start of the number and is advanced past it on success
+ * @param aResult receives the value of the number
+ * @return true if an integer in the range of int was parsed
+ */
+bool WRLParseInt( const char*& aCursor, int& aResult );
+
+#endif  // WRLNUMBER_H
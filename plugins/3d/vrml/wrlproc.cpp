@@ -27,6 +27,7 @@
 #include <wx/string.h>
 #include <wx/log.h>
 #include "wrlproc.h"
+#include "wrlnumber.h"
 
 #define GETLINE do {\
     try { \
@@ -179,6 +180,53 @@ bool WRLPROC::getRawLine( void )
 }
 
 
+// characters which end a number, as ReadGlob would split the text
+static inline bool isNumberEnd( char aChar )
+{
+    return aChar <= 0x20 || ',' == aChar || '[' == aChar || ']' == aChar
+           || '{' == aChar || '}' == aChar;
+}
+
+
+bool WRLPROC::parseSFFloat( float& aSFFloat )
+{
+    const char* start = m_buf.c_str() + m_bufpos;
+    const char* cursor = start;
+    double value;
+
+    if( !WRLParseNumber( cursor, value ) || !isNumberEnd( *cursor ) )
+        return false;
+
+    // a comma directly after the number is consumed as ReadGlob does
+    if( ',' == *cursor )
+        ++cursor;
+
+    m_bufpos += cursor - start;
+    aSFFloat = value;
+
+    return true;
+}
+
+
+bool WRLPROC::parseSFInt( int& aSFInt32 )
+{
+    const char* start = m_buf.c_str() + m_bufpos;
+    const char* cursor = start;
+    int value;
+
+    if( !WRLParseInt( cursor, value ) || !isNumberEnd( *cursor ) )
+        return false;
+
+    if( ',' == *cursor )
+        ++cursor;
+
+    m_bufpos += cursor - start;
+    aSFInt32 = value;
+
+    return true;
+}
+
+
 bool WRLPROC::EatSpace( void )
 {
     if( !m_file )
@@ -811,6 +859,9 @@ bool WRLPROC::ReadSFFloat( float& aSFFloat )
             break;
     }
 
+    if( parseSFFloat( aSFFloat ) )
+        return true;
+
     std::string tmp;
 
     if( !ReadGlob( tmp ) )
@@ -871,6 +922,9 @@ bool WRLPROC::ReadSFInt( int& aSFInt32 )
             break;
     }
 
+    if( parseSFInt( aSFInt32 ) )
+        return true;
+
     std::string tmp;
 
     if( !ReadGlob( tmp ) )
@@ -1095,6 +1149,18 @@ bool WRLPROC::ReadSFVec3f( WRLVEC3F& aSFVec3f )
 
     for( int i = 0; i < 3; ++i )
     {
+        if( EatSpace() && parseSFFloat( tcol[i] ) )
+        {
+            // ignore any commas
+            if( !EatSpace() )
+                return false;
+
+            if( ',' == m_buf[m_bufpos] )
+                Pop();
+
+            continue;
+        }
+
         if( !ReadGlob( tmp ) )
         {
             std::ostringstream ostr;
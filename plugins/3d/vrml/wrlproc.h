@@ -58,6 +58,13 @@ private:
     // parameters are updated as appropriate.
     bool getRawLine( void );
 
+    // parseSFFloat and parseSFInt convert a plain decimal number directly from
+    // m_buf at m_bufpos, which is the case for nearly all of the large coordinate,
+    // index, normal and color arrays. They return 'false' without consuming any
+    // input if the text needs the generic stream conversion of ReadGlob.
+    bool parseSFFloat( float& aSFFloat );
+    bool parseSFInt( int& aSFInt32 );
+
 public:
     WRLPROC( LINE_READER* aLineReader );
     ~WRLPROC();
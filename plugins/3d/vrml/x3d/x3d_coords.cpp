@@ -24,10 +24,10 @@
 
 #include <iostream>
 #include <wx/xml/xml.h>
-#include <wx/tokenzr.h>
 #include <wx/log.h>
 #include "x3d_ops.h"
 #include "x3d_coords.h"
+#include "wrlnumber.h"
 
 
 X3DCOORDS::X3DCOORDS() : X3DNODE()
@@ -88,38 +88,42 @@ bool X3DCOORDS::Read( wxXmlNode* aNode, X3DNODE* aTopNode, X3D_DICT& aDict )
         else if( pname == "point" )
         {
             // Save points to vector as doubles
-            wxStringTokenizer plist( prop->GetValue() );
+            wxScopedCharBuffer plist = prop->GetValue().ToUTF8();
+            const char* cursor = plist.data();
             double point = 0.0;
             WRLVEC3F pt;
             int i = 0;
 
-            while( plist.HasMoreTokens() )
+            while( true )
             {
-                if( plist.GetNextToken().ToDouble( &point ) )
-                {
-                    // note: coordinates are multiplied by 2.54 to retain
-                    // legacy behavior of 1 X3D unit = 0.1 inch; the SG*
-                    // classes expect all units in mm.
-                    switch( i % 3 )
-                    {
-                    case 0:
-                        pt.x = point * 2.54;
-                        break;
-
-                    case 1:
-                        pt.y = point * 2.54;
-                        break;
-
-                    case 2:
-                        pt.z = point * 2.54;
-                        points.push_back( pt );
-                        break;
-
-                    }
-                }
-                else
-                {
+                // commas are white space in X3D lists
+                while( *cursor && ( (unsigned char) *cursor <= 0x20 || ',' == *cursor ) )
+                    ++cursor;
+
+                if( !*cursor )
+                    break;
+
+                if( !WRLParseNumber( cursor, point ) )
                     return false;
+
+                // note: coordinates are multiplied by 2.54 to retain
+                // legacy behavior of 1 X3D unit = 0.1 inch; the SG*
+                // classes expect all units in mm.
+                switch( i % 3 )
+                {
+                case 0:
+                    pt.x = point * 2.54;
+                    break;
+
+                case 1:
+                    pt.y = point * 2.54;
+                    break;
+
+                case 2:
+                    pt.z = point * 2.54;
+                    points.push_back( pt );
+                    break;
+
                 }
 
                 ++i;
@@ -27,12 +27,12 @@
 #include <cmath>
 #include <wx/log.h>
 #include <wx/xml/xml.h>
-#include <wx/tokenzr.h>
 #include "x3d_ops.h"
 #include "x3d_ifaceset.h"
 #include "x3d_coords.h"
 #include "plugins/3dapi/ifsg_all.h"
 #include "wrlfacet.h"
+#include "wrlnumber.h"
 
 
 X3DIFACESET::X3DIFACESET() : X3DNODE()
@@ -122,13 +122,28 @@ void X3DIFACESET::readFields( wxXmlNode* aNode )
         }
         else if( pname == "coordIndex" )
         {
-            wxStringTokenizer indices( prop->GetValue() );
+            wxScopedCharBuffer indices = prop->GetValue().ToUTF8();
+            const char* cursor = indices.data();
 
-            while( indices.HasMoreTokens() )
+            while( true )
             {
-                long index = 0;
-                indices.GetNextToken().ToLong( &index );
-                coordIndex.push_back( (int) index );
+                // commas are white space in X3D lists
+                while( *cursor && ( (unsigned char) *cursor <= 0x20 || ',' == *cursor ) )
+                    ++cursor;
+
+                if( !*cursor )
+                    break;
+
+                int index = 0;
+
+                // invalid entries are read as 0 and skipped
+                if( !WRLParseInt( cursor, index ) )
+                {
+                    while( *cursor && (unsigned char) *cursor > 0x20 && ',' != *cursor )
+                        ++cursor;
+                }
+
+                coordIndex.push_back( index );
             }
         }
     }
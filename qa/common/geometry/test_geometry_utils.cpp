@@ -0,0 +1,132 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2018 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the circle approximation functions of geometry_utils
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <geometry/geometry_utils.h>
+
+#include <cmath>
+
+
+/**
+ * Declare the test suite
+ */
+BOOST_AUTO_TEST_SUITE( GeometryUtils )
+
+
+/// The segment count used when the error is not taken in account
+static const int MAX_SEG_COUNT = 32;
+
+
+/**
+ * @return the max distance between the middle of a segment and the circle when
+ * approximating a circle of radius aRadius with aSegCount segments
+ */
+static double CircleApproxError( int aRadius, int aSegCount )
+{
+    return aRadius * ( 1.0 - std::cos( M_PI / aSegCount ) );
+}
+
+
+/**
+ * The count grows with the radius, and stays a multiple of 4
+ */
+BOOST_AUTO_TEST_CASE( CircleSegCountGrowsWithRadius )
+{
+    const int maxError = 10;
+    int       prevCount = 0;
+
+    for( int radius = 1; radius <= 1000000; radius *= 2 )
+    {
+        BOOST_TEST_CONTEXT( "Radius: " << radius )
+        {
+            const int count = GetCircleToSegmentCount( radius, maxError, 1000 );
+
+            BOOST_CHECK_GE( count, prevCount );
+            BOOST_CHECK_GE( count, 8 );
+            BOOST_CHECK_EQUAL( count % 4, 0 );
+
+            prevCount = count;
+        }
+    }
+
+    BOOST_CHECK_GT( prevCount, GetCircleToSegmentCount( 1000, maxError, 1000 ) );
+}
+
+
+/**
+ * The count never exceeds aMaxSegCount, and a null error uses aMaxSegCount
+ */
+BOOST_AUTO_TEST_CASE( CircleSegCountClamped )
+{
+    for( int radius = 1; radius <= 1000000; radius *= 10 )
+    {
+        BOOST_TEST_CONTEXT( "Radius: " << radius )
+        {
+            BOOST_CHECK_LE( GetCircleToSegmentCount( radius, 1, MAX_SEG_COUNT ),
+                            MAX_SEG_COUNT );
+            BOOST_CHECK_EQUAL( GetCircleToSegmentCount( radius, 0, MAX_SEG_COUNT ),
+                               MAX_SEG_COUNT );
+            BOOST_CHECK_EQUAL( GetCircleToSegmentCount( radius, -5, MAX_SEG_COUNT ),
+                               MAX_SEG_COUNT );
+        }
+    }
+
+    // A large circle with a small error needs the max count
+    BOOST_CHECK_EQUAL( GetCircleToSegmentCount( 1000000, 1, MAX_SEG_COUNT ), MAX_SEG_COUNT );
+}
+
+
+/**
+ * When the count is not clamped, the approximation error is within the budget,
+ * and the count is the smallest multiple of 4 which achieves it
+ */
+BOOST_AUTO_TEST_CASE( CircleSegCountErrorBudget )
+{
+    const std::vector<int> errors = { 1, 5, 50, 500 };
+
+    for( int maxError : errors )
+    {
+        for( int radius = 1; radius <= 10000000; radius = radius * 3 + 1 )
+        {
+            BOOST_TEST_CONTEXT( "Radius: " << radius << ", error: " << maxError )
+            {
+                const int count = GetCircleToSegmentCount( radius, maxError, 100000 );
+
+                BOOST_CHECK_LE( CircleApproxError( radius, count ), maxError );
+
+                if( count > 8 )
+                    BOOST_CHECK_GT( CircleApproxError( radius, count - 4 ), maxError );
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,231 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <vector>
+#include <geometry/packed_rtree.h>
+#include <geometry/rtree.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+// RTree data must be pointer sized when the tree is modified, as the reinsertion
+// of the branches of underfull nodes goes through the data member of the branches
+typedef RTree<intptr_t, int, 2, double> RTREE;
+
+/**
+ * Random boxes over a square, of various sizes, identified by their index
+ */
+struct RTREE_FIXTURE
+{
+    static const int SIZE = 100000;
+
+    struct ENTRY
+    {
+        int min[2];
+        int max[2];
+    };
+
+    RTREE_FIXTURE()
+    {
+        std::mt19937                    rng( 42 );
+        std::uniform_int_distribution<> pos( -SIZE, SIZE );
+        std::uniform_int_distribution<> extent( 0, SIZE / 50 );
+
+        for( int i = 0; i < 2000; ++i )
+        {
+            ENTRY entry;
+
+            for( int axis = 0; axis < 2; ++axis )
+            {
+                entry.min[axis] = pos( rng );
+                entry.max[axis] = entry.min[axis] + extent( rng );
+            }
+
+            m_entries.push_back( entry );
+        }
+
+        for( int i = 0; i < 200; ++i )
+        {
+            ENTRY query;
+            int   extentScale = ( i % 4 + 1 ) * 5;
+
+            for( int axis = 0; axis < 2; ++axis )
+            {
+                query.min[axis] = pos( rng );
+                query.max[axis] = query.min[axis] + extent( rng ) * extentScale;
+            }
+
+            m_queries.push_back( query );
+        }
+    }
+
+    /// Entry getter for bulk loading the first aCount entries
+    std::function<void( size_t, int*, int*, intptr_t& )> getter()
+    {
+        return [this]( size_t aIndex, int* aMin, int* aMax, intptr_t& aData )
+               {
+                   std::copy( m_entries[aIndex].min, m_entries[aIndex].min + 2, aMin );
+                   std::copy( m_entries[aIndex].max, m_entries[aIndex].max + 2, aMax );
+                   aData = (intptr_t) aIndex;
+               };
+    }
+
+    /// The entries overlapping a query, found by brute force
+    std::vector<intptr_t> expected( const ENTRY& aQuery, size_t aCount ) const
+    {
+        std::vector<intptr_t> found;
+
+        for( size_t i = 0; i < aCount; ++i )
+        {
+            const ENTRY& e = m_entries[i];
+
+            if( e.min[0] <= aQuery.max[0] && aQuery.min[0] <= e.max[0]
+                    && e.min[1] <= aQuery.max[1] && aQuery.min[1] <= e.max[1] )
+                found.push_back( (intptr_t) i );
+        }
+
+        return found;
+    }
+
+    /// Checks the results of all the queries on a tree against brute force
+    template <class TREE>
+    void checkQueries( TREE& aTree, size_t aCount )
+    {
+        for( const ENTRY& query : m_queries )
+        {
+            std::vector<intptr_t> found;
+            auto             visitor = [&found]( const intptr_t& aData )
+                                       {
+                                           found.push_back( aData );
+                                           return true;
+                                       };
+
+            int count = aTree.Search( query.min, query.max, visitor );
+            std::sort( found.begin(), found.end() );
+
+            std::vector<intptr_t> exp = expected( query, aCount );
+
+            BOOST_CHECK_EQUAL( count, (int) exp.size() );
+            BOOST_CHECK_EQUAL_COLLECTIONS( found.begin(), found.end(), exp.begin(), exp.end() );
+        }
+    }
+
+    std::vector<ENTRY> m_entries;
+    std::vector<ENTRY> m_queries;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( RTreeBulkLoad, RTREE_FIXTURE )
+
+
+/**
+ * A bulk loaded tree finds the same entries as brute force, for any number of
+ * entries (full and partial nodes, one or several levels)
+ */
+BOOST_AUTO_TEST_CASE( BulkInsertSearch )
+{
+    for( size_t count : { 0, 1, 5, 8, 9, 13, 64, 65, 2000 } )
+    {
+        BOOST_TEST_CONTEXT( count << " entries" )
+        {
+            RTREE tree;
+            tree.BulkInsert( count, getter() );
+
+            BOOST_CHECK_EQUAL( tree.Count(), (int) count );
+            checkQueries( tree, count );
+        }
+    }
+}
+
+
+/**
+ * A bulk loaded tree stays a valid RTree: it can be modified like one
+ */
+BOOST_AUTO_TEST_CASE( BulkInsertThenModify )
+{
+    RTREE tree;
+    tree.BulkInsert( 1000, getter() );
+
+    // Bulk inserting into a non-empty tree inserts one by one
+    tree.BulkInsert( 500, [this]( size_t aIndex, int* aMin, int* aMax, intptr_t& aData )
+                           {
+                               getter()( aIndex + 1000, aMin, aMax, aData );
+                           } );
+    checkQueries( tree, 1500 );
+
+    for( int i = 1499; i >= 500; --i )
+        BOOST_CHECK_EQUAL( tree.Remove( m_entries[i].min, m_entries[i].max, i ), false );
+
+    BOOST_CHECK_EQUAL( tree.Count(), 500 );
+    checkQueries( tree, 500 );
+
+    for( int i = 500; i < 2000; ++i )
+        tree.Insert( m_entries[i].min, m_entries[i].max, i );
+
+    checkQueries( tree, 2000 );
+}
+
+
+/**
+ * A packed tree finds the same entries as brute force
+ */
+BOOST_AUTO_TEST_CASE( PackedSearch )
+{
+    for( size_t count : { 0, 1, 15, 16, 17, 256, 257, 2000 } )
+    {
+        BOOST_TEST_CONTEXT( count << " entries" )
+        {
+            PACKED_RTREE<intptr_t, int, 2> tree;
+            tree.Build( count, getter() );
+
+            BOOST_CHECK_EQUAL( tree.Size(), count );
+            checkQueries( tree, count );
+        }
+    }
+}
+
+
+/**
+ * A search stops when the visitor returns false
+ */
+BOOST_AUTO_TEST_CASE( PackedSearchStop )
+{
+    PACKED_RTREE<intptr_t, int, 2> tree;
+    tree.Build( m_entries.size(), getter() );
+
+    const int everywhere[2][2] = { { -2 * SIZE, -2 * SIZE }, { 2 * SIZE, 2 * SIZE } };
+    int       visited = 0;
+    auto      visitor = [&visited]( const intptr_t& )
+                        {
+                            return ++visited < 10;
+                        };
+
+    tree.Search( everywhere[0], everywhere[1], visitor );
+    BOOST_CHECK_EQUAL( visited, 10 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,243 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <geometry/seg_batch.h>
+
+#include <random>
+#include <vector>
+
+/**
+ * Random segments, with the directions the kernels handle separately: degenerate,
+ * nearly vertical, nearly horizontal, nearly diagonal and arbitrary
+ */
+struct SEG_BATCH_FIXTURE
+{
+    SEG_BATCH_FIXTURE() : m_rng( 1 )
+    {
+    }
+
+    void Fill( int aCount, int aScale )
+    {
+        std::uniform_int_distribution<int> coord( -aScale, aScale );
+        std::uniform_int_distribution<int> small( -2, 2 );
+
+        m_a.clear();
+        m_b.clear();
+
+        for( int i = 0; i < aCount; i++ )
+        {
+            VECTOR2I a( coord( m_rng ), coord( m_rng ) );
+            int      v = coord( m_rng );
+
+            m_a.push_back( a );
+
+            switch( i % 5 )
+            {
+            case 0: m_b.push_back( a ); break;
+            case 1: m_b.push_back( a + VECTOR2I( small( m_rng ), v ) ); break;
+            case 2: m_b.push_back( a + VECTOR2I( v, small( m_rng ) ) ); break;
+            case 3: m_b.push_back( a + VECTOR2I( v + small( m_rng ), ( i % 2 ) ? v : -v ) ); break;
+            default: m_b.push_back( VECTOR2I( coord( m_rng ), coord( m_rng ) ) ); break;
+            }
+        }
+    }
+
+    /// A point near one of the segment ends half of the time, anywhere otherwise
+    VECTOR2I Point( int aScale )
+    {
+        std::uniform_int_distribution<int> coord( -aScale, aScale );
+        std::uniform_int_distribution<int> small( -2, 2 );
+
+        if( m_rng() % 2 )
+            return m_a[m_rng() % m_a.size()] + VECTOR2I( small( m_rng ), small( m_rng ) );
+
+        return VECTOR2I( coord( m_rng ), coord( m_rng ) );
+    }
+
+    /// The kernels available on this CPU
+    std::vector<SEG_BATCH::KERNEL> Kernels() const
+    {
+        std::vector<SEG_BATCH::KERNEL> kernels;
+
+        for( SEG_BATCH::KERNEL k : { SEG_BATCH::SCALAR, SEG_BATCH::SSE42, SEG_BATCH::AVX2 } )
+        {
+            if( SEG_BATCH::HasKernel( k ) )
+                kernels.push_back( k );
+        }
+
+        return kernels;
+    }
+
+    std::mt19937          m_rng;
+    std::vector<VECTOR2I> m_a;
+    std::vector<VECTOR2I> m_b;
+};
+
+
+static const int SCALES[] = { 10, 1000, 1000000, 500000000 };
+
+
+BOOST_FIXTURE_TEST_SUITE( SegBatch, SEG_BATCH_FIXTURE )
+
+
+/**
+ * Point to segment distances are those of SEG, whatever the kernel
+ */
+BOOST_AUTO_TEST_CASE( PointToSegments )
+{
+    for( int scale : SCALES )
+    {
+        for( int round = 0; round < 50; round++ )
+        {
+            Fill( 1 + round, scale );
+
+            const VECTOR2I p = Point( scale );
+            SEG::ecoord    nearest = VECTOR2I::ECOORD_MAX;
+
+            for( size_t i = 0; i < m_a.size(); i++ )
+                nearest = std::min( nearest, SEG( m_a[i], m_b[i] ).SquaredDistance( p ) );
+
+            for( SEG_BATCH::KERNEL kernel : Kernels() )
+            {
+                SEG_BATCH                batch( m_a.data(), m_b.data(), m_a.size(), kernel );
+                std::vector<SEG::ecoord> dist( m_a.size() );
+
+                batch.SquaredDistances( p, dist.data() );
+
+                for( size_t i = 0; i < m_a.size(); i++ )
+                    BOOST_CHECK_EQUAL( dist[i], SEG( m_a[i], m_b[i] ).SquaredDistance( p ) );
+
+                BOOST_CHECK_EQUAL( batch.SquaredDistance( p ), nearest );
+            }
+        }
+    }
+}
+
+
+/**
+ * Segment to point distances are those of SEG, whatever the kernel
+ */
+BOOST_AUTO_TEST_CASE( SegmentToPoints )
+{
+    for( int scale : SCALES )
+    {
+        for( int round = 0; round < 50; round++ )
+        {
+            Fill( 1 + round, scale );
+
+            const SEG seg( Point( scale ), Point( scale ) );
+
+            for( SEG_BATCH::KERNEL kernel : Kernels() )
+            {
+                std::vector<SEG::ecoord> dist( m_a.size() );
+
+                SEG_BATCH::SquaredDistances( seg, m_a.data(), m_a.size(), dist.data(), kernel );
+
+                for( size_t i = 0; i < m_a.size(); i++ )
+                    BOOST_CHECK_EQUAL( dist[i], seg.SquaredDistance( m_a[i] ) );
+            }
+        }
+    }
+}
+
+
+/**
+ * Collisions are those of SEG, whatever the kernel and the clearance
+ */
+BOOST_AUTO_TEST_CASE( Collide )
+{
+    for( int scale : SCALES )
+    {
+        const int clearances[] = { 0, 1, 3, -5, 100, scale / 10, scale / 3 + 7, scale };
+
+        for( int round = 0; round < 50; round++ )
+        {
+            Fill( 1 + round, scale );
+
+            const VECTOR2I p = Point( scale );
+            const SEG      seg( p, ( round % 4 ) ? Point( scale ) : p );
+
+            for( int clearance : clearances )
+            {
+                std::vector<int> expected;
+
+                for( size_t i = 0; i < m_a.size(); i++ )
+                {
+                    if( SEG( m_a[i], m_b[i] ).Collide( seg, clearance ) )
+                        expected.push_back( i );
+                }
+
+                expected.push_back( -1 );
+
+                for( SEG_BATCH::KERNEL kernel : Kernels() )
+                {
+                    SEG_BATCH        batch( m_a.data(), m_b.data(), m_a.size(), kernel );
+                    std::vector<int> found;
+
+                    for( int i = batch.Collide( seg, clearance ); ;
+                            i = batch.Collide( seg, clearance, i + 1 ) )
+                    {
+                        found.push_back( i );
+
+                        if( i < 0 )
+                            break;
+                    }
+
+                    BOOST_CHECK_EQUAL_COLLECTIONS( found.begin(), found.end(),
+                                                   expected.begin(), expected.end() );
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * SEG::PointCloserThan() first measures the distance of points inside the span of nearly
+ * vertical segments to a diagonal line: the batch must give the same results
+ */
+BOOST_AUTO_TEST_CASE( NearlyVerticalSegments )
+{
+    const VECTOR2I a[] = { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    const VECTOR2I b[] = { { 1, 1000 }, { -1, 1000 }, { 1000, 1 }, { 0, 1000 } };
+    const SEG      seg( VECTOR2I( 500, 500 ), VECTOR2I( 500, 500 ) );
+
+    for( int clearance : { 5, 50, 400, 600 } )
+    {
+        int expected = -1;
+
+        for( int i = 0; i < 4 && expected < 0; i++ )
+        {
+            if( SEG( a[i], b[i] ).Collide( seg, clearance ) )
+                expected = i;
+        }
+
+        for( SEG_BATCH::KERNEL kernel : Kernels() )
+            BOOST_CHECK_EQUAL( SEG_BATCH( a, b, 4, kernel ).Collide( seg, clearance ), expected );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,302 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <geometry/segment_bvh.h>
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+#include <cmath>
+#include <limits>
+
+/**
+ * Builds a closed star-shaped chain, large enough to be indexed
+ */
+static SHAPE_LINE_CHAIN buildStar( int aPoints, int aInner, int aOuter )
+{
+    SHAPE_LINE_CHAIN chain;
+
+    for( int i = 0; i < aPoints; i++ )
+    {
+        double angle = 2 * M_PI * i / aPoints;
+        int    r = ( i % 2 ) ? aInner : aOuter;
+
+        chain.Append( int( r * cos( angle ) ), int( r * sin( angle ) ) );
+    }
+
+    chain.SetClosed( true );
+
+    return chain;
+}
+
+
+/**
+ * Linear reference for SHAPE_LINE_CHAIN::Distance( aP, true )
+ */
+static int refDistance( const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP )
+{
+    int d = std::numeric_limits<int>::max();
+
+    for( int i = 0; i < aChain.SegmentCount(); i++ )
+        d = std::min( d, aChain.CSegment( i ).Distance( aP ) );
+
+    return d;
+}
+
+
+/**
+ * Linear reference for SHAPE_LINE_CHAIN::PointInside(), by ray casting
+ */
+static bool refInside( const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP )
+{
+    bool inside = false;
+
+    for( int i = 0; i < aChain.PointCount(); i++ )
+    {
+        const VECTOR2I& p1 = aChain.CPoint( i );
+        const VECTOR2I& p2 = aChain.CPoint( i + 1 );
+
+        if( ( p1.y > aP.y ) != ( p2.y > aP.y ) )
+        {
+            double x = p1.x + (double) ( p2.x - p1.x ) * ( aP.y - p1.y ) / ( p2.y - p1.y );
+
+            if( aP.x < x )
+                inside = !inside;
+        }
+    }
+
+    return inside;
+}
+
+
+/**
+ * Query points on a regular grid around the star, avoiding its edges
+ */
+static std::vector<VECTOR2I> queryPoints()
+{
+    std::vector<VECTOR2I> points;
+
+    for( int x = -1200; x <= 1200; x += 97 )
+    {
+        for( int y = -1200; y <= 1200; y += 89 )
+            points.emplace_back( x, y );
+    }
+
+    return points;
+}
+
+
+BOOST_AUTO_TEST_SUITE( SegmentBvh )
+
+
+/**
+ * The hierarchy visits every segment once, in order, when all the nodes are accepted
+ */
+BOOST_AUTO_TEST_CASE( VisitsAllSegmentsInOrder )
+{
+    const SHAPE_LINE_CHAIN star = buildStar( 1000, 500, 1000 );
+    SEGMENT_BVH            bvh( star );
+
+    BOOST_CHECK_EQUAL( bvh.SegmentCount(), star.SegmentCount() );
+
+    int expected = 0;
+
+    bvh.Query(
+            []( const BOX2I& aBox )
+            {
+                return true;
+            },
+            [&]( int aSegment )
+            {
+                BOOST_CHECK_EQUAL( aSegment, expected );
+                expected++;
+                return true;
+            } );
+
+    BOOST_CHECK_EQUAL( expected, star.SegmentCount() );
+}
+
+
+/**
+ * The boxes passed to the node filter hold the segments below them
+ */
+BOOST_AUTO_TEST_CASE( BoxesHoldSegments )
+{
+    const SHAPE_LINE_CHAIN star = buildStar( 1000, 500, 1000 );
+    SEGMENT_BVH            bvh( star );
+
+    BOX2I leaf;
+
+    bvh.Query(
+            [&]( const BOX2I& aBox )
+            {
+                leaf = aBox;
+                return true;
+            },
+            [&]( int aSegment )
+            {
+                const SEG seg = star.CSegment( aSegment );
+                BOOST_CHECK( leaf.Contains( seg.A ) && leaf.Contains( seg.B ) );
+                return true;
+            } );
+
+    BOX2I bbox = star.BBox();
+    BOOST_CHECK_EQUAL( bvh.BBox().GetOrigin(), bbox.GetOrigin() );
+    BOOST_CHECK_EQUAL( bvh.BBox().GetSize(), bbox.GetSize() );
+}
+
+
+/**
+ * Indexed distances match a linear scan over the segments
+ */
+BOOST_AUTO_TEST_CASE( Distance )
+{
+    const SHAPE_LINE_CHAIN star = buildStar( 1000, 500, 1000 );
+
+    for( const VECTOR2I& p : queryPoints() )
+    {
+        BOOST_TEST_CONTEXT( "Point " << p.x << ", " << p.y )
+        {
+            BOOST_CHECK_EQUAL( star.Distance( p, true ), refDistance( star, p ) );
+        }
+    }
+}
+
+
+/**
+ * Indexed point inside tests match a linear ray casting
+ */
+BOOST_AUTO_TEST_CASE( PointInside )
+{
+    const SHAPE_LINE_CHAIN star = buildStar( 1000, 500, 1000 );
+
+    for( const VECTOR2I& p : queryPoints() )
+    {
+        if( refDistance( star, p ) <= 2 )
+            continue;
+
+        BOOST_TEST_CONTEXT( "Point " << p.x << ", " << p.y )
+        {
+            BOOST_CHECK_EQUAL( star.PointInside( p ), refInside( star, p ) );
+        }
+    }
+}
+
+
+/**
+ * Points on an edge are found on the edge with the lowest index
+ */
+BOOST_AUTO_TEST_CASE( EdgeContainingPoint )
+{
+    const SHAPE_LINE_CHAIN star = buildStar( 1000, 500, 1000 );
+
+    for( int i = 0; i < star.PointCount(); i += 7 )
+    {
+        // A vertex belongs to the segment ending there, and to the one starting there
+        int expected = i > 0 ? i - 1 : 0;
+
+        BOOST_CHECK_EQUAL( star.EdgeContainingPoint( star.CPoint( i ) ), expected );
+    }
+
+    BOOST_CHECK_EQUAL( star.EdgeContainingPoint( VECTOR2I( 5000, 5000 ) ), -1 );
+}
+
+
+/**
+ * Segment collisions match a linear scan over the segments
+ */
+BOOST_AUTO_TEST_CASE( CollideSeg )
+{
+    const SHAPE_LINE_CHAIN star = buildStar( 1000, 500, 1000 );
+    const int              clearance = 50;
+
+    for( const VECTOR2I& p : queryPoints() )
+    {
+        SEG seg( p, p + VECTOR2I( 100, 30 ) );
+
+        bool expected = false;
+
+        for( int i = 0; i < star.SegmentCount(); i++ )
+            expected |= star.CSegment( i ).Collide( seg, clearance );
+
+        BOOST_TEST_CONTEXT( "Segment from " << p.x << ", " << p.y )
+        {
+            BOOST_CHECK_EQUAL( star.Collide( seg, clearance ), expected );
+        }
+    }
+}
+
+
+/**
+ * Changing a chain drops its index, without changing copies sharing it
+ */
+BOOST_AUTO_TEST_CASE( Invalidation )
+{
+    SHAPE_LINE_CHAIN star = buildStar( 1000, 500, 1000 );
+    const VECTOR2I   far( 5000, 0 );
+
+    const int before = star.Distance( far, true );
+
+    // The copy shares the index built by the query above
+    const SHAPE_LINE_CHAIN copy = star;
+
+    star.Point( 0 ) = VECTOR2I( 4000, 0 );
+
+    BOOST_CHECK_EQUAL( star.Distance( far, true ), 1000 );
+    BOOST_CHECK_EQUAL( copy.Distance( far, true ), before );
+
+    star.Append( VECTOR2I( 4900, 0 ) );
+
+    BOOST_CHECK_EQUAL( star.Distance( far, true ), 100 );
+
+    star.Move( VECTOR2I( 100, 0 ) );
+
+    BOOST_CHECK_EQUAL( star.Distance( far, true ), 0 );
+}
+
+
+/**
+ * Polygon set queries using the contour indexes
+ */
+BOOST_AUTO_TEST_CASE( PolySetQueries )
+{
+    SHAPE_POLY_SET polyset;
+
+    SHAPE_LINE_CHAIN hole( VECTOR2I( -100, -100 ), VECTOR2I( 100, -100 ), VECTOR2I( 100, 100 ),
+                           VECTOR2I( -100, 100 ) );
+    hole.SetClosed( true );
+
+    polyset.AddOutline( buildStar( 1000, 500, 1000 ) );
+    polyset.AddHole( hole );
+
+    BOOST_CHECK( !polyset.Contains( VECTOR2I( 0, 0 ) ) );
+    BOOST_CHECK( polyset.Contains( VECTOR2I( 300, 0 ) ) );
+    BOOST_CHECK( !polyset.Contains( VECTOR2I( 2000, 0 ) ) );
+
+    BOOST_CHECK_EQUAL( polyset.Distance( VECTOR2I( 300, 0 ) ), 0 );
+    BOOST_CHECK_EQUAL( polyset.Distance( VECTOR2I( 0, 0 ) ), 100 );
+    BOOST_CHECK_EQUAL( polyset.Distance( VECTOR2I( 1500, 0 ) ), 500 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <geometry/shape_line_chain.h>
+
+#include <cmath>
+
+/**
+ * Checks the (cached) bounding box of a chain against the one of its points
+ */
+static void checkBBox( const SHAPE_LINE_CHAIN& aChain )
+{
+    BOX2I expected;
+    expected.Compute( aChain.CPoints() );
+
+    const BOX2I bbox = aChain.BBox();
+
+    BOOST_CHECK_EQUAL( bbox.GetOrigin(), expected.GetOrigin() );
+    BOOST_CHECK_EQUAL( bbox.GetSize(), expected.GetSize() );
+}
+
+
+BOOST_AUTO_TEST_SUITE( ShapeLineChainBBox )
+
+
+/**
+ * The cached bounding box follows each kind of change of the points
+ */
+BOOST_AUTO_TEST_CASE( FollowsChanges )
+{
+    SHAPE_LINE_CHAIN chain( { 0, 0 }, { 100, 0 }, { 100, 50 } );
+    checkBBox( chain );
+
+    chain.Append( -20, 70 );
+    checkBBox( chain );
+
+    chain.Point( 1 ) = VECTOR2I( 300, -10 );
+    checkBBox( chain );
+
+    chain.Insert( 1, VECTOR2I( 10, -400 ) );
+    checkBBox( chain );
+
+    chain.Move( VECTOR2I( 5, 7 ) );
+    checkBBox( chain );
+
+    chain.Rotate( M_PI / 2, VECTOR2I( 0, 0 ) );
+    checkBBox( chain );
+
+    chain.Replace( 0, 1, VECTOR2I( 1000, 1000 ) );
+    checkBBox( chain );
+
+    chain.Remove( 0 );
+    checkBBox( chain );
+
+    chain.Append( SHAPE_LINE_CHAIN( { -500, 0 }, { 0, 600 } ) );
+    checkBBox( chain );
+}
+
+
+/**
+ * Copies take the cached bounding box, but do not share later changes
+ */
+BOOST_AUTO_TEST_CASE( Copies )
+{
+    SHAPE_LINE_CHAIN chain( { 0, 0 }, { 100, 0 }, { 100, 50 } );
+    checkBBox( chain );
+
+    SHAPE_LINE_CHAIN copy( chain );
+    checkBBox( copy );
+
+    copy.Append( 200, 200 );
+    checkBBox( copy );
+    checkBBox( chain );
+
+    chain = copy;
+    checkBBox( chain );
+
+    chain.Clear();
+    chain.Append( 10, 10 );
+    checkBBox( chain );
+    checkBBox( copy );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,176 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <geometry/shape_poly_set.h>
+
+#include <qa_utils/geometry/line_chain_construction.h>
+#include <qa_utils/geometry/poly_set_construction.h>
+
+#include <random>
+
+/**
+ * Random overlapping and self-intersecting polygons, with holes
+ */
+struct PIPELINE_FIXTURE
+{
+    PIPELINE_FIXTURE() : m_rng( 1 )
+    {
+    }
+
+    SHAPE_LINE_CHAIN RandomChain( int aScale )
+    {
+        std::uniform_int_distribution<int> coord( -aScale, aScale );
+        std::uniform_int_distribution<int> count( 3, 12 );
+        SHAPE_LINE_CHAIN                   chain;
+
+        for( int i = count( m_rng ); i > 0; i-- )
+            chain.Append( coord( m_rng ), coord( m_rng ) );
+
+        chain.SetClosed( true );
+        return chain;
+    }
+
+    SHAPE_POLY_SET RandomPolySet( int aPolygons, int aScale )
+    {
+        SHAPE_POLY_SET polySet;
+
+        for( int i = 0; i < aPolygons; i++ )
+        {
+            polySet.AddOutline( RandomChain( aScale ) );
+
+            if( i % 2 )
+                polySet.AddHole( KI_TEST::BuildSquareChain( aScale / 4 ) );
+        }
+
+        return polySet;
+    }
+
+    std::mt19937 m_rng;
+};
+
+
+/**
+ * Checks that two polygon sets have the same polygons, with the same points in the
+ * same order
+ */
+static void CheckSamePolygons( const SHAPE_POLY_SET& aExpected, const SHAPE_POLY_SET& aActual )
+{
+    BOOST_REQUIRE_EQUAL( aExpected.OutlineCount(), aActual.OutlineCount() );
+
+    for( int i = 0; i < aExpected.OutlineCount(); i++ )
+    {
+        const SHAPE_POLY_SET::POLYGON& expected = aExpected.CPolygon( i );
+        const SHAPE_POLY_SET::POLYGON& actual = aActual.CPolygon( i );
+
+        BOOST_REQUIRE_EQUAL( expected.size(), actual.size() );
+
+        for( size_t j = 0; j < expected.size(); j++ )
+        {
+            BOOST_REQUIRE_EQUAL( expected[j].PointCount(), actual[j].PointCount() );
+            BOOST_CHECK( expected[j].IsClosed() && actual[j].IsClosed() );
+
+            for( int k = 0; k < expected[j].PointCount(); k++ )
+                BOOST_CHECK( expected[j].CPoint( k ) == actual[j].CPoint( k ) );
+        }
+    }
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( SPSPipeline, PIPELINE_FIXTURE )
+
+
+/**
+ * A single simplification, on self-intersecting polygons
+ */
+BOOST_AUTO_TEST_CASE( Simplify )
+{
+    for( auto mode : { SHAPE_POLY_SET::PM_FAST, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE } )
+    {
+        SHAPE_POLY_SET polySet = RandomPolySet( 5, 10000 );
+
+        SHAPE_POLY_SET::PIPELINE pipeline( polySet );
+        pipeline.Simplify( mode );
+
+        polySet.Simplify( mode );
+
+        CheckSamePolygons( polySet, pipeline.Result() );
+    }
+}
+
+
+/**
+ * The zone filling sequence: deflate, simplify and remove the simplified holes
+ */
+BOOST_AUTO_TEST_CASE( DeflateSimplifySubtract )
+{
+    for( int i = 0; i < 20; i++ )
+    {
+        SHAPE_POLY_SET solid = RandomPolySet( 4, 10000 );
+        SHAPE_POLY_SET holes = RandomPolySet( 6, 10000 );
+
+        SHAPE_POLY_SET::PIPELINE pipeline( solid );
+        SHAPE_POLY_SET::PIPELINE holesPipeline( holes );
+
+        holesPipeline.Simplify( SHAPE_POLY_SET::PM_FAST );
+        pipeline.Inflate( -250, 16 )
+                .Simplify( SHAPE_POLY_SET::PM_FAST )
+                .BooleanSubtract( holesPipeline, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+
+        solid.Inflate( -250, 16 );
+        solid.Simplify( SHAPE_POLY_SET::PM_FAST );
+        holes.Simplify( SHAPE_POLY_SET::PM_FAST );
+        solid.BooleanSubtract( holes, SHAPE_POLY_SET::PM_STRICTLY_SIMPLE );
+
+        CheckSamePolygons( solid, pipeline.Result() );
+    }
+}
+
+
+/**
+ * Unions and intersections of inflated polygons
+ */
+BOOST_AUTO_TEST_CASE( InflateAddIntersect )
+{
+    for( int i = 0; i < 20; i++ )
+    {
+        SHAPE_POLY_SET a = RandomPolySet( 3, 10000 );
+        SHAPE_POLY_SET b = RandomPolySet( 3, 10000 );
+
+        SHAPE_POLY_SET::PIPELINE pipeline( a );
+
+        pipeline.Inflate( 300, 32 )
+                .BooleanAdd( SHAPE_POLY_SET::PIPELINE( b ), SHAPE_POLY_SET::PM_FAST )
+                .BooleanIntersection( SHAPE_POLY_SET::PIPELINE( b ), SHAPE_POLY_SET::PM_FAST );
+
+        SHAPE_POLY_SET expected = a;
+        expected.Inflate( 300, 32 );
+        expected.BooleanAdd( b, SHAPE_POLY_SET::PM_FAST );
+        expected.BooleanIntersection( b, SHAPE_POLY_SET::PM_FAST );
+
+        CheckSamePolygons( expected, pipeline.Result() );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
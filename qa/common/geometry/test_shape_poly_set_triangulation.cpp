@@ -0,0 +1,142 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+#include <geometry/shape_poly_set.h>
+
+#include <qa_utils/geometry/line_chain_construction.h>
+
+#include <cmath>
+
+/**
+ * Returns the area of a polygon set, holes removed
+ */
+static double PolySetArea( const SHAPE_POLY_SET& aPolySet )
+{
+    double area = 0.0;
+
+    for( int i = 0; i < aPolySet.OutlineCount(); i++ )
+    {
+        area += std::abs( aPolySet.COutline( i ).Area() );
+
+        for( int j = 0; j < aPolySet.HoleCount( i ); j++ )
+            area -= std::abs( aPolySet.CHole( i, j ).Area() );
+    }
+
+    return area;
+}
+
+
+/**
+ * Returns the area covered by the triangles of a triangulated polygon set
+ */
+static double TriangulatedArea( const SHAPE_POLY_SET& aPolySet )
+{
+    double area = 0.0;
+
+    for( unsigned i = 0; i < aPolySet.TriangulatedPolyCount(); i++ )
+    {
+        const SHAPE_POLY_SET::TRIANGULATED_POLYGON* tri = aPolySet.TriangulatedPolygon( i );
+
+        for( size_t j = 0; j < tri->GetTriangleCount(); j++ )
+        {
+            VECTOR2I a, b, c;
+            tri->GetTriangle( j, a, b, c );
+
+            area += std::abs( (double) ( b - a ).Cross( c - a ) ) / 2.0;
+        }
+    }
+
+    return area;
+}
+
+
+/**
+ * A square with a grid of polygonal holes
+ */
+static SHAPE_POLY_SET BuildPerforatedSquare( int aHoles, int aHoleSegments )
+{
+    const int pitch = 1000;
+
+    SHAPE_POLY_SET polySet;
+    polySet.AddOutline( KI_TEST::BuildSquareChain( pitch * ( aHoles + 1 ),
+            { pitch * ( aHoles + 1 ) / 2, pitch * ( aHoles + 1 ) / 2 } ) );
+
+    for( int y = 1; y <= aHoles; y++ )
+    {
+        for( int x = 1; x <= aHoles; x++ )
+        {
+            SHAPE_LINE_CHAIN hole;
+
+            for( int i = 0; i < aHoleSegments; i++ )
+            {
+                double angle = 2.0 * M_PI * i / aHoleSegments;
+                hole.Append( x * pitch + (int) ( 300 * std::cos( angle ) ),
+                             y * pitch + (int) ( 300 * std::sin( angle ) ) );
+            }
+
+            hole.SetClosed( true );
+            polySet.AddHole( hole );
+        }
+    }
+
+    return polySet;
+}
+
+
+BOOST_AUTO_TEST_SUITE( SPSTriangulation )
+
+
+/**
+ * A small polygon, triangulated at once
+ */
+BOOST_AUTO_TEST_CASE( SmallPolygon )
+{
+    SHAPE_POLY_SET polySet = BuildPerforatedSquare( 3, 16 );
+
+    polySet.CacheTriangulation();
+
+    BOOST_CHECK( polySet.IsTriangulationUpToDate() );
+    BOOST_CHECK_CLOSE( TriangulatedArea( polySet ), PolySetArea( polySet ), 1e-6 );
+}
+
+
+/**
+ * A polygon large enough to be cut in pieces: the pieces cover it without gaps
+ * or overlaps
+ */
+BOOST_AUTO_TEST_CASE( TiledPolygon )
+{
+    SHAPE_POLY_SET polySet = BuildPerforatedSquare( 40, 16 );
+
+    polySet.CacheTriangulation();
+
+    BOOST_CHECK( polySet.IsTriangulationUpToDate() );
+    BOOST_CHECK_GT( polySet.TriangulatedPolyCount(), 1 );
+
+    // Where the cuts cross the holes, the holes pass through the nearest integer points
+    BOOST_CHECK_CLOSE( TriangulatedArea( polySet ), PolySetArea( polySet ), 1e-3 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,292 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2018 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the plain number parsers of the VRML plugin
+ */
+
+#include <unit_test_utils/unit_test_utils.h>
+
+// Code under test
+#include <plugins/3d/vrml/wrlnumber.h>
+
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+
+/**
+ * Declare the test suite
+ */
+BOOST_AUTO_TEST_SUITE( WrlNumber )
+
+
+struct WRL_NUMBER_CASE
+{
+    std::string m_text;
+    double      m_exp_value;
+    long        m_exp_length;   ///< characters consumed by the parser
+};
+
+
+/**
+ * Test the #WRLParseNumber function on numbers it must convert itself
+ */
+BOOST_AUTO_TEST_CASE( ParseNumber )
+{
+    const std::vector<WRL_NUMBER_CASE> cases = {
+        { "0", 0.0, 1 },
+        { "12.5", 12.5, 4 },
+        { "+3", 3.0, 2 },
+        { "-2.25", -2.25, 5 },
+        { "0.001", 0.001, 5 },          // leading zeros of the fraction
+        { "0.000000000000000000000123", 1.23e-22, 26 },
+        { "1.", 1.0, 2 },               // no fraction digits
+        { ".5", 0.5, 2 },               // no integer digits
+        { "-.5", -0.5, 3 },
+        { "1.5e3", 1500.0, 5 },
+        { "1.5E+3", 1500.0, 6 },
+        { "25e-2", 0.25, 5 },
+        { "0.5 0.25", 0.5, 3 },         // stops at the separator
+        { "7,", 7.0, 1 },
+    };
+
+    for( const auto& c : cases )
+    {
+        BOOST_TEST_CONTEXT( "Testing: " << c.m_text )
+        {
+            const char* cursor = c.m_text.c_str();
+            double      value = 0.0;
+
+            BOOST_CHECK( WRLParseNumber( cursor, value ) );
+            BOOST_CHECK_EQUAL( value, c.m_exp_value );
+            BOOST_CHECK_EQUAL( cursor - c.m_text.c_str(), c.m_exp_length );
+        }
+    }
+}
+
+
+/**
+ * A negative zero keeps its sign, as with strtod()
+ */
+BOOST_AUTO_TEST_CASE( ParseNegativeZero )
+{
+    const char* text = "-0";
+    double      value = 1.0;
+
+    BOOST_CHECK( WRLParseNumber( text, value ) );
+    BOOST_CHECK_EQUAL( value, 0.0 );
+    BOOST_CHECK( std::signbit( value ) );
+    BOOST_CHECK_EQUAL( *text, '\0' );
+}
+
+
+/**
+ * Digits beyond the precision of the mantissa scale the value or are dropped
+ */
+BOOST_AUTO_TEST_CASE( ParseManyDigits )
+{
+    const std::vector<std::string> cases = {
+        "3.14159265358979323846264",
+        "12345678901234567890123",
+        "1234567890123456789.0123456789",
+        "0.00000123456789012345678901234",
+        "-98765432109876543210e-10",
+    };
+
+    for( const auto& c : cases )
+    {
+        BOOST_TEST_CONTEXT( "Testing: " << c )
+        {
+            const char* cursor = c.c_str();
+            double      value = 0.0;
+
+            BOOST_CHECK( WRLParseNumber( cursor, value ) );
+            BOOST_CHECK_CLOSE( value, std::strtod( c.c_str(), nullptr ), 1e-12 );
+            BOOST_CHECK_EQUAL( *cursor, '\0' );
+        }
+    }
+}
+
+
+/**
+ * Exponents up to 308 and down to -330 are converted, the others are left to
+ * the generic conversion
+ */
+BOOST_AUTO_TEST_CASE( ParseExponentBounds )
+{
+    const std::vector<std::string> accepted = {
+        "1e308",
+        "1.7976931348623157e308",
+        "1e-308",
+        "2.5e-315",                     // subnormal
+        "1e-320",
+        "1234567890123456789e-330",
+    };
+
+    for( const auto& c : accepted )
+    {
+        BOOST_TEST_CONTEXT( "Testing: " << c )
+        {
+            const char* cursor = c.c_str();
+            double      value = 0.0;
+
+            const double expected = std::strtod( c.c_str(), nullptr );
+
+            // subnormal results may differ by one unit in the last place
+            BOOST_CHECK( WRLParseNumber( cursor, value ) );
+            BOOST_CHECK_LE( std::fabs( value - expected ),
+                            std::fabs( expected ) * 1e-14 +
+                            std::numeric_limits<double>::denorm_min() );
+            BOOST_CHECK_EQUAL( *cursor, '\0' );
+        }
+    }
+
+    const std::vector<std::string> rejected = {
+        "1e309",
+        "1e-331",
+        "1e99999",
+    };
+
+    for( const auto& c : rejected )
+    {
+        BOOST_TEST_CONTEXT( "Testing: " << c )
+        {
+            const char* cursor = c.c_str();
+            double      value = 0.0;
+
+            BOOST_CHECK( !WRLParseNumber( cursor, value ) );
+            BOOST_CHECK_EQUAL( cursor - c.c_str(), 0 );
+        }
+    }
+}
+
+
+/**
+ * Text which is not a plain decimal number is rejected and the cursor is not moved
+ */
+BOOST_AUTO_TEST_CASE( ParseNumberRejected )
+{
+    const std::vector<std::string> cases = {
+        "",
+        "1e",                           // exponent without digits
+        "1e+",
+        "-",
+        ".",
+        "+.e1",
+        "inf",
+        "nan",
+    };
+
+    for( const auto& c : cases )
+    {
+        BOOST_TEST_CONTEXT( "Testing: " << c )
+        {
+            const char* cursor = c.c_str();
+            double      value = 0.0;
+
+            BOOST_CHECK( !WRLParseNumber( cursor, value ) );
+            BOOST_CHECK_EQUAL( cursor - c.c_str(), 0 );
+        }
+    }
+}
+
+
+struct WRL_INT_CASE
+{
+    std::string m_text;
+    bool        m_exp_ok;
+    int         m_exp_value;
+};
+
+
+/**
+ * Test the #WRLParseInt function, including the limits of int
+ */
+BOOST_AUTO_TEST_CASE( ParseInt )
+{
+    const std::vector<WRL_INT_CASE> cases = {
+        { "0", true, 0 },
+        { "-1", true, -1 },
+        { "+42", true, 42 },
+        { "2147483647", true, INT_MAX },
+        { "-2147483648", true, INT_MIN },
+        { "2147483648", false, 0 },     // INT_MAX + 1
+        { "-2147483649", false, 0 },    // INT_MIN - 1
+        { "99999999999999999999", false, 0 },
+        { "", false, 0 },
+        { "-", false, 0 },
+        { "a1", false, 0 },
+    };
+
+    for( const auto& c : cases )
+    {
+        BOOST_TEST_CONTEXT( "Testing: " << c.m_text )
+        {
+            const char* cursor = c.m_text.c_str();
+            int         value = 0;
+
+            BOOST_CHECK_EQUAL( WRLParseInt( cursor, value ), c.m_exp_ok );
+
+            if( c.m_exp_ok )
+            {
+                BOOST_CHECK_EQUAL( value, c.m_exp_value );
+                BOOST_CHECK_EQUAL( *cursor, '\0' );
+            }
+            else
+            {
+                BOOST_CHECK_EQUAL( cursor - c.m_text.c_str(), 0 );
+            }
+        }
+    }
+}
+
+
+/**
+ * Hexadecimal numbers are not parsed past the leading zero: the parser stops at
+ * the 'x', which is not a number separator, so the caller falls back to the
+ * stream conversion
+ */
+BOOST_AUTO_TEST_CASE( ParseHex )
+{
+    const std::string text = "0x1A";
+
+    const char* cursor = text.c_str();
+    double      value = 1.0;
+
+    BOOST_CHECK( WRLParseNumber( cursor, value ) );
+    BOOST_CHECK_EQUAL( value, 0.0 );
+    BOOST_CHECK_EQUAL( *cursor, 'x' );
+
+    cursor = text.c_str();
+    int intValue = 1;
+
+    BOOST_CHECK( WRLParseInt( cursor, intValue ) );
+    BOOST_CHECK_EQUAL( intValue, 0 );
+    BOOST_CHECK_EQUAL( *cursor, 'x' );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,6 +25,7 @@
 
 #include "tools/coroutines/coroutine_tools.h"
 #include "tools/io_benchmark/io_benchmark.h"
+#include "tools/poly_query_benchmark/poly_query_benchmark.h"
 
 /**
  * List of registered tools.
@@ -35,6 +36,7 @@
 const static std::vector<KI_TEST::UTILITY_PROGRAM*> known_tools = {
     &coroutine_tool,
     &io_benchmark_tool,
+    &poly_query_benchmark_tool,
 };
 
 
@@ -0,0 +1,296 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "poly_query_benchmark.h"
+
+#include <geometry/seg_batch.h>
+#include <geometry/shape_poly_set.h>
+
+#include <qa_utils/scoped_timer.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include <wx/string.h>
+
+
+using DURATION = std::chrono::microseconds;
+
+
+/**
+ * A single kind of query, run once through the segment index and once as
+ * a plain loop over every segment of the chain, so the results can be
+ * checked against each other as well as timed.
+ */
+struct QUERY_BENCH
+{
+    wxString name;
+
+    std::function<long( const SHAPE_LINE_CHAIN&, const VECTOR2I&, const VECTOR2I& )> indexed;
+    std::function<long( const SHAPE_LINE_CHAIN&, const VECTOR2I&, const VECTOR2I& )> linear;
+};
+
+
+static long linearDistance( const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP )
+{
+    int d = std::numeric_limits<int>::max();
+
+    for( int s = 0; s < aChain.SegmentCount(); s++ )
+        d = std::min( d, aChain.CSegment( s ).Distance( aP ) );
+
+    return d;
+}
+
+
+static long linearCollide( const SHAPE_LINE_CHAIN& aChain, const SEG& aSeg, int aClearance )
+{
+    for( int s = 0; s < aChain.SegmentCount(); s++ )
+    {
+        if( aChain.CSegment( s ).Collide( aSeg, aClearance ) )
+            return 1;
+    }
+
+    return 0;
+}
+
+
+static long linearInside( const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP )
+{
+    bool inside = false;
+
+    for( int s = 0; s < aChain.SegmentCount(); s++ )
+    {
+        const SEG seg = aChain.CSegment( s );
+
+        if( ( seg.A.y > aP.y ) != ( seg.B.y > aP.y ) )
+        {
+            double x = seg.A.x + double( aP.y - seg.A.y ) * ( seg.B.x - seg.A.x )
+                                         / ( seg.B.y - seg.A.y );
+
+            if( aP.x < x )
+                inside = !inside;
+        }
+    }
+
+    return inside;
+}
+
+
+static const std::vector<QUERY_BENCH> benchmarks = {
+    {
+        "PointInside",
+        []( const SHAPE_LINE_CHAIN& c, const VECTOR2I& p, const VECTOR2I& ) -> long {
+            return c.PointInside( p );
+        },
+        []( const SHAPE_LINE_CHAIN& c, const VECTOR2I& p, const VECTOR2I& ) -> long {
+            return linearInside( c, p );
+        },
+    },
+    {
+        "Distance(point)",
+        []( const SHAPE_LINE_CHAIN& c, const VECTOR2I& p, const VECTOR2I& ) -> long {
+            return c.Distance( p, true );
+        },
+        []( const SHAPE_LINE_CHAIN& c, const VECTOR2I& p, const VECTOR2I& ) -> long {
+            return linearDistance( c, p );
+        },
+    },
+    {
+        "Collide(SEG)",
+        []( const SHAPE_LINE_CHAIN& c, const VECTOR2I& p, const VECTOR2I& q ) -> long {
+            return c.Collide( SEG( p, q ), 1000 );
+        },
+        []( const SHAPE_LINE_CHAIN& c, const VECTOR2I& p, const VECTOR2I& q ) -> long {
+            return linearCollide( c, SEG( p, q ), 1000 );
+        },
+    },
+};
+
+
+/**
+ * Build a closed, roughly circular outline with a noisy radius, similar
+ * in shape to a zone fill outline.
+ */
+static SHAPE_LINE_CHAIN buildOutline( int aVertices, std::mt19937& aRng )
+{
+    const int radius = 10000000;
+    std::uniform_int_distribution<int> noise( 0, radius / 20 );
+
+    SHAPE_LINE_CHAIN chain;
+
+    for( int i = 0; i < aVertices; i++ )
+    {
+        const double a = 2.0 * M_PI * i / aVertices;
+        const int    r = radius + noise( aRng );
+
+        chain.Append( int( r * cos( a ) ), int( r * sin( a ) ) );
+    }
+
+    chain.SetClosed( true );
+    return chain;
+}
+
+
+int poly_query_benchmark_func( int argc, char* argv[] )
+{
+    auto& os = std::cout;
+
+    long vertices = 20000;
+    long queries = 2000;
+
+    if( argc > 1 && !wxString( argv[1] ).ToLong( &vertices ) )
+    {
+        os << "Usage: " << argv[0] << " [VERTICES] [QUERIES]" << std::endl;
+        return KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    if( argc > 2 && ( !wxString( argv[2] ).ToLong( &queries ) || queries < 1 ) )
+    {
+        os << "Usage: " << argv[0] << " [VERTICES] [QUERIES]" << std::endl;
+        return KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    std::mt19937 rng( 1 );
+    std::uniform_int_distribution<int> coord( -12000000, 12000000 );
+    std::uniform_int_distribution<int> offset( -500000, 500000 );
+
+    std::vector<std::pair<VECTOR2I, VECTOR2I>> points;
+
+    for( long i = 0; i < queries; i++ )
+    {
+        VECTOR2I p( coord( rng ), coord( rng ) );
+        points.emplace_back( p, p + VECTOR2I( offset( rng ), offset( rng ) ) );
+    }
+
+    os << "Polygon query benchmark" << std::endl;
+    os << "  Vertices: " << vertices << std::endl;
+    os << "  Queries:  " << queries << std::endl;
+    os << std::endl;
+
+    int ret = KI_TEST::RET_CODES::OK;
+
+    for( const auto& bench : benchmarks )
+    {
+        // A fresh chain for each benchmark, so that the first indexed query
+        // pays for building the index
+        const SHAPE_LINE_CHAIN chain = buildOutline( vertices, rng );
+
+        DURATION first, indexed, linear;
+        long     accIndexed = 0;
+        long     accLinear = 0;
+
+        {
+            SCOPED_TIMER<DURATION> timer( first );
+            accIndexed += bench.indexed( chain, points[0].first, points[0].second );
+        }
+
+        {
+            SCOPED_TIMER<DURATION> timer( indexed );
+
+            for( const auto& pt : points )
+                accIndexed += bench.indexed( chain, pt.first, pt.second );
+        }
+
+        {
+            SCOPED_TIMER<DURATION> timer( linear );
+
+            for( const auto& pt : points )
+                accLinear += bench.linear( chain, pt.first, pt.second );
+        }
+
+        // Undo the extra first query so the accumulators are comparable
+        accIndexed -= bench.indexed( chain, points[0].first, points[0].second );
+
+        os << wxString::Format( "%-18s first: %8d us, indexed: %8.2f us/query, "
+                                "linear: %8.2f us/query",
+                      bench.name, (int) first.count(),
+                      double( indexed.count() ) / queries, double( linear.count() ) / queries )
+           << std::endl;
+
+        if( accIndexed != accLinear )
+        {
+            os << "  result mismatch: " << accIndexed << " != " << accLinear << std::endl;
+            ret = KI_TEST::RET_CODES::TOOL_SPECIFIC;
+        }
+    }
+
+    os << std::endl;
+
+    // The segment kernels alone, over all the segments of an outline
+    const SHAPE_LINE_CHAIN chain = buildOutline( vertices, rng );
+    const wxString         kernelNames[] = { "scalar", "SSE4.2", "AVX2" };
+    long                   accReference = 0;
+
+    for( SEG_BATCH::KERNEL kernel : { SEG_BATCH::SCALAR, SEG_BATCH::SSE42, SEG_BATCH::AVX2 } )
+    {
+        if( !SEG_BATCH::HasKernel( kernel ) )
+            continue;
+
+        SEG_BATCH batch( &chain.CPoint( 0 ), &chain.CPoint( 1 ), chain.PointCount() - 1, kernel );
+
+        DURATION distance, collide;
+        long     acc = 0;
+
+        {
+            SCOPED_TIMER<DURATION> timer( distance );
+
+            for( const auto& pt : points )
+                acc += batch.SquaredDistance( pt.first ) % 1000;
+        }
+
+        {
+            SCOPED_TIMER<DURATION> timer( collide );
+
+            for( const auto& pt : points )
+                acc += batch.Collide( SEG( pt.first, pt.second ), 1000 );
+        }
+
+        os << wxString::Format( "SEG_BATCH %-8s distance: %8.2f us/query, collide: %8.2f us/query",
+                      kernelNames[kernel], double( distance.count() ) / queries,
+                      double( collide.count() ) / queries )
+           << std::endl;
+
+        if( kernel == SEG_BATCH::SCALAR )
+            accReference = acc;
+
+        if( acc != accReference )
+        {
+            os << "  result mismatch: " << acc << " != " << accReference << std::endl;
+            ret = KI_TEST::RET_CODES::TOOL_SPECIFIC;
+        }
+    }
+
+    return ret;
+}
+
+
+KI_TEST::UTILITY_PROGRAM poly_query_benchmark_tool = {
+    "poly_query_benchmark",
+    "Benchmark indexed SHAPE_LINE_CHAIN queries against linear scans",
+    poly_query_benchmark_func,
+};
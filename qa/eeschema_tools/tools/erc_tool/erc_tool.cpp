@@ -0,0 +1,491 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "erc_tool.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+
+#include <fctsys.h>
+#include <pgm_base.h>
+#include <kiway.h>
+#include <project.h>
+#include <reporter.h>
+#include <wildcards_and_files_ext.h>
+
+#include <general.h>
+#include <connection_graph.h>
+#include <erc.h>
+#include <erc_settings.h>
+#include <netlist_object.h>
+#include <netlist_exporters/netlist_exporter_kicad.h>
+#include <sch_io_mgr.h>
+#include <sch_marker.h>
+#include <sch_reference_list.h>
+#include <sch_screen.h>
+#include <sch_sheet.h>
+#include <sch_sheet_path.h>
+#include <symbol_lib_table.h>
+
+#include <qa_utils/scoped_timer.h>
+
+
+extern int DiagErc[PINTYPE_COUNT][PINTYPE_COUNT];
+extern int DefaultDiagErc[PINTYPE_COUNT][PINTYPE_COUNT];
+
+
+using ERC_DURATION = std::chrono::microseconds;
+
+
+/**
+ * A program object without any user interface, needed by the Eeschema KIFACE
+ */
+static struct PGM_ERC_TOOL : public PGM_BASE
+{
+    bool OnPgmInit() override
+    {
+        return true;
+    }
+
+    void OnPgmExit() override
+    {
+        PGM_BASE::Destroy();
+    }
+
+    void MacOpenFile( const wxString& aFileName ) override
+    {
+    }
+} program;
+
+
+/**
+ * Format a string as a JSON string literal
+ */
+static std::string jsonString( const wxString& aStr )
+{
+    std::string out = "\"";
+
+    for( char c : std::string( aStr.ToUTF8() ) )
+    {
+        switch( c )
+        {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if( (unsigned char) c < 0x20 )
+            {
+                char buf[8];
+                snprintf( buf, sizeof( buf ), "\\u%04x", c );
+                out += buf;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+
+    return out + "\"";
+}
+
+
+/**
+ * ERC runner: loads schematics without any frame, runs the ERC, annotation checks and
+ * netlist/BOM exports on them and writes a report for each schematic as a JSON object
+ * on a single line (JSON lines format), with the time spent in each step.
+ *
+ * Eeschema holds the current schematic in global state (g_RootSheet, g_ConnectionGraph),
+ * so schematics are processed one after another: to use several cores, run several
+ * instances of the tool on separate sets of projects.
+ */
+class ERC_RUNNER
+{
+public:
+    /**
+     * What the ERC runner does for each schematic
+     */
+    struct EXECUTION_CONTEXT
+    {
+        bool     m_verbose;
+        bool     m_run_erc;
+        wxString m_netlist_dir;     ///< if not empty, write the netlists here
+        wxString m_bom_dir;         ///< if not empty, write the BOM (XML netlists) here
+    };
+
+    ERC_RUNNER( const EXECUTION_CONTEXT& aExecCtx ) :
+        m_exec_context( aExecCtx ),
+        m_kiway( &program, KFCTL_STANDALONE ),
+        m_graph( nullptr )
+    {
+        // The ERC matrix is normally initialized by the ERC dialog
+        memcpy( DiagErc, DefaultDiagErc, sizeof( DiagErc ) );
+        m_erc_settings.LoadDefaults();
+    }
+
+    /**
+     * Run the checks on a schematic, and write the report.
+     * @return true if the schematic was loaded and has no ERC and annotation errors
+     */
+    bool Execute( const wxString& aFileName, std::ostream& aReport )
+    {
+        wxFileName fn( aFileName );
+        fn.MakeAbsolute();
+
+        if( m_exec_context.m_verbose )
+            std::cerr << "Checking " << fn.GetFullPath() << std::endl;
+
+        aReport << "{\"file\": " << jsonString( fn.GetFullPath() );
+
+        wxFileName pro = fn;
+        pro.SetExt( ProjectFileExtension );
+        m_kiway.Prj().SetProjectFullName( pro.GetFullPath() );
+
+        ERC_DURATION duration;
+
+        try
+        {
+            SCOPED_TIMER<ERC_DURATION> timer( duration );
+            g_RootSheet = SCH_IO_MGR::Load( SCH_IO_MGR::SCH_LEGACY, fn.GetFullPath(), &m_kiway );
+        }
+        catch( const IO_ERROR& ioe )
+        {
+            aReport << ", \"status\": \"load_error\", \"error\": " << jsonString( ioe.What() )
+                    << "}" << std::endl;
+            return false;
+        }
+
+        aReport << ", \"status\": \"ok\", \"timings_us\": {\"load\": " << duration.count();
+
+        bool ok = check( aReport, fn );
+
+        // Release this schematic before loading the next one
+        m_graph.Reset();
+        delete g_RootSheet;
+        g_RootSheet = nullptr;
+
+        return ok;
+    }
+
+private:
+    bool check( std::ostream& aReport, const wxFileName& aFileName )
+    {
+        ERC_DURATION duration;
+        SCH_SCREENS  screens;
+        SCH_SHEET_LIST sheets( g_RootSheet );
+
+        {
+            SCOPED_TIMER<ERC_DURATION> timer( duration );
+            screens.UpdateSymbolLinks();
+            sheets.AnnotatePowerSymbols();
+        }
+
+        aReport << ", \"symbol_links\": " << duration.count();
+
+        wxString annotationMsgs;
+        int annotationErrors;
+
+        {
+            SCOPED_TIMER<ERC_DURATION> timer( duration );
+            SCH_REFERENCE_LIST components;
+            WX_STRING_REPORTER reporter( &annotationMsgs );
+
+            sheets.GetComponents( components );
+            annotationErrors = components.CheckAnnotation( reporter );
+        }
+
+        aReport << ", \"annotation\": " << duration.count();
+
+        g_ConnectionGraph = &m_graph;
+
+        {
+            SCOPED_TIMER<ERC_DURATION> timer( duration );
+            m_graph.Recalculate( sheets, true );
+        }
+
+        aReport << ", \"connectivity\": " << duration.count();
+
+        if( m_exec_context.m_run_erc )
+        {
+            SCOPED_TIMER<ERC_DURATION> timer( duration );
+            runErc( screens, sheets );
+        }
+
+        aReport << ", \"erc\": " << ( m_exec_context.m_run_erc ? duration.count() : 0 );
+
+        bool exported = true;
+
+        if( !m_exec_context.m_netlist_dir.IsEmpty() )
+        {
+            SCOPED_TIMER<ERC_DURATION> timer( duration );
+            exported &= exportNetlist( sheets, aFileName, m_exec_context.m_netlist_dir,
+                                       NetlistFileExtension, 0 );
+        }
+
+        aReport << ", \"netlist\": "
+                << ( m_exec_context.m_netlist_dir.IsEmpty() ? 0 : duration.count() );
+
+        if( !m_exec_context.m_bom_dir.IsEmpty() )
+        {
+            SCOPED_TIMER<ERC_DURATION> timer( duration );
+            exported &= exportNetlist( sheets, aFileName, m_exec_context.m_bom_dir,
+                                       wxT( "xml" ), GNL_ALL );
+        }
+
+        aReport << ", \"bom\": " << ( m_exec_context.m_bom_dir.IsEmpty() ? 0 : duration.count() )
+                << "}";
+
+        aReport << ", \"annotation_errors\": " << annotationErrors
+                << ", \"annotation_messages\": " << jsonString( annotationMsgs )
+                << ", \"export_ok\": " << ( exported ? "true" : "false" );
+
+        int ercErrors = reportMarkers( aReport, sheets );
+
+        aReport << "}" << std::endl;
+
+        return exported && annotationErrors == 0 && ercErrors == 0;
+    }
+
+    /**
+     * Run the same tests as the ERC dialog
+     */
+    void runErc( SCH_SCREENS& aScreens, SCH_SHEET_LIST& aSheets )
+    {
+        aScreens.DeleteAllMarkers( MARKER_BASE::MARKER_ERC );
+
+        TestDuplicateSheetNames( true );
+        TestConflictingBusAliases();
+        m_graph.RunERC( m_erc_settings );
+        TestMultiunitFootprints( aSheets );
+
+        std::unique_ptr<NETLIST_OBJECT_LIST> objectsConnectedList( new NETLIST_OBJECT_LIST );
+
+        if( objectsConnectedList->BuildNetListInfo( aSheets ) )
+            TestNetlistErc( objectsConnectedList.get(), m_erc_settings );
+    }
+
+    bool exportNetlist( SCH_SHEET_LIST& aSheets, const wxFileName& aSchFile,
+                        const wxString& aOutDir, const wxString& aExt, unsigned aOptions )
+    {
+        // The exporter owns the netlist object list
+        NETLIST_OBJECT_LIST* objectsConnectedList = new NETLIST_OBJECT_LIST;
+        objectsConnectedList->BuildNetListInfo( aSheets );
+
+        wxFileName out( aOutDir, aSchFile.GetName(), aExt );
+        SYMBOL_LIB_TABLE* libTable = m_kiway.Prj().SchSymbolLibTable();
+
+        if( aOptions == 0 )
+        {
+            NETLIST_EXPORTER_KICAD exporter( libTable, objectsConnectedList, &m_graph );
+            return exporter.WriteNetlist( out.GetFullPath(), aOptions );
+        }
+
+        NETLIST_EXPORTER_GENERIC exporter( libTable, objectsConnectedList, &m_graph );
+        return exporter.WriteNetlist( out.GetFullPath(), aOptions );
+    }
+
+    /**
+     * Write the ERC markers of the schematic
+     * @return the number of ERC errors
+     */
+    int reportMarkers( std::ostream& aReport, SCH_SHEET_LIST& aSheets )
+    {
+        int errors = 0;
+        int warnings = 0;
+        std::ostringstream markers;
+
+        for( SCH_SHEET_PATH& sheet : aSheets )
+        {
+            for( SCH_ITEM* item = sheet.LastDrawList(); item; item = item->Next() )
+            {
+                if( item->Type() != SCH_MARKER_T )
+                    continue;
+
+                SCH_MARKER* marker = static_cast<SCH_MARKER*>( item );
+
+                if( marker->GetMarkerType() != MARKER_BASE::MARKER_ERC )
+                    continue;
+
+                bool isError = marker->GetErrorLevel() == MARKER_BASE::MARKER_SEVERITY_ERROR;
+
+                if( isError )
+                    errors++;
+                else
+                    warnings++;
+
+                const DRC_ITEM& rpt = marker->GetReporter();
+
+                markers << ( errors + warnings > 1 ? ", " : "" )
+                        << "{\"code\": " << rpt.GetErrorCode()
+                        << ", \"severity\": \"" << ( isError ? "error" : "warning" ) << "\""
+                        << ", \"sheet\": " << jsonString( sheet.PathHumanReadable() )
+                        << ", \"x\": " << rpt.GetPointA().x
+                        << ", \"y\": " << rpt.GetPointA().y
+                        << ", \"message\": " << jsonString( rpt.GetErrorText() + wxT( ": " )
+                                                            + rpt.GetMainText() )
+                        << "}";
+            }
+        }
+
+        aReport << ", \"erc_errors\": " << errors << ", \"erc_warnings\": " << warnings
+                << ", \"markers\": [" << markers.str() << "]";
+
+        return errors;
+    }
+
+    const EXECUTION_CONTEXT m_exec_context;
+    KIWAY                   m_kiway;
+    CONNECTION_GRAPH        m_graph;
+    ERC_SETTINGS            m_erc_settings;
+};
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    {
+            wxCMD_LINE_SWITCH,
+            "h",
+            "help",
+            _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE,
+            wxCMD_LINE_OPTION_HELP,
+    },
+    {
+            wxCMD_LINE_SWITCH,
+            "v",
+            "verbose",
+            _( "print progress information on stderr" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_SWITCH,
+            "E",
+            "no-erc",
+            _( "do not run the ERC (only annotation checks and exports)" ).mb_str(),
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "n",
+            "netlist-dir",
+            _( "write the KiCad netlist of each schematic in this directory" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "b",
+            "bom-dir",
+            _( "write the BOM (XML netlist) of each schematic in this directory" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    {
+            wxCMD_LINE_OPTION,
+            "o",
+            "output",
+            _( "write the JSON report to this file instead of stdout" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+    },
+    {
+            wxCMD_LINE_PARAM,
+            nullptr,
+            nullptr,
+            _( "schematic files" ).mb_str(),
+            wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_MULTIPLE,
+    },
+    { wxCMD_LINE_NONE }
+};
+
+/**
+ * Tool-specific return codes
+ */
+enum ERC_RET_CODES
+{
+    /// At least one schematic could not be loaded or exported, or has ERC errors
+    CHECK_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+};
+
+
+int erc_main_func( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText(
+            _( "This program runs the ERC, annotation checks and netlist exports on the "
+               "given schematic files without any user interface, and writes a JSON report "
+               "(one line per schematic). Run several instances to check several projects "
+               "in parallel." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    // Give the Eeschema KIFACE its program object
+    int kifaceVersion;
+    KIFACE_GETTER( &kifaceVersion, KIFACE_VERSION, &program );
+
+    ERC_RUNNER::EXECUTION_CONTEXT exec_context{
+        cl_parser.Found( "verbose" ),
+        !cl_parser.Found( "no-erc" ),
+    };
+
+    cl_parser.Found( "netlist-dir", &exec_context.m_netlist_dir );
+    cl_parser.Found( "bom-dir", &exec_context.m_bom_dir );
+
+    wxString      outputFile;
+    std::ofstream outputStream;
+
+    if( cl_parser.Found( "output", &outputFile ) )
+        outputStream.open( outputFile.ToStdString() );
+
+    std::ostream& report = outputStream.is_open() ? outputStream : std::cout;
+
+    ERC_RUNNER runner( exec_context );
+    bool       ok = true;
+
+    for( size_t i = 0; i < cl_parser.GetParamCount(); i++ )
+        ok &= runner.Execute( cl_parser.GetParam( i ), report );
+
+    return ok ? KI_TEST::RET_CODES::OK : ERC_RET_CODES::CHECK_FAILED;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM erc_tool = {
+    "erc",
+    "Run ERC, annotation checks and netlist exports on schematics",
+    erc_main_func,
+};
@@ -24,6 +24,7 @@
 #include <qa_utils/utility_program.h>
 
 #include "tools/drc_tool/drc_tool.h"
+#include "tools/geometry_benchmark/geometry_benchmark.h"
 #include "tools/pcb_parser/pcb_parser_tool.h"
 #include "tools/polygon_generator/polygon_generator.h"
 #include "tools/polygon_triangulation/polygon_triangulation.h"
@@ -36,6 +37,7 @@
  */
 const static std::vector<KI_TEST::UTILITY_PROGRAM*> known_tools = {
     &drc_tool,
+    &geometry_benchmark_tool,
     &pcb_parser_tool,
     &polygon_generator_tool,
     &polygon_triangulation_tool,
@@ -0,0 +1,669 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2019 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "geometry_benchmark.h"
+
+#include <geometry/packed_rtree.h>
+#include <geometry/rtree.h>
+#include <geometry/seg.h>
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+#include <pcbnew_utils/board_file_utils.h>
+#include <qa_utils/scoped_timer.h>
+
+#include <class_board.h>
+#include <class_zone.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+#include <wx/tokenzr.h>
+
+
+using DURATION = std::chrono::microseconds;
+
+using SEG_RTREE = RTree<int, int, 2, double>;
+using SEG_PACKED_RTREE = PACKED_RTREE<int, int, 2>;
+
+
+/**
+ * The shapes a set of benchmarks runs on: an area to fill and the obstacles
+ * to knock out of it, like a zone and the copper items around it.
+ */
+struct BENCH_INPUT
+{
+    std::string    m_name;
+    SHAPE_POLY_SET m_area;
+    SHAPE_POLY_SET m_obstacles;
+
+    // Built once from the above, so that each benchmark only times its own step
+    SHAPE_POLY_SET                m_holed;      ///< m_area minus m_obstacles
+    SHAPE_POLY_SET                m_fractured;  ///< m_holed, fractured
+    std::vector<SHAPE_LINE_CHAIN> m_chains;     ///< the contours of m_holed
+    std::vector<SEG>              m_segs;       ///< the segments of m_chains
+    std::vector<SEG>              m_queries;    ///< random short segments over m_area
+};
+
+
+/**
+ * A benchmark prepares a run from an input (not timed), and returns the step
+ * to time.  The step returns a checksum of its result, which is reported with
+ * the timings so that a change of behaviour shows in the diff too.
+ */
+struct BENCHMARK
+{
+    std::string m_name;
+
+    std::function<std::function<long()>( const BENCH_INPUT& )> m_prepare;
+};
+
+
+static void segBox( const SEG& aSeg, int aMin[2], int aMax[2] )
+{
+    aMin[0] = std::min( aSeg.A.x, aSeg.B.x );
+    aMin[1] = std::min( aSeg.A.y, aSeg.B.y );
+    aMax[0] = std::max( aSeg.A.x, aSeg.B.x );
+    aMax[1] = std::max( aSeg.A.y, aSeg.B.y );
+}
+
+
+static void fillRTree( SEG_RTREE& aTree, const std::vector<SEG>& aSegs )
+{
+    for( size_t i = 0; i < aSegs.size(); i++ )
+    {
+        int min[2], max[2];
+        segBox( aSegs[i], min, max );
+
+        aTree.Insert( min, max, (int) i );
+    }
+}
+
+
+/**
+ * Entry getter for the bulk loading of R-trees: the segments indexed by position.
+ */
+static std::function<void( size_t, int*, int*, int& )> segEntries( const std::vector<SEG>& aSegs )
+{
+    return [&aSegs]( size_t aIndex, int* aMin, int* aMax, int& aData )
+           {
+               segBox( aSegs[aIndex], aMin, aMax );
+               aData = (int) aIndex;
+           };
+}
+
+
+/**
+ * Run the query segments' boxes on a tree (RTree or PACKED_RTREE).
+ * @return the number of entries found
+ */
+template <class TREE>
+static long searchRTree( TREE& aTree, const std::vector<SEG>& aQueries )
+{
+    long found = 0;
+    auto visitor = []( const int& ) { return true; };
+
+    for( const SEG& query : aQueries )
+    {
+        int min[2], max[2];
+        segBox( query, min, max );
+
+        found += aTree.Search( min, max, visitor );
+    }
+
+    return found;
+}
+
+
+static const std::vector<BENCHMARK> benchmarks = {
+    {
+        "SHAPE_POLY_SET::Simplify",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            auto polys = std::make_shared<SHAPE_POLY_SET>( aInput.m_obstacles );
+
+            return [polys]() -> long {
+                polys->Simplify( SHAPE_POLY_SET::PM_FAST );
+                return polys->TotalVertices();
+            };
+        },
+    },
+    {
+        "SHAPE_POLY_SET::BooleanSubtract",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            auto polys = std::make_shared<SHAPE_POLY_SET>( aInput.m_area );
+
+            return [polys, &aInput]() -> long {
+                polys->BooleanSubtract( aInput.m_obstacles, SHAPE_POLY_SET::PM_FAST );
+                return polys->TotalVertices();
+            };
+        },
+    },
+    {
+        "SHAPE_POLY_SET::Fracture",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            auto polys = std::make_shared<SHAPE_POLY_SET>( aInput.m_holed );
+
+            return [polys]() -> long {
+                polys->Fracture( SHAPE_POLY_SET::PM_FAST );
+                return polys->TotalVertices();
+            };
+        },
+    },
+    {
+        "SHAPE_POLY_SET::CacheTriangulation",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            auto polys = std::make_shared<SHAPE_POLY_SET>( aInput.m_fractured );
+
+            return [polys]() -> long {
+                polys->CacheTriangulation();
+
+                long triangles = 0;
+
+                for( unsigned i = 0; i < polys->TriangulatedPolyCount(); i++ )
+                    triangles += polys->TriangulatedPolygon( i )->GetTriangleCount();
+
+                return triangles;
+            };
+        },
+    },
+    {
+        "SHAPE_LINE_CHAIN::Collide",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            // The chains are shared between the runs: the first one pays for
+            // any lazily built index, which shows in the maximum
+            return [&aInput]() -> long {
+                long hits = 0;
+
+                for( const SEG& query : aInput.m_queries )
+                {
+                    for( const SHAPE_LINE_CHAIN& chain : aInput.m_chains )
+                        hits += chain.Collide( query, 1000 );
+                }
+
+                return hits;
+            };
+        },
+    },
+    {
+        "SEG::Distance",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            return [&aInput]() -> long {
+                long acc = 0;
+
+                for( const SEG& query : aInput.m_queries )
+                {
+                    int d = std::numeric_limits<int>::max();
+
+                    for( const SEG& seg : aInput.m_segs )
+                        d = std::min( d, seg.Distance( query ) );
+
+                    acc += d;
+                }
+
+                return acc;
+            };
+        },
+    },
+    {
+        "RTree::Insert",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            auto tree = std::make_shared<SEG_RTREE>();
+
+            return [tree, &aInput]() -> long {
+                fillRTree( *tree, aInput.m_segs );
+                return aInput.m_segs.size();
+            };
+        },
+    },
+    {
+        "RTree::BulkInsert",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            return [&aInput]() -> long {
+                SEG_RTREE tree;
+                tree.BulkInsert( aInput.m_segs.size(), segEntries( aInput.m_segs ) );
+                return aInput.m_segs.size();
+            };
+        },
+    },
+    {
+        "RTree::Search",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            auto tree = std::make_shared<SEG_RTREE>();
+            fillRTree( *tree, aInput.m_segs );
+
+            return [tree, &aInput]() -> long {
+                return searchRTree( *tree, aInput.m_queries );
+            };
+        },
+    },
+    {
+        "RTree::Search (bulk loaded)",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            auto tree = std::make_shared<SEG_RTREE>();
+            tree->BulkInsert( aInput.m_segs.size(), segEntries( aInput.m_segs ) );
+
+            return [tree, &aInput]() -> long {
+                return searchRTree( *tree, aInput.m_queries );
+            };
+        },
+    },
+    {
+        "PACKED_RTREE::Build",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            return [&aInput]() -> long {
+                SEG_PACKED_RTREE tree;
+                tree.Build( aInput.m_segs.size(), segEntries( aInput.m_segs ) );
+                return tree.Size();
+            };
+        },
+    },
+    {
+        "PACKED_RTREE::Search",
+        []( const BENCH_INPUT& aInput ) -> std::function<long()> {
+            auto tree = std::make_shared<SEG_PACKED_RTREE>();
+            tree->Build( aInput.m_segs.size(), segEntries( aInput.m_segs ) );
+
+            return [tree, &aInput]() -> long {
+                return searchRTree( *tree, aInput.m_queries );
+            };
+        },
+    },
+};
+
+
+/**
+ * Build the derived shapes and the queries of an input, once its area and
+ * obstacles are set.
+ */
+static void prepareInput( BENCH_INPUT& aInput, int aQueryCount, std::mt19937& aRng )
+{
+    aInput.m_holed = aInput.m_area;
+    aInput.m_holed.BooleanSubtract( aInput.m_obstacles, SHAPE_POLY_SET::PM_FAST );
+
+    aInput.m_fractured = aInput.m_holed;
+    aInput.m_fractured.Fracture( SHAPE_POLY_SET::PM_FAST );
+
+    for( int i = 0; i < aInput.m_holed.OutlineCount(); i++ )
+    {
+        for( const SHAPE_LINE_CHAIN& chain : aInput.m_holed.Polygon( i ) )
+        {
+            aInput.m_chains.push_back( chain );
+
+            for( int s = 0; s < chain.SegmentCount(); s++ )
+                aInput.m_segs.push_back( chain.CSegment( s ) );
+        }
+    }
+
+    const BOX2I bbox = aInput.m_area.BBox();
+    const int   maxLength = std::max( bbox.GetWidth(), bbox.GetHeight() ) / 50 + 1;
+
+    std::uniform_int_distribution<int> x( bbox.GetLeft(), bbox.GetRight() );
+    std::uniform_int_distribution<int> y( bbox.GetTop(), bbox.GetBottom() );
+    std::uniform_int_distribution<int> offset( -maxLength, maxLength );
+
+    for( int i = 0; i < aQueryCount; i++ )
+    {
+        const VECTOR2I p( x( aRng ), y( aRng ) );
+        aInput.m_queries.emplace_back( p, p + VECTOR2I( offset( aRng ), offset( aRng ) ) );
+    }
+}
+
+
+/**
+ * A synthetic input of about aVertices vertices: a round area with a noisy
+ * outline, and a grid of octagonal pads of as many vertices in total.
+ */
+static std::unique_ptr<BENCH_INPUT> buildSyntheticInput( int aVertices, std::mt19937& aRng )
+{
+    const int radius = 50000000;    // 50 mm
+
+    auto input = std::make_unique<BENCH_INPUT>();
+    input->m_name = "synthetic_" + std::to_string( aVertices );
+
+    std::uniform_int_distribution<int> noise( 0, radius / 20 );
+    SHAPE_LINE_CHAIN                   outline;
+
+    for( int i = 0; i < aVertices; i++ )
+    {
+        const double a = 2.0 * M_PI * i / aVertices;
+        const int    r = radius - noise( aRng );
+
+        outline.Append( int( r * cos( a ) ), int( r * sin( a ) ) );
+    }
+
+    outline.SetClosed( true );
+    input->m_area.AddOutline( outline );
+
+    const int padsPerSide = std::max( 1, int( std::sqrt( aVertices / 8.0 ) ) );
+    const int pitch = 2 * radius / padsPerSide;
+    const int padRadius = pitch * 3 / 10;
+
+    std::uniform_int_distribution<int> jitter( -pitch / 10, pitch / 10 );
+
+    for( int i = 0; i < padsPerSide; i++ )
+    {
+        for( int j = 0; j < padsPerSide; j++ )
+        {
+            const VECTOR2I centre( -radius + pitch / 2 + i * pitch + jitter( aRng ),
+                                   -radius + pitch / 2 + j * pitch + jitter( aRng ) );
+            SHAPE_LINE_CHAIN pad;
+
+            for( int k = 0; k < 8; k++ )
+            {
+                const double a = M_PI * ( 2 * k + 1 ) / 8;
+                pad.Append( centre + VECTOR2I( int( padRadius * cos( a ) ),
+                                               int( padRadius * sin( a ) ) ) );
+            }
+
+            pad.SetClosed( true );
+            input->m_obstacles.AddOutline( pad );
+        }
+    }
+
+    return input;
+}
+
+
+/**
+ * An input taken from a board: its zone outlines (or its board outline, if
+ * it has no zones) as the area, and its copper items as the obstacles.
+ */
+static std::unique_ptr<BENCH_INPUT> buildBoardInput( const std::string& aFilename )
+{
+    auto brd = KI_TEST::ReadBoardFromFileOrStream( aFilename );
+
+    if( !brd )
+        return nullptr;
+
+    auto input = std::make_unique<BENCH_INPUT>();
+    input->m_name = wxFileName( aFilename ).GetName().ToStdString();
+
+    for( int i = 0; i < brd->GetAreaCount(); i++ )
+        input->m_area.Append( *brd->GetArea( i )->Outline() );
+
+    if( input->m_area.OutlineCount() == 0 )
+        brd->GetBoardPolygonOutlines( input->m_area );
+
+    brd->ConvertBrdLayerToPolygonalContours( F_Cu, input->m_obstacles );
+    brd->ConvertBrdLayerToPolygonalContours( B_Cu, input->m_obstacles );
+
+    if( input->m_area.OutlineCount() == 0 )
+        return nullptr;
+
+    return input;
+}
+
+
+/**
+ * The timings of a benchmark on an input, in microseconds
+ */
+struct BENCH_RESULT
+{
+    std::string m_input;
+    std::string m_benchmark;
+    int         m_vertices;
+    long        m_min;
+    long        m_median;
+    long        m_mean;
+    long        m_max;
+    long        m_checksum;
+};
+
+
+static BENCH_RESULT runBenchmark( const BENCHMARK& aBench, const BENCH_INPUT& aInput,
+                                  int aRepeat )
+{
+    BENCH_RESULT      result;
+    std::vector<long> times;
+
+    result.m_input = aInput.m_name;
+    result.m_benchmark = aBench.m_name;
+    result.m_vertices = aInput.m_area.TotalVertices() + aInput.m_obstacles.TotalVertices();
+    result.m_checksum = 0;
+
+    for( int i = 0; i < aRepeat; i++ )
+    {
+        std::function<long()> step = aBench.m_prepare( aInput );
+        DURATION              duration;
+
+        {
+            SCOPED_TIMER<DURATION> timer( duration );
+            result.m_checksum = step();
+        }
+
+        times.push_back( duration.count() );
+    }
+
+    std::sort( times.begin(), times.end() );
+
+    long total = 0;
+
+    for( long t : times )
+        total += t;
+
+    result.m_min = times.front();
+    result.m_median = times[times.size() / 2];
+    result.m_mean = total / (long) times.size();
+    result.m_max = times.back();
+
+    return result;
+}
+
+
+static std::string jsonString( const std::string& aStr )
+{
+    std::string quoted = "\"";
+
+    for( char c : aStr )
+    {
+        if( c == '"' || c == '\\' )
+            quoted += '\\';
+
+        quoted += c;
+    }
+
+    return quoted + "\"";
+}
+
+
+/**
+ * Write the results as JSON, one result per line and in a fixed order, so
+ * that the files of two runs can be compared with a plain diff.
+ */
+static void writeJson( std::ostream& aStream, const std::vector<BENCH_RESULT>& aResults,
+                       int aRepeat, int aQueries )
+{
+    aStream << "{\n";
+    aStream << "  \"tool\": \"geometry_benchmark\",\n";
+    aStream << "  \"repeat\": " << aRepeat << ",\n";
+    aStream << "  \"queries\": " << aQueries << ",\n";
+    aStream << "  \"unit\": \"us\",\n";
+    aStream << "  \"results\": [\n";
+
+    for( size_t i = 0; i < aResults.size(); i++ )
+    {
+        const BENCH_RESULT& r = aResults[i];
+
+        aStream << "    { \"input\": " << jsonString( r.m_input )
+                << ", \"benchmark\": " << jsonString( r.m_benchmark )
+                << ", \"vertices\": " << r.m_vertices
+                << ", \"min\": " << r.m_min
+                << ", \"median\": " << r.m_median
+                << ", \"mean\": " << r.m_mean
+                << ", \"max\": " << r.m_max
+                << ", \"checksum\": " << r.m_checksum << " }"
+                << ( i + 1 < aResults.size() ? "," : "" ) << "\n";
+    }
+
+    aStream << "  ]\n";
+    aStream << "}\n";
+}
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_SWITCH, "h", "help", _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_SWITCH, "v", "verbose", _( "print progress on stderr" ).mb_str() },
+    { wxCMD_LINE_OPTION, "s", "sizes",
+            _( "comma separated vertex counts of the synthetic inputs (default 1000,10000)" )
+                    .mb_str(),
+            wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, "r", "repeat", _( "runs of each benchmark (default 5)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, "q", "queries", _( "queries per run (default 500)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, "f", "filter", _( "only run the benchmarks containing this" ).mb_str(),
+            wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_OPTION, "o", "output", _( "JSON output file (default stdout)" ).mb_str(),
+            wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_PARAM, nullptr, nullptr, _( "board files to take real inputs from" ).mb_str(),
+            wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum GEOM_BENCH_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    WRITE_FAILED,
+};
+
+
+int geometry_benchmark_main( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText(
+            _( "This program times the common geometry operations (polygon booleans, "
+               "fracturing, triangulation, collision and distance queries, R-tree) on "
+               "synthetic inputs and on the outlines of the given boards, e.g. "
+               "qa/data/complex_hierarchy.kicad_pcb, and writes the results as JSON." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    const bool verbose = cl_parser.Found( "verbose" );
+
+    long     repeat = 5;
+    long     queries = 500;
+    wxString sizes = "1000,10000";
+    wxString filter;
+    wxString output;
+
+    cl_parser.Found( "repeat", &repeat );
+    cl_parser.Found( "queries", &queries );
+    cl_parser.Found( "sizes", &sizes );
+    cl_parser.Found( "filter", &filter );
+    cl_parser.Found( "output", &output );
+
+    if( repeat < 1 || queries < 1 )
+        return KI_TEST::RET_CODES::BAD_CMDLINE;
+
+    // Fixed seed: the same inputs, and checksums, on every run
+    std::mt19937                             rng( 1 );
+    std::vector<std::unique_ptr<BENCH_INPUT>> inputs;
+
+    wxStringTokenizer tokenizer( sizes, "," );
+
+    while( tokenizer.HasMoreTokens() )
+    {
+        long vertices;
+
+        if( !tokenizer.GetNextToken().ToLong( &vertices ) || vertices < 3 )
+            return KI_TEST::RET_CODES::BAD_CMDLINE;
+
+        inputs.push_back( buildSyntheticInput( vertices, rng ) );
+    }
+
+    for( unsigned i = 0; i < cl_parser.GetParamCount(); i++ )
+    {
+        const auto filename = cl_parser.GetParam( i ).ToStdString();
+        auto       input = buildBoardInput( filename );
+
+        if( !input )
+        {
+            std::cerr << "Could not take outlines from " << filename << std::endl;
+            return GEOM_BENCH_RET_CODES::LOAD_FAILED;
+        }
+
+        inputs.push_back( std::move( input ) );
+    }
+
+    std::vector<BENCH_RESULT> results;
+
+    for( auto& input : inputs )
+    {
+        prepareInput( *input, queries, rng );
+
+        for( const BENCHMARK& bench : benchmarks )
+        {
+            if( !filter.IsEmpty() && !wxString( bench.m_name ).Contains( filter ) )
+                continue;
+
+            results.push_back( runBenchmark( bench, *input, repeat ) );
+
+            if( verbose )
+            {
+                std::cerr << input->m_name << " " << bench.m_name << ": "
+                          << results.back().m_median << " us" << std::endl;
+            }
+        }
+    }
+
+    if( output.IsEmpty() )
+    {
+        writeJson( std::cout, results, repeat, queries );
+    }
+    else
+    {
+        std::ofstream fout( output.ToStdString() );
+        writeJson( fout, results, repeat, queries );
+
+        if( !fout )
+            return GEOM_BENCH_RET_CODES::WRITE_FAILED;
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+/*
+ * Define the tool interface
+ */
+KI_TEST::UTILITY_PROGRAM geometry_benchmark_tool = {
+    "geometry_benchmark",
+    "Time the geometry primitives and write the results as JSON",
+    geometry_benchmark_main,
+};
@@ -25,12 +25,19 @@
 
 #include "polygon_generator.h"
 
+#include <chrono>
+#include <cstring>
+
 #include <geometry/shape_file_io.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_poly_set.h>
 
 #include <pcbnew_utils/board_file_utils.h>
 
+#include <macros.h>
+
+#include <qa_utils/scoped_timer.h>
+
 #include <class_board.h>
 #include <class_drawsegment.h>
 #include <class_module.h>
@@ -58,6 +65,55 @@ void process( const BOARD_CONNECTED_ITEM* item, int net )
 }
 
 
+/**
+ * Time SHAPE_POLY_SET::Fracture() on the filled areas of the zones of a board.
+ *
+ * The filled areas are stored fractured in the board file, so they are unfractured
+ * first to get back the holes made by the pads, vias and tracks.
+ */
+void benchmarkFracture( BOARD& aBoard, int aIterations )
+{
+    using MS = std::chrono::duration<double, std::milli>;
+
+    MS total( 0 );
+    int index = 0;
+
+    for( auto zone : aBoard.Zones() )
+    {
+        SHAPE_POLY_SET unfractured = zone->GetFilledPolysList();
+        unfractured.Unfracture( SHAPE_POLY_SET::PM_FAST );
+
+        int holes = 0;
+
+        for( int i = 0; i < unfractured.OutlineCount(); i++ )
+            holes += unfractured.HoleCount( i );
+
+        MS duration( 0 );
+
+        for( int i = 0; i < aIterations; i++ )
+        {
+            SHAPE_POLY_SET fractured = unfractured;
+            MS             iteration;
+
+            {
+                SCOPED_TIMER<MS> timer( iteration );
+                fractured.Fracture( SHAPE_POLY_SET::PM_FAST );
+            }
+
+            duration += iteration;
+        }
+
+        printf( "zone %d (%s): %d outlines, %d holes, %d vertices: %.3f ms\n", index++,
+                TO_UTF8( zone->GetNetname() ), unfractured.OutlineCount(), holes,
+                unfractured.TotalVertices(), duration.count() / aIterations );
+
+        total += duration;
+    }
+
+    printf( "total: %.3f ms\n", total.count() / aIterations );
+}
+
+
 enum POLY_GEN_RET_CODES
 {
     LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
@@ -66,17 +122,18 @@ enum POLY_GEN_RET_CODES
 
 int polygon_gererator_main( int argc, char* argv[] )
 {
-    if( argc < 2 )
+    bool benchmark = argc > 1 && !strcmp( argv[1], "--fracture-bench" );
+
+    if( argc < ( benchmark ? 3 : 2 ) )
     {
         printf( "A sample tool for dumping board geometry as a set of polygons.\n" );
-        printf( "Usage : %s board_file.kicad_pcb\n\n", argv[0] );
+        printf( "Usage : %s board_file.kicad_pcb\n", argv[0] );
+        printf( "        %s --fracture-bench board_file.kicad_pcb [iterations]\n", argv[0] );
+        printf( "            times the fracturing of the zone fills of the board\n\n" );
         return KI_TEST::RET_CODES::BAD_CMDLINE;
     }
 
-    std::string filename;
-
-    if( argc > 1 )
-        filename = argv[1];
+    std::string filename = argv[benchmark ? 2 : 1];
 
     auto brd = KI_TEST::ReadBoardFromFileOrStream( filename );
 
@@ -85,6 +142,12 @@ int polygon_gererator_main( int argc, char* argv[] )
         return POLY_GEN_RET_CODES::LOAD_FAILED;
     }
 
+    if( benchmark )
+    {
+        benchmarkFracture( *brd, argc > 3 ? std::max( 1, atoi( argv[3] ) ) : 10 );
+        return KI_TEST::RET_CODES::OK;
+    }
+
     for( unsigned net = 0; net < brd->GetNetCount(); net++ )
     {
         printf( "net %d\n", net );